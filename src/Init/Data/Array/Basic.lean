@@ -360,7 +360,7 @@ def forM {α : Type u} {m : Type v → Type w} [Monad m] (f : α → m PUnit) (a
 def forRevM {α : Type u} {m : Type v → Type w} [Monad m] (f : α → m PUnit) (as : Array α) (start := as.size) (stop := 0) : m PUnit :=
   as.foldrM (fun a _ => f a) ⟨⟩ start stop
 
-@[inline]
+@[extern "lean_array_foldl"]
 def foldl {α : Type u} {β : Type v} (f : β → α → β) (init : β) (as : Array α) (start := 0) (stop := as.size) : β :=
   Id.run <| as.foldlM f init start stop
 
@@ -368,7 +368,7 @@ def foldl {α : Type u} {β : Type v} (f : β → α → β) (init : β) (as : A
 def foldr {α : Type u} {β : Type v} (f : α → β → β) (init : β) (as : Array α) (start := as.size) (stop := 0) : β :=
   Id.run <| as.foldrM f init start stop
 
-@[inline]
+@[extern "lean_array_map"]
 def map {α : Type u} {β : Type v} (f : α → β) (as : Array α) : Array β :=
   Id.run <| as.mapM f
 
@@ -518,7 +518,7 @@ partial def isEqvAux (a b : Array α) (hsz : a.size = b.size) (p : α → α →
 instance [BEq α] : BEq (Array α) :=
   ⟨fun a b => isEqv a b BEq.beq⟩
 
-@[inline]
+@[extern "lean_array_filter"]
 def filter (p : α → Bool) (as : Array α) (start := 0) (stop := as.size) : Array α :=
   as.foldl (init := #[]) (start := start) (stop := stop) fun r a =>
     if p a then r.push a else r
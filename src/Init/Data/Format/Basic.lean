@@ -61,16 +61,34 @@ private structure SpaceResult where
     let r₂ := r₂ (w - r₁.space);
     { r₂ with space := r₁.space + r₂.space }
 
-private def spaceUptoLine : Format → Bool → Nat → SpaceResult
-  | nil,          flatten, w => {}
-  | line,         flatten, w => if flatten then { space := 1 } else { foundLine := true }
-  | text s,       flatten, w =>
-    let p := s.posOf '\n';
-    let off := s.offsetOfPos p;
-    { foundLine := p != s.bsize, foundFlattenedHardLine := flatten && p != s.bsize, space := off }
-  | append f₁ f₂, flatten, w => merge w (spaceUptoLine f₁ flatten w) (spaceUptoLine f₂ flatten)
-  | nest _ f,     flatten, w => spaceUptoLine f flatten w
-  | group f _,    _,       w => spaceUptoLine f true w
+/-- Measures the space up to the next line break (or up to `w`, whichever comes first), like
+    folding `merge` over the leaves of `f` in order. The explicit worklist keeps the stack
+    constant: `append` spines grow linearly with the document, so recursing on them overflows
+    the stack on large terms. All `go` calls are tail calls. -/
+private partial def spaceUptoLine (f : Format) (flatten : Bool) (w : Nat) : SpaceResult :=
+  go [(f, flatten)] {}
+where
+  go : List (Format × Bool) → SpaceResult → SpaceResult
+  | [],              r => r
+  | (f, flatten)::fs, r =>
+    match f with
+    | nil          => go fs r
+    | line         =>
+      if flatten then
+        let r := { r with space := r.space + 1 }
+        if r.space > w then r else go fs r
+      else
+        { r with foundLine := true }
+    | text s       =>
+      let p := s.posOf '\n';
+      if p != s.bsize then
+        { r with foundLine := true, foundFlattenedHardLine := flatten, space := r.space + s.offsetOfPos p }
+      else
+        let r := { r with space := r.space + s.offsetOfPos p }
+        if r.space > w then r else go fs r
+    | append f₁ f₂ => go ((f₁, flatten)::(f₂, flatten)::fs) r
+    | nest _ f     => go ((f, flatten)::fs) r
+    | group f _    => go ((f, true)::fs) r
 
 private structure WorkItem where
   f : Format
@@ -24,6 +24,12 @@ instance decLt (s₁ s₂ : @& String) : Decidable (s₁ < s₂) :=
 def length : (@& String) → Nat
   | ⟨s⟩ => s.length
 
+/- The parameter `c` is the initial capacity in bytes. The result is `""`, but `push` and
+   `append` loops seeded with it do not reallocate until the string exceeds `c` bytes. -/
+@[extern "lean_mk_empty_string_with_capacity"]
+def mkEmpty (c : @& Nat) : String :=
+  ⟨[]⟩
+
 /-- The internal implementation uses dynamic arrays and will perform destructive updates
    if the String is not shared. -/
 @[extern "lean_string_push"]
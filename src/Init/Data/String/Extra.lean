@@ -25,4 +25,30 @@ constant fromUTF8Unchecked (a : @& ByteArray) : String
 @[extern "lean_string_to_utf8"]
 constant toUTF8 (a : @& String) : ByteArray
 
+/--
+  Return the position of the first byte at `≥ pos` that cannot be part of an
+  ASCII identifier (letter, digit, `_`, `'`), or of the first non-ASCII byte,
+  whichever comes first; returns `s.bsize` if the scan reaches the end.
+  The runtime scans whole words at a time, so this is much faster than
+  advancing with `String.get`/`String.next`; callers handle the byte at the
+  returned position (e.g. letter-like unicode) themselves. -/
+@[extern "lean_string_find_non_ident_byte"]
+constant findNonIdentByte (s : @& String) (pos : @& Pos) : Pos
+
+/-- Return the position of the first whitespace byte (space, tab, CR, LF) at
+  `≥ pos`, or `s.bsize` if there is none. -/
+@[extern "lean_string_find_ws_byte"]
+constant findWhitespaceByte (s : @& String) (pos : @& Pos) : Pos
+
+/-- Return the position of the first non-whitespace byte at `≥ pos`, i.e. skip
+  a whitespace run; returns `s.bsize` if the rest of the string is whitespace. -/
+@[extern "lean_string_skip_ws"]
+constant skipWhitespace (s : @& String) (pos : @& Pos) : Pos
+
+/-- Return `(line, column)` for byte position `pos`: the number of line feeds
+  before `pos` and the byte offset from the start of the current line. The
+  column counts bytes, not codepoints. -/
+@[extern "lean_string_line_column"]
+constant lineColumn (s : @& String) (pos : @& Pos) : Nat × Nat
+
 end String
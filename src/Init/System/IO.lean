@@ -103,6 +103,13 @@ def sleep (ms : UInt32) : IO Unit :=
 @[extern "lean_io_as_task"]
 constant asTask (act : IO α) (prio := Task.Priority.default) : IO (Task (Except IO.Error α))
 
+/--
+  Like `asTask`, for actions that spend most of their time blocked on I/O: the task runs
+  on the runtime's elastic blocking-I/O thread pool instead of occupying a compute worker,
+  so file and pipe reads do not stall compute-bound tasks. -/
+@[extern "lean_io_as_blocking_task"]
+constant asBlockingTask (act : IO α) : IO (Task (Except IO.Error α))
+
 /-- See `IO.asTask`. -/
 @[extern "lean_io_map_task"]
 constant mapTask (f : α → IO β) (t : Task α) (prio := Task.Priority.default) : IO (Task (Except IO.Error β))
@@ -243,9 +250,9 @@ partial def Handle.readToEnd (h : Handle) : IO String := do
       loop (s ++ line)
   loop ""
 
-def readBinFile (fname : FilePath) : IO ByteArray := do
-  let h ← Handle.mk fname Mode.read true
-  h.readBinToEnd
+/-- The runtime sizes the result from the file metadata and reads it in one pass. -/
+@[extern "lean_io_prim_read_bin_file"]
+constant readBinFile (fname : @& FilePath) : IO ByteArray
 
 def readFile (fname : FilePath) : IO String := do
   let h ← Handle.mk fname Mode.read false
@@ -316,6 +323,11 @@ open IO
 @[extern "lean_io_read_dir"]
 constant readDir : @& FilePath → IO (Array IO.FS.DirEntry)
 
+/-- Like `readDir`, but also returns each entry's file type as reported by the directory
+   enumeration itself, so tree walks do not need a `metadata` call per entry. -/
+@[extern "lean_io_read_dir_with_file_type"]
+constant readDirWithFileType : @& FilePath → IO (Array (IO.FS.DirEntry × IO.FS.FileType))
+
 @[extern "lean_io_metadata"]
 constant metadata : @& FilePath → IO IO.FS.Metadata
 
@@ -424,6 +436,13 @@ structure Child (cfg : StdioConfig) where
 
 @[extern "lean_io_process_child_wait"] constant Child.wait {cfg : @& StdioConfig} : @& Child cfg → IO UInt32
 
+/--
+Checks whether the child has exited yet, without blocking. Returns `none` while the child is
+still running and its exit code once it has terminated. A driver fanning out many children can
+poll them with this instead of parking one thread per child in `wait`.
+-/
+@[extern "lean_io_process_child_try_wait"] constant Child.tryWait {cfg : @& StdioConfig} : @& Child cfg → IO (Option UInt32)
+
 /--
 Extract the `stdin` field from a `Child` object, allowing them to be freed independently.
 This operation is necessary for closing the child process' stdin while still holding on to a process handle,
@@ -441,7 +460,7 @@ structure Output where
 /-- Run process to completion and capture output. -/
 def output (args : SpawnArgs) : IO Output := do
   let child ← spawn { args with stdout := Stdio.piped, stderr := Stdio.piped }
-  let stdout ← IO.asTask child.stdout.readToEnd Task.Priority.dedicated
+  let stdout ← IO.asBlockingTask child.stdout.readToEnd
   let stderr ← child.stderr.readToEnd
   let exitCode ← child.wait
   let stdout ← IO.ofExcept stdout.get
@@ -12,11 +12,23 @@ structure ClosedTermCache where
   constNames : NameSet := {}
   deriving Inhabited
 
-builtin_initialize closedTermCacheExt : EnvExtension ClosedTermCache ← registerEnvExtension (pure {})
+def ClosedTermCache.addEntry : ClosedTermCache → Expr × Name → ClosedTermCache
+  | s, (e, n) => { s with map := s.map.insert e n, constNames := s.constNames.insert n }
+
+/- The cache is persistent so the closed terms materialized by imported modules are
+   visible here: a closed term lifted while compiling an imported module is reused by
+   name instead of being materialized (and initialized) again in every module that
+   produces it. -/
+builtin_initialize closedTermCacheExt : SimplePersistentEnvExtension (Expr × Name) ClosedTermCache ←
+  registerSimplePersistentEnvExtension {
+    name          := `closedTermCache,
+    addEntryFn    := ClosedTermCache.addEntry,
+    addImportedFn := mkStateFromImportedEntries ClosedTermCache.addEntry {}
+  }
 
 @[export lean_cache_closed_term_name]
 def cacheClosedTermName (env : Environment) (e : Expr) (n : Name) : Environment :=
-  closedTermCacheExt.modifyState env fun s => { s with map := s.map.insert e n, constNames := s.constNames.insert n }
+  closedTermCacheExt.addEntry env (e, n)
 
 @[export lean_get_closed_term_name]
 def getClosedTermName? (env : Environment) (e : Expr) : Option Name :=
@@ -21,6 +21,8 @@ import Lean.Compiler.IR.ElimDeadBranches
 import Lean.Compiler.IR.EmitC
 import Lean.Compiler.IR.CtorLayout
 import Lean.Compiler.IR.Sorry
+import Lean.Compiler.IR.TailRecModCons
+import Lean.Compiler.IR.SimpRC
 
 namespace Lean.IR
 
@@ -29,6 +31,11 @@ register_builtin_option compiler.reuse : Bool := {
   descr    := "heuristically insert reset/reuse instruction pairs"
 }
 
+register_builtin_option compiler.trmc : Bool := {
+  defValue := true
+  descr    := "rewrite tail recursion modulo constructor into destination-passing style loops"
+}
+
 private def compileAux (decls : Array Decl) : CompilerM Unit := do
   logDecls `init decls
   checkDecls decls
@@ -55,6 +62,22 @@ private def compileAux (decls : Array Decl) : CompilerM Unit := do
     logDecls `expand_reset_reuse decls
   decls := decls.map Decl.pushProj
   logDecls `push_proj decls
+  decls ← decls.mapM fun decl => do
+    let (decl, n) := decl.simpRC
+    if n > 0 then
+      logMessageIf `simp_rc s!"eliminated {n} RC instructions in '{decl.name}'"
+    pure decl
+  logDecls `simp_rc decls
+  if compiler.trmc.get (← read) then
+    decls := tailRecModCons decls
+    logDecls `trmc decls
+  decls.forM fun decl =>
+    match decl with
+    | Decl.fdecl (f := f) (body := b) .. =>
+      if hasNonLoopSelfCall f b then
+        logMessageIf `loopify s!"recursive calls in '{f}' are not compiled into loops"
+      else pure ()
+    | _ => pure ()
   decls ← updateSorryDep decls
   logDecls `result decls
   checkDecls decls
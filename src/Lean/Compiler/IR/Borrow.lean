@@ -175,20 +175,22 @@ def isOwned (x : VarId) : M Bool := do
   let s      ← get
   pure $ s.owned.contains (currFn, x.idx)
 
-/- Updates `map[k]` using the current set of `owned` variables. -/
+/- Updates `map[k]` using the current set of `owned` variables.
+   We only write back to the map when some parameter actually changed;
+   this function runs once per declaration and join point on every
+   fixpoint iteration, and most iterations change nothing. -/
 def updateParamMap (k : ParamMap.Key) : M Unit := do
-  let currFn ← getCurrFn
   let s ← get
   match s.paramMap.find? k with
   | some ps => do
-    let ps ← ps.mapM fun (p : Param) => do
-      if !p.borrow then pure p
-      else if (← isOwned p.x) then
-        markModified
-        pure { p with borrow := false }
+    let (ps, changed) ← ps.foldlM (init := (Array.mkEmpty ps.size, false)) fun (acc : Array Param × Bool) (p : Param) => do
+      if p.borrow && (← isOwned p.x) then
+        pure (acc.1.push { p with borrow := false }, true)
       else
-        pure p
-    modify fun s => { s with paramMap := s.paramMap.insert k ps }
+        pure (acc.1.push p, acc.2)
+    if changed then do
+      markModified
+      modify fun s => { s with paramMap := s.paramMap.insert k ps }
   | none    => pure ()
 
 def getParamInfo (k : ParamMap.Key) : M (Array Param) := do
@@ -200,7 +202,15 @@ def getParamInfo (k : ParamMap.Key) : M (Array Param) := do
     | ParamMap.Key.decl fn => do
       let ctx ← read
       match findEnvDecl ctx.env fn with
-      | some decl => pure decl.params
+      | some decl => do
+        /- `fn` is not part of the block being analyzed, so its borrow
+           annotations are fixed. Cache them so that later visits of its call
+           sites do not resolve the declaration through the environment again.
+           `updateParamMap` is never invoked for such keys, and `applyParamMap`
+           only consults the keys of the block's own declarations, so the
+           extra entries are invisible outside this function. -/
+        modify fun s => { s with paramMap := s.paramMap.insert k decl.params }
+        pure decl.params
       | none      => unreachable!
     | _ => unreachable!
 
@@ -25,7 +25,18 @@ structure Context where
   mainFn     : FunId := arbitrary
   mainParams : Array Param := #[]
 
-abbrev M := ReaderT Context (EStateM String String)
+/-- Emission buffer. `out` is the active chunk; once it grows past `chunkSize`
+   it is sealed into `chunks`, so a large translation unit is produced as a
+   sequence of modest strings that the consumer writes out one by one instead
+   of one huge string that keeps being reallocated as it doubles. Chunk
+   boundaries are only introduced between top-level declarations. -/
+structure EmitState where
+  chunks : Array String := #[]
+  out    : String       := ""
+
+def chunkSize : Nat := 1048576
+
+abbrev M := ReaderT Context (EStateM String EmitState)
 
 def getEnv : M Environment := Context.env <$> read
 def getModName : M Name := Context.modName <$> read
@@ -36,7 +47,12 @@ def getDecl (n : Name) : M Decl := do
   | none   => throw s!"unknown declaration '{n}'"
 
 @[inline] def emit {α : Type} [ToString α] (a : α) : M Unit :=
-  modify fun out => out ++ toString a
+  modify fun s => { s with out := s.out ++ toString a }
+
+/-- Seal the active chunk if it has grown past `chunkSize`. -/
+def flushIfBig : M Unit :=
+  modify fun s =>
+    if s.out.length ≥ chunkSize then { chunks := s.chunks.push s.out, out := "" } else s
 
 @[inline] def emitLn {α : Type} [ToString α] (a : α) : M Unit := do
   emit a; emit "\n"
@@ -94,8 +110,9 @@ def emitFnDeclAux (decl : Decl) (cppBaseName : String) (addExternForConsts : Boo
   let ps := decl.params
   let env ← getEnv
   if ps.isEmpty then
-    if isClosedTermName env decl.name then emit "static "
-    else if addExternForConsts then emit "extern "
+    /- Closed-term constants are no longer `static`: the cache is cross-module, so a
+       module may reference a closed term materialized by one of its imports. -/
+    if addExternForConsts then emit "extern "
   emit (toCType decl.resultType ++ " " ++ cppBaseName)
   unless ps.isEmpty do
     emit "("
@@ -593,9 +610,17 @@ partial def emitBlock (b : FnBody) : M Unit := do
   | FnBody.jdecl j xs v b      => emitBlock b
   | d@(FnBody.vdecl x t v b)   =>
     let ctx ← read
-    if isTailCallTo ctx.mainFn d then
+    match tailCallTo? ctx.mainFn d with
+    | some (pre, v) =>
+      /- The `dec`/`del` instructions between the call and the `ret` only release references
+         that are dead across the call, so they may run before the back-edge. -/
+      pre.forM fun instr => do
+        match instr with
+        | FnBody.dec y n c p _ => unless p do emitDec y n c
+        | FnBody.del y _       => emitDel y
+        | _                    => pure ()
       emitTailCall v
-    else
+    | none =>
       emitVDecl x t v
       emitBlock b
   | FnBody.inc x n c p b       =>
@@ -673,7 +698,7 @@ def emitDecl (d : Decl) : M Unit := do
 def emitFns : M Unit := do
   let env ← getEnv;
   let decls := getDecls env;
-  decls.reverse.forM emitDecl
+  decls.reverse.forM fun d => do emitDecl d; flushIfBig
 
 def emitMarkPersistent (d : Decl) (n : Name) : M Unit := do
   if d.resultType.isObj then
@@ -729,9 +754,9 @@ def main : M Unit := do
 end EmitC
 
 @[export lean_ir_emit_c]
-def emitC (env : Environment) (modName : Name) : Except String String :=
-  match (EmitC.main { env := env, modName := modName }).run "" with
-  | EStateM.Result.ok    _   s => Except.ok s
+def emitC (env : Environment) (modName : Name) : Except String (Array String) :=
+  match (EmitC.main { env := env, modName := modName }).run {} with
+  | EStateM.Result.ok    _   s => Except.ok (s.chunks.push s.out)
   | EStateM.Result.error err _ => Except.error err
 
 end Lean.IR
@@ -9,11 +9,42 @@ import Lean.Compiler.IR.CompilerM
 /- Helper functions for backend code generators -/
 
 namespace Lean.IR
-/- Return true iff `b` is of the form `let x := g ys; ret x` -/
-def isTailCallTo (g : Name) (b : FnBody) : Bool :=
+private partial def tailCallPre? (x : VarId) (ys : Array Arg) : FnBody → Array FnBody → Option (Array FnBody)
+  | FnBody.ret (Arg.var r),   pre => if r == x then some pre else none
+  | b@(FnBody.dec y _ _ _ k), pre =>
+    if y != x && !ys.contains (Arg.var y) then tailCallPre? x ys k (pre.push b.resetBody) else none
+  | b@(FnBody.del y k),       pre =>
+    if y != x && !ys.contains (Arg.var y) then tailCallPre? x ys k (pre.push b.resetBody) else none
+  | _, _ => none
+
+/- Return `some (pre, v)` iff `b` is of the form `let x := g ys; pre; ret x`, where `pre`
+   contains only `dec`/`del` instructions on variables that do not occur in `ys` (nor are `x`).
+   Such references are dead across the call, so a backend that compiles the tail call into a
+   back-edge may release them before jumping. The plain `let x := g ys; ret x` shape is the
+   `pre = #[]` special case. -/
+def tailCallTo? (g : Name) (b : FnBody) : Option (Array FnBody × Expr) :=
   match b with
-  | FnBody.vdecl x _ (Expr.fap f _) (FnBody.ret (Arg.var y)) => x == y && f == g
-  | _  => false
+  | FnBody.vdecl x _ v@(Expr.fap f ys) rest =>
+    if f == g then
+      match tailCallPre? x ys rest #[] with
+      | some pre => some (pre, v)
+      | none     => none
+    else none
+  | _ => none
+
+def isTailCallTo (g : Name) (b : FnBody) : Bool :=
+  (tailCallTo? g b).isSome
+
+/- Return true iff `b` contains a full application of `g` that is not in tail-call shape,
+   i.e. a self-call that a backend cannot compile into a local back-edge. Used for the
+   `trace.compiler.ir.loopify` diagnostic. -/
+partial def hasNonLoopSelfCall (g : Name) (b : FnBody) : Bool :=
+  if (tailCallTo? g b).isSome then false
+  else match b with
+    | FnBody.vdecl _ _ (Expr.fap f _) k => f == g || hasNonLoopSelfCall g k
+    | FnBody.jdecl _ _ v k   => hasNonLoopSelfCall g v || hasNonLoopSelfCall g k
+    | FnBody.case _ _ _ alts => alts.any fun alt => hasNonLoopSelfCall g alt.body
+    | e => if e.isTerminal then false else hasNonLoopSelfCall g e.body
 
 def usesModuleFrom (env : Environment) (modulePrefix : Name) : Bool :=
   env.allImportedModuleNames.toList.any $ fun modName => modulePrefix.isPrefixOf modName
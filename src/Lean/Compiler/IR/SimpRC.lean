@@ -0,0 +1,128 @@
+/-
+Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+Authors: Leonardo de Moura
+-/
+import Lean.Compiler.IR.Basic
+import Lean.Compiler.IR.CompilerM
+
+namespace Lean.IR.SimpRC
+/-
+Peephole simplification of reference counting instructions.
+
+`explicitRC` is careful, but the passes around it (`expandResetReuse`,
+`pushProj`, the boxing of borrowed arguments) can leave behind sequences like
+```
+inc x; let y : obj := proj[1] x; dec x; ...
+```
+inside a single basic block. This pass cancels such `inc x … dec x` pairs and
+merges adjacent `inc`/`dec` instructions on the same variable, so the emitted
+code performs fewer RC updates.
+
+The pass is deliberately local and conservative. An `inc x` may only meet a
+later `dec x` if every instruction in between
+- cannot free any object (so `x` stays valid while its count is lower), and
+- cannot observe reference counts (`Expr.reset` and the sharing tests emitted
+  by `expandResetReuse` would see a different count).
+We restrict the instructions we are willing to look through to literal and
+projection `vdecl`s and `inc`s of other variables, which satisfy both
+conditions by construction. The pair must also agree on the tagged-pointer
+check and persistence flags: a pair with different flags is not a no-op on
+scalar or persistent values.
+
+Cross-block sinking and converting owned parameters into borrowed ones are out
+of scope here; the latter is `inferBorrow`'s job, which runs on the whole
+program before RC insertion.
+-/
+
+/-- We may look through `b` when matching an `inc x` with a later `dec x`:
+    `b` must not free or consume any object and must not observe reference
+    counts. -/
+private def isCrossable (b : FnBody) : Bool :=
+  match b with
+  | FnBody.vdecl _ _ (Expr.lit _) _       => true
+  | FnBody.vdecl _ _ (Expr.proj _ _) _    => true
+  | FnBody.vdecl _ _ (Expr.uproj _ _) _   => true
+  | FnBody.vdecl _ _ (Expr.sproj _ _ _) _ => true
+  | FnBody.inc _ _ _ _ _                  => true
+  | _                                     => false
+
+/-- Try to cancel `dec x m` (with flags `c`, `p`) against a preceding `inc x`
+    in the already-processed prefix `r`, scanning backwards from position `j`
+    across crossable instructions only. Returns the updated prefix and the
+    number of eliminated instructions. -/
+private partial def cancelDec? (r : Array FnBody) (x : VarId) (m : Nat) (c p : Bool) (j : Nat) : Option (Array FnBody × Nat) :=
+  if j == 0 then none
+  else
+    let j := j - 1
+    match r.get! j with
+    | b@(FnBody.inc y n c' p' k) =>
+      if y == x then
+        if c == c' && p == p' then
+          if n == m then some (r.eraseIdx j, 2)
+          else if n > m then some (r.set! j (FnBody.inc y (n - m) c' p' k), 1)
+          else some ((r.eraseIdx j).push (FnBody.dec x (m - n) c p FnBody.nil), 1)
+        else none
+      else if isCrossable b then cancelDec? r x m c p j
+      else none
+    | b =>
+      if isCrossable b then cancelDec? r x m c p j
+      else none
+
+abbrev M := StateT Nat Id
+
+private def eliminated (n : Nat) : M Unit :=
+  modify fun total => total + n
+
+private def peephole (bs : Array FnBody) : M (Array FnBody) :=
+  bs.foldlM (init := #[]) fun r b => do
+    match b with
+    | FnBody.inc x n c p _ =>
+      if r.size > 0 then
+        match r.back with
+        | FnBody.inc y m c' p' k =>
+          if x == y && c == c' && p == p' then do
+            eliminated 1
+            pure (r.pop.push (FnBody.inc x (n + m) c p k))
+          else pure (r.push b)
+        | _ => pure (r.push b)
+      else pure (r.push b)
+    | FnBody.dec x m c p _ =>
+      match cancelDec? r x m c p r.size with
+      | some (r, k) => do eliminated k; pure r
+      | none =>
+        if r.size > 0 then
+          match r.back with
+          | FnBody.dec y n c' p' k =>
+            if x == y && c == c' && p == p' then do
+              eliminated 1
+              pure (r.pop.push (FnBody.dec x (n + m) c p k))
+            else pure (r.push b)
+          | _ => pure (r.push b)
+        else pure (r.push b)
+    | b => pure (r.push b)
+
+partial def visitFnBody (b : FnBody) : M FnBody := do
+  let (bs, term) := b.flatten
+  let bs ← mmodifyJPs bs visitFnBody
+  let term ← match term with
+    | FnBody.case tid x xType alts => do
+      let alts ← alts.mapM fun alt => alt.mmodifyBody visitFnBody
+      pure (FnBody.case tid x xType alts)
+    | other => pure other
+  let bs ← peephole bs
+  pure (reshape bs term)
+
+end SimpRC
+
+/-- Cancel and merge redundant reference counting instructions within basic
+    blocks; see `Lean.IR.SimpRC`. Returns the simplified declaration together
+    with the number of eliminated RC instructions. -/
+def Decl.simpRC (d : Decl) : Decl × Nat :=
+  match d with
+  | Decl.fdecl (body := b) .. =>
+    let (b, n) := (SimpRC.visitFnBody b).run 0
+    (d.updateBody! b, n)
+  | other => (other, 0)
+
+end Lean.IR
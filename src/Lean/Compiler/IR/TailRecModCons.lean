@@ -0,0 +1,159 @@
+/-
+Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+Authors: Leonardo de Moura
+-/
+import Lean.Compiler.IR.Basic
+import Lean.Compiler.IR.FreeVars
+import Lean.Compiler.IR.CompilerM
+
+namespace Lean.IR.TailRecModCons
+/-
+Destination-passing style for tail recursion modulo constructor.
+
+A recursive function that returns a constructor whose only pending work is the
+recursive call, e.g. a `List.map`-like function compiled into
+```
+let r := f as; let z := ctor c ... r ...; ret z
+```
+allocates every cell *after* the recursive call returns, so the recursion depth
+is proportional to the structure being built and every cell is written twice
+(once on allocation, once when the parent links it). We rewrite such functions
+into a pair `(f, f._dps)` where `f._dps` receives the partially built parent
+cell as an extra (borrowed) destination parameter, allocates the next cell with
+a hole, links it into the destination, and then recurses on itself in *tail*
+position. The code generator turns the self tail call into a `goto`, so the
+recursion becomes a loop that builds the structure top-down.
+
+Remarks:
+- This transformation runs at the end of the pipeline, after `explicitRC` and
+  `expandResetReuse`: the code it emits contains explicit `FnBody.set`
+  instructions and relies on the borrow annotations already being final.
+  The generated code preserves the RC invariants: the value stored into the
+  destination field is owned by the cell (exactly as it was owned by the
+  constructor in the original code), and the destination itself is only
+  borrowed, since the root cell is kept alive by the wrapper `f`.
+- We only rewrite sites of the form `let r := f as; let z := ctor c ys; ret z`
+  where `r` occurs exactly once in `ys`, in an object field. Sites with
+  intervening instructions (e.g. `dec` of arguments passed to `f` in borrowed
+  positions) are left alone: reordering them across the recursive call would
+  not be sound.
+- All rewritten sites of `f` must agree on the hole position, because
+  `FnBody.set` takes a static field index. This covers the common case (the
+  recursive result is always the same field, e.g. the tail of a list cell).
+-/
+
+/-- Return the position of the hole if `ys` contains exactly one occurrence of
+    `r` and it is an object field of `c`. -/
+private def holeIdx? (r : VarId) (c : CtorInfo) (ys : Array Arg) : Option Nat :=
+  let (idx?, occs, _) := ys.foldl (init := ((none : Option Nat), (0 : Nat), (0 : Nat))) fun acc y =>
+    match acc with
+    | (idx?, occs, i) =>
+      if y == Arg.var r then (some i, occs + 1, i + 1)
+      else (idx?, occs, i + 1)
+  match idx? with
+  | some i => if occs == 1 && i < c.size then some i else none
+  | none   => none
+
+/-- Return the hole position if `b` is of the form
+    `let r := fname as; let z := ctor c ys; ret z` with `r` stored exactly once
+    in an object field of `z`. -/
+private def candidateHole? (fname : FunId) : FnBody → Option Nat
+  | FnBody.vdecl r _ (Expr.fap g as) (FnBody.vdecl z _ (Expr.ctor c ys) (FnBody.ret (Arg.var zr))) =>
+    if g == fname && z == zr then holeIdx? r c ys
+    else none
+  | _ => none
+
+private partial def findHoles (fname : FunId) (b : FnBody) (acc : Array Nat) : Array Nat :=
+  match candidateHole? fname b with
+  | some i => acc.push i
+  | none   =>
+    match b with
+    | FnBody.jdecl _ _ v k   => findHoles fname k (findHoles fname v acc)
+    | FnBody.case _ _ _ alts => alts.foldl (init := acc) fun acc alt => findHoles fname alt.body acc
+    | e => if e.isTerminal then acc else findHoles fname e.body acc
+
+abbrev M := StateT Index Id
+
+private def mkFresh : M VarId := do
+  let idx ← getModify fun n => n + 1
+  pure { idx := idx }
+
+/-- Rewrite a candidate site. In the auxiliary function (`dst? = some dst`) we
+    link the new cell into the destination and recurse in tail position; in the
+    wrapper (`dst? = none`) we keep the root cell and return it ourselves. -/
+private def mkSite (auxName : FunId) (dst? : Option VarId) (i : Nat) (as : Array Arg)
+    (z : VarId) (zty : IRType) (c : CtorInfo) (ys : Array Arg) : M FnBody := do
+  let w ← mkFresh
+  let alloc := Expr.ctor c (ys.set! i Arg.irrelevant)
+  let call  := FnBody.vdecl w IRType.irrelevant (Expr.fap auxName (#[Arg.var z] ++ as))
+  match dst? with
+  | some dst => pure $ FnBody.vdecl z zty alloc $ FnBody.set dst i (Arg.var z) $ call (FnBody.ret (Arg.var w))
+  | none     => pure $ FnBody.vdecl z zty alloc $ call (FnBody.ret (Arg.var z))
+
+/-- Body of `f._dps`: candidate sites become linked tail calls, and every other
+    `ret r` stores `r` into the destination instead of returning it. -/
+private partial def mkAuxBody (fname auxName : FunId) (dst : VarId) (i : Nat) (b : FnBody) : M FnBody :=
+  match candidateHole? fname b, b with
+  | some _, FnBody.vdecl _ _ (Expr.fap _ as) (FnBody.vdecl z zty (Expr.ctor c ys) _) =>
+    mkSite auxName (some dst) i as z zty c ys
+  | _, FnBody.ret a => pure $ FnBody.set dst i a (FnBody.ret Arg.irrelevant)
+  | _, FnBody.jdecl j xs v k => do
+    let v ← mkAuxBody fname auxName dst i v
+    let k ← mkAuxBody fname auxName dst i k
+    pure $ FnBody.jdecl j xs v k
+  | _, FnBody.case tid x xType alts => do
+    let alts ← alts.mapM fun alt => alt.mmodifyBody (mkAuxBody fname auxName dst i)
+    pure $ FnBody.case tid x xType alts
+  | _, e =>
+    if e.isTerminal then pure e
+    else do
+      let (instr, k) := e.split
+      let k ← mkAuxBody fname auxName dst i k
+      pure $ instr.setBody k
+
+/-- Body of the rewritten `f`: candidate sites allocate the root cell and
+    delegate the rest of the structure to `f._dps`. -/
+private partial def mkWrapperBody (fname auxName : FunId) (i : Nat) (b : FnBody) : M FnBody :=
+  match candidateHole? fname b, b with
+  | some _, FnBody.vdecl _ _ (Expr.fap _ as) (FnBody.vdecl z zty (Expr.ctor c ys) _) =>
+    mkSite auxName none i as z zty c ys
+  | _, FnBody.jdecl j xs v k => do
+    let v ← mkWrapperBody fname auxName i v
+    let k ← mkWrapperBody fname auxName i k
+    pure $ FnBody.jdecl j xs v k
+  | _, FnBody.case tid x xType alts => do
+    let alts ← alts.mapM fun alt => alt.mmodifyBody (mkWrapperBody fname auxName i)
+    pure $ FnBody.case tid x xType alts
+  | _, e =>
+    if e.isTerminal then pure e
+    else do
+      let (instr, k) := e.split
+      let k ← mkWrapperBody fname auxName i k
+      pure $ instr.setBody k
+
+private def visitDecl (d : Decl) : Array Decl :=
+  match d with
+  | Decl.fdecl f xs IRType.object b info =>
+    let holes := findHoles f b #[]
+    if holes.isEmpty then #[d]
+    else
+      let i := holes[0]
+      if holes.any (fun h => h != i) then #[d]
+      else
+        let auxName  := Name.mkStr f "_dps"
+        let nextIdx  := d.maxIndex + 1
+        let dst : VarId := { idx := nextIdx }
+        let auxBody  := (mkAuxBody f auxName dst i b).run' (nextIdx + 1)
+        let auxParams := #[{ x := dst, borrow := true, ty := IRType.object : Param }] ++ xs
+        let aux      := Decl.fdecl auxName auxParams IRType.irrelevant auxBody info
+        let newBody  := (mkWrapperBody f auxName i b).run' (nextIdx + 1)
+        #[d.updateBody! newBody, aux]
+  | d => #[d]
+
+end TailRecModCons
+
+def tailRecModCons (decls : Array Decl) : Array Decl :=
+  decls.foldl (init := #[]) fun newDecls decl => newDecls ++ TailRecModCons.visitDecl decl
+
+end Lean.IR
@@ -136,6 +136,16 @@ def addAndCompile (env : Environment) (opt : Options) (decl : Declaration) : Exc
   let env ← addDecl env decl
   compileDecl env opt decl
 
+/--
+  Freeze the environment for concurrent read-only sharing: every object reachable from it is
+  marked persistent, so reader threads perform no reference counting at all when accessing it,
+  not even the atomic operations paid after multi-thread marking. Objects in the compacted
+  regions of imported modules are already persistent, so the sweep only visits what was added
+  on top of the imports. Freezing is irreversible — the frozen graph is reclaimed only at
+  process exit — and is meant for a long-lived environment served to many readers. -/
+@[extern "lean_environment_freeze"]
+def freeze (env : Environment) : Environment := env
+
 end Environment
 
 /- Interface for managing environment extensions. -/
@@ -538,6 +548,8 @@ private def finalizePersistentExtensions (env : Environment) (opts : Options) :
 
 structure ImportState where
   moduleNameSet : NameSet := {}
+  /- Background reads of .olean files that have been started but not yet consumed. -/
+  moduleTasks   : NameMap (Task (Except IO.Error (ModuleData × CompactedRegion))) := {}
   moduleNames   : Array Name := #[]
   moduleData    : Array ModuleData := #[]
   regions       : Array CompactedRegion := #[]
@@ -573,6 +585,29 @@ partial def importModules (imports : List Import) (opts : Options) (trustLevel :
   let env ← finalizePersistentExtensions env opts
   pure env
 where
+  olean (module : Name) : IO System.FilePath := do
+    let mFile ← findOLean module
+    unless (← mFile.pathExists) do
+      throw $ IO.userError s!"object file '{mFile}' of module {module} does not exist"
+    pure mFile
+  /-- Starts reading the given module in the background unless it has already been imported or its
+      read is already in flight. -/
+  prefetchMod (i : Import) : StateRefT ImportState IO Unit := do
+    let s ← get
+    unless i.runtimeOnly || s.moduleNameSet.contains i.module || s.moduleTasks.contains i.module do
+      let mFile ← olean i.module
+      let t ← IO.asBlockingTask (readModuleData mFile)
+      modify fun s => { s with moduleTasks := s.moduleTasks.insert i.module t }
+  /-- Returns the module's data, waiting for its background read if one was started. -/
+  readMod (i : Import) : StateRefT ImportState IO (ModuleData × CompactedRegion) := do
+    match (← get).moduleTasks.find? i.module with
+    | some t =>
+      match t.get with
+      | Except.ok modRegion => pure modRegion
+      | Except.error e      => throw e
+    | none => do
+      let mFile ← olean i.module
+      readModuleData mFile
   importMods : List Import → StateRefT ImportState IO Unit
   | []    => pure ()
   | i::is => do
@@ -580,10 +615,11 @@ where
       importMods is
     else do
       modify fun s => { s with moduleNameSet := s.moduleNameSet.insert i.module }
-      let mFile ← findOLean i.module
-      unless (← mFile.pathExists) do
-        throw $ IO.userError s!"object file '{mFile}' of module {i.module} does not exist"
-      let (mod, region) ← readModuleData mFile
+      /- Reading and fixing up distinct .olean files are independent, so start the remaining
+         imports at this level in the background before blocking on this one. The consumption
+         order below is unchanged; the tasks merely act as a read-ahead cache for it. -/
+      is.forM prefetchMod
+      let (mod, region) ← readMod i
       importMods mod.imports.toList
       modify fun s => { s with
         moduleData  := s.moduleData.push mod
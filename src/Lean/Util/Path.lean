@@ -8,6 +8,7 @@ paths containing package roots: an import `A.B.C` resolves to
 `path/A/B/C.olean` for the first entry `path` in `LEAN_PATH`
 with a directory `A/`. `import A` resolves to `path/A.olean`.
 -/
+import Std.Data.HashMap
 import Lean.Data.Name
 
 namespace Lean
@@ -41,6 +42,12 @@ end SearchPath
 
 builtin_initialize searchPathRef : IO.Ref SearchPath ← IO.mkRef {}
 
+/-- Memoizes package-name → search-path-root resolutions made by `findOLean`. Every import of
+   a package repeats the same directory probes across every root in the search path, and the
+   failed `stat` calls dominate cold-start syscall counts. The cache is cleared whenever the
+   search path is replaced through `initSearchPath`. -/
+builtin_initialize pkgRootCache : IO.Ref (Std.HashMap String System.FilePath) ← IO.mkRef {}
+
 @[extern c inline "LEAN_IS_STAGE0"]
 private constant isStage0 (u : Unit) : Bool
 
@@ -66,7 +73,8 @@ def addSearchPathFromEnv (sp : SearchPath) : IO SearchPath := do
   | some val => pure <| SearchPath.parse val ++ sp
 
 @[export lean_init_search_path]
-def initSearchPath (path : Option String := none) : IO Unit :=
+def initSearchPath (path : Option String := none) : IO Unit := do
+  pkgRootCache.set {}
   match path with
   | some path => searchPathRef.set <| SearchPath.parse path
   | none      => do
@@ -75,9 +83,15 @@ def initSearchPath (path : Option String := none) : IO Unit :=
     searchPathRef.set sp
 
 partial def findOLean (mod : Name) : IO FilePath := do
+  let pkg := mod.getRoot.toString
+  if let some root := (← pkgRootCache.get).find? pkg then
+    return modToFilePath root mod "olean"
   let sp ← searchPathRef.get
-  if let some fname ← sp.findWithExt "olean" mod then
-    return fname
+  let root? ← sp.findM? fun p =>
+    (p / pkg).isDir <||> ((p / pkg).withExtension "olean").pathExists
+  if let some root := root? then
+    pkgRootCache.modify (·.insert pkg root)
+    return modToFilePath root mod "olean"
   else
     let pkg := FilePath.mk mod.getRoot.toString
     let mut msg := s!"unknown package '{pkg}'"
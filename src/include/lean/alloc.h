@@ -7,12 +7,93 @@ Author: Leonardo de Moura
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include <iosfwd>
 
 namespace lean {
 void init_thread_heap();
 void * alloc(size_t sz);
 void dealloc(void * o, size_t sz);
+/* Usable bytes in the block backing `o` (allocated via `alloc(sz)`). */
+size_t alloc_usable_size(void * o, size_t sz);
 uint64_t get_num_heartbeats();
+/* Small-object bytes allocated by the current thread so far. */
+uint64_t get_alloc_bytes();
+/* Bytes held in allocator segments process-wide. Always maintained; one
+   atomic load to read. Segments are never unmapped, so this is the high-water
+   footprint of the small-object heap. */
+size_t get_segment_bytes();
+/* Write a per-kind census of live heap objects to `out` (see
+   lean_get_heap_census). Best effort: pages mutated concurrently may be
+   slightly over- or under-counted. */
+void display_heap_census(std::ostream & out);
+/* NUMA segment allocation policy.
+   - `none`:  segments are allocated with no node preference (default).
+   - `local`: segments are bound to the NUMA node of the requesting heap, and
+     orphan heaps are preferably adopted by heaps on the same node.
+   The policy is a no-op on platforms without NUMA support. */
+enum class numa_policy { none, local };
+void set_numa_policy(numa_policy p);
+numa_policy get_numa_policy();
+/* Return the number of NUMA nodes (1 on platforms without NUMA support). */
+unsigned get_num_numa_nodes();
+/* Pin the current thread to the CPUs of NUMA node `worker_idx % get_num_numa_nodes()`.
+   Used by the task manager to distribute workers across nodes when the `local`
+   policy is active. No-op when the policy is `none` or NUMA is unsupported. */
+void bind_worker_to_numa_node(unsigned worker_idx);
+/* When enabled, allocator segments are backed by 2 MB-aligned mappings marked
+   MADV_HUGEPAGE, reducing TLB pressure on huge heaps. Must be set before the
+   runtime is initialized (or set LEAN_HUGE_PAGES in the environment); segments
+   already allocated are unaffected. No-op on platforms without mmap/madvise. */
+void set_huge_page_segments(bool flag);
+/* When `num_pages` is non-zero, a heap whose free-page count exceeds the
+   watermark returns the data area of fully-free pages to the OS (madvise
+   MADV_DONTNEED), so RSS shrinks after large imports are dropped. Also
+   settable via the LEAN_PAGE_TRIM environment variable. Trimmed pages are
+   transparently reinitialized when reused. */
+void set_page_trim_watermark(unsigned num_pages);
 void initialize_alloc();
 void finalize_alloc();
+
+/* Scoped region (arena) allocator for short-lived scratch data.
+
+   Memory is carved out of a list of chunks with a bump pointer; individual
+   deallocation is a no-op and the whole region is released at once by
+   `clear()`/the destructor. This eliminates per-object free-list traffic for
+   allocation patterns such as the kernel's per-declaration whnf/infer caches,
+   where everything dies together at the end of a `check`. */
+class region {
+    struct chunk {
+        chunk * m_next;
+        size_t  m_size; /* size of the data area following this header */
+    };
+    chunk * m_chunks{nullptr};
+    char *  m_next{nullptr};
+    char *  m_end{nullptr};
+    void alloc_chunk(size_t min_sz);
+public:
+    region() {}
+    region(region const &) = delete;
+    region & operator=(region const &) = delete;
+    ~region() { clear(); }
+    void * alloc(size_t sz);
+    /* Release all chunks; previously returned memory becomes invalid. */
+    void clear();
+};
+
+/* STL allocator adapter backed by a `region`. Deallocation is a no-op; the
+   memory is reclaimed when the region is cleared. The region must outlive
+   every container using the adapter. */
+template<typename T>
+class region_allocator {
+    region * m_region;
+    template<typename U> friend class region_allocator;
+public:
+    typedef T value_type;
+    explicit region_allocator(region & r):m_region(&r) {}
+    template<typename U> region_allocator(region_allocator<U> const & o):m_region(o.m_region) {}
+    T * allocate(size_t n) { return static_cast<T*>(m_region->alloc(n * sizeof(T))); }
+    void deallocate(T *, size_t) {}
+    template<typename U> bool operator==(region_allocator<U> const & o) const { return m_region == o.m_region; }
+    template<typename U> bool operator!=(region_allocator<U> const & o) const { return m_region != o.m_region; }
+};
 }
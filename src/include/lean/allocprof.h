@@ -26,4 +26,20 @@ public:
     allocprof(std::ostream & out, char const * msg);
     ~allocprof();
 };
+
+/* Sampling allocation-site profiler.
+
+   Every `period`-th allocation records the current call stack; aggregated
+   counts and bytes per distinct stack can be dumped in collapsed-stack form
+   (`frame;frame;frame count`, flamegraph-compatible) at any time. Sampling
+   keeps the overhead low enough for full `csimp` runs; a dump can also be
+   requested asynchronously via SIGUSR2 (written to `allocprof.out` at the
+   next sample). Sampling is off by default and costs a single predicted
+   branch on the allocation path when disabled. */
+void enable_alloc_sampling(unsigned period);
+void disable_alloc_sampling();
+void dump_alloc_samples(std::ostream & out);
+/* Hook called by the allocator; do not call directly. */
+void allocprof_sample(size_t sz);
+extern bool g_alloc_sampling;
 }
@@ -0,0 +1,20 @@
+/*
+Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+*/
+#pragma once
+#include <cstddef>
+#include <functional>
+
+namespace lean {
+/** \brief Run `fn` on a heap-allocated stack of `stack_size` bytes, so its
+    recursion depth is bounded by memory instead of the thread stack size.
+
+    The stack is a lazily committed anonymous mapping: reserving a large size
+    costs address space, not physical memory. Exceptions thrown by `fn` are
+    caught on the custom stack and rethrown to the caller, and the stack guard
+    (`check_stack`) is redirected to the custom stack for the duration of the
+    call. On platforms without ucontext support `fn` simply runs on the current
+    stack. */
+void run_with_big_stack(std::function<void()> const & fn, size_t stack_size = size_t(1) << 30);
+}
@@ -39,8 +39,17 @@ class object_compactor {
     bool insert_task(object * o);
     bool insert_ref(object * o);
     void insert_mpz(object * o);
+    void index_existing_objects();
 public:
     object_compactor();
+    /* Creates an object compactor seeded with the contents of a previously written
+       compacted region (e.g., the body of an existing .olean file, including its
+       trailing terminator, which is dropped so that the next `operator()` call
+       defines the root of the combined region). Objects structurally identical to
+       objects already in the base are shared instead of copied, so only new or
+       changed subgraphs are appended. If `base` does not look like a compacted
+       region, it is ignored and the compactor starts empty. */
+    object_compactor(void const * base, size_t base_sz);
     object_compactor(object_compactor const &) = delete;
     object_compactor(object_compactor &&) = delete;
     ~object_compactor();
@@ -56,6 +65,11 @@ class compacted_region {
     void *            m_next;
     void *            m_end;
     mpz_object *      m_nested_mpzs;
+    /* When the region is backed by a (copy-on-write) file mapping, `m_mmap_base`/`m_mmap_size`
+       describe the whole mapping (page aligned, including any file header preceding the region),
+       and the destructor unmaps it instead of freeing `m_begin`. */
+    void *            m_mmap_base;
+    size_t            m_mmap_size;
     void move(size_t d);
     void move(object * o);
     object * fix_object_ptr(object * o);
@@ -69,6 +83,10 @@ public:
     /* Creates a compacted object region using the given region in memory.
        This object takes ownership of the region. */
     compacted_region(size_t sz, void * data);
+    /* Creates a compacted object region inside the file mapping `[mmap_base, mmap_base + mmap_size)`.
+       `data` points at the region itself (i.e., past any file header). The mapping is released
+       with `munmap` when this object is deleted. Only available on platforms with `mmap`. */
+    compacted_region(size_t sz, void * data, void * mmap_base, size_t mmap_size);
     /* Creates a compacted object region using the object_compactor current state.
        It creates a copy of the compacted region generated by the object compactor. */
     explicit compacted_region(object_compactor const & c);
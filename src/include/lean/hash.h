@@ -14,6 +14,11 @@ void mix(unsigned & a, unsigned & b, unsigned & c);
 
 unsigned hash_str(size_t len, char const * str, unsigned init_value);
 
+/* Faster 64-bit byte hash for process-local tables. Not stable across platforms or versions:
+   do NOT use it for anything observable from Lean code or stored on disk (`hash_str` feeds
+   `String.hash` and hence the hash codes embedded in `Name` objects). */
+uint64 hash_bytes(size_t len, char const * str, uint64 init_value);
+
 inline unsigned hash(unsigned h1, unsigned h2) {
     h2 -= h1; h2 ^= (h1 << 8);
     h1 -= h2; h2 ^= (h1 << 16);
@@ -15,6 +15,11 @@ namespace lean {
 /** \brief Increment thread local counter for approximating elapsed time. */
 void inc_heartbeat();
 
+/** \brief Account `n` heartbeats at once and enforce the budget, equivalent to
+    `n` calls of `check_heartbeat` but with a single increment and check. Lets
+    tight loops batch their per-iteration accounting. */
+void add_heartbeats(size_t n);
+
 /** \brief Reset thread local counter for approximating elapsed time. */
 void reset_heartbeat();
 
@@ -40,8 +45,75 @@ public:
     scope_max_heartbeat(size_t max);
 };
 
+/** \brief Shared heartbeat budget for a tree of tasks.
+
+    The thread local heartbeat counter undercounts when work fans out into
+    tasks executed on other threads. A token is inherited by child tasks at
+    spawn time, and every thread working on the tree flushes its local ticks
+    into the token in batches, so \c set_max_heartbeat bounds the whole tree
+    with near-zero hot-path cost. Intrusively reference counted since a token
+    is shared by the spawning thread and all (transitive) child tasks. */
+class heartbeat_token {
+    atomic_uint    m_rc;
+    atomic<size_t> m_count;
+    size_t         m_max;
+public:
+    explicit heartbeat_token(size_t max);
+    void inc_ref();
+    void dec_ref();
+    /** \brief Add \c n local ticks to the shared count. */
+    void flush(size_t n);
+    /** \brief Approximate check (pending local ticks are not counted). */
+    bool expired() const;
+};
+
+/** \brief Token the current thread flushes heartbeats into. Borrowed reference, may be nullptr. */
+heartbeat_token * get_heartbeat_token();
+/** \brief Install \c t as the current thread's token. Pending local ticks are
+    flushed into the previous token first. */
+void set_heartbeat_token(heartbeat_token * t);
+
+/* Install a token for the duration of a scope (e.g. while executing one task). */
+class scope_heartbeat_token {
+    heartbeat_token * m_old;
+public:
+    scope_heartbeat_token(heartbeat_token * t); // NOLINT
+    ~scope_heartbeat_token();
+};
+
 void check_heartbeat();
 
+/** \brief Cooperative cancellation flag shared by a tree of tasks.
+
+    Children inherit a reference at spawn time, so cancelling the token is
+    O(1) and reaches every (transitive) descendant without walking the task
+    graph, unlike per-task `IO.cancel`. The object occupies a single cache
+    line and \c canceled is one relaxed load, cheap enough for hot loops.
+    Intrusively reference counted. */
+class alignas(64) cancel_token {
+    atomic_uint m_rc;
+    atomic_bool m_canceled;
+public:
+    cancel_token();
+    void inc_ref();
+    void dec_ref();
+    bool canceled() const { return m_canceled.load(memory_order_relaxed); }
+    void cancel() { m_canceled.store(true, memory_order_relaxed); }
+};
+
+/** \brief Token polled by \c check_interrupted. Borrowed reference, may be nullptr. */
+cancel_token * get_cancel_token();
+/** \brief Install \c t as the current thread's cancellation token. */
+void set_cancel_token(cancel_token * t);
+
+/* Install a cancellation token for the duration of a scope (e.g. while executing one task). */
+class scope_cancel_token {
+    cancel_token * m_old;
+public:
+    scope_cancel_token(cancel_token * t); // NOLINT
+    ~scope_cancel_token();
+};
+
 struct scoped_interrupt_flag : flet<atomic_bool *> {
     scoped_interrupt_flag(atomic_bool *); // NOLINT
 };
@@ -56,6 +128,11 @@ void check_interrupted();
 */
 void check_system(char const * component_name);
 
+/** \brief Like `check_system`, but accounts `heartbeats` loop iterations in one
+    step. For a loop that polls every `heartbeats` iterations this preserves the
+    total count while removing the per-iteration increment. */
+void check_system(char const * component_name, size_t heartbeats);
+
 constexpr unsigned g_small_sleep = 10;
 
 /**
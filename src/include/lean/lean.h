@@ -214,10 +214,26 @@ typedef struct {
     struct lean_task *   m_head_dep;
     struct lean_task *   m_next_dep;
     unsigned             m_prio;
+    /* Affinity group (0 = none): the scheduler keeps tasks of one group on
+       the same worker when possible. Inherited by child tasks at spawn. */
+    unsigned             m_group;
+    /* `lean::heartbeat_token` the task tree charges its heartbeats against
+       (may be NULL). Inherited by child tasks at spawn. */
+    void *               m_heartbeat;
+    /* `lean::cancel_token` shared by the task tree (may be NULL). Inherited by
+       child tasks at spawn; cancelling it cancels the whole subtree in O(1). */
+    void *               m_cancel;
+    /* Attribution counters, accumulated by the scheduler over the task's
+       execution slices: thread CPU time and small-object bytes allocated. */
+    uint64_t             m_cpu_time_ns;
+    uint64_t             m_alloc_bytes;
     uint8_t              m_canceled;
     // If true, task will not be freed until finished
     uint8_t              m_keep_alive;
     uint8_t              m_deleted;
+    /* If true, the task is expected to block on I/O and is executed by the
+       elastic blocking-I/O pool instead of a CPU worker. */
+    uint8_t              m_blocking;
 } lean_task_imp;
 
 /* Object of type `Task _`. The lifetime of a `lean_task` object can be represented as a state machine with atomic
@@ -318,6 +334,59 @@ void lean_free_small(void * p);
 unsigned lean_small_mem_size(void * p);
 void lean_inc_heartbeat();
 
+/* Fast attach/detach for foreign threads calling into the runtime.
+   lean_attach_thread gives the calling thread an allocation heap, reusing the
+   heap of a previously detached thread when one is cached, which is much
+   cheaper than full per-thread initialization. Each attach must be paired
+   with a lean_detach_thread on the same thread before it exits. Threads whose
+   heap is managed by the runtime itself (workers, lthreads) must not call
+   detach; on such threads attach is a no-op. */
+void lean_attach_thread();
+void lean_detach_thread();
+
+/* Snapshot of the calling thread's small-object heap. All figures refer to the
+   current thread only; aggregate across threads for a process-wide view. */
+typedef struct lean_mem_stats {
+    size_t segments;         /* segments owned by the heap */
+    size_t reserved_bytes;   /* bytes reserved by those segments */
+    size_t pages;            /* pages carved out of the segments */
+    size_t free_pages;       /* mostly-free pages parked on the page free lists */
+    size_t free_bytes;       /* bytes sitting on per-page object free lists */
+    /* per size class: number of pages and free object slots */
+    size_t class_pages[LEAN_MAX_SMALL_OBJECT_SIZE / LEAN_OBJECT_SIZE_DELTA];
+    size_t class_free_slots[LEAN_MAX_SMALL_OBJECT_SIZE / LEAN_OBJECT_SIZE_DELTA];
+} lean_mem_stats;
+/* Walk the calling thread's heap and fill `s`. The ratio free_bytes /
+   reserved_bytes is a direct fragmentation measure for triggering mitigation
+   in long-running processes. No-op (all zeros) without LEAN_SMALL_ALLOCATOR. */
+void lean_get_mem_stats(lean_mem_stats * s);
+
+/* Live-heap census: live small objects bucketed by kind. */
+#define LEAN_CENSUS_CTOR      0
+#define LEAN_CENSUS_CLOSURE   1
+#define LEAN_CENSUS_ARRAY     2
+#define LEAN_CENSUS_SARRAY    3
+#define LEAN_CENSUS_STRING    4
+#define LEAN_CENSUS_MPZ       5
+#define LEAN_CENSUS_THUNK     6
+#define LEAN_CENSUS_TASK      7
+#define LEAN_CENSUS_REF       8
+#define LEAN_CENSUS_OTHER     9
+#define LEAN_CENSUS_NUM_KINDS 10
+typedef struct lean_heap_census {
+    size_t num_objects[LEAN_CENSUS_NUM_KINDS];
+    size_t num_bytes[LEAN_CENSUS_NUM_KINDS]; /* heap bytes, i.e. occupied slot sizes */
+} lean_heap_census;
+/* Walk every page of every heap (all threads) and fill `c` with live object
+   counts and bytes per kind, answering "what is the resident set made of".
+   The walk does not stop the world: pages mutated concurrently can be
+   mis-counted and objects freed but not yet recycled still count as live, so
+   figures are approximate. With LEAN_HEAP_CENSUS set in the environment,
+   SIGUSR1 triggers the same census and dumps it to leancensus.out at the
+   allocator's next page allocation; the signal is left untouched otherwise.
+   Covers small objects only; no-op (all zeros) without LEAN_SMALL_ALLOCATOR. */
+void lean_get_heap_census(lean_heap_census * c);
+
 static inline lean_object * lean_alloc_small_object(unsigned sz) {
 #ifdef LEAN_SMALL_ALLOCATOR
     sz = lean_align(sz, LEAN_OBJECT_SIZE_DELTA);
@@ -442,7 +511,31 @@ static inline _Atomic(size_t) * lean_get_rc_mt_addr(lean_object* o) {
 #endif
 }
 
+#ifdef LEAN_DEFERRED_RC
+/* Append a decrement for the multi-threaded object `o` to the calling
+   thread's RC log. Logged decrements are flushed in coalesced batches (one
+   atomic update per distinct object), trading a little latency for far fewer
+   contended writes. Sound because the pending decrement still accounts for a
+   live reference, so the count cannot reach zero before the flush. */
+void lean_deferred_dec(lean_object * o);
+/* Record an increment for the multi-threaded object `o` against the calling
+   thread's RC log: it cancels a pending logged decrement when one exists, so
+   inc/dec churn by the thread that effectively owns a shared object never
+   touches the shared counter. Without a pending decrement the increment is
+   applied atomically right away; deferring it would let another thread drop
+   the count to zero before the flush. */
+void lean_deferred_inc(lean_object * o);
+/* Flush the calling thread's RC log (a safepoint for deferred decrements). */
+void lean_rc_log_flush();
+#endif
+
 static inline void lean_inc_ref(lean_object * o) {
+#ifdef LEAN_DEFERRED_RC
+    if (!lean_is_st(o) && lean_is_mt(o)) {
+        lean_deferred_inc(o);
+        return;
+    }
+#endif
 #if defined(LEAN_COMPRESSED_OBJECT_HEADER)
     if (LEAN_LIKELY(lean_is_st(o))) {
         o->m_header++;
@@ -545,7 +638,21 @@ static inline bool lean_dec_ref_core(lean_object * o) {
 /* Generic Lean object delete operation. */
 void lean_del(lean_object * o);
 
-static inline void lean_dec_ref(lean_object * o) { if (lean_dec_ref_core(o)) lean_del(o); }
+/* When `max_objs` is non-zero, lean_del frees at most that many objects
+   synchronously and defers the remainder of the graph to a background
+   reclamation thread, bounding deletion latency on the calling thread. Pass 0
+   (the default) for fully synchronous deletion. */
+void lean_set_del_slice(size_t max_objs);
+
+static inline void lean_dec_ref(lean_object * o) {
+#ifdef LEAN_DEFERRED_RC
+    if (!lean_is_st(o) && lean_is_mt(o)) {
+        lean_deferred_dec(o);
+        return;
+    }
+#endif
+    if (lean_dec_ref_core(o)) lean_del(o);
+}
 static inline void lean_inc(lean_object * o) { if (!lean_is_scalar(o)) lean_inc_ref(o); }
 static inline void lean_inc_n(lean_object * o, size_t n) { if (!lean_is_scalar(o)) lean_inc_ref_n(o, n); }
 static inline void lean_dec(lean_object * o) { if (!lean_is_scalar(o)) lean_dec_ref(o); }
@@ -638,7 +745,38 @@ static inline bool lean_nonzero_rc(lean_object * o) {
 #endif
 }
 
+/* Current reference count of `o`. For MT objects the value is a relaxed
+   snapshot and may already be stale when the caller inspects it; for
+   persistent and region objects (which are not reference counted) the result
+   is SIZE_MAX. Intended for heuristics such as cache eviction, not for
+   correctness decisions. */
+static inline size_t lean_rc_value(lean_object * o) {
+#if defined(LEAN_COMPRESSED_OBJECT_HEADER) || defined(LEAN_COMPRESSED_OBJECT_HEADER_SMALL_RC)
+    if (LEAN_LIKELY(lean_is_st(o))) {
+        return (o->m_header) & ((1ull << LEAN_RC_NBITS) - 1);
+    } else if (lean_is_mt(o)) {
+        LEAN_USING_STD;
+        return atomic_load_explicit(lean_get_rc_mt_addr(o), memory_order_relaxed) & ((1ull << LEAN_RC_NBITS) - 1);
+    } else {
+        return SIZE_MAX;
+    }
+#else
+    if (LEAN_LIKELY(lean_is_st(o))) {
+        return o->m_rc;
+    } else if (lean_is_mt(o)) {
+        LEAN_USING_STD;
+        return atomic_load_explicit(lean_get_rc_mt_addr(o), memory_order_relaxed);
+    } else {
+        return SIZE_MAX;
+    }
+#endif
+}
+
 void lean_mark_mt(lean_object * o);
+/* Like lean_mark_mt, but traverses the graph with `num_workers` threads.
+   Only safe while the graph is not yet visible to other threads (the usual
+   situation when publishing a freshly built value). */
+void lean_mark_mt_parallel(lean_object * o, unsigned num_workers);
 void lean_mark_persistent(lean_object * o);
 
 static inline void lean_set_st_header(lean_object * o, unsigned tag, unsigned other) {
@@ -991,7 +1129,15 @@ static inline lean_object * lean_array_swap(lean_obj_arg a, b_lean_obj_arg i, b_
 }
 
 lean_object * lean_array_push(lean_obj_arg a, lean_obj_arg v);
+/* Ensure `a` has capacity for at least `cap` elements, reallocating at most
+   once; lets array-building loops avoid repeated copy-on-grow. */
+lean_obj_res lean_array_reserve(lean_obj_arg a, size_t cap);
 lean_object * lean_mk_array(lean_obj_arg n, lean_obj_arg v);
+/* Native `Array.map`/`Array.foldl`/`Array.filter`; `map` and full-range `filter`
+   reuse an exclusive array in place. */
+lean_obj_res lean_array_map(lean_obj_arg f, lean_obj_arg a);
+lean_obj_res lean_array_foldl(lean_obj_arg f, lean_obj_arg init, lean_obj_arg a, lean_obj_arg start, lean_obj_arg stop);
+lean_obj_res lean_array_filter(lean_obj_arg p, lean_obj_arg a, lean_obj_arg start, lean_obj_arg stop);
 
 /* Array of scalars */
 
@@ -1046,6 +1192,9 @@ static inline uint8_t lean_byte_array_get(b_lean_obj_arg a, b_lean_obj_arg i) {
 }
 
 lean_obj_res lean_byte_array_push(lean_obj_arg a, uint8_t b);
+/* bulk kernels (vectorized in the runtime) */
+lean_obj_res lean_byte_array_fill(lean_obj_arg a, uint8_t b);
+size_t lean_byte_array_index_of(b_lean_obj_arg a, uint8_t b, size_t start);
 
 static inline lean_obj_res lean_byte_array_set(lean_obj_arg a, b_lean_obj_arg i, uint8_t b) {
     if (!lean_is_scalar(i)) {
@@ -1095,6 +1244,10 @@ static inline double lean_float_array_get(b_lean_obj_arg a, b_lean_obj_arg i) {
 }
 
 lean_obj_res lean_float_array_push(lean_obj_arg a, double d);
+/* bulk kernels (vectorized in the runtime) */
+double lean_float_array_sum(b_lean_obj_arg a);
+double lean_float_array_dot(b_lean_obj_arg a, b_lean_obj_arg b);
+lean_obj_res lean_float_array_scale(lean_obj_arg a, double s);
 
 static inline lean_obj_res lean_float_array_set(lean_obj_arg a, b_lean_obj_arg i, double d) {
     if (!lean_is_scalar(i)) {
@@ -1140,10 +1293,20 @@ static inline lean_obj_res lean_alloc_string(size_t size, size_t capacity, size_
     return (lean_object*)o;
 }
 static inline size_t lean_string_capacity(lean_object * o) { return lean_to_string(o)->m_capacity; }
+static inline lean_obj_res lean_mk_empty_string_with_capacity(b_lean_obj_arg capacity) {
+    if (!lean_is_scalar(capacity)) lean_internal_panic_out_of_memory();
+    lean_obj_res r = lean_alloc_string(1, lean_unbox(capacity) + 1, 0);
+    lean_to_string(r)->m_data[0] = 0;
+    return r;
+}
 static inline size_t lean_string_byte_size(lean_object * o) { return sizeof(lean_string_object) + lean_string_capacity(o); }
 /* instance : inhabited char := ⟨'A'⟩ */
 static inline uint32_t lean_char_default_value() { return 'A'; }
 lean_obj_res lean_mk_string(char const * s);
+/* When enabled, short strings (<= 32 bytes) built by lean_mk_string are
+   served from a per-thread interning cache, so repeated identifiers are
+   usually pointer-identical. Off by default. */
+void lean_set_string_interning(bool flag);
 static inline char const * lean_string_cstr(b_lean_obj_arg o) {
     assert(lean_is_string(o));
     return lean_to_string(o)->m_data;
@@ -1170,9 +1333,17 @@ static inline bool lean_string_eq(b_lean_obj_arg s1, b_lean_obj_arg s2) {
 }
 static inline bool lean_string_ne(b_lean_obj_arg s1, b_lean_obj_arg s2) { return !lean_string_eq(s1, s2); }
 bool lean_string_lt(b_lean_obj_arg s1, b_lean_obj_arg s2);
+/* Three-way byte-lexicographic comparison: < 0, 0, > 0. A single pass, unlike
+   calling `lean_string_lt` in both directions. */
+int lean_string_cmp(b_lean_obj_arg s1, b_lean_obj_arg s2);
 static inline uint8_t lean_string_dec_eq(b_lean_obj_arg s1, b_lean_obj_arg s2) { return lean_string_eq(s1, s2); }
 static inline uint8_t lean_string_dec_lt(b_lean_obj_arg s1, b_lean_obj_arg s2) { return lean_string_lt(s1, s2); }
 uint64_t lean_string_hash(b_lean_obj_arg);
+/* Bulk byte-position scans; see runtime/object.cpp */
+lean_obj_res lean_string_find_non_ident_byte(b_lean_obj_arg s, b_lean_obj_arg pos);
+lean_obj_res lean_string_find_ws_byte(b_lean_obj_arg s, b_lean_obj_arg pos);
+lean_obj_res lean_string_skip_ws(b_lean_obj_arg s, b_lean_obj_arg pos);
+lean_obj_res lean_string_line_column(b_lean_obj_arg s, b_lean_obj_arg pos);
 
 /* Thunks */
 
@@ -1214,6 +1385,13 @@ void lean_init_task_manager();
 void lean_init_task_manager_using(unsigned num_workers);
 
 lean_obj_res lean_task_spawn_core(lean_obj_arg c, unsigned prio, bool keep_alive);
+/* Like lean_task_spawn_core, but places the task in affinity group `group`
+   (0 = none): related tasks funnel to the same worker so dependency chains
+   stay cache-warm. Affinity is best effort; idle workers may still steal. */
+lean_obj_res lean_task_spawn_affinity_core(lean_obj_arg c, unsigned prio, unsigned group, bool keep_alive);
+/* Like lean_task_spawn_core, but runs the task on the elastic blocking-I/O
+   pool, so file and child-process waits do not occupy CPU workers. */
+lean_obj_res lean_task_spawn_blocking_core(lean_obj_arg c, bool keep_alive);
 /* Run a closure `Unit -> A` as a `Task A` */
 static inline lean_obj_res lean_task_spawn(lean_obj_arg c, lean_obj_arg prio) { return lean_task_spawn_core(c, lean_unbox(prio), false); }
 /* Convert a value `a : A` into `Task A` */
@@ -1239,9 +1417,30 @@ bool lean_io_check_canceled_core();
 void lean_io_cancel_core(b_lean_obj_arg t);
 /* primitive for implementing `IO.hasFinished : Task a -> IO Unit` */
 bool lean_io_has_finished_core(b_lean_obj_arg t);
+
+/* Cancellation tokens (external objects): O(1) cooperative cancellation of a
+   whole task subtree. A freshly spawned task inherits the token installed via
+   `lean_io_cancel_token_set_current_core` (or the one of its spawning task),
+   and `IO.checkCanceled`/`lean_io_check_canceled_core` reports true for every
+   task sharing a cancelled token. */
+lean_obj_res lean_io_cancel_token_new_core();
+void lean_io_cancel_token_cancel_core(b_lean_obj_arg tk);
+bool lean_io_cancel_token_is_canceled_core(b_lean_obj_arg tk);
+void lean_io_cancel_token_set_current_core(b_lean_obj_arg tk);
 /* primitive for implementing `IO.waitAny : List (Task a) -> IO (Task a)` */
 b_lean_obj_res lean_io_wait_any_core(b_lean_obj_arg task_list);
 
+/* Aggregate attribution counters of all finished tasks, for tuning task
+   granularity. CPU time uses the thread CPU clock sampled at scheduler switch
+   points; alloc_bytes counts small-object allocations. Totals are dumped to
+   stderr at shutdown when LEAN_TASK_STATS is set in the environment. */
+typedef struct lean_task_stats {
+    uint64_t num_finished;
+    uint64_t cpu_time_ns;
+    uint64_t alloc_bytes;
+} lean_task_stats;
+void lean_get_task_stats(lean_task_stats * s);
+
 /* External objects */
 
 static inline lean_object * lean_alloc_external(lean_external_class * cls, void * data) {
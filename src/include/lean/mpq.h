@@ -5,18 +5,87 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <climits>
 #include <lean/mpz.h>
 #include <lean/serializer.h>
 
 namespace lean {
 /**
    \brief Wrapper for GMP rationals
+
+   Rationals whose numerator and denominator fit in a machine word are handled
+   by inline fast paths: the canonicalization gcds are computed on words, the
+   overflow checks are single instructions, and GMP keeps word-sized values in
+   the limb storage already attached to the number, so no allocation happens.
+   Arithmetic falls back to the generic GMP routines only when an operand or an
+   intermediate product does not fit.
 */
 class mpq {
     friend class mpfp;
     mpq_t m_val;
     static mpz_t const & zval(mpz const & v) { return v.m_val; }
     static mpz_t & zval(mpz & v) { return v.m_val; }
+    static bool get_small(mpq_t const & v, long & n, long & d) {
+        if (mpz_fits_slong_p(mpq_numref(v)) && mpz_fits_slong_p(mpq_denref(v))) {
+            n = mpz_get_si(mpq_numref(v));
+            d = mpz_get_si(mpq_denref(v));
+            return true;
+        }
+        return false;
+    }
+    static long gcd_word(long a, long b) { while (b != 0) { long t = a % b; a = b; b = t; } return a < 0 ? -a : a; }
+    void set_small(long n, long d) { mpz_set_si(mpq_numref(m_val), n); mpz_set_si(mpq_denref(m_val), d); }
+    /* `*this <- *this + o` (or `- o` when `sub`) on word-sized components.
+       Since both operands are canonical, the result only needs to be reduced
+       by `gcd(num, gcd(d1, d2))`, so no full-size gcd is computed. Returns
+       false (leaving `*this` unchanged) when a component or an intermediate
+       product does not fit in a word. */
+    bool add_small(mpq const & o, bool sub) {
+#if defined(__GNUC__) || defined(__clang__)
+        long n1, d1, n2, d2;
+        if (!get_small(m_val, n1, d1) || !get_small(o.m_val, n2, d2))
+            return false;
+        if (sub) {
+            if (n2 == LONG_MIN) return false;
+            n2 = -n2;
+        }
+        long g   = gcd_word(d1, d2);
+        long d1g = d1 / g;
+        long d2g = d2 / g;
+        long t1, t2, num, den;
+        if (__builtin_mul_overflow(n1, d2g, &t1) ||
+            __builtin_mul_overflow(n2, d1g, &t2) ||
+            __builtin_add_overflow(t1, t2, &num) ||
+            __builtin_mul_overflow(d1g, d2, &den))
+            return false;
+        long g2 = g == 1 ? 1 : gcd_word(num % g, g);
+        set_small(num / g2, den / g2);
+        return true;
+#else
+        return false;
+#endif
+    }
+    /* `*this <- *this * o` on word-sized components; cross-reduces before
+       multiplying, so the result is canonical without a final gcd. */
+    bool mul_small(mpq const & o) {
+#if defined(__GNUC__) || defined(__clang__)
+        long n1, d1, n2, d2;
+        if (!get_small(m_val, n1, d1) || !get_small(o.m_val, n2, d2))
+            return false;
+        if (n1 == LONG_MIN || n2 == LONG_MIN)
+            return false;
+        long g1 = gcd_word(n1, d2);
+        long g2 = gcd_word(n2, d1);
+        long num, den;
+        if (__builtin_mul_overflow(n1 / g1, n2 / g2, &num) ||
+            __builtin_mul_overflow(d1 / g2, d2 / g1, &den))
+            return false;
+        set_small(num, den);
+        return true;
+#else
+        return false;
+#endif
+    }
 public:
     friend void swap(mpq & a, mpq & b) { mpq_swap(a.m_val, b.m_val); }
     friend void swap_numerator(mpq & a, mpz & b) { mpz_swap(mpq_numref(a.m_val), zval(b)); mpq_canonicalize(a.m_val); }
@@ -128,17 +197,42 @@ public:
     friend bool operator!=(unsigned int a, mpq const & b) { return !operator==(a, b); }
     friend bool operator!=(int a, mpq const & b) { return !operator==(a, b); }
 
-    mpq & operator+=(mpq const & o) { mpq_add(m_val, m_val, o.m_val); return *this; }
+    /* Non-normalizing arithmetic: the value is kept exact, but the fraction is
+       not reduced to lowest terms. Accumulation loops can chain these and pay
+       for a single gcd in a final `canonicalize` instead of one per step.
+       Until `canonicalize` is called, only these operations may be applied to
+       the value; everything else in this class assumes canonical form. */
+    void add_raw(mpq const & o) {
+        if (this == &o) { mpz_mul_si(mpq_numref(m_val), mpq_numref(m_val), 2); return; }
+        mpz_mul(mpq_numref(m_val), mpq_numref(m_val), mpq_denref(o.m_val));
+        mpz_addmul(mpq_numref(m_val), mpq_denref(m_val), mpq_numref(o.m_val));
+        mpz_mul(mpq_denref(m_val), mpq_denref(m_val), mpq_denref(o.m_val));
+    }
+    void sub_raw(mpq const & o) {
+        if (this == &o) { mpz_set_ui(mpq_numref(m_val), 0); mpz_set_ui(mpq_denref(m_val), 1); return; }
+        mpz_mul(mpq_numref(m_val), mpq_numref(m_val), mpq_denref(o.m_val));
+        mpz_submul(mpq_numref(m_val), mpq_denref(m_val), mpq_numref(o.m_val));
+        mpz_mul(mpq_denref(m_val), mpq_denref(m_val), mpq_denref(o.m_val));
+    }
+    void mul_raw(mpq const & o) {
+        mpz_mul(mpq_numref(m_val), mpq_numref(m_val), mpq_numref(o.m_val));
+        mpz_mul(mpq_denref(m_val), mpq_denref(m_val), mpq_denref(o.m_val));
+    }
+    /* Reduce to lowest terms; restores the invariant assumed by the rest of
+       the API after a chain of `*_raw` operations. */
+    void canonicalize() { mpq_canonicalize(m_val); }
+
+    mpq & operator+=(mpq const & o) { if (!add_small(o, false)) mpq_add(m_val, m_val, o.m_val); return *this; }
     mpq & operator+=(mpz const & o) { mpz_addmul(mpq_numref(m_val), mpq_denref(m_val), o.m_val); mpq_canonicalize(m_val); return *this; }
     mpq & operator+=(unsigned int k) { mpz_addmul_ui(mpq_numref(m_val), mpq_denref(m_val), k); mpq_canonicalize(m_val); return *this; }
     mpq & operator+=(int k) { if (k >= 0) return operator+=(static_cast<unsigned int>(k)); else return operator-=(static_cast<unsigned int>(-k)); }
 
-    mpq & operator-=(mpq const & o) { mpq_sub(m_val, m_val, o.m_val); return *this; }
+    mpq & operator-=(mpq const & o) { if (!add_small(o, true)) mpq_sub(m_val, m_val, o.m_val); return *this; }
     mpq & operator-=(mpz const & o) { mpz_submul(mpq_numref(m_val), mpq_denref(m_val), o.m_val); mpq_canonicalize(m_val); return *this; }
     mpq & operator-=(unsigned int k) { mpz_submul_ui(mpq_numref(m_val), mpq_denref(m_val), k); mpq_canonicalize(m_val); return *this; }
     mpq & operator-=(int k) { if (k >= 0) return operator-=(static_cast<unsigned int>(k)); else return operator+=(static_cast<unsigned int>(-k)); }
 
-    mpq & operator*=(mpq const & o) { mpq_mul(m_val, m_val, o.m_val); return *this; }
+    mpq & operator*=(mpq const & o) { if (!mul_small(o)) mpq_mul(m_val, m_val, o.m_val); return *this; }
     mpq & operator*=(mpz const & o) { mpz_mul(mpq_numref(m_val), mpq_numref(m_val), o.m_val); mpq_canonicalize(m_val); return *this; }
     mpq & operator*=(unsigned int k) { mpz_mul_ui(mpq_numref(m_val), mpq_numref(m_val), k); mpq_canonicalize(m_val); return *this; }
     mpq & operator*=(int k) { mpz_mul_si(mpq_numref(m_val), mpq_numref(m_val), k); mpq_canonicalize(m_val); return *this; }
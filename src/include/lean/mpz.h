@@ -14,6 +14,12 @@ Author: Leonardo de Moura
 #include <lean/debug.h>
 #include <lean/lean.h>
 
+/* Double-word (128-bit) fast paths are available when the compiler has a
+   128-bit integer type and GMP limbs carry 64 bits. */
+#if defined(__SIZEOF_INT128__) && defined(GMP_NUMB_BITS) && GMP_NUMB_BITS == 64
+#define LEAN_MPZ_U128
+#endif
+
 namespace lean {
 
 class mpq;
@@ -36,6 +42,37 @@ public:
         else
             return mpz((unsigned) v); // NOLINT
     }
+    /* Construct a non-negative value from \c n little-endian machine-word
+       limbs. Lets callers that gather bits word-wise build the value in a
+       single O(n) import instead of per-bit arithmetic. */
+    static mpz of_limbs(size_t n, mp_limb_t const * limbs) {
+        mpz r;
+        mpz_import(r.m_val, n, -1, sizeof(mp_limb_t), 0, 0, limbs);
+        return r;
+    }
+#ifdef LEAN_MPZ_U128
+    /* Build/read values below 2^128 by touching the limbs directly, bypassing
+       the generic GMP entry points. Used by the Nat mul/div fast paths. */
+    static mpz of_u128(uint64 hi, uint64 lo) {
+        mpz r;
+        _mpz_realloc(r.m_val, 2);
+        r.m_val->_mp_d[0] = lo;
+        if (hi != 0) {
+            r.m_val->_mp_d[1] = hi;
+            r.m_val->_mp_size = 2;
+        } else {
+            r.m_val->_mp_size = lo != 0 ? 1 : 0;
+        }
+        return r;
+    }
+    bool is_u128() const { return m_val->_mp_size >= 0 && m_val->_mp_size <= 2; }
+    void get_u128(uint64 & hi, uint64 & lo) const {
+        lean_assert(is_u128());
+        int sz = m_val->_mp_size;
+        lo = sz >= 1 ? m_val->_mp_d[0] : 0;
+        hi = sz == 2 ? m_val->_mp_d[1] : 0;
+    }
+#endif
     mpz(mpz const & s) { mpz_init_set(m_val, s.m_val); }
     mpz(mpz && s):mpz() { mpz_swap(m_val, s.m_val); }
     ~mpz() { mpz_clear(m_val); }
@@ -264,4 +301,9 @@ public:
 struct mpz_cmp_fn {
     int operator()(mpz const & v1, mpz const & v2) const { return cmp(v1, v2); }
 };
+
+/* Install mp_set_memory_functions hooks routing GMP limb storage through the
+   Lean allocator. Must run after initialize_alloc and before any GMP use. */
+void initialize_mpz();
+void finalize_mpz();
 }
@@ -48,6 +48,7 @@ inline bool is_heap_obj(object * o) { return is_st_heap_obj(o) || is_mt_heap_obj
 inline void mark_mt(object * o) { lean_mark_mt(o); }
 inline bool is_shared(object * o) { return lean_is_shared(o); }
 inline bool is_exclusive(object * o) { return lean_is_exclusive(o); }
+inline size_t rc_value(object * o) { return lean_rc_value(o); }
 inline void inc_ref(object * o) { lean_inc_ref(o); }
 inline void inc_ref(object * o, size_t n) { lean_inc_ref_n(o, n); }
 inline bool dec_ref_core(object * o) { return lean_dec_ref_core(o); }
@@ -275,6 +276,7 @@ inline bool string_eq(b_obj_arg s1, b_obj_arg s2) { return lean_string_eq(s1, s2
 bool string_eq(b_obj_arg s1, char const * s2);
 inline bool string_ne(b_obj_arg s1, b_obj_arg s2) { return lean_string_ne(s1, s2); }
 inline bool string_lt(b_obj_arg s1, b_obj_arg s2) { return lean_string_lt(s1, s2); }
+inline int string_cmp(b_obj_arg s1, b_obj_arg s2) { return lean_string_cmp(s1, s2); }
 inline uint8 string_dec_eq(b_obj_arg s1, b_obj_arg s2) { return string_eq(s1, s2); }
 inline uint8 string_dec_lt(b_obj_arg s1, b_obj_arg s2) { return string_lt(s1, s2); }
 inline usize string_hash(b_obj_arg s) { return lean_string_hash(s); }
@@ -19,6 +19,16 @@ namespace lean {
 class serializer {
     std::ostream & m_out;
     std::unordered_map<object*, unsigned, std::hash<object*>, std::equal_to<object*>> m_obj_table;
+    /* Content-based tables: ids of already emitted strings (keyed by their characters) and
+       constructors (keyed by tag + children, see `mk_cnstr_key`). They let us emit a
+       back-reference for an object that is structurally equal to an already serialized one
+       even when the two are distinct heap objects (e.g., duplicated `name` chains). */
+    std::unordered_map<std::string, unsigned> m_str_table;
+    std::unordered_map<std::string, unsigned> m_cnstr_table;
+    unsigned m_num_objs{0};
+    bool mk_cnstr_key(object * o, std::string & key);
+    optional<unsigned> find_shared_content(object * o);
+    void save_content(object * o, unsigned id);
     void write_constructor(object * o);
     void write_closure(object * o);
     void write_thunk(object * o);
@@ -32,7 +42,6 @@ public:
     ~serializer();
     void write_string(char const * str) { m_out.write(str, strlen(str) + 1); }
     void write_string(std::string const & str) { write_string(str.c_str()); }
-    void write_unsigned_short(unsigned short i);
     void write_unsigned(unsigned i);
     void write_uint64(uint64 i);
     void write_size_t(size_t i);
@@ -43,6 +52,16 @@ public:
     void write_mpz(mpz const & m);
     void write_object(object * o);
     void write_blob(std::string const &);
+    /* Reset the back-reference tables: subsequent objects are serialized without
+       references to anything emitted before this point. */
+    void reset_sharing();
+    /* Streaming interface: a stream is a count (`write_size_t`) followed by that many
+       elements written with this function. The back-reference tables are reset after
+       each element, so back references never cross element boundaries and a reader
+       using `deserializer::read_stream_elem` can drop its window after each element,
+       processing the stream in memory bounded by the largest element. The price is
+       that subterms shared across elements are serialized once per element. */
+    void write_stream_elem(object * o);
 };
 
 inline serializer & operator<<(serializer & s, char const * str) { s.write_string(str); return s; }
@@ -59,7 +78,6 @@ class deserializer {
     std::istream &        m_in;
     std::vector<object*>  m_objs;
     optional<std::string> m_fname;
-    unsigned read_unsigned_ext();
     object * read_constructor();
     object * read_closure();
     object * read_thunk();
@@ -74,19 +92,31 @@ public:
     ~deserializer();
     std::string read_string();
     unsigned read_unsigned() {
-        unsigned r = static_cast<unsigned>(m_in.get());
-        return r < 255 ? r : read_unsigned_ext();
+        /* LEB128, see `serializer::write_unsigned`. The shift bound also terminates the loop
+           on a truncated stream. */
+        unsigned r = 0;
+        for (unsigned shift = 0; shift < 32; shift += 7) {
+            unsigned char b = static_cast<unsigned char>(m_in.get());
+            r |= static_cast<unsigned>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) break;
+        }
+        return r;
     }
     uint64 read_uint64();
     size_t read_size_t();
     int read_int() { return read_unsigned(); }
     char read_char() { return m_in.get(); }
     bool read_bool() { return m_in.get() != 0; }
-    unsigned short read_unsigned_short();
     double read_double();
     mpz read_mpz();
     std::string read_blob();
     object * read_object();
+    /* Drop the back-reference window; objects read so far can be freed as soon as the
+       consumer releases them. */
+    void reset_sharing();
+    /* Read one element written by `serializer::write_stream_elem` and drop the
+       back-reference window. Returns an owned reference. */
+    object * read_stream_elem();
     optional<std::string> get_fname() const { return m_fname; }
 };
 
@@ -8,6 +8,16 @@ Author: Leonardo de Moura
 #include <cstdlib>
 
 namespace lean {
+/* Snapshot of the thread-local stack bounds consulted by `check_stack`; lets
+   code that temporarily switches the thread to a custom stack (see
+   runtime/big_stack.cpp) redirect the guard and restore it afterwards. */
+struct stack_info_snapshot {
+    bool   m_init;
+    size_t m_size;
+    size_t m_base;
+    size_t m_threshold;
+};
+
 #if defined(LEAN_USE_SPLIT_STACK)
 // If we are using split stacks, we don't need to check anything
 inline void check_stack(char const * ) { }
@@ -15,6 +25,9 @@ inline size_t get_stack_size(bool ) { return 8192*1024; }
 inline void save_stack_info(bool = true) {}
 inline size_t get_used_stack_size() { return 0; }
 inline size_t get_available_stack_size() { return 8192*1024; }
+inline stack_info_snapshot get_stack_info() { return stack_info_snapshot(); }
+inline void set_stack_info(stack_info_snapshot const &) {}
+inline void set_custom_stack_info(size_t) {}
 #else
 size_t get_stack_size(bool main);
 void save_stack_info(bool main = true);
@@ -27,5 +40,10 @@ size_t get_available_stack_size();
    user which module is the potential offender.
 */
 void check_stack(char const * component_name);
+stack_info_snapshot get_stack_info();
+void set_stack_info(stack_info_snapshot const & info);
+/** \brief Point the stack guard at a custom stack of `stack_size` bytes whose
+    top is approximately the current stack pointer. */
+void set_custom_stack_info(size_t stack_size);
 #endif
 }
@@ -21,7 +21,14 @@ namespace chrono = std::chrono;
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <memory>
 #include <condition_variable>
+#ifdef LEAN_LOCK_STATS
+#include <iostream>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #define LEAN_THREAD_LOCAL thread_local
 
 namespace lean {
@@ -48,11 +55,16 @@ using std::memory_order_seq_cst;
 using std::atomic_thread_fence;
 namespace this_thread = std::this_thread;
 inline unsigned hardware_concurrency() { return std::thread::hardware_concurrency(); }
+struct pool_job;
 /** Simple thread class that allows us to set the thread stack size.
-    We implement it using pthreads on OSX/Linux and WinThreads on Windows. */
+    We implement it using pthreads on OSX/Linux and WinThreads on Windows.
+    The procedure is handed to a parked pool thread when one is available,
+    so repeated spawns reuse stacks and thread-local heaps; `join` waits for
+    the procedure to finish, not for the underlying OS thread to exit. */
 class lthread {
     static size_t m_thread_stack_size;
     struct imp;
+    std::shared_ptr<pool_job> m_job;
     std::unique_ptr<imp> m_imp;
 public:
     lthread(std::function<void(void)> const & p);
@@ -61,6 +73,69 @@ public:
     static void set_thread_stack_size(size_t sz);
     static size_t get_thread_stack_size();
 };
+
+inline void cpu_relax() {
+#if defined(_MSC_VER)
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+#ifdef LEAN_LOCK_STATS
+#define LEAN_LOCK_STAT(S) (S).fetch_add(1, std::memory_order_relaxed);
+#else
+#define LEAN_LOCK_STAT(S)
+#endif
+
+/* Mutex for short runtime-internal critical sections (free lists, orphan
+   segment lists). Tries a bounded exponential spin with pause instructions
+   before parking on the underlying mutex, avoiding the futex round trip when
+   the holder leaves the section quickly. Do not use it for locks held across
+   blocking operations or paired with condition variables. With
+   LEAN_LOCK_STATS, each named lock reports at exit how many acquisitions were
+   uncontended, satisfied by spinning, or had to park. */
+class adaptive_mutex {
+    std::mutex            m_mutex;
+#ifdef LEAN_LOCK_STATS
+    char const *          m_name;
+    std::atomic<uint64_t> m_fast{0};
+    std::atomic<uint64_t> m_spin{0};
+    std::atomic<uint64_t> m_park{0};
+#endif
+public:
+#ifdef LEAN_LOCK_STATS
+    explicit adaptive_mutex(char const * name = nullptr):m_name(name) {}
+    ~adaptive_mutex() {
+        if (m_name)
+            std::cerr << "lock " << m_name << ": fast " << m_fast << ", spin " << m_spin << ", park " << m_park << "\n";
+    }
+#else
+    explicit adaptive_mutex(char const * = nullptr) {}
+#endif
+    adaptive_mutex(adaptive_mutex const &) = delete;
+    adaptive_mutex & operator=(adaptive_mutex const &) = delete;
+    void lock() {
+        if (m_mutex.try_lock()) {
+            LEAN_LOCK_STAT(m_fast);
+            return;
+        }
+        for (unsigned spins = 1; spins <= 64; spins *= 2) {
+            for (unsigned i = 0; i < spins; i++)
+                cpu_relax();
+            if (m_mutex.try_lock()) {
+                LEAN_LOCK_STAT(m_spin);
+                return;
+            }
+        }
+        LEAN_LOCK_STAT(m_park);
+        m_mutex.lock();
+    }
+    bool try_lock() { return m_mutex.try_lock(); }
+    void unlock() { m_mutex.unlock(); }
+};
 }
 
 #else
@@ -101,8 +176,16 @@ public:
     friend T atomic_load_explicit(atomic const * a, int) { return a->m_value; }
     friend T atomic_fetch_add_explicit(atomic * a, T const & v, int ) { T r(a->m_value); a->m_value += v; return r; }
     friend T atomic_fetch_sub_explicit(atomic * a, T const & v, int ) { T r(a->m_value); a->m_value -= v; return r; }
+    void store(T const & v, int ) { m_value = v; }
+    T load(int ) const { return m_value; }
     T exchange(T desired) { T old = m_value; m_value = desired; return old; }
-    bool compare_exchange_strong(T & expected, T desired) {
+    T exchange(T desired, int ) { return exchange(desired); }
+    T fetch_add(T const & v, int = 0) { T r(m_value); m_value += v; return r; }
+    T fetch_sub(T const & v, int = 0) { T r(m_value); m_value -= v; return r; }
+    bool compare_exchange_weak(T & expected, T desired, int = 0, int = 0) {
+        return compare_exchange_strong(expected, desired);
+    }
+    bool compare_exchange_strong(T & expected, T desired, int = 0, int = 0) {
         if (m_value == expected) {
             m_value = desired;
             return true;
@@ -146,6 +229,13 @@ public:
     void lock() {}
     void unlock() {}
 };
+class adaptive_mutex {
+public:
+    explicit adaptive_mutex(char const * = nullptr) {}
+    void lock() {}
+    bool try_lock() { return true; }
+    void unlock() {}
+};
 class recursive_mutex {
 public:
     void lock() {}
@@ -180,11 +270,21 @@ inline unsigned hardware_concurrency() { return 1; }
 #define LEAN_THREAD_EXTERN_PTR(T, V) extern __declspec(thread) T * V
 #define LEAN_THREAD_GLOBAL_PTR(T, V) __declspec(thread) T * V = nullptr
 #define LEAN_THREAD_VALUE(T, V, VAL) static __declspec(thread) T V = VAL
+#define LEAN_TLS_INITIAL_EXEC
 #else
 #define LEAN_THREAD_PTR(T, V) static __thread T * V = nullptr
 #define LEAN_THREAD_EXTERN_PTR(T, V) extern __thread T * V
 #define LEAN_THREAD_GLOBAL_PTR(T, V) __thread T * V = nullptr
 #define LEAN_THREAD_VALUE(T, V, VAL) static __thread T V = VAL
+#if defined(__ELF__)
+/* The runtime's TLS lives in the executable or in libleanshared, both mapped
+   at process startup, so the initial-exec model applies: accesses become one
+   addition to a thread-pointer-relative offset instead of a __tls_get_addr
+   call. Plugins merely reference this TLS; they do not define it. */
+#define LEAN_TLS_INITIAL_EXEC __attribute__((tls_model("initial-exec")))
+#else
+#define LEAN_TLS_INITIAL_EXEC
+#endif
 #endif
 
 #define MK_THREAD_LOCAL_GET(T, GETTER_NAME, DEF_VALUE)                  \
@@ -216,6 +316,45 @@ static T & GETTER_NAME() {                                              \
 }
 
 namespace lean {
+class heartbeat_token;
+class cancel_token;
+
+/** \brief Consolidated per-thread runtime context.
+
+    The hot thread-local state polled at every safepoint and on the allocation
+    path used to be scattered over per-module `LEAN_THREAD_VALUE` variables,
+    each with its own TLS address computation. Gathering them into one
+    zero-initialized (hence trivially constructed, no dynamic-init guard)
+    block reached through a single thread-local symbol with the initial-exec
+    model keeps the whole context on one or two cache lines and makes each
+    access a plain thread-pointer-relative load.
+
+    Pointers owned by specific modules (`m_heap`, `m_current_task`) are stored
+    untyped; the owning translation unit casts them back. */
+struct thread_ctx {
+    /* heartbeat/budget cluster, read by check_system */
+    size_t            m_heartbeat;
+    size_t            m_heartbeat_flushed;
+    size_t            m_max_heartbeat;
+    heartbeat_token * m_heartbeat_token;
+    cancel_token *    m_cancel_token;
+    atomic_bool *     m_interrupt_flag;
+    /* check_memory sampling counter (see runtime/memory.cpp) */
+    size_t            m_memory_counter;
+    /* `heap *` of the small-object allocator (see runtime/alloc.cpp) */
+    void *            m_heap;
+    /* `lean_task_object *` being executed by this worker (see runtime/object.cpp) */
+    void *            m_current_task;
+};
+
+#ifdef _MSC_VER
+extern __declspec(thread) thread_ctx g_thread_ctx;
+#else
+extern __thread thread_ctx g_thread_ctx LEAN_TLS_INITIAL_EXEC;
+#endif
+
+inline thread_ctx & get_thread_ctx() { return g_thread_ctx; }
+
 void initialize_thread();
 void finalize_thread();
 
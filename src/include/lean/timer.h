@@ -0,0 +1,32 @@
+/*
+Copyright (c) 2019 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <lean/thread.h>
+#include <lean/interrupt.h>
+
+namespace lean {
+/* Hashed timer wheel: arm tens of thousands of deadlines with O(1)
+   insert/disarm and a single watcher thread (started lazily on first use).
+   Expiry is quantized to LEAN_TIMER_TICK_MS; a fired deadline cancels its
+   `cancel_token`, so an expired elaboration request stops consuming workers
+   as soon as its tasks poll for cancellation. */
+struct timer_event;
+
+/** \brief Arm a deadline: \c tk is cancelled after (approximately) \c ms
+    milliseconds unless the event is disarmed first. Retains a reference to
+    \c tk; the returned handle is owned by the caller and must be released
+    with \c release_timer. Returns nullptr without multi-threading support. */
+timer_event * set_timer(cancel_token * tk, unsigned ms);
+/** \brief Disarm \c e if it has not fired yet (O(1)). The handle stays valid;
+    the caller still owns its reference. */
+void cancel_timer(timer_event * e);
+/** \brief Drop the caller's reference to \c e. */
+void release_timer(timer_event * e);
+
+void initialize_timer();
+void finalize_timer();
+}
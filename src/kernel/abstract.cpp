@@ -7,14 +7,40 @@ Author: Leonardo de Moura
 #include <algorithm>
 #include <utility>
 #include <vector>
+#include "util/name_hash_map.h"
 #include "kernel/abstract.h"
 #include "kernel/replace_fn.h"
 
+/* Number of abstracted free variables from which fvar occurrences are resolved
+   through a name -> index table instead of a linear scan over `subst`. The scan
+   makes closing a term over an n-entry local context quadratic in n. */
+#ifndef LEAN_ABSTRACT_MAP_THRESHOLD
+#define LEAN_ABSTRACT_MAP_THRESHOLD 16
+#endif
+
 namespace lean {
 expr abstract(expr const & e, unsigned n, expr const * subst) {
     lean_assert(std::all_of(subst, subst+n, [](expr const & e) { return !has_loose_bvars(e) && is_fvar(e); }));
     if (!has_fvar(e))
         return e;
+    if (n >= LEAN_ABSTRACT_MAP_THRESHOLD) {
+        name_hash_map<unsigned> fvar2idx;
+        fvar2idx.reserve(n);
+        /* Entries with a higher index overwrite earlier ones, matching the
+           backward scan below. */
+        for (unsigned i = 0; i < n; i++)
+            fvar2idx[fvar_name(subst[i])] = i;
+        return replace(e, [&](expr const & m, unsigned offset) -> optional<expr> {
+                if (!has_fvar(m))
+                    return some_expr(m); // expression m does not contain free variables
+                if (is_fvar(m)) {
+                    auto it = fvar2idx.find(fvar_name(m));
+                    if (it != fvar2idx.end())
+                        return some_expr(mk_bvar(offset + n - it->second - 1));
+                }
+                return none_expr();
+            });
+    }
     return replace(e, [=](expr const & m, unsigned offset) -> optional<expr> {
             if (!has_fvar(m))
                 return some_expr(m); // expression m does not contain free variables
@@ -43,6 +69,26 @@ static object * lean_expr_abstract_core(object * e0, size_t n, object * subst) {
         lean_inc(e0);
         return e0;
     }
+    if (n >= LEAN_ABSTRACT_MAP_THRESHOLD) {
+        name_hash_map<size_t> fvar2idx;
+        fvar2idx.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            object * v = lean_array_get_core(subst, i);
+            if (is_fvar_core(v))
+                fvar2idx[fvar_name_core(v)] = i;
+        }
+        expr r = replace(e, [&](expr const & m, unsigned offset) -> optional<expr> {
+                if (!has_fvar(m))
+                    return some_expr(m); // expression m does not contain free variables
+                if (is_fvar(m)) {
+                    auto it = fvar2idx.find(fvar_name(m));
+                    if (it != fvar2idx.end())
+                        return some_expr(mk_bvar(offset + n - it->second - 1));
+                }
+                return none_expr();
+            });
+        return r.steal();
+    }
     expr r = replace(e, [=](expr const & m, unsigned offset) -> optional<expr> {
             if (!has_fvar(m))
                 return some_expr(m); // expression m does not contain free variables
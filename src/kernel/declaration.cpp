@@ -191,6 +191,10 @@ static unsigned get_max_height(environment const & env, expr const & v) {
     return h;
 }
 
+unsigned get_definitional_height(environment const & env, expr const & v) {
+    return get_max_height(env, v) + 1;
+}
+
 definition_val mk_definition_val(environment const & env, name const & n, names const & params, expr const & t, expr const & v, definition_safety s) {
     unsigned h = get_max_height(env, v);
     return definition_val(n, params, t, v, reducibility_hints::mk_regular(h+1), s);
@@ -206,6 +210,11 @@ declaration mk_definition(environment const & env, name const & n, names const &
     return declaration(mk_cnstr(static_cast<unsigned>(declaration_kind::Definition), mk_definition_val(env, n, params, t, v, safety)));
 }
 
+declaration update_definition_hints(declaration const & d, reducibility_hints const & hints) {
+    definition_val const & v = d.to_definition_val();
+    return mk_definition(v.get_name(), v.get_lparams(), v.get_type(), v.get_value(), hints, v.get_safety());
+}
+
 declaration mk_opaque(name const & n, names const & params, expr const & t, expr const & v, bool is_unsafe) {
     return declaration(mk_cnstr(static_cast<unsigned>(declaration_kind::Opaque), opaque_val(n, params, t, v, is_unsafe)));
 }
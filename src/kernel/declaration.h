@@ -230,6 +230,16 @@ declaration mk_opaque(name const & n, names const & lparams, expr const & t, exp
 declaration mk_axiom(name const & n, names const & lparams, expr const & t, bool unsafe = false);
 declaration mk_inductive_decl(names const & lparams, nat const & nparams, inductive_types const & types, bool is_unsafe);
 
+/** \brief Return the definitional height of a definition with value \c v in \c env:
+    1 + the maximum height among the (regular) definitions referenced by \c v.
+    The convertibility checker unfolds the definition with the bigger height first,
+    so heights must reflect the environment the definition is added to. */
+unsigned get_definitional_height(environment const & env, expr const & v);
+
+/** \brief Return \c d with its reducibility hints replaced by \c hints.
+    \pre d.is_definition() */
+declaration update_definition_hints(declaration const & d, reducibility_hints const & hints);
+
 /** \brief Similar to mk_definition but infer the value of unsafe flag.
     That is, set it to true if \c t or \c v contains a unsafe declaration. */
 declaration mk_definition_inferring_unsafe(environment const & env, name const & n, names const & lparams,
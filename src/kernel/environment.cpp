@@ -6,9 +6,13 @@ Author: Leonardo de Moura
 */
 #include <utility>
 #include <vector>
+#include <memory>
 #include <limits>
+#include <algorithm>
 #include <lean/sstream.h>
 #include <lean/thread.h>
+#include <lean/object.h>
+#include <lean/big_stack.h>
 #include "util/map_foreach.h"
 #include "util/io.h"
 #include "kernel/environment.h"
@@ -111,6 +115,7 @@ void environment::check_duplicated_univ_params(names ls) const {
 }
 
 static void check_constant_val(environment const & env, constant_val const & v, type_checker & checker) {
+    checker.set_decl(v.get_name());
     check_name(env, v.get_name());
     check_duplicated_univ_params(env, v.get_lparams());
     check_no_metavar_no_fvar(env, v.get_name(), v.get_type());
@@ -138,7 +143,19 @@ environment environment::add_axiom(declaration const & d, bool check) const {
     return add(constant_info(d));
 }
 
-environment environment::add_definition(declaration const & d, bool check) const {
+environment environment::add_definition(declaration const & d0, bool check) const {
+    declaration d = d0;
+    /* The convertibility checker uses the definitional height to decide which
+       side to unfold first, so heights must be computed against the
+       environment the definition is added to rather than trusted from the
+       front end; stale heights cause pathological double-unfolding on deep
+       definition chains. Opaque/abbreviation hints are explicit user choices
+       and are kept as is. */
+    if (d0.to_definition_val().get_hints().is_regular()) {
+        unsigned h = get_definitional_height(*this, d0.to_definition_val().get_value());
+        if (d0.to_definition_val().get_hints().get_height() != h)
+            d = update_definition_hints(d0, reducibility_hints::mk_regular(h));
+    }
     definition_val const & v = d.to_definition_val();
     if (v.is_unsafe()) {
         /* Meta definition can be recursive.
@@ -152,6 +169,7 @@ environment environment::add_definition(declaration const & d, bool check) const
         if (check) {
             bool safe_only = false;
             type_checker checker(new_env, safe_only);
+            checker.set_decl(v.get_name());
             check_no_metavar_no_fvar(new_env, v.get_name(), v.get_value());
             expr val_type = checker.check(v.get_value(), v.get_lparams());
             if (!checker.is_def_eq(val_type, v.get_type()))
@@ -223,6 +241,7 @@ environment environment::add_mutual(declaration const & d, bool check) const {
     if (check) {
         type_checker checker(new_env, safe_only);
         for (definition_val const & v : vs) {
+            checker.set_decl(v.get_name());
             check_no_metavar_no_fvar(new_env, v.get_name(), v.get_value());
             expr val_type = checker.check(v.get_value(), v.get_lparams());
             if (!checker.is_def_eq(val_type, v.get_type()))
@@ -233,24 +252,198 @@ environment environment::add_mutual(declaration const & d, bool check) const {
 }
 
 environment environment::add(declaration const & d, bool check) const {
+    optional<environment> new_env;
     switch (d.kind()) {
-    case declaration_kind::Axiom:            return add_axiom(d, check);
-    case declaration_kind::Definition:       return add_definition(d, check);
-    case declaration_kind::Theorem:          return add_theorem(d, check);
-    case declaration_kind::Opaque:           return add_opaque(d, check);
-    case declaration_kind::MutualDefinition: return add_mutual(d, check);
-    case declaration_kind::Quot:             return add_quot();
-    case declaration_kind::Inductive:        return add_inductive(d);
+    case declaration_kind::Axiom:            new_env = add_axiom(d, check); break;
+    case declaration_kind::Definition:       new_env = add_definition(d, check); break;
+    case declaration_kind::Theorem:          new_env = add_theorem(d, check); break;
+    case declaration_kind::Opaque:           new_env = add_opaque(d, check); break;
+    case declaration_kind::MutualDefinition: new_env = add_mutual(d, check); break;
+    case declaration_kind::Quot:             new_env = add_quot(); break;
+    case declaration_kind::Inductive:        new_env = add_inductive(d); break;
     }
-    lean_unreachable();
+    if (!new_env) lean_unreachable();
+    mark_kernel_cache_extension(*this, *new_env);
+    return *new_env;
 }
 
 extern "C" object * lean_add_decl(object * env, object * decl) {
     return catch_kernel_exceptions<environment>([&]() {
-            return environment(env).add(declaration(decl, true));
+            environment e(env);
+            declaration d(decl, true);
+            try {
+                return e.add(d);
+            } catch (stack_space_exception &) {
+                /* Machine-generated terms can out-recurse any fixed thread
+                   stack. Nothing has been added to the environment when the
+                   checker runs out of stack, so retry the whole addition on a
+                   heap-allocated stack bounded by memory instead. */
+                optional<environment> r;
+                run_with_big_stack([&]() { r = e.add(d); });
+                return *r;
+            }
         });
 }
 
+/* Type check \c d against \c env without extending it. Only valid for declaration
+   kinds whose checking does not need the declared constant itself in the
+   environment: axioms, theorems, opaque constants, and safe definitions. */
+static void check_declaration(environment const & env, declaration const & d) {
+    switch (d.kind()) {
+    case declaration_kind::Axiom:
+        check_constant_val(env, d.to_axiom_val().to_constant_val(), !d.is_unsafe());
+        break;
+    case declaration_kind::Definition: {
+        definition_val const & v = d.to_definition_val();
+        lean_assert(!v.is_unsafe());
+        type_checker checker(env);
+        check_constant_val(env, v.to_constant_val(), checker);
+        check_no_metavar_no_fvar(env, v.get_name(), v.get_value());
+        expr val_type = checker.check(v.get_value(), v.get_lparams());
+        if (!checker.is_def_eq(val_type, v.get_type()))
+            throw definition_type_mismatch_exception(env, d, val_type);
+        break;
+    }
+    case declaration_kind::Theorem: {
+        theorem_val const & v = d.to_theorem_val();
+        type_checker checker(env);
+        check_constant_val(env, v.to_constant_val(), checker);
+        check_no_metavar_no_fvar(env, v.get_name(), v.get_value());
+        expr val_type = checker.check(v.get_value(), v.get_lparams());
+        if (!checker.is_def_eq(val_type, v.get_type()))
+            throw definition_type_mismatch_exception(env, d, val_type);
+        break;
+    }
+    case declaration_kind::Opaque: {
+        opaque_val const & v = d.to_opaque_val();
+        type_checker checker(env);
+        check_constant_val(env, v.to_constant_val(), checker);
+        expr val_type = checker.check(v.get_value(), v.get_lparams());
+        if (!checker.is_def_eq(val_type, v.get_type()))
+            throw definition_type_mismatch_exception(env, d, val_type);
+        break;
+    }
+    default:
+        lean_unreachable();
+    }
+}
+
+/* Return true iff \c d can be checked by \c check_declaration, i.e., against the
+   environment it is added to instead of the one that results from adding it. */
+static bool is_par_checkable(declaration const & d) {
+    switch (d.kind()) {
+    case declaration_kind::Axiom: case declaration_kind::Theorem:
+    case declaration_kind::Opaque:
+        return true;
+    case declaration_kind::Definition:
+        /* Unsafe definitions may be recursive and must see themselves. */
+        return !d.is_unsafe();
+    default:
+        return false;
+    }
+}
+
+#if defined(LEAN_MULTI_THREAD)
+/* Check declaration \c decls[i] against environment \c envs[i] for every \c i,
+   using up to hardware_concurrency() worker threads. If several declarations
+   fail, the exception for the one with the smallest index is rethrown, so the
+   reported error matches the one produced by a sequential `add` loop. */
+static void check_in_parallel(std::vector<environment> const & envs, std::vector<declaration> const & decls) {
+    unsigned n           = decls.size();
+    unsigned num_workers = std::min(hardware_concurrency(), n);
+    if (n == 1 || num_workers < 2) {
+        for (unsigned i = 0; i < n; i++)
+            check_declaration(envs[i], decls[i]);
+        return;
+    }
+    /* The environments and declarations are shared with the worker threads. */
+    for (unsigned i = 0; i < n; i++) {
+        mark_mt(envs[i].raw());
+        mark_mt(decls[i].raw());
+    }
+    std::vector<std::exception_ptr> errors(n);
+    atomic<unsigned> next(0);
+    std::vector<std::unique_ptr<lthread>> workers;
+    for (unsigned w = 0; w < num_workers; w++) {
+        workers.push_back(std::unique_ptr<lthread>(new lthread([&]() {
+                while (true) {
+                    unsigned i = next.fetch_add(1);
+                    if (i >= n)
+                        return;
+                    try {
+                        check_declaration(envs[i], decls[i]);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                }
+            })));
+    }
+    for (std::unique_ptr<lthread> const & w : workers)
+        w->join();
+    for (unsigned i = 0; i < n; i++) {
+        if (errors[i])
+            std::rethrow_exception(errors[i]);
+    }
+}
+#endif
+
+environment environment::add_all(buffer<declaration> const & ds, bool check) const {
+    environment cur = *this;
+#if defined(LEAN_MULTI_THREAD)
+    if (check && hardware_concurrency() >= 2 && ds.size() >= 2) {
+        /* Commit each checkable declaration without checking it, remember the
+           environment it was committed against, and run the deferred checks in
+           parallel. This is sound because such a declaration is checked against
+           an environment that does not contain it, exactly as in `add`. */
+        std::vector<environment> pre_envs;
+        std::vector<declaration> pending;
+        auto flush = [&]() {
+            if (pending.empty())
+                return;
+            check_in_parallel(pre_envs, pending);
+            pre_envs.clear();
+            pending.clear();
+        };
+        for (declaration const & d : ds) {
+            if (is_par_checkable(d)) {
+                pre_envs.push_back(cur);
+                pending.push_back(d);
+                cur = cur.add(d, false);
+            } else {
+                /* Inductive types, mutual/unsafe definitions and quot need their
+                   own constants in the environment while being checked; they act
+                   as sequential barriers. Flush first so that an earlier failure
+                   takes precedence over one produced by the barrier. */
+                flush();
+                cur = cur.add(d, true);
+            }
+        }
+        flush();
+        return cur;
+    }
+#endif
+    for (declaration const & d : ds)
+        cur = cur.add(d, check);
+    return cur;
+}
+
+extern "C" object * lean_add_decls(object * env, object * decls) {
+    return catch_kernel_exceptions<environment>([&]() {
+            buffer<declaration> ds;
+            to_buffer(list_ref<declaration>(decls, true), ds);
+            return environment(env).add_all(ds);
+        });
+}
+
+void environment::freeze() const {
+    mark_persistent(raw());
+}
+
+extern "C" obj_res lean_environment_freeze(obj_arg env) {
+    mark_persistent(env);
+    return env;
+}
+
 void environment::for_each_constant(std::function<void(constant_info const & d)> const & f) const {
     smap_foreach(cnstr_get(raw(), 1), [&](object *, object * v) {
             constant_info cinfo(v, true);
@@ -74,9 +74,31 @@ public:
     /** \brief Extends the current environment with the given declaration */
     environment add(declaration const & d, bool check = true) const;
 
+    /** \brief Extends the current environment with all declarations in \c ds.
+        The declarations must be given in dependency order. The resulting environment
+        (and, on failure, the reported exception) is the same as adding the
+        declarations one by one with \c add, but in multi-threaded builds the
+        declarations are type checked in parallel whenever possible. */
+    environment add_all(buffer<declaration> const & ds, bool check = true) const;
+
     /** \brief Apply the function \c f to each constant */
     void for_each_constant(std::function<void(constant_info const & d)> const & f) const;
 
+    /** \brief Freeze this environment for concurrent read-only sharing.
+
+        Marks every reference-counted object reachable from it persistent, so
+        readers perform no reference counting at all on access — not even the
+        atomic operations paid after a `mark_mt` sweep — and copying the handle
+        itself becomes free. Objects backed by the compacted regions of
+        imported modules are already outside reference counting and terminate
+        the sweep, so the cost is proportional to the declarations added on
+        top of the imports.
+
+        Freezing is irreversible: the frozen graph is only reclaimed when the
+        process exits. It is meant for a long-lived environment served to many
+        reader threads, not for short-lived intermediate ones. */
+    void freeze() const;
+
     /** \brief Pointer equality */
     friend bool is_eqp(environment const & e1, environment const & e2) {
         return e1.raw() == e2.raw();
@@ -23,7 +23,10 @@ auto equiv_manager::find(node_ref n) -> node_ref {
         node_ref p = m_nodes[n].m_parent;
         if (p == n)
             return p;
-        n = p;
+        /* path halving: point `n` at its grandparent as we walk up */
+        node_ref g = m_nodes[p].m_parent;
+        m_nodes[n].m_parent = g;
+        n = g;
     }
 }
 
@@ -44,13 +47,48 @@ void equiv_manager::merge(node_ref n1, node_ref n2) {
     }
 }
 
+static unsigned equiv_hash_ptr(expr const & e) {
+    return static_cast<unsigned>(reinterpret_cast<uintptr_t>(e.raw()) >> 4);
+}
+
+void equiv_manager::grow_index() {
+    std::vector<index_entry> new_index(m_index.size() * 2);
+    unsigned mask = new_index.size() - 1;
+    for (index_entry & en : m_index) {
+        if (en.m_key && en.m_gen == m_gen) {
+            unsigned i = equiv_hash_ptr(*en.m_key) & mask;
+            while (new_index[i].m_key)
+                i = (i + 1) & mask;
+            new_index[i] = std::move(en);
+        }
+    }
+    m_index.swap(new_index);
+}
+
 auto equiv_manager::to_node(expr const & e) -> node_ref {
-    auto it = m_to_node.find(e);
-    if (it != m_to_node.end())
-        return it->second;
-    node_ref r = mk_node();
-    m_to_node.insert(mk_pair(e, r));
-    return r;
+    if (m_index_size >= m_index.size() / 2)
+        grow_index();
+    unsigned mask = m_index.size() - 1;
+    unsigned i    = equiv_hash_ptr(e) & mask;
+    while (true) {
+        index_entry & en = m_index[i];
+        if (!en.m_key || en.m_gen != m_gen) {
+            en.m_key  = e;
+            en.m_node = mk_node();
+            en.m_gen  = m_gen;
+            m_index_size++;
+            return en.m_node;
+        }
+        if (is_eqp(*en.m_key, e))
+            return en.m_node;
+        i = (i + 1) & mask;
+    }
+}
+
+void equiv_manager::reset() {
+    m_gen++;
+    m_index_size = 0;
+    m_nodes.clear();
 }
 
 bool equiv_manager::is_equiv_core(expr const & a, expr const & b) {
@@ -6,7 +6,7 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <vector>
-#include "kernel/expr_maps.h"
+#include "kernel/expr.h"
 
 namespace lean {
 class equiv_manager {
@@ -17,18 +17,33 @@ class equiv_manager {
         unsigned m_rank;
     };
 
-    std::vector<node>  m_nodes;
-    expr_map<node_ref> m_to_node;
-    bool               m_use_hash;
+    /* Pointer-keyed open-addressing index from expressions to union-find
+       nodes. Entries carry a generation stamp, so `reset` invalidates the
+       index (and thereby all recorded equivalences) in O(1); stale entries
+       act as free slots and are reclaimed as they are overwritten. */
+    struct index_entry {
+        optional<expr> m_key;
+        node_ref       m_node;
+        uint64_t       m_gen{0};
+    };
+
+    std::vector<node>        m_nodes;
+    std::vector<index_entry> m_index;
+    unsigned                 m_index_size{0};
+    uint64_t                 m_gen{1};
+    bool                     m_use_hash;
 
     node_ref mk_node();
     node_ref find(node_ref n);
     void merge(node_ref n1, node_ref n2);
     node_ref to_node(expr const & e);
+    void grow_index();
     bool is_equiv_core(expr const & e1, expr const & e2);
 public:
-    equiv_manager():m_use_hash(false) {}
+    equiv_manager():m_index(1024), m_use_hash(false) {}
     bool is_equiv(expr const & e1, expr const & e2, bool use_hash = false);
     void add_equiv(expr const & e1, expr const & e2);
+    /* Forget every recorded equivalence in O(1). */
+    void reset();
 };
 }
@@ -11,6 +11,8 @@ Author: Leonardo de Moura
 #include <algorithm>
 #include <limits>
 #include <lean/hash.h>
+#include <lean/io.h>
+#include <lean/serializer.h>
 #include "util/list_fn.h"
 #include "util/buffer.h"
 #include "kernel/expr.h"
@@ -72,29 +74,127 @@ bool is_atomic(expr const & e) {
     lean_unreachable(); // LCOV_EXCL_LINE
 }
 
-extern "C" uint8 lean_expr_binder_info(object * e);
-binder_info binding_info(expr const & e) { return static_cast<binder_info>(lean_expr_binder_info(e.to_obj_arg())); }
+/* See the `Expr.Data` layout comment next to `expr_data` in expr.h. */
+binder_info binding_info(expr const & e) { return static_cast<binder_info>((expr_data(e) >> 37) & 7); }
 
 extern "C" object * lean_lit_type(obj_arg e);
 expr lit_type(literal const & lit) { return expr(lean_lit_type(lit.to_obj_arg())); }
 
-extern "C" uint64_t lean_expr_hash(obj_arg e);
-unsigned hash(expr const & e) { return lean_expr_hash(e.to_obj_arg()); }
+// =======================================
+// Hash consing
+
+/* Content-addressed table over constructor arguments. Freshly built nodes are
+   canonicalized after construction: children are compared by pointer, so a
+   term built bottom-up through an active scope collapses structurally
+   identical subterms into one node (the transient duplicate is freed by its
+   reference count immediately). Open addressing with linear probing. */
+class expr_hash_cons_table {
+    std::vector<optional<expr>> m_entries;
+    unsigned                    m_size{0};
+
+    static unsigned ptr_hash(object * o) {
+        return static_cast<unsigned>(reinterpret_cast<uintptr_t>(o) >> 4);
+    }
+
+    /* Shallow hash over the constructor arguments of `e`. */
+    static unsigned hc_hash(expr const & e) {
+        unsigned k = static_cast<unsigned>(e.kind());
+        switch (e.kind()) {
+        case expr_kind::App:
+            return hash(k, hash(ptr_hash(app_fn(e).raw()), ptr_hash(app_arg(e).raw())));
+        case expr_kind::Lambda: case expr_kind::Pi:
+            return hash(hash(k, binding_name(e).hash()),
+                        hash(ptr_hash(binding_domain(e).raw()), ptr_hash(binding_body(e).raw())));
+        case expr_kind::Let:
+            return hash(hash(k, ptr_hash(let_type(e).raw())),
+                        hash(ptr_hash(let_value(e).raw()), ptr_hash(let_body(e).raw())));
+        case expr_kind::Sort:
+            return hash(k, sort_level(e).hash());
+        case expr_kind::Const:
+            return hash(k, const_name(e).hash());
+        case expr_kind::Proj:
+            return hash(hash(k, proj_sname(e).hash()),
+                        hash(proj_idx(e).hash(), ptr_hash(proj_expr(e).raw())));
+        default:
+            lean_unreachable();
+        }
+    }
+
+    /* Shallow equality over the constructor arguments: children by pointer,
+       scalars and names structurally. */
+    static bool hc_equal(expr const & a, expr const & b) {
+        if (a.kind() != b.kind()) return false;
+        switch (a.kind()) {
+        case expr_kind::App:
+            return is_eqp(app_fn(a), app_fn(b)) && is_eqp(app_arg(a), app_arg(b));
+        case expr_kind::Lambda: case expr_kind::Pi:
+            return is_eqp(binding_domain(a), binding_domain(b)) && is_eqp(binding_body(a), binding_body(b)) &&
+                binding_info(a) == binding_info(b) && binding_name(a) == binding_name(b);
+        case expr_kind::Let:
+            return is_eqp(let_type(a), let_type(b)) && is_eqp(let_value(a), let_value(b)) &&
+                is_eqp(let_body(a), let_body(b)) && let_name(a) == let_name(b);
+        case expr_kind::Sort:
+            return sort_level(a) == sort_level(b);
+        case expr_kind::Const:
+            return const_name(a) == const_name(b) && const_levels(a) == const_levels(b);
+        case expr_kind::Proj:
+            return is_eqp(proj_expr(a), proj_expr(b)) && proj_idx(a) == proj_idx(b) &&
+                proj_sname(a) == proj_sname(b);
+        default:
+            lean_unreachable();
+        }
+    }
+
+    void grow() {
+        std::vector<optional<expr>> old;
+        old.swap(m_entries);
+        m_entries.resize(old.size() * 2);
+        for (optional<expr> & e : old) {
+            if (!e) continue;
+            unsigned mask = m_entries.size() - 1;
+            unsigned i    = hc_hash(*e) & mask;
+            while (m_entries[i])
+                i = (i + 1) & mask;
+            m_entries[i] = std::move(e);
+        }
+    }
 
-extern "C" uint8 lean_expr_has_fvar(obj_arg e);
-bool has_fvar(expr const & e) { return lean_expr_has_fvar(e.to_obj_arg()); }
+public:
+    expr_hash_cons_table():m_entries(1024) {}
+
+    /* Return the canonical node for `e`, inserting `e` if it is new. */
+    expr cons(expr const & e) {
+        unsigned mask = m_entries.size() - 1;
+        unsigned i    = hc_hash(e) & mask;
+        while (m_entries[i]) {
+            if (hc_equal(*m_entries[i], e))
+                return *m_entries[i];
+            i = (i + 1) & mask;
+        }
+        m_entries[i] = e;
+        m_size++;
+        if (m_size > m_entries.size() / 2)
+            grow();
+        return e;
+    }
+};
 
-extern "C" uint8 lean_expr_has_expr_mvar(obj_arg e);
-bool has_expr_mvar(expr const & e) { return lean_expr_has_expr_mvar(e.to_obj_arg()); }
+LEAN_THREAD_PTR(expr_hash_cons_table, g_hash_cons);
 
-extern "C" uint8 lean_expr_has_level_mvar(obj_arg e);
-bool has_univ_mvar(expr const & e) { return lean_expr_has_level_mvar(e.to_obj_arg()); }
+scoped_expr_hash_cons::scoped_expr_hash_cons():m_old_table(g_hash_cons) {
+    g_hash_cons = new expr_hash_cons_table();
+}
 
-extern "C" uint8 lean_expr_has_level_param(obj_arg e);
-bool has_univ_param(expr const & e) { return lean_expr_has_level_param(e.to_obj_arg()); }
+scoped_expr_hash_cons::~scoped_expr_hash_cons() {
+    delete g_hash_cons;
+    g_hash_cons = m_old_table;
+}
 
-extern "C" unsigned lean_expr_loose_bvar_range(object * e);
-unsigned get_loose_bvar_range(expr const & e) { return lean_expr_loose_bvar_range(e.to_obj_arg()); }
+static inline expr cons(expr && e) {
+    if (g_hash_cons)
+        return g_hash_cons->cons(e);
+    return e;
+}
 
 // =======================================
 // Constructors
@@ -112,13 +212,36 @@ static expr const & get_dummy() {
 expr::expr():expr(get_dummy()) {}
 
 extern "C" object * lean_expr_mk_lit(obj_arg l);
-expr mk_lit(literal const & l) { return expr(lean_expr_mk_lit(l.to_obj_arg())); }
+
+/* Preallocated `Expr.lit` nodes for the Nat literals 0..255 and the empty
+   string, built once at initialization and marked persistent so handing them
+   out is RC-free — the boxed small-int trick lifted to expression nodes.
+   Small numerals (including character code points below 256) account for the
+   bulk of literal construction in elaboration and in the `num.cpp`
+   conversions, and each uncached `mk_lit` allocates a constructor node plus
+   a boxed nat. */
+#define LEAN_NUM_SMALL_LITS 256
+static expr * g_small_nat_lits = nullptr;
+static expr * g_empty_str_lit  = nullptr;
+
+expr mk_lit(literal const & l) {
+    if (g_small_nat_lits) {
+        if (l.kind() == literal_kind::Nat) {
+            nat const & v = l.get_nat();
+            if (v.is_small() && v.get_small_value() < LEAN_NUM_SMALL_LITS)
+                return g_small_nat_lits[v.get_small_value()];
+        } else if (l.get_string().num_bytes() == 0) {
+            return *g_empty_str_lit;
+        }
+    }
+    return expr(lean_expr_mk_lit(l.to_obj_arg()));
+}
 
 extern "C" object * lean_expr_mk_mdata(obj_arg m, obj_arg e);
 expr mk_mdata(kvmap const & m, expr const & e) { return expr(lean_expr_mk_mdata(m.to_obj_arg(), e.to_obj_arg())); }
 
 extern "C" object * lean_expr_mk_proj(obj_arg s, obj_arg idx, obj_arg e);
-expr mk_proj(name const & s, nat const & idx, expr const & e) { return expr(lean_expr_mk_proj(s.to_obj_arg(), idx.to_obj_arg(), e.to_obj_arg())); }
+expr mk_proj(name const & s, nat const & idx, expr const & e) { return cons(expr(lean_expr_mk_proj(s.to_obj_arg(), idx.to_obj_arg(), e.to_obj_arg()))); }
 
 extern "C" object * lean_expr_mk_bvar(obj_arg idx);
 expr mk_bvar(nat const & idx) { return expr(lean_expr_mk_bvar(idx.to_obj_arg())); }
@@ -130,22 +253,43 @@ extern "C" object * lean_expr_mk_mvar(object * n);
 expr mk_mvar(name const & n) { return expr(lean_expr_mk_mvar(n.to_obj_arg())); }
 
 extern "C" object * lean_expr_mk_const(obj_arg n, obj_arg ls);
-expr mk_const(name const & n, levels const & ls) { return expr(lean_expr_mk_const(n.to_obj_arg(), ls.to_obj_arg())); }
+expr mk_const(name const & n, levels const & ls) { return cons(expr(lean_expr_mk_const(n.to_obj_arg(), ls.to_obj_arg()))); }
+
+/* Build the `Expr.app` constructor directly, mirroring `Expr.mkApp`
+   (src/Lean/Expr.lean), instead of crossing into the Lean-exported
+   `lean_expr_mk_app`: applications are by far the most frequently allocated
+   expression nodes, and spine construction shows up in kernel reduction. The
+   packed Expr.Data word is derived from the children's words exactly as
+   `mkApp` computes it: the hash mixes as `mixHash 29 (mixHash (hash f)
+   (hash a))` (with `mixHash` being `hash(uint64, uint64)` from lean/hash.h),
+   the has-fvar/mvar/level bits 32-35 are or-ed, and the loose-bvar range is
+   the max of the 24-bit fields. An application neither binds nor is a let,
+   so the binder-info and non-dep-let bits stay zero. */
+static object * mk_app_core(obj_arg f, obj_arg a) {
+    uint64 fd = expr_data_core(f);
+    uint64 ad = expr_data_core(a);
+    uint64 h  = hash(static_cast<uint64>(29), hash(static_cast<uint64>(fd & 0xffffffffu), static_cast<uint64>(ad & 0xffffffffu))) & 0xffffffffu;
+    uint64 d  = h | ((fd | ad) & (0xfull << 32)) | (std::max(fd >> 40, ad >> 40) << 40);
+    object * r = lean_alloc_ctor(static_cast<unsigned>(expr_kind::App), 2, sizeof(uint64));
+    lean_ctor_set(r, 0, f);
+    lean_ctor_set(r, 1, a);
+    lean_ctor_set_uint64(r, 2 * sizeof(object *), d);
+    return r;
+}
 
-extern "C" object * lean_expr_mk_app(obj_arg f, obj_arg a);
-expr mk_app(expr const & f, expr const & a) { return expr(lean_expr_mk_app(f.to_obj_arg(), a.to_obj_arg())); }
+expr mk_app(expr const & f, expr const & a) { return cons(expr(mk_app_core(f.to_obj_arg(), a.to_obj_arg()))); }
 
 extern "C" object * lean_expr_mk_sort(obj_arg l);
-expr mk_sort(level const & l) { return expr(lean_expr_mk_sort(l.to_obj_arg())); }
+expr mk_sort(level const & l) { return cons(expr(lean_expr_mk_sort(l.to_obj_arg()))); }
 
 extern "C" object * lean_expr_mk_lambda(obj_arg n, obj_arg t, obj_arg e, uint8 bi);
 expr mk_lambda(name const & n, expr const & t, expr const & e, binder_info bi) {
-    return expr(lean_expr_mk_lambda(n.to_obj_arg(), t.to_obj_arg(), e.to_obj_arg(), static_cast<uint8>(bi)));
+    return cons(expr(lean_expr_mk_lambda(n.to_obj_arg(), t.to_obj_arg(), e.to_obj_arg(), static_cast<uint8>(bi))));
 }
 
 extern "C" object * lean_expr_mk_forall(obj_arg n, obj_arg t, obj_arg e, uint8 bi);
 expr mk_pi(name const & n, expr const & t, expr const & e, binder_info bi) {
-    return expr(lean_expr_mk_forall(n.to_obj_arg(), t.to_obj_arg(), e.to_obj_arg(), static_cast<uint8>(bi)));
+    return cons(expr(lean_expr_mk_forall(n.to_obj_arg(), t.to_obj_arg(), e.to_obj_arg(), static_cast<uint8>(bi))));
 }
 
 static name * g_default_name = nullptr;
@@ -155,7 +299,7 @@ expr mk_arrow(expr const & t, expr const & e) {
 
 extern "C" object * lean_expr_mk_let(object * n, object * t, object * v, object * b);
 expr mk_let(name const & n, expr const & t, expr const & v, expr const & b) {
-    return expr(lean_expr_mk_let(n.to_obj_arg(), t.to_obj_arg(), v.to_obj_arg(), b.to_obj_arg()));
+    return cons(expr(lean_expr_mk_let(n.to_obj_arg(), t.to_obj_arg(), v.to_obj_arg(), b.to_obj_arg())));
 }
 
 static expr * g_Prop  = nullptr;
@@ -371,7 +515,7 @@ extern "C" object * lean_expr_update_proj(obj_arg e, obj_arg new_expr) {
 
 extern "C" object * lean_expr_update_app(obj_arg e, obj_arg new_fn, obj_arg new_arg) {
     if (app_fn(TO_REF(expr, e)).raw() != new_fn || app_arg(TO_REF(expr, e)).raw() != new_arg) {
-        object * r = lean_expr_mk_app(new_fn, new_arg);
+        object * r = mk_app_core(new_fn, new_arg);
         lean_dec_ref(e);
         return r;
     } else {
@@ -562,17 +706,65 @@ void initialize_expr() {
     mark_persistent(g_Type0->raw());
     g_Prop         = new expr(mk_sort(mk_level_zero()));
     mark_persistent(g_Prop->raw());
+    /* The cache pointers are still null here, so these go through the
+       allocating path. */
+    g_empty_str_lit = new expr(lean_expr_mk_lit(literal("").to_obj_arg()));
+    mark_persistent(g_empty_str_lit->raw());
+    g_small_nat_lits = new expr[LEAN_NUM_SMALL_LITS];
+    for (unsigned i = 0; i < LEAN_NUM_SMALL_LITS; i++) {
+        g_small_nat_lits[i] = expr(lean_expr_mk_lit(literal(i).to_obj_arg()));
+        mark_persistent(g_small_nat_lits[i].raw());
+    }
     /* TODO(Leo): add support for builtin constants in the kernel.
        Something similar to what we have in the library directory. */
 }
 
 void finalize_expr() {
+    delete[] g_small_nat_lits;
+    g_small_nat_lits = nullptr;
+    delete g_empty_str_lit;
+    g_empty_str_lit = nullptr;
     delete g_Prop;
     delete g_Type0;
     delete g_dummy;
     delete g_default_name;
 }
 
+// =======================================
+// Binary wire format for IPC
+
+/* Lightweight binary round-trip for shipping terms between cooperating lean
+   processes (driver/workers running the same build; the format makes no
+   stability guarantees across versions). The generic serializer preserves
+   sharing: repeated subterms, name chains, and duplicated strings are emitted
+   once and back-referenced afterwards, so the shared spines typical of goal
+   states do not explode on the wire. This avoids both the pretty-print/reparse
+   round trip and the heavyweight olean compactor. */
+extern "C" obj_res lean_expr_serialize(obj_arg e, obj_arg /* w */) {
+    std::ostringstream out;
+    serializer s(out);
+    s.write_object(e);
+    dec(e);
+    std::string data = out.str();
+    obj_res r = lean_alloc_sarray(1, data.size(), data.size());
+    memcpy(lean_sarray_cptr(r), data.data(), data.size());
+    return io_result_mk_ok(r);
+}
+
+extern "C" obj_res lean_expr_deserialize(obj_arg bytes, obj_arg /* w */) {
+    try {
+        std::string data(reinterpret_cast<char const *>(lean_sarray_cptr(bytes)), lean_sarray_size(bytes));
+        dec(bytes);
+        std::istringstream in(data);
+        deserializer d(in);
+        object * e = d.read_object();
+        inc(e);
+        return io_result_mk_ok(e);
+    } catch (exception & ex) {
+        return io_result_mk_error(ex.what());
+    }
+}
+
 // =======================================
 // Legacy
 
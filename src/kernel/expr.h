@@ -138,13 +138,21 @@ inline bool is_eqp(optional<expr> const & a, optional<expr> const & b) {
     return static_cast<bool>(a) == static_cast<bool>(b) && (!a || is_eqp(*a, *b));
 }
 
-unsigned hash(expr const & e);
-bool has_expr_mvar(expr const & e);
-bool has_univ_mvar(expr const & e);
-inline bool has_mvar(expr const & e) { return has_expr_mvar(e) || has_univ_mvar(e); }
-bool has_fvar(expr const & e);
-bool has_univ_param(expr const & e);
-unsigned get_loose_bvar_range(expr const & e);
+/* Packed `Expr.Data` cache word; the layout mirrors `Expr.mkDataCore` in
+   Lean/Expr.lean: bits 0-31 hash, 32 hasFVar, 33 hasExprMVar, 34 hasLevelMVar,
+   35 hasLevelParam, 36 nonDepLet, 37-39 binderInfo, 40-63 looseBVarRange.
+   It is the trailing scalar field of every constructor, so these read-only
+   probes access it directly; the exported Lean accessors take owned arguments
+   and would pay a reference count increment/decrement per probe. */
+inline uint64_t expr_data_core(object * o) { return lean_ctor_get_uint64(o, lean_ctor_num_objs(o) * sizeof(object *)); }
+inline uint64_t expr_data(expr const & e) { return expr_data_core(e.raw()); }
+inline unsigned hash(expr const & e) { return static_cast<unsigned>(expr_data(e)); }
+inline bool has_expr_mvar(expr const & e) { return (expr_data(e) >> 33) & 1; }
+inline bool has_univ_mvar(expr const & e) { return (expr_data(e) >> 34) & 1; }
+inline bool has_mvar(expr const & e) { return (expr_data(e) >> 33) & 3; }
+inline bool has_fvar(expr const & e) { return (expr_data(e) >> 32) & 1; }
+inline bool has_univ_param(expr const & e) { return (expr_data(e) >> 35) & 1; }
+inline unsigned get_loose_bvar_range(expr const & e) { return static_cast<unsigned>(expr_data(e) >> 40); }
 
 struct expr_hash { unsigned operator()(expr const & e) const { return hash(e); } };
 struct expr_pair_hash {
@@ -326,6 +334,26 @@ expr infer_implicit(expr const & t, bool strict);
 std::ostream & operator<<(std::ostream & out, expr const & e);
 // =======================================
 
+// =======================================
+// Hash consing
+
+/** \brief Opt-in hash-consing scope for the C++ expression constructors.
+
+    While a scope is active on the current thread, `mk_app`, `mk_lambda`,
+    `mk_pi`, `mk_let`, `mk_sort`, `mk_const` and `mk_proj` canonicalize the
+    node they build against a content-addressed table, so terms constructed
+    bottom-up inside the scope collapse structurally identical subterms into
+    a single node and structural equality degenerates into pointer equality.
+    Used by the type checker when LEAN_KERNEL_HASH_CONS is set; worthwhile for
+    large auto-generated proofs with massive internal sharing. Scopes nest. */
+class expr_hash_cons_table;
+class scoped_expr_hash_cons {
+    expr_hash_cons_table * m_old_table;
+public:
+    scoped_expr_hash_cons();
+    ~scoped_expr_hash_cons();
+};
+
 void initialize_expr();
 void finalize_expr();
 
@@ -62,9 +62,20 @@ class expr_eq_fn {
 
     static void check_system() { ::lean::check_system("expression equality test"); }
 
+    /* The packed Expr.Data word (see expr.h) caches the hash, the has-fvar/mvar
+       and loose-bvar-range fields, and the binder info; everything except the
+       binder-info bits is invariant under structural equality, so one 64-bit
+       compare (masked for `==`, which ignores binder information) subsumes the
+       hash test and rejects flag or range mismatches with a single load per
+       side. */
+    static uint64_t structural_data(expr const & e) {
+        uint64_t d = expr_data(e);
+        return CompareBinderInfo ? d : d & ~(7ull << 37);
+    }
+
     bool apply(expr const & a, expr const & b) {
         if (is_eqp(a, b))          return true;
-        if (hash(a) != hash(b))    return false;
+        if (structural_data(a) != structural_data(b)) return false;
         if (a.kind() != b.kind())  return false;
         if (is_bvar(a))            return bvar_idx(a) == bvar_idx(b);
         if (m_cache.check(a, b))
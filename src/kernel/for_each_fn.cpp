@@ -6,11 +6,14 @@ Author: Leonardo de Moura
 */
 #include <vector>
 #include <utility>
+#include <unordered_set>
 #include <lean/memory.h>
 #include <lean/interrupt.h>
 #include <lean/flet.h>
+#include <lean/object.h>
 #include "kernel/for_each_fn.h"
 #include "kernel/cache_stack.h"
+#include "kernel/par_traverse.h"
 
 #ifndef LEAN_DEFAULT_FOR_EACH_CACHE_CAPACITY
 #define LEAN_DEFAULT_FOR_EACH_CACHE_CAPACITY 1024*8
@@ -121,4 +124,31 @@ public:
 void for_each(expr const & e, std::function<bool(expr const &, unsigned)> && f) { // NOLINT
     return for_each_fn(f)(e);
 }
+
+void par_for_each(expr const & e, std::function<bool(expr const &)> const & f) { // NOLINT
+#if defined(LEAN_MULTI_THREAD)
+    unsigned num_workers = hardware_concurrency();
+    if (num_workers >= 2) {
+        buffer<expr> chunks;
+        partition_expr(e, num_workers * LEAN_PAR_TRAVERSE_CHUNK_FACTOR, chunks);
+        if (chunks.size() >= 2) {
+            /* Reference counts on the graph are manipulated from several threads. */
+            mark_mt(e.raw());
+            par_run_chunks(chunks, [&](unsigned, expr const & c) {
+                    for_each(c, [&](expr const & s, unsigned) { return f(s); });
+                });
+            std::unordered_set<object const *> chunk_set;
+            for (expr const & c : chunks)
+                chunk_set.insert(c.raw());
+            for_each(e, [&](expr const & s, unsigned) {
+                    if (chunk_set.find(s.raw()) != chunk_set.end())
+                        return false; /* already traversed by a worker */
+                    return f(s);
+                });
+            return;
+        }
+    }
+#endif
+    for_each(e, [&](expr const & s, unsigned) { return f(s); });
+}
 }
@@ -24,4 +24,17 @@ namespace lean {
     The \c offset is the number of binders under which \c e occurs.
 */
 void for_each(expr const & e, std::function<bool(expr const &, unsigned)> && f); // NOLINT
+
+/** \brief Parallel variant of \c for_each for offset-independent functors.
+
+    The expression DAG is partitioned at nodes near the root, the subtrees are
+    traversed on worker threads (each with its own visited cache), and a final
+    sequential pass covers the small spine above the partition points. The
+    graph is marked multi-thread before the traversal.
+
+    \c f may be invoked from several threads concurrently, so it must be
+    effect-free or synchronize its own state; as with \c for_each, it may see
+    the same shared subexpression more than once. Falls back to a sequential
+    traversal on small expressions and on non-multi-thread builds. */
+void par_for_each(expr const & e, std::function<bool(expr const &)> const & f); // NOLINT
 }
@@ -4,9 +4,15 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <unordered_map>
+#include <memory>
+#include <vector>
 #include <lean/sstream.h>
 #include <lean/utf8.h>
+#include <lean/thread.h>
+#include <lean/object.h>
 #include "util/name_generator.h"
+#include "util/name_hash_map.h"
 #include "kernel/environment.h"
 #include "kernel/type_checker.h"
 #include "kernel/instantiate.h"
@@ -60,16 +66,93 @@ optional<expr> mk_nullary_cnstr(environment const & env, expr const & type, unsi
     return some(mk_app(mk_constant(*cnstr_name, const_levels(d)), args));
 }
 
+#define LEAN_REC_RULE_INDEX_THRESHOLD 16 /* rule lists at least this long get a hash index */
+
+/* Hash index over the rule lists of big recursors.
+
+   `get_rec_rule_for` sits in the iota-reduction inner loop, and for
+   inductives with hundreds of constructors the linear scan of the
+   `recursor_rules` list dominates. Rule lists are immutable objects, so the
+   index is built once per list and keyed by the list's identity; the entry
+   pins the list, keeping the key pointer valid. Small lists keep the plain
+   scan, which beats hashing at that size. */
+class rec_rule_index {
+    struct entry {
+        recursor_rules                 m_rules; /* pins the key */
+        name_hash_map<recursor_rule>   m_map;
+        entry(recursor_rules const & rules):m_rules(rules) {
+            for (recursor_rule const & rule : rules)
+                m_map.insert(mk_pair(rule.get_cnstr(), rule));
+        }
+    };
+    mutex                                      m_mutex;
+    std::unordered_map<object const *, entry>  m_entries;
+public:
+    optional<recursor_rule> find(recursor_rules const & rules, name const & cnstr) {
+        lock_guard<mutex> lock(m_mutex);
+        auto it = m_entries.find(rules.raw());
+        if (it == m_entries.end())
+            it = m_entries.emplace(rules.raw(), entry(rules)).first;
+        auto r = it->second.m_map.find(cnstr);
+        if (r == it->second.m_map.end())
+            return optional<recursor_rule>();
+        return optional<recursor_rule>(r->second);
+    }
+};
+
+static rec_rule_index * g_rec_rule_index = nullptr;
+
 optional<recursor_rule> get_rec_rule_for(recursor_val const & rec_val, expr const & major) {
     expr const & fn = get_app_fn(major);
     if (!is_constant(fn)) return optional<recursor_rule>();
-    for (recursor_rule const & rule : rec_val.get_rules()) {
+    recursor_rules const & rules = rec_val.get_rules();
+    /* Scan the first few rules directly; if the list turns out to be long,
+       switch to the hash index instead of walking the rest. */
+    unsigned scanned = 0;
+    for (recursor_rule const & rule : rules) {
         if (rule.get_cnstr() == const_name(fn))
             return optional<recursor_rule>(rule);
+        if (++scanned == LEAN_REC_RULE_INDEX_THRESHOLD)
+            return g_rec_rule_index->find(rules, const_name(fn));
     }
     return optional<recursor_rule>();
 }
 
+#if defined(LEAN_MULTI_THREAD)
+#define LEAN_PAR_INDUCTIVE_THRESHOLD 8 /* minimum number of constructors before worker threads are used */
+
+/* Run `fn(i)` for every `i < n` on up to hardware_concurrency() worker threads.
+   If several invocations throw, the exception for the smallest `i` is rethrown,
+   so errors are reported in the same order as a sequential loop. */
+template<typename F>
+static void par_for_index(unsigned n, F const & fn) {
+    unsigned num_workers = std::min(hardware_concurrency(), n);
+    std::vector<std::exception_ptr> errors(n);
+    atomic<unsigned> next(0);
+    std::vector<std::unique_ptr<lthread>> workers;
+    for (unsigned w = 0; w < num_workers; w++) {
+        workers.push_back(std::unique_ptr<lthread>(new lthread([&]() {
+                while (true) {
+                    unsigned i = next.fetch_add(1);
+                    if (i >= n)
+                        return;
+                    try {
+                        fn(i);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                }
+            })));
+    }
+    for (std::unique_ptr<lthread> const & w : workers)
+        w->join();
+    for (unsigned i = 0; i < n; i++) {
+        if (errors[i])
+            std::rethrow_exception(errors[i]);
+    }
+}
+#endif
+
 /* Auxiliary class for adding a mutual inductive datatype declaration. */
 class add_inductive_fn {
     environment            m_env;
@@ -107,6 +190,28 @@ class add_inductive_fn {
        and for nested inductive datatypes. */
     buffer<rec_info>       m_rec_infos;
 
+    /* Telescope of a recursive constructor field: the arguments of the field,
+       and the inductive type (with its indices) the field maps into. */
+    struct rec_arg_info {
+        buffer<expr> m_xs;
+        unsigned     m_it_idx;
+        buffer<expr> m_it_indices;
+    };
+
+    /* Per-constructor telescope information. `mk_rec_infos` traverses each
+       constructor type once (creating the field free variables, and computing
+       the telescope of each recursive field with whnf); this structure saves
+       the result so `mk_rec_rules` does not have to redo the traversal. */
+    struct cnstr_info {
+        buffer<expr>         m_fields;   /* free variables for the non-parameter fields */
+        buffer<expr>         m_rec_args; /* the recursive fields (subset of m_fields) */
+        buffer<rec_arg_info> m_rec_arg_infos;
+    };
+
+    /* One entry per constructor, in declaration order (i.e., aligned with the
+       flat minor premise buffer). Populated by `mk_rec_infos`. */
+    buffer<cnstr_info>     m_cnstr_infos;
+
 public:
     add_inductive_fn(environment const & env, inductive_decl const & decl, bool is_nested):
         m_env(env), m_ngen(*g_ind_fresh), m_lparams(decl.get_lparams()), m_is_unsafe(decl.is_unsafe()),
@@ -144,6 +249,46 @@ public:
     expr mk_lambda(buffer<expr> const & fvars, expr const & e) const { return m_lctx.mk_lambda(fvars, e); }
     expr mk_lambda(expr const & fvar, expr const & e) const { return m_lctx.mk_lambda(1, &fvar, e); }
 
+#if defined(LEAN_MULTI_THREAD)
+    /* Mark the state shared with worker threads (directly or through copies of
+       this object) as multi-threaded, so reference counters are updated
+       atomically. */
+    void prepare_for_par() {
+        mark_mt(m_env.raw());
+        mark_mt(m_lctx.raw());
+        m_lctx.mark_index_mt();
+        mark_mt(m_lparams.raw());
+        mark_mt(m_levels.raw());
+        mark_mt(m_result_level.raw());
+        mark_mt(m_elim_level.raw());
+        mark_mt(m_ngen.prefix().raw());
+        for (inductive_type const & ind_type : m_ind_types)
+            mark_mt(ind_type.raw());
+        for (expr const & param : m_params)
+            mark_mt(param.raw());
+        for (expr const & c : m_ind_cnsts)
+            mark_mt(c.raw());
+        for (rec_info const & info : m_rec_infos) {
+            mark_mt(info.m_C.raw());
+            mark_mt(info.m_major.raw());
+            for (expr const & e : info.m_minors)
+                mark_mt(e.raw());
+            for (expr const & e : info.m_indices)
+                mark_mt(e.raw());
+        }
+        for (cnstr_info const & info : m_cnstr_infos) {
+            for (expr const & e : info.m_fields)
+                mark_mt(e.raw());
+            for (rec_arg_info const & arg : info.m_rec_arg_infos) {
+                for (expr const & e : arg.m_xs)
+                    mark_mt(e.raw());
+                for (expr const & e : arg.m_it_indices)
+                    mark_mt(e.raw());
+            }
+        }
+    }
+#endif
+
     /**
        \brief Check whether the type of each datatype is well typed, and do not contain free variables or meta variables,
        all inductive datatypes have the same parameters, the number of parameters match the argument m_nparams,
@@ -343,9 +488,47 @@ public:
         }
     }
 
+    /** \brief Check whether constructor \c cnstr of the \c idx -th inductive datatype is type correct,
+        parameters are in the expected positions, constructor fields are in acceptable universe levels,
+        positivity constraints, and returns the expected result.
+
+        \remark This method mutates only m_lctx and m_ngen, and the local declarations it creates are
+        not used after the check. So it may also run on worker threads, on a copy of this object. */
+    void check_constructor(unsigned idx, constructor const & cnstr) {
+        name const & n = constructor_name(cnstr);
+        expr t = constructor_type(cnstr);
+        tc().check(t, m_lparams);
+        unsigned i = 0;
+        while (is_pi(t)) {
+            if (i < m_nparams) {
+                if (!is_def_eq(binding_domain(t), get_param_type(i)))
+                    throw kernel_exception(m_env, sstream() << "arg #" << (i + 1) << " of '" << n << "' "
+                                           << "does not match inductive datatypes parameters'");
+                t = instantiate(binding_body(t), m_params[i]);
+            } else {
+                expr s = tc().ensure_type(binding_domain(t));
+                // the sort is ok IF
+                //   1- its level is <= inductive datatype level, OR
+                //   2- is an inductive predicate
+                if (!(is_geq(m_result_level, sort_level(s)) || is_zero(m_result_level))) {
+                    throw kernel_exception(m_env, sstream() << "universe level of type_of(arg #" << (i + 1) << ") "
+                                           << "of '" << n << "' is too big for the corresponding inductive datatype");
+                }
+                if (!m_is_unsafe)
+                    check_positivity(binding_domain(t), n, i);
+                expr local = mk_local_decl_for(t);
+                t = instantiate(binding_body(t), local);
+            }
+            i++;
+        }
+        if (!is_valid_ind_app(t, idx))
+            throw kernel_exception(m_env, sstream() << "invalid return type for '" << n << "'");
+    }
+
     /** \brief Check whether the constructor declarations are type correct, parameters are in the expected positions,
         constructor fields are in acceptable universe levels, positivity constraints, and returns the expected result. */
     void check_constructors() {
+        buffer<pair<unsigned, constructor>> cnstrs;
         for (unsigned idx = 0; idx < m_ind_types.size(); idx++) {
             inductive_type const & ind_type = m_ind_types[idx];
             name_set found_cnstrs;
@@ -355,37 +538,23 @@ public:
                     throw kernel_exception(m_env, sstream() << "duplicate constructor name '" << n << "'");
                 }
                 found_cnstrs.insert(n);
-                expr t = constructor_type(cnstr);
                 m_env.check_name(n);
-                check_no_metavar_no_fvar(m_env, n, t);
-                tc().check(t, m_lparams);
-                unsigned i = 0;
-                while (is_pi(t)) {
-                    if (i < m_nparams) {
-                        if (!is_def_eq(binding_domain(t), get_param_type(i)))
-                            throw kernel_exception(m_env, sstream() << "arg #" << (i + 1) << " of '" << n << "' "
-                                                   << "does not match inductive datatypes parameters'");
-                        t = instantiate(binding_body(t), m_params[i]);
-                    } else {
-                        expr s = tc().ensure_type(binding_domain(t));
-                        // the sort is ok IF
-                        //   1- its level is <= inductive datatype level, OR
-                        //   2- is an inductive predicate
-                        if (!(is_geq(m_result_level, sort_level(s)) || is_zero(m_result_level))) {
-                            throw kernel_exception(m_env, sstream() << "universe level of type_of(arg #" << (i + 1) << ") "
-                                                   << "of '" << n << "' is too big for the corresponding inductive datatype");
-                        }
-                        if (!m_is_unsafe)
-                            check_positivity(binding_domain(t), n, i);
-                        expr local = mk_local_decl_for(t);
-                        t = instantiate(binding_body(t), local);
-                    }
-                    i++;
-                }
-                if (!is_valid_ind_app(t, idx))
-                    throw kernel_exception(m_env, sstream() << "invalid return type for '" << n << "'");
+                check_no_metavar_no_fvar(m_env, n, constructor_type(cnstr));
+                cnstrs.push_back(mk_pair(idx, cnstr));
             }
         }
+#if defined(LEAN_MULTI_THREAD)
+        if (hardware_concurrency() >= 2 && cnstrs.size() >= LEAN_PAR_INDUCTIVE_THRESHOLD) {
+            prepare_for_par();
+            par_for_index(cnstrs.size(), [&](unsigned i) {
+                    add_inductive_fn checker(*this);
+                    checker.check_constructor(cnstrs[i].first, cnstrs[i].second);
+                });
+            return;
+        }
+#endif
+        for (pair<unsigned, constructor> const & p : cnstrs)
+            check_constructor(p.first, p.second);
     }
 
     void declare_constructors() {
@@ -554,8 +723,9 @@ public:
         for (inductive_type const & ind_type : m_ind_types) {
             name ind_type_name = ind_type.get_name();
             for (constructor const & cnstr : ind_type.get_cnstrs()) {
-                buffer<expr> b_u; // nonrec and rec args;
-                buffer<expr> u;   // rec args
+                cnstr_info cinfo;
+                buffer<expr> & b_u = cinfo.m_fields;   // nonrec and rec args;
+                buffer<expr> & u   = cinfo.m_rec_args; // rec args
                 buffer<expr> v;   // inductive args
                 name cnstr_name = constructor_name(cnstr);
                 expr t          = constructor_type(cnstr);
@@ -581,14 +751,16 @@ public:
                 for (unsigned i = 0; i < u.size(); i++) {
                     expr u_i    = u[i];
                     expr u_i_ty = whnf(infer_type(u_i));
-                    buffer<expr> xs;
+                    rec_arg_info arg_info;
+                    buffer<expr> & xs = arg_info.m_xs;
                     while (is_pi(u_i_ty)) {
                         expr x = mk_local_decl_for(u_i_ty);
                         xs.push_back(x);
                         u_i_ty = whnf(instantiate(binding_body(u_i_ty), x));
                     }
-                    buffer<expr> it_indices;
+                    buffer<expr> & it_indices = arg_info.m_it_indices;
                     unsigned it_idx = get_I_indices(u_i_ty, it_indices);
+                    arg_info.m_it_idx = it_idx;
                     expr C_app  = mk_app(m_rec_infos[it_idx].m_C, it_indices);
                     expr u_app  = mk_app(u_i, xs);
                     C_app = mk_app(C_app, u_app);
@@ -596,11 +768,13 @@ public:
                     local_decl u_i_decl = m_lctx.get_local_decl(fvar_name(u_i));
                     expr v_i    = mk_local_decl(u_i_decl.get_user_name().append_after("_ih"), v_i_ty, binder_info());
                     v.push_back(v_i);
+                    cinfo.m_rec_arg_infos.push_back(arg_info);
                 }
                 expr minor_ty   = mk_pi(b_u, mk_pi(v, C_app));
                 name minor_name = cnstr_name.replace_prefix(ind_type_name, name());
                 expr minor      = mk_local_decl(minor_name, minor_ty);
                 m_rec_infos[d_idx].m_minors.push_back(minor);
+                m_cnstr_infos.push_back(cinfo);
                 minor_idx++;
             }
             d_idx++;
@@ -636,47 +810,31 @@ public:
             ms.append(m_rec_infos[i].m_minors);
     }
 
-    recursor_rules mk_rec_rules(unsigned d_idx, buffer<expr> const & Cs, buffer<expr> const & minors, unsigned & minor_idx) {
+    /** \brief Build the recursor rules for the \c d_idx -th inductive datatype.
+        \c minor_idx is the position of the datatype's first minor premise in the flat \c minors buffer.
+
+        \remark The constructor telescopes were computed by `mk_rec_infos` and are retrieved from
+        `m_cnstr_infos`: the field free variables are reused (each rule closes over them), so no new
+        local declarations, whnf, or type inference is needed here. The method does not mutate this
+        object and may run on worker threads. */
+    recursor_rules mk_rec_rules(unsigned d_idx, buffer<expr> const & Cs, buffer<expr> const & minors, unsigned minor_idx) {
         inductive_type const & d = m_ind_types[d_idx];
         levels lvls = get_rec_levels();
         buffer<recursor_rule> rules;
         for (constructor const & cnstr : d.get_cnstrs()) {
-            buffer<expr> b_u;
-            buffer<expr> u;
-            expr t = constructor_type(cnstr);
-            unsigned i = 0;
-            while (is_pi(t)) {
-                if (i < m_nparams) {
-                    t = instantiate(binding_body(t), m_params[i]);
-                } else {
-                    expr l = mk_local_decl_for(t);
-                    b_u.push_back(l);
-                    if (is_rec_argument(binding_domain(t)))
-                        u.push_back(l);
-                    t = instantiate(binding_body(t), l);
-                }
-                i++;
-            }
+            cnstr_info const & cinfo = m_cnstr_infos[minor_idx];
             buffer<expr> v;
-            for (unsigned i = 0; i < u.size(); i++) {
-                expr u_i    = u[i];
-                expr u_i_ty = whnf(infer_type(u_i));
-                buffer<expr> xs;
-                while (is_pi(u_i_ty)) {
-                    expr x = mk_local_decl_for(u_i_ty);
-                    xs.push_back(x);
-                    u_i_ty = whnf(instantiate(binding_body(u_i_ty), x));
-                }
-                buffer<expr> it_indices;
-                unsigned it_idx = get_I_indices(u_i_ty, it_indices);
-                name rec_name   = mk_rec_name(m_ind_types[it_idx].get_name());
+            for (unsigned i = 0; i < cinfo.m_rec_args.size(); i++) {
+                expr const & u_i          = cinfo.m_rec_args[i];
+                rec_arg_info const & arg  = cinfo.m_rec_arg_infos[i];
+                name rec_name   = mk_rec_name(m_ind_types[arg.m_it_idx].get_name());
                 expr rec_app    = mk_constant(rec_name, lvls);
-                rec_app         = mk_app(mk_app(mk_app(mk_app(mk_app(rec_app, m_params), Cs), minors), it_indices), mk_app(u_i, xs));
-                v.push_back(mk_lambda(xs, rec_app));
+                rec_app         = mk_app(mk_app(mk_app(mk_app(mk_app(rec_app, m_params), Cs), minors), arg.m_it_indices), mk_app(u_i, arg.m_xs));
+                v.push_back(mk_lambda(arg.m_xs, rec_app));
             }
-            expr e_app    = mk_app(mk_app(minors[minor_idx], b_u), v);
-            expr comp_rhs = mk_lambda(m_params, mk_lambda(Cs, mk_lambda(minors, mk_lambda(b_u, e_app))));
-            rules.push_back(recursor_rule(constructor_name(cnstr), b_u.size(), comp_rhs));
+            expr e_app    = mk_app(mk_app(minors[minor_idx], cinfo.m_fields), v);
+            expr comp_rhs = mk_lambda(m_params, mk_lambda(Cs, mk_lambda(minors, mk_lambda(cinfo.m_fields, e_app))));
+            rules.push_back(recursor_rule(constructor_name(cnstr), cinfo.m_fields.size(), comp_rhs));
             minor_idx++;
         }
         return recursor_rules(rules);
@@ -689,7 +847,33 @@ public:
         unsigned nminors   = minors.size();
         unsigned nmotives  = Cs.size();
         names all          = get_all_inductive_names();
+        /* Position of each datatype's first minor premise in `minors`. */
+        buffer<unsigned> minor_offsets;
         unsigned minor_idx = 0;
+        for (unsigned d_idx = 0; d_idx < m_ind_types.size(); d_idx++) {
+            minor_offsets.push_back(minor_idx);
+            minor_idx += m_rec_infos[d_idx].m_minors.size();
+        }
+        std::vector<recursor_rules> rules_of(m_ind_types.size());
+        bool done = false;
+#if defined(LEAN_MULTI_THREAD)
+        if (hardware_concurrency() >= 2 && m_ind_types.size() >= 2 && minors.size() >= LEAN_PAR_INDUCTIVE_THRESHOLD) {
+            /* The rules of each recursor only read shared state; they are built in parallel
+               and added to the environment afterwards. */
+            prepare_for_par();
+            par_for_index(m_ind_types.size(), [&](unsigned d_idx) {
+                    recursor_rules rules = mk_rec_rules(d_idx, Cs, minors, minor_offsets[d_idx]);
+                    /* the new terms become visible to the main thread */
+                    mark_mt(rules.raw());
+                    rules_of[d_idx] = rules;
+                });
+            done = true;
+        }
+#endif
+        if (!done) {
+            for (unsigned d_idx = 0; d_idx < m_ind_types.size(); d_idx++)
+                rules_of[d_idx] = mk_rec_rules(d_idx, Cs, minors, minor_offsets[d_idx]);
+        }
         for (unsigned d_idx = 0; d_idx < m_ind_types.size(); d_idx++) {
             rec_info const & info = m_rec_infos[d_idx];
             expr C_app            = mk_app(mk_app(info.m_C, info.m_indices), info.m_major);
@@ -699,12 +883,11 @@ public:
             rec_ty                = mk_pi(Cs, rec_ty);
             rec_ty                = mk_pi(m_params, rec_ty);
             rec_ty                = infer_implicit(rec_ty, true /* strict */);
-            recursor_rules rules  = mk_rec_rules(d_idx, Cs, minors, minor_idx);
             name rec_name         = mk_rec_name(m_ind_types[d_idx].get_name());
             names rec_lparams     = get_rec_lparams();
             m_env.add_core(constant_info(recursor_val(rec_name, rec_lparams, rec_ty, all,
                                                       m_nparams, m_nindices[d_idx], nmotives, nminors,
-                                                      rules, m_K_target, m_is_unsafe)));
+                                                      rules_of[d_idx], m_K_target, m_is_unsafe)));
         }
     }
 
@@ -885,11 +1068,10 @@ struct elim_nested_inductive_fn {
     }
 
     expr instantiate_pi_params(expr e, unsigned nparams, expr const * params) {
-        for (unsigned i = 0; i < nparams; i++) {
-            if (!is_pi(e)) throw_ill_formed();
-            e = binding_body(e);
-        }
-        return instantiate_rev(e, nparams, params);
+        if (optional<expr> r = instantiate_telescope(e, nparams, params))
+            return *r;
+        throw_ill_formed();
+        lean_unreachable();
     }
 
     /* If `e` is a nested occurrence `I Ds is`, return `Iaux As is` */
@@ -1143,6 +1325,7 @@ expr string_lit_to_constructor(expr const & e) {
 
 
 void initialize_inductive() {
+    g_rec_rule_index = new rec_rule_index();
     g_nested         = new name("_nested");
     mark_persistent(g_nested->raw());
     g_ind_fresh      = new name("_ind_fresh");
@@ -1167,6 +1350,8 @@ void initialize_inductive() {
 }
 
 void finalize_inductive() {
+    delete g_rec_rule_index;
+    g_rec_rule_index = nullptr;
     delete g_nested;
     delete g_ind_fresh;
     delete g_nested_fresh;
@@ -160,6 +160,18 @@ extern "C" object * lean_expr_instantiate_rev_range(b_obj_arg a, b_obj_arg begin
     }
 }
 
+optional<expr> instantiate_telescope(expr const & e, unsigned n, expr const * s) {
+    expr it = e;
+    for (unsigned i = 0; i < n; i++) {
+        if (!is_pi(it))
+            return none_expr();
+        it = binding_body(it);
+    }
+    /* In `it`, the variable bound by the i-th binder is the loose bvar `n - i - 1`,
+       so the telescope-ordered `s` is applied in reverse. */
+    return some_expr(instantiate_rev(it, n, s));
+}
+
 bool is_head_beta(expr const & t) {
     return is_app(t) && is_lambda(get_app_fn(t));
 }
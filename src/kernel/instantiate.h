@@ -24,6 +24,14 @@ inline expr instantiate_rev(expr const & e, buffer<expr> const & s) {
     return instantiate_rev(e, s.size(), s.data());
 }
 
+/** \brief Given `e` syntactically of the form `(x_1 : A_1) -> ... -> (x_n : A_n) -> B`,
+    return `B[x_1 := s[0], ..., x_n := s[n-1]]`, substituting all \c n telescope variables
+    in a single traversal. Return none if \c e has fewer than \c n (syntactic) binders;
+    callers must then fall back to reducing between the one-by-one instantiation steps.
+    Note that instantiating one binder at a time traverses the body \c n times and is
+    quadratic on big telescopes. */
+optional<expr> instantiate_telescope(expr const & e, unsigned n, expr const * s);
+
 expr apply_beta(expr f, unsigned num_rev_args, expr const * rev_args);
 bool is_head_beta(expr const & t);
 expr head_beta_reduce(expr const & t);
@@ -11,6 +11,7 @@ Author: Leonardo de Moura
 #include <lean/debug.h>
 #include <lean/interrupt.h>
 #include <lean/hash.h>
+#include <lean/thread.h>
 #include "util/buffer.h"
 #include "util/list.h"
 #include "kernel/level.h"
@@ -18,11 +19,6 @@ Author: Leonardo de Moura
 
 namespace lean {
 
-extern "C" unsigned lean_level_hash(obj_arg l);
-extern "C" unsigned lean_level_depth(obj_arg l);
-extern "C" uint8 lean_level_has_mvar(obj_arg l);
-extern "C" uint8 lean_level_has_param(obj_arg l);
-
 extern "C" object * lean_level_mk_zero(object*);
 extern "C" object * lean_level_mk_succ(obj_arg);
 extern "C" object * lean_level_mk_mvar(obj_arg);
@@ -38,10 +34,7 @@ level mk_imax_core(level const & l1, level const & l2) { return level(lean_level
 level mk_univ_param(name const & n) { return level(lean_level_mk_param(n.to_obj_arg())); }
 level mk_univ_mvar(name const & n) { return level(lean_level_mk_mvar(n.to_obj_arg())); }
 
-unsigned level::hash() const { return lean_level_hash(to_obj_arg()); }
-unsigned get_depth(level const & l) { return lean_level_depth(l.to_obj_arg()); }
-bool has_param(level const & l) { return lean_level_has_param(l.to_obj_arg()); }
-bool has_mvar(level const & l) { return lean_level_has_mvar(l.to_obj_arg()); }
+unsigned level::hash() const { return static_cast<unsigned>(level_data_core(raw())); }
 
 bool is_explicit(level const & l) {
     switch (kind(l)) {
@@ -70,6 +63,10 @@ unsigned to_explicit(level const & l) {
     return to_offset(l).second;
 }
 
+static bool is_norm_lt(level const & a, level const & b);
+void push_max_args(level const & l, buffer<level> & r);
+static level mk_max_canonical(buffer<level> & args);
+
 level mk_max(level const & l1, level const & l2)  {
     if (is_explicit(l1) && is_explicit(l2)) {
         return get_depth(l1) >= get_depth(l2) ? l1 : l2;
@@ -90,7 +87,13 @@ level mk_max(level const & l1, level const & l2)  {
             lean_assert(p1.second != p2.second);
             return p1.second > p2.second ? l1 : l2;
         } else {
-            return mk_max_core(l1, l2);
+            /* Build the canonical (sorted, deduplicated, right-nested) form
+               instead of a syntactic node, so max chains folded over many
+               arguments stay small and never need a separate normalize pass. */
+            buffer<level> args;
+            push_max_args(l1, args);
+            push_max_args(l2, args);
+            return mk_max_canonical(args);
         }
     }
 }
@@ -204,7 +207,7 @@ bool is_lt(levels const & as, levels const & bs, bool use_hash) {
 
 bool levels_has_param(b_obj_arg ls) {
     while (!is_scalar(ls)) {
-        if (lean_level_has_param(cnstr_get(ls, 0))) return true;
+        if ((level_data_core(cnstr_get(ls, 0)) >> 33) & 1) return true;
         ls = cnstr_get(ls, 1);
     }
     return false;
@@ -212,7 +215,7 @@ bool levels_has_param(b_obj_arg ls) {
 
 bool levels_has_mvar(b_obj_arg ls) {
     while (!is_scalar(ls)) {
-        if (lean_level_has_mvar(cnstr_get(ls, 0))) return true;
+        if ((level_data_core(cnstr_get(ls, 0)) >> 32) & 1) return true;
         ls = cnstr_get(ls, 1);
     }
     return false;
@@ -487,21 +490,66 @@ void push_max_args(level const & l, buffer<level> & r) {
     }
 }
 
-level mk_max(buffer<level> const & args) {
+/* Rebuild `max` over the flattened arms in `args` (no Max entries) in canonical
+   form: arms sorted by `is_norm_lt`, at most one arm per base (keeping the
+   largest offset), and explicit universes dropped when subsumed by a `succ^k l`
+   arm. This is the shape `normalize` produces, so levels assembled through the
+   smart constructors are already normal and the normalize passes reduce to the
+   memo-table fast path. Destroys `args`. */
+static level mk_max_canonical(buffer<level> & args) {
     lean_assert(!args.empty());
-    unsigned nargs = args.size();
-    if (nargs == 1) {
-        return args[0];
-    } else {
-        lean_assert(nargs >= 2);
-        level r = mk_max(args[nargs-2], args[nargs-1]);
-        unsigned i = nargs-2;
-        while (i > 0) {
-            --i;
-            r = mk_max(args[i], r);
+    std::sort(args.begin(), args.end(), is_norm_lt);
+    unsigned i = 0;
+    if (is_explicit(args[i])) {
+        // find max explicit universe
+        while (i+1 < args.size() && is_explicit(args[i+1]))
+            i++;
+        lean_assert(is_explicit(args[i]));
+        unsigned k = to_offset(args[i]).second;
+        // an explicit universe k is subsumed by succ^k(l)
+        unsigned j = i+1;
+        for (; j < args.size(); j++) {
+            if (to_offset(args[j]).second >= k)
+                break;
+        }
+        if (j < args.size()) {
+            // explicit universe was subsumed by succ^k'(l) where k' >= k
+            i++;
+        }
+    }
+    buffer<level> rargs;
+    rargs.push_back(args[i]);
+    auto p_prev = to_offset(args[i]);
+    i++;
+    for (; i < args.size(); i++) {
+        auto p_curr = to_offset(args[i]);
+        if (p_prev.first == p_curr.first) {
+            if (p_prev.second < p_curr.second) {
+                p_prev = p_curr;
+                rargs.back() = args[i];
+            }
+        } else {
+            p_prev = p_curr;
+            rargs.push_back(args[i]);
         }
-        return r;
     }
+    unsigned n = rargs.size();
+    level r = rargs[n-1];
+    while (n > 1) {
+        --n;
+        r = mk_max_core(rargs[n-1], r);
+    }
+    return r;
+}
+
+level mk_max(buffer<level> const & args) {
+    lean_assert(!args.empty());
+    if (args.size() == 1)
+        return args[0];
+    buffer<level> fargs;
+    for (level const & a : args)
+        push_max_args(a, fargs);
+    return mk_max_canonical(fargs);
 }
 
 level mk_succ(level l, unsigned k) {
@@ -512,7 +560,61 @@ level mk_succ(level l, unsigned k) {
     return l;
 }
 
+#define LEAN_NORMALIZE_CACHE_CAPACITY 1024 /* must be a power of two */
+
+/* Thread-local memo for `normalize`.
+
+   Universe-polymorphic code normalizes the same handful of level expressions
+   on every defeq query. `m_entries` is a direct-mapped cache from the level's
+   identity to its normal form (a collision overwrites the slot), and
+   `m_canon` keeps one canonical representative per normal form, so repeated
+   queries return pointer-identical levels and the equality checks hit the
+   pointer fast path. */
+struct level_norm_cache {
+    struct entry {
+        optional<level> m_level;
+        level           m_result;
+    };
+    std::vector<entry>          m_entries;
+    std::vector<optional<level>> m_canon;
+    level_norm_cache():m_entries(LEAN_NORMALIZE_CACHE_CAPACITY), m_canon(LEAN_NORMALIZE_CACHE_CAPACITY) {}
+};
+MK_THREAD_LOCAL_GET_DEF(level_norm_cache, get_level_norm_cache);
+
+static unsigned level_ptr_hash(level const & l) {
+    return static_cast<unsigned>(reinterpret_cast<uintptr_t>(l.raw()) >> 4);
+}
+
+/* Return the canonical representative of normal form `r` on this thread. */
+static level canonicalize(level_norm_cache & c, level const & r) {
+    optional<level> & slot = c.m_canon[hash(r) & (LEAN_NORMALIZE_CACHE_CAPACITY - 1)];
+    if (slot && *slot == r)
+        return *slot;
+    slot = r;
+    return r;
+}
+
+static level normalize_core(level const & l);
+
 level normalize(level const & l) {
+    switch (kind(l)) {
+    case level_kind::Zero: case level_kind::Param:
+    case level_kind::MVar:
+        return l;
+    default:
+        break;
+    }
+    level_norm_cache & c = get_level_norm_cache();
+    level_norm_cache::entry & en = c.m_entries[level_ptr_hash(l) & (LEAN_NORMALIZE_CACHE_CAPACITY - 1)];
+    if (en.m_level && is_eqp(*en.m_level, l))
+        return en.m_result;
+    level r = canonicalize(c, normalize_core(l));
+    en.m_level  = l;
+    en.m_result = r;
+    return r;
+}
+
+static level normalize_core(level const & l) {
     auto p = to_offset(l);
     level const & r = p.first;
     switch (kind(r)) {
@@ -532,52 +634,24 @@ level normalize(level const & l) {
         push_max_args(r, todo);
         for (level const & a : todo)
             push_max_args(normalize(a), args);
-        std::sort(args.begin(), args.end(), is_norm_lt);
-        buffer<level> & rargs = todo;
-        rargs.clear();
-        unsigned i = 0;
-        if (is_explicit(args[i])) {
-            // find max explicit univierse
-            while (i+1 < args.size() && is_explicit(args[i+1]))
-                i++;
-            lean_assert(is_explicit(args[i]));
-            unsigned k = to_offset(args[i]).second;
-            // an explicit universe k is subsumed by succ^k(l)
-            unsigned j = i+1;
-            for (; j < args.size(); j++) {
-                if (to_offset(args[j]).second >= k)
-                    break;
-            }
-            if (j < args.size()) {
-                // explicit universe was subsumed by succ^k'(l) where k' >= k
-                i++;
-            }
+        /* A uniform `succ` offset preserves the `is_norm_lt` order and the
+           subsumption relations, so it can be distributed over the arms before
+           the canonical rebuild. */
+        if (p.second > 0) {
+            for (level & a : args)
+                a = mk_succ(a, p.second);
         }
-        rargs.push_back(args[i]);
-        auto p_prev = to_offset(args[i]);
-        i++;
-        for (; i < args.size(); i++) {
-            auto p_curr = to_offset(args[i]);
-            if (p_prev.first == p_curr.first) {
-                if (p_prev.second < p_curr.second) {
-                    p_prev = p_curr;
-                    rargs.pop_back();
-                    rargs.push_back(args[i]);
-                }
-            } else {
-                p_prev = p_curr;
-                rargs.push_back(args[i]);
-            }
-        }
-        for (level & a : rargs)
-            a = mk_succ(a, p.second);
-        return mk_max(rargs);
+        return mk_max_canonical(args);
     }}
     lean_unreachable(); // LCOV_EXCL_LINE
 }
 
 bool is_equivalent(level const & lhs, level const & rhs) {
+    if (is_eqp(lhs, rhs))
+        return true;
     check_system("level constraints");
+    /* Normal forms are canonicalized per thread, so for repeated queries the
+       comparison below reduces to the pointer fast path. */
     return lhs == rhs || normalize(lhs) == normalize(rhs);
 }
 
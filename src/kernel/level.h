@@ -116,7 +116,14 @@ inline bool is_max(level const & l)    { return l.is_max(); }
 inline bool is_imax(level const & l)   { return l.is_imax(); }
 bool is_one(level const & l);
 
-unsigned get_depth(level const & l);
+/* Packed Level.Data word, computed at construction by `Level.mkData` (see
+   src/Lean/Level.lean) and stored as the trailing scalar field of every level
+   constructor: bits 0-31 hash, bit 32 hasMVar, bit 33 hasParam, bits 40-63
+   depth. Reading it directly gives single-load accessors without crossing into
+   the Lean-exported wrappers (which take an owned argument). */
+inline uint64 level_data_core(object * o) { return lean_ctor_get_uint64(o, lean_ctor_num_objs(o) * sizeof(object *)); }
+inline uint64 level_data(level const & l) { return level_data_core(l.raw()); }
+inline unsigned get_depth(level const & l) { return static_cast<unsigned>(level_data(l) >> 40); }
 
 /** \brief Return true iff \c l is an explicit level.
     We say a level l is explicit iff
@@ -127,9 +134,9 @@ bool is_explicit(level const & l);
     \pre is_explicit(l) */
 unsigned to_explicit(level const & l);
 /** \brief Return true iff \c l contains placeholder (aka meta parameters). */
-bool has_mvar(level const & l);
+inline bool has_mvar(level const & l) { return (level_data(l) >> 32) & 1; }
 /** \brief Return true iff \c l contains parameters */
-bool has_param(level const & l);
+inline bool has_param(level const & l) { return (level_data(l) >> 33) & 1; }
 
 /** \brief Return a new level expression based on <tt>l == succ(arg)</tt>, where \c arg is replaced with
     \c new_arg.
@@ -6,6 +6,7 @@ Author: Leonardo de Moura
 */
 #include <limits>
 #include <lean/sstream.h>
+#include <lean/object.h>
 #include "kernel/local_ctx.h"
 #include "kernel/abstract.h"
 
@@ -49,7 +50,7 @@ extern "C" object * lean_local_ctx_mk_let_decl(object * lctx, object * name, obj
 extern "C" object * lean_local_ctx_find(object * lctx, object * name);
 extern "C" object * lean_local_ctx_erase(object * lctx, object * name);
 
-local_ctx::local_ctx():object_ref(lean_mk_empty_local_ctx(box(0))) {
+local_ctx::local_ctx():object_ref(lean_mk_empty_local_ctx(box(0))), m_index(std::make_shared<index>()) {
 }
 
 bool local_ctx::empty() const {
@@ -59,16 +60,32 @@ bool local_ctx::empty() const {
 local_decl local_ctx::mk_local_decl(name const & n, name const & un, expr const & type, expr const & value) {
     unsigned idx = unbox(lean_local_ctx_num_indices(to_obj_arg()));
     m_obj = lean_local_ctx_mk_let_decl(raw(), n.to_obj_arg(), un.to_obj_arg(), type.to_obj_arg(), value.to_obj_arg(), false);
-    return local_decl(idx, n, un, type, value);
+    local_decl d(idx, n, un, type, value);
+    if (m_index) {
+        ensure_unshared_index();
+        m_index->m_decls[n] = d;
+    }
+    return d;
 }
 
 local_decl local_ctx::mk_local_decl(name const & n, name const & un, expr const & type, binder_info bi) {
     unsigned idx = unbox(lean_local_ctx_num_indices(to_obj_arg()));
     m_obj = lean_local_ctx_mk_local_decl(raw(), n.to_obj_arg(), un.to_obj_arg(), type.to_obj_arg(), static_cast<uint8>(bi));
-    return local_decl(idx, n, un, type, bi);
+    local_decl d(idx, n, un, type, bi);
+    if (m_index) {
+        ensure_unshared_index();
+        m_index->m_decls[n] = d;
+    }
+    return d;
 }
 
 optional<local_decl> local_ctx::find_local_decl(name const & n) const {
+    if (m_index) {
+        auto it = m_index->m_decls.find(n);
+        if (it == m_index->m_decls.end())
+            return optional<local_decl>();
+        return optional<local_decl>(it->second);
+    }
     return to_optional<local_decl>(lean_local_ctx_find(to_obj_arg(), n.to_obj_arg()));
 }
 
@@ -88,6 +105,19 @@ expr local_ctx::get_local(name const & n) const {
 
 void local_ctx::clear(local_decl const & d) {
     m_obj = lean_local_ctx_erase(m_obj, d.get_name().to_obj_arg());
+    if (m_index) {
+        ensure_unshared_index();
+        m_index->m_decls.erase(d.get_name());
+    }
+}
+
+void local_ctx::mark_index_mt() const {
+    if (!m_index)
+        return;
+    for (auto const & p : m_index->m_decls) {
+        mark_mt(p.first.raw());
+        mark_mt(p.second.raw());
+    }
 }
 
 template<bool is_lambda>
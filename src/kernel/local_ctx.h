@@ -5,9 +5,11 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <memory>
 #include "util/name_generator.h"
 #include "util/rb_map.h"
 #include "util/name_map.h"
+#include "util/name_hash_map.h"
 #include "kernel/expr.h"
 
 namespace lean {
@@ -45,18 +47,39 @@ public:
     expr mk_ref() const;
 };
 
-/* Plain local context object used by the kernel type checker. */
+/* Plain local context object used by the kernel type checker.
+
+   The underlying Lean object remains the authoritative representation (it is
+   stored in kernel exceptions and may be handed back to Lean code), but
+   contexts built from scratch in C++ also maintain a flat side index from
+   fvar ids to declarations. The index is shared between copies and cloned on
+   the first mutation after a copy, so snapshot/backtrack (e.g. `flet` in the
+   type checker) stays cheap while declaration lookup is a single hash probe
+   instead of a walk over the persistent maps of the Lean representation.
+   Contexts received from Lean code have no index and fall back to the Lean
+   lookup functions. */
 class local_ctx : public object_ref {
 protected:
+    struct index {
+        name_hash_map<local_decl> m_decls;
+    };
+    std::shared_ptr<index> m_index;
+
+    /* Clone the index if it is shared with another context (copy-on-write). */
+    void ensure_unshared_index() {
+        if (m_index.use_count() != 1)
+            m_index = std::make_shared<index>(*m_index);
+    }
+
     template<bool is_lambda> expr mk_binding(unsigned num, expr const * fvars, expr const & b, bool remove_dead_let = false) const;
 public:
     local_ctx();
     explicit local_ctx(obj_arg o):object_ref(o) {}
     local_ctx(b_obj_arg o, bool):object_ref(o, true) {}
-    local_ctx(local_ctx const & other):object_ref(other) {}
-    local_ctx(local_ctx && other):object_ref(other) {}
-    local_ctx & operator=(local_ctx const & other) { object_ref::operator=(other); return *this; }
-    local_ctx & operator=(local_ctx && other) { object_ref::operator=(other); return *this; }
+    local_ctx(local_ctx const & other):object_ref(other), m_index(other.m_index) {}
+    local_ctx(local_ctx && other):object_ref(other), m_index(std::move(other.m_index)) {}
+    local_ctx & operator=(local_ctx const & other) { object_ref::operator=(other); m_index = other.m_index; return *this; }
+    local_ctx & operator=(local_ctx && other) { object_ref::operator=(other); m_index = std::move(other.m_index); return *this; }
 
     bool empty() const;
 
@@ -91,6 +114,10 @@ public:
     /** \brief Remove the given local decl. */
     void clear(local_decl const & d);
 
+    /** \brief Mark the declarations in the lookup index as multi-threaded.
+        Must be invoked before this context (or a copy of it) is shared with other threads. */
+    void mark_index_mt() const;
+
     expr mk_lambda(unsigned num, expr const * fvars, expr const & e, bool remove_dead_let = false) const;
     expr mk_pi(unsigned num, expr const * fvars, expr const & e, bool remove_dead_let = false) const;
     expr mk_lambda(buffer<expr> const & fvars, expr const & e, bool remove_dead_let = false) const { return mk_lambda(fvars.size(), fvars.data(), e, remove_dead_let); }
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2013 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include <lean/thread.h>
+#include "util/buffer.h"
+#include "kernel/expr.h"
+
+namespace lean {
+#if defined(LEAN_MULTI_THREAD)
+/* Helpers shared by par_for_each/par_replace: partition the top of an
+   expression DAG into subtree roots ("chunks") that worker threads can
+   traverse independently. The caller finishes with a sequential pass over the
+   small spine above the chunks, short-circuiting at the chunk roots. */
+
+#ifndef LEAN_PAR_TRAVERSE_CHUNK_FACTOR
+#define LEAN_PAR_TRAVERSE_CHUNK_FACTOR 8 /* chunks per worker thread */
+#endif
+
+/** \brief Expand \c root breadth-first until about \c target distinct subtree
+    roots remain, and store them in \c chunks. Atomic subexpressions are
+    dropped during the expansion; they are covered by the caller's spine pass.
+    If the expression is exhausted before the target is reached, \c chunks may
+    end up empty or tiny and the caller should fall back to a sequential
+    traversal. */
+inline void partition_expr(expr const & root, unsigned target, buffer<expr> & chunks) {
+    std::deque<expr> q;
+    std::unordered_set<object const *> seen;
+    q.push_back(root);
+    seen.insert(root.raw());
+    auto push = [&](expr const & c) {
+        if (seen.insert(c.raw()).second)
+            q.push_back(c);
+    };
+    while (!q.empty() && q.size() < target) {
+        expr e = q.front();
+        q.pop_front();
+        switch (e.kind()) {
+        case expr_kind::Const: case expr_kind::BVar:
+        case expr_kind::Sort:  case expr_kind::Lit:
+        case expr_kind::MVar:  case expr_kind::FVar:
+            break;
+        case expr_kind::MData:
+            push(mdata_expr(e));
+            break;
+        case expr_kind::Proj:
+            push(proj_expr(e));
+            break;
+        case expr_kind::App:
+            push(app_fn(e));
+            push(app_arg(e));
+            break;
+        case expr_kind::Lambda: case expr_kind::Pi:
+            push(binding_domain(e));
+            push(binding_body(e));
+            break;
+        case expr_kind::Let:
+            push(let_type(e));
+            push(let_value(e));
+            push(let_body(e));
+            break;
+        }
+    }
+    for (expr const & c : q)
+        chunks.push_back(c);
+}
+
+/** \brief Run `task(i, chunks[i])` for every chunk on up to
+    `hardware_concurrency()` worker threads. */
+template<typename TASK>
+void par_run_chunks(buffer<expr> const & chunks, TASK const & task) {
+    atomic<unsigned> next(0);
+    unsigned num_threads = std::min(hardware_concurrency(), static_cast<unsigned>(chunks.size()));
+    std::vector<std::unique_ptr<lthread>> threads;
+    for (unsigned i = 0; i < num_threads; i++) {
+        threads.emplace_back(new lthread([&]() {
+                    while (true) {
+                        unsigned j = next.fetch_add(1);
+                        if (j >= chunks.size())
+                            break;
+                        task(j, chunks[j]);
+                    }
+                }));
+    }
+    for (std::unique_ptr<lthread> & t : threads)
+        t->join();
+}
+#endif
+}
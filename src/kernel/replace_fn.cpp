@@ -6,8 +6,11 @@ Author: Leonardo de Moura
 */
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <lean/object.h>
 #include "kernel/replace_fn.h"
 #include "kernel/cache_stack.h"
+#include "kernel/par_traverse.h"
 
 #ifndef LEAN_DEFAULT_REPLACE_CACHE_CAPACITY
 #define LEAN_DEFAULT_REPLACE_CACHE_CAPACITY 1024*8
@@ -121,4 +124,35 @@ public:
 expr replace(expr const & e, std::function<optional<expr>(expr const &, unsigned)> const & f, bool use_cache) {
     return replace_rec_fn(f, use_cache)(e);
 }
+
+expr par_replace(expr const & e, std::function<optional<expr>(expr const &)> const & f) {
+#if defined(LEAN_MULTI_THREAD)
+    unsigned num_workers = hardware_concurrency();
+    if (num_workers >= 2) {
+        buffer<expr> chunks;
+        partition_expr(e, num_workers * LEAN_PAR_TRAVERSE_CHUNK_FACTOR, chunks);
+        if (chunks.size() >= 2) {
+            /* Reference counts on the graph are manipulated from several threads. */
+            mark_mt(e.raw());
+            std::vector<expr> results(chunks.size());
+            par_run_chunks(chunks, [&](unsigned i, expr const & c) {
+                    expr r = replace(c, [&](expr const & s, unsigned) { return f(s); });
+                    /* the new nodes become visible to the other threads */
+                    mark_mt(r.raw());
+                    results[i] = r;
+                });
+            std::unordered_map<object const *, expr const *> result_of;
+            for (unsigned i = 0; i < chunks.size(); i++)
+                result_of.insert(mk_pair(chunks[i].raw(), &results[i]));
+            return replace(e, [&](expr const & s, unsigned) -> optional<expr> {
+                    auto it = result_of.find(s.raw());
+                    if (it != result_of.end())
+                        return some_expr(*it->second);
+                    return f(s);
+                });
+        }
+    }
+#endif
+    return replace(e, [&](expr const & s, unsigned) { return f(s); });
+}
 }
@@ -24,4 +24,18 @@ expr replace(expr const & e, std::function<optional<expr>(expr const &, unsigned
 inline expr replace(expr const & e, std::function<optional<expr>(expr const &)> const & f, bool use_cache = true) {
     return replace(e, [&](expr const & e, unsigned) { return f(e); }, use_cache);
 }
+
+/** \brief Parallel variant of \c replace for offset-independent functors.
+
+    The expression DAG is partitioned at nodes near the root, the subtrees are
+    rewritten on worker threads (each with its own cache), and a final
+    sequential pass rewrites the small spine above the partition points,
+    splicing in the precomputed subtree results. The graph is marked
+    multi-thread before the traversal, and so are the new subtrees before they
+    are published.
+
+    \c f may be invoked from several threads concurrently, so it must be
+    effect-free or synchronize its own state. Falls back to a sequential
+    \c replace on small expressions and on non-multi-thread builds. */
+expr par_replace(expr const & e, std::function<optional<expr>(expr const &)> const & f);
 }
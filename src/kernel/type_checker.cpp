@@ -6,6 +6,7 @@ Author: Leonardo de Moura
 */
 #include <utility>
 #include <vector>
+#include <limits>
 #include <lean/interrupt.h>
 #include <lean/sstream.h>
 #include <lean/flet.h>
@@ -33,8 +34,334 @@ static expr * g_nat_div      = nullptr;
 static expr * g_nat_beq      = nullptr;
 static expr * g_nat_ble      = nullptr;
 
+expr * expr_ptr_cache::find(expr const & e) {
+    unsigned mask = m_entries.size() - 1;
+    unsigned i    = hash_ptr(e) & mask;
+    while (true) {
+        entry & en = m_entries[i];
+        if (!en.m_key || en.m_gen != m_gen) {
+            m_misses++;
+            return nullptr;
+        }
+        if (is_eqp(*en.m_key, e)) {
+            m_hits++;
+            return &en.m_result;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+void expr_ptr_cache::insert(expr const & e, expr const & v) {
+    if (m_size >= m_entries.size() / 2) {
+        /* Sweep before growing: when enough entries were pinning dead terms,
+           the table keeps its size, so a long-lived cache is bounded by its
+           live working set instead of everything it has ever seen. */
+        if (!sweep_dead())
+            grow();
+    }
+    unsigned mask = m_entries.size() - 1;
+    unsigned i    = hash_ptr(e) & mask;
+    while (true) {
+        entry & en = m_entries[i];
+        if (!en.m_key || en.m_gen != m_gen) {
+            en.m_key    = e;
+            en.m_result = v;
+            en.m_gen    = m_gen;
+            m_size++;
+            return;
+        }
+        if (is_eqp(*en.m_key, e)) {
+            en.m_result = v;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+/* An entry is dead when this table holds the only references to its key: the
+   key can never be produced again by the traversals feeding the cache (they
+   would have to hold a reference), so the entry can only waste memory. The
+   entry pins the key once, and a second time when the result is the key
+   itself (whnf fixpoints are common). Evicting an entry drops the references
+   its key and result hold to their subterms, so nested dead terms unravel
+   over successive sweeps. For MT keys the count is a relaxed snapshot: a
+   stale value only delays the eviction to a later sweep, since a count of
+   one cannot race with an increment (incrementing requires an owner, and the
+   table is the only one left). */
+bool expr_ptr_cache::is_dead(entry const & en) {
+    size_t pinned = is_eqp(*en.m_key, en.m_result) ? 2 : 1;
+    return rc_value(en.m_key->raw()) <= pinned;
+}
+
+bool expr_ptr_cache::sweep_dead() {
+    /* Linear probing does not support in-place deletion; rebuild instead. */
+    std::vector<entry> new_entries(m_entries.size());
+    unsigned mask     = m_entries.size() - 1;
+    unsigned new_size = 0;
+    for (entry & en : m_entries) {
+        if (en.m_key && en.m_gen == m_gen && !is_dead(en)) {
+            unsigned i = hash_ptr(*en.m_key) & mask;
+            while (new_entries[i].m_key)
+                i = (i + 1) & mask;
+            new_entries[i] = std::move(en);
+            new_size++;
+        }
+    }
+    m_entries.swap(new_entries);
+    unsigned evicted = m_size - new_size;
+    m_size           = new_size;
+    return 4 * evicted >= static_cast<unsigned>(m_entries.size());
+}
+
+void expr_ptr_cache::grow() {
+    std::vector<entry> new_entries(m_entries.size() * 2);
+    unsigned mask = new_entries.size() - 1;
+    for (entry & en : m_entries) {
+        if (en.m_key && en.m_gen == m_gen) {
+            unsigned i = hash_ptr(*en.m_key) & mask;
+            while (new_entries[i].m_key)
+                i = (i + 1) & mask;
+            new_entries[i] = std::move(en);
+        }
+    }
+    m_entries.swap(new_entries);
+}
+
+constant_info const * const_info_cache::find(name const & n) {
+    unsigned mask = m_entries.size() - 1;
+    unsigned i    = hash_ptr(n) & mask;
+    while (true) {
+        entry & en = m_entries[i];
+        if (en.m_key.is_anonymous())
+            return nullptr;
+        if (en.m_key.raw() == n.raw())
+            return &en.m_info;
+        i = (i + 1) & mask;
+    }
+}
+
+void const_info_cache::insert(name const & n, constant_info const & info) {
+    if (m_size >= m_entries.size() / 2)
+        grow();
+    unsigned mask = m_entries.size() - 1;
+    unsigned i    = hash_ptr(n) & mask;
+    while (true) {
+        entry & en = m_entries[i];
+        if (en.m_key.is_anonymous()) {
+            en.m_key  = n;
+            en.m_info = info;
+            m_size++;
+            return;
+        }
+        if (en.m_key.raw() == n.raw()) {
+            en.m_info = info;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+void const_info_cache::grow() {
+    std::vector<entry> new_entries(m_entries.size() * 2);
+    unsigned mask = new_entries.size() - 1;
+    for (entry & en : m_entries) {
+        if (!en.m_key.is_anonymous()) {
+            unsigned i = hash_ptr(en.m_key) & mask;
+            while (!new_entries[i].m_key.is_anonymous())
+                i = (i + 1) & mask;
+            new_entries[i] = std::move(en);
+        }
+    }
+    m_entries.swap(new_entries);
+}
+
+/* Environment-level whnf memo table.
+
+   Each `type_checker::state` starts with empty caches, so checking many small
+   declarations against the same environment re-normalizes the same
+   instance/recursor spines over and over. whnf results for closed terms do
+   not depend on the local context or checker flags, and extending the
+   environment cannot change them (constants are never redeclared), so they
+   can be shared across checker instances.
+
+   The table is tagged with the environment it was built against.
+   `environment::add` notifies it via `mark_whnf_cache_extension`, which
+   retargets the tag to the extended environment and keeps the entries;
+   switching to an unrelated environment resets the table. Keys are
+   expression identities, so cross-checker hits rely on the hash-consing
+   arena making structurally equal terms pointer-equal. */
+class whnf_shared_cache {
+    mutex                 m_mutex;
+    optional<environment> m_env;
+    expr_ptr_cache        m_cache;
+public:
+    uint64_t hits() const { return m_cache.hits(); }
+    uint64_t misses() const { return m_cache.misses(); }
+
+    optional<expr> find(environment const & env, expr const & e) {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_env || !is_eqp(*m_env, env))
+            return none_expr();
+        if (expr * r = m_cache.find(e))
+            return some_expr(*r);
+        return none_expr();
+    }
+    void insert(environment const & env, expr const & e, expr const & r) {
+        /* Cached expressions may be retrieved by checkers running on other
+           threads, so their reference counters must be thread safe. */
+        mark_mt(e.raw());
+        mark_mt(r.raw());
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_env || !is_eqp(*m_env, env)) {
+            m_env = optional<environment>(env);
+            m_cache.reset();
+        }
+        m_cache.insert(e, r);
+    }
+    void mark_extension(environment const & from, environment const & to) {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_env && is_eqp(*m_env, from))
+            m_env = optional<environment>(to);
+    }
+};
+
+static whnf_shared_cache * g_whnf_shared_cache = nullptr;
+
+#define LEAN_DEFEQ_FAILURE_CACHE_SIZE  8192 /* number of slots, must be a power of two */
+#define LEAN_DEFEQ_FAILURE_CACHE_ASSOC 4    /* slots probed per pair */
+
+/* Environment-level negative is_def_eq cache.
+
+   `type_checker::cache_failure` records failed defeq pairs only for the
+   lifetime of one checker, so overlapping goals re-checked by later checker
+   instances rediscover the same expensive failures. This table keeps the
+   failures across instances. A recorded failure cannot be invalidated by
+   extending the environment (new constants do not occur in old terms), so it
+   uses the same extension-tagging scheme as `whnf_shared_cache`; only pairs
+   without free variables are shared, since free variable ids are only
+   meaningful within one checker's local context.
+
+   The table is bounded: each pair hashes to a small window of slots and
+   insertion evicts the least recently used entry in the window (hits refresh
+   the stamp). The hit counter measures the unfolding work saved. */
+class defeq_failure_cache {
+    struct entry {
+        optional<expr> m_t;
+        optional<expr> m_s;
+        uint64_t       m_stamp{0};
+    };
+    mutex                 m_mutex;
+    optional<environment> m_env;
+    std::vector<entry>    m_entries;
+    uint64_t              m_stamp{0};
+    uint64_t              m_hits{0};
+    static unsigned hash_ptr(expr const & e) {
+        return static_cast<unsigned>(reinterpret_cast<uintptr_t>(e.raw()) >> 4);
+    }
+    static void normalize(expr const & t, expr const & s, expr const * & t1, expr const * & s1) {
+        /* Keys are pointer identities, so order the pair by address. */
+        if (t.raw() <= s.raw()) { t1 = &t; s1 = &s; } else { t1 = &s; s1 = &t; }
+    }
+    unsigned slot(expr const & t, expr const & s) const {
+        return hash(hash_ptr(t), hash_ptr(s)) & (LEAN_DEFEQ_FAILURE_CACHE_SIZE - 1);
+    }
+public:
+    defeq_failure_cache():m_entries(LEAN_DEFEQ_FAILURE_CACHE_SIZE) {}
+
+    bool contains(environment const & env, expr const & t, expr const & s) {
+        expr const * t1; expr const * s1;
+        normalize(t, s, t1, s1);
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_env || !is_eqp(*m_env, env))
+            return false;
+        unsigned i = slot(*t1, *s1);
+        for (unsigned j = 0; j < LEAN_DEFEQ_FAILURE_CACHE_ASSOC; j++) {
+            entry & en = m_entries[(i + j) & (LEAN_DEFEQ_FAILURE_CACHE_SIZE - 1)];
+            if (en.m_t && is_eqp(*en.m_t, *t1) && is_eqp(*en.m_s, *s1)) {
+                en.m_stamp = ++m_stamp;
+                m_hits++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void insert(environment const & env, expr const & t, expr const & s) {
+        expr const * t1; expr const * s1;
+        normalize(t, s, t1, s1);
+        /* see whnf_shared_cache::insert */
+        mark_mt(t.raw());
+        mark_mt(s.raw());
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_env || !is_eqp(*m_env, env)) {
+            m_env = optional<environment>(env);
+            for (entry & en : m_entries)
+                en = entry();
+        }
+        unsigned i       = slot(*t1, *s1);
+        entry *  victim  = nullptr;
+        for (unsigned j = 0; j < LEAN_DEFEQ_FAILURE_CACHE_ASSOC; j++) {
+            entry & en = m_entries[(i + j) & (LEAN_DEFEQ_FAILURE_CACHE_SIZE - 1)];
+            if (en.m_t && is_eqp(*en.m_t, *t1) && is_eqp(*en.m_s, *s1)) {
+                en.m_stamp = ++m_stamp;
+                return;
+            }
+            if (!victim || en.m_stamp < victim->m_stamp)
+                victim = &en;
+        }
+        victim->m_t     = *t1;
+        victim->m_s     = *s1;
+        victim->m_stamp = ++m_stamp;
+    }
+
+    void mark_extension(environment const & from, environment const & to) {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_env && is_eqp(*m_env, from))
+            m_env = optional<environment>(to);
+    }
+
+    uint64_t hits() const { return m_hits; }
+};
+
+static defeq_failure_cache * g_defeq_failure_cache = nullptr;
+
+void mark_kernel_cache_extension(environment const & from, environment const & to) {
+    if (g_whnf_shared_cache)
+        g_whnf_shared_cache->mark_extension(from, to);
+    if (g_defeq_failure_cache)
+        g_defeq_failure_cache->mark_extension(from, to);
+}
+
 type_checker::state::state(environment const & env):
-    m_env(env), m_ngen(*g_kernel_fresh) {}
+    m_env(env), m_ngen(*g_kernel_fresh),
+    m_failure(expr_pair_set::allocator_type(m_cache_region)) {}
+
+static bool decl_stats_enabled() {
+    static bool r = getenv("LEAN_KERNEL_DECL_STATS") != nullptr;
+    return r;
+}
+
+type_checker::state::~state() {
+    if (decl_stats_enabled() && m_decl) {
+        fprintf(stderr, "kernel stats: %s: whnf=%llu, unfolded=%llu, recursor=%llu, "
+                "cache hits=%llu, cache misses=%llu, max depth=%llu\n",
+                m_decl.to_string().c_str(),
+                static_cast<unsigned long long>(m_counters.m_whnf),
+                static_cast<unsigned long long>(m_counters.m_unfolded),
+                static_cast<unsigned long long>(m_counters.m_recursor),
+                static_cast<unsigned long long>(cache_hits()),
+                static_cast<unsigned long long>(cache_misses()),
+                static_cast<unsigned long long>(m_counters.m_max_depth));
+    }
+}
+
+uint64_t type_checker::state::cache_hits() const {
+    return m_infer_type[0].hits() + m_infer_type[1].hits() + m_whnf_core.hits() + m_whnf.hits();
+}
+
+uint64_t type_checker::state::cache_misses() const {
+    return m_infer_type[0].misses() + m_infer_type[1].misses() + m_whnf_core.misses() + m_whnf.misses();
+}
 
 /** \brief Make sure \c e "is" a sort, and return the corresponding sort.
     If \c e is not a sort, then the whnf procedure is invoked.
@@ -80,8 +407,28 @@ expr type_checker::infer_fvar(expr const & e) {
     }
 }
 
+/* Cached `environment::find`. The environment is fixed for the lifetime of the
+   checker state and constants are never redeclared, so a resolved `constant_info`
+   can be reused for every later occurrence of the same name. Only successful
+   lookups are cached; unknown constants are error paths. */
+optional<constant_info> type_checker::find_constant(name const & n) const {
+    if (constant_info const * info = m_st->m_const_info.find(n))
+        return optional<constant_info>(*info);
+    optional<constant_info> info = env().find(n);
+    if (info)
+        m_st->m_const_info.insert(n, *info);
+    return info;
+}
+
+/* Cached `environment::get`. */
+constant_info type_checker::get_constant(name const & n) const {
+    if (optional<constant_info> info = find_constant(n))
+        return *info;
+    throw unknown_constant_exception(env(), n);
+}
+
 expr type_checker::infer_constant(expr const & e, bool infer_only) {
-    constant_info info = env().get(const_name(e));
+    constant_info info = get_constant(const_name(e));
     auto const & ps = info.get_lparams();
     auto const & ls = const_levels(e);
     if (length(ps) != length(ls))
@@ -237,28 +584,43 @@ expr type_checker::infer_proj(expr const & e, bool infer_only) {
     name const & I_name  = const_name(I);
     if (I_name != proj_sname(e))
         throw invalid_proj_exception(env(), m_lctx, e);
-    constant_info I_info = env().get(I_name);
+    constant_info I_info = get_constant(I_name);
     if (!I_info.is_inductive())
         throw invalid_proj_exception(env(), m_lctx, e);
     inductive_val I_val = I_info.to_inductive_val();
     if (length(I_val.get_cnstrs()) != 1 || args.size() != I_val.get_nparams() + I_val.get_nindices())
         throw invalid_proj_exception(env(), m_lctx, e);
 
-    constant_info c_info = env().get(head(I_val.get_cnstrs()));
+    constant_info c_info = get_constant(head(I_val.get_cnstrs()));
     expr r = instantiate_type_lparams(c_info, const_levels(I));
-    for (unsigned i = 0; i < I_val.get_nparams(); i++) {
-        lean_assert(i < args.size());
-        r = whnf(r);
-        if (!is_pi(r)) throw invalid_proj_exception(env(), m_lctx, e);
-        r = instantiate(binding_body(r), args[i]);
-    }
-    for (unsigned i = 0; i < idx; i++) {
-        r = whnf(r);
-        if (!is_pi(r)) throw invalid_proj_exception(env(), m_lctx, e);
-        if (has_loose_bvars(binding_body(r)))
-            r = instantiate(binding_body(r), mk_proj(I_name, i, proj_expr(e)));
-        else
-            r = binding_body(r);
+    /* Constructor types are usually syntactic Pi telescopes, so the parameters
+       (and the fields before `idx`) can be substituted in a single traversal.
+       We only fall back to whnf-interleaved one-by-one instantiation when a
+       binder is hidden behind a reducible definition. */
+    if (optional<expr> r2 = instantiate_telescope(r, I_val.get_nparams(), args.data())) {
+        r = *r2;
+    } else {
+        for (unsigned i = 0; i < I_val.get_nparams(); i++) {
+            lean_assert(i < args.size());
+            r = whnf(r);
+            if (!is_pi(r)) throw invalid_proj_exception(env(), m_lctx, e);
+            r = instantiate(binding_body(r), args[i]);
+        }
+    }
+    buffer<expr> fields;
+    for (unsigned i = 0; i < idx; i++)
+        fields.push_back(mk_proj(I_name, i, proj_expr(e)));
+    if (optional<expr> r2 = instantiate_telescope(r, idx, fields.data())) {
+        r = *r2;
+    } else {
+        for (unsigned i = 0; i < idx; i++) {
+            r = whnf(r);
+            if (!is_pi(r)) throw invalid_proj_exception(env(), m_lctx, e);
+            if (has_loose_bvars(binding_body(r)))
+                r = instantiate(binding_body(r), fields[i]);
+            else
+                r = binding_body(r);
+        }
     }
     r = whnf(r);
     if (!is_pi(r)) throw invalid_proj_exception(env(), m_lctx, e);
@@ -274,9 +636,12 @@ expr type_checker::infer_type_core(expr const & e, bool infer_only) {
     lean_assert(!has_loose_bvars(e));
     check_system("type checker");
 
-    auto it = m_st->m_infer_type[infer_only].find(e);
-    if (it != m_st->m_infer_type[infer_only].end())
-        return it->second;
+    if (expr * it = m_st->m_infer_type[infer_only].find(e))
+        return *it;
+
+    if (m_depth >= m_st->m_counters.m_max_depth)
+        m_st->m_counters.m_max_depth = m_depth + 1;
+    flet<unsigned> inc_depth(m_depth, m_depth + 1);
 
     expr r;
     switch (e.kind()) {
@@ -298,7 +663,7 @@ expr type_checker::infer_type_core(expr const & e, bool infer_only) {
     case expr_kind::Let:      r = infer_let(e, infer_only);            break;
     }
 
-    m_st->m_infer_type[infer_only].insert(mk_pair(e, r));
+    m_st->m_infer_type[infer_only].insert(e, r);
     return r;
 }
 
@@ -306,8 +671,20 @@ expr type_checker::infer_type(expr const & e) {
     return infer_type_core(e, true);
 }
 
+static bool hash_cons_enabled() {
+    static bool r = getenv("LEAN_KERNEL_HASH_CONS") != nullptr;
+    return r;
+}
+
 expr type_checker::check(expr const & e, names const & lps) {
     flet<names const *> updt(m_lparams, &lps);
+    if (hash_cons_enabled()) {
+        /* Canonicalize every node the checker builds (whnf, instantiation,
+           inferred types), so repeated subterms of large auto-generated
+           proofs collapse and the pointer-equality fast paths fire. */
+        scoped_expr_hash_cons scope;
+        return infer_type_core(e, false);
+    }
     return infer_type_core(e, false);
 }
 
@@ -334,6 +711,7 @@ bool type_checker::is_prop(expr const & e) {
 optional<expr> type_checker::reduce_recursor(expr const & e, bool cheap) {
     if (env().is_quot_initialized()) {
         if (optional<expr> r = quot_reduce_rec(e, [&](expr const & e) { return whnf(e); })) {
+            m_st->m_counters.m_recursor++;
             return r;
         }
     }
@@ -341,6 +719,7 @@ optional<expr> type_checker::reduce_recursor(expr const & e, bool cheap) {
                                                 [&](expr const & e) { return cheap ? whnf_core(e, cheap) : whnf(e); },
                                                 [&](expr const & e) { return infer(e); },
                                                 [&](expr const & e1, expr const & e2) { return is_def_eq(e1, e2); })) {
+        m_st->m_counters.m_recursor++;
         return r;
     }
     return none_expr();
@@ -372,10 +751,18 @@ optional<expr> type_checker::reduce_proj(expr const & e, bool cheap) {
     expr const & mk = get_app_args(c, args);
     if (!is_constant(mk))
         return none_expr();
-    constant_info mk_info = env().get(const_name(mk));
-    if (!mk_info.is_constructor())
+    unsigned nparams;
+    auto it = m_st->m_cnstr_nparams.find(const_name(mk));
+    if (it != m_st->m_cnstr_nparams.end()) {
+        nparams = it->second;
+    } else {
+        constant_info mk_info = get_constant(const_name(mk));
+        nparams = mk_info.is_constructor() ? mk_info.to_constructor_val().get_nparams()
+                                           : std::numeric_limits<unsigned>::max();
+        m_st->m_cnstr_nparams[const_name(mk)] = nparams;
+    }
+    if (nparams == std::numeric_limits<unsigned>::max())
         return none_expr();
-    unsigned nparams = mk_info.to_constructor_val().get_nparams();
     if (nparams + idx < args.size())
         return some_expr(args[nparams + idx]);
     else
@@ -417,9 +804,8 @@ expr type_checker::whnf_core(expr const & e, bool cheap) {
 
     // check cache
     if (!cheap) {
-        auto it = m_st->m_whnf_core.find(e);
-        if (it != m_st->m_whnf_core.end())
-            return it->second;
+        if (expr * it = m_st->m_whnf_core.find(e))
+            return *it;
     }
 
     // do the actual work
@@ -443,14 +829,31 @@ expr type_checker::whnf_core(expr const & e, bool cheap) {
         expr f0 = get_app_rev_args(e, args);
         expr f = whnf_core(f0, cheap);
         if (is_lambda(f)) {
-            unsigned m = 1;
-            unsigned num_args = args.size();
-            while (is_lambda(binding_body(f)) && m < num_args) {
-                f = binding_body(f);
-                m++;
-            }
-            lean_assert(m <= num_args);
-            r = whnf_core(mk_rev_app(instantiate(binding_body(f), m, args.data() + (num_args - m)), num_args - m, args.data()), cheap);
+            /* Perform the beta steps iteratively over the argument buffer.
+               The recursive formulation materialized the application spine
+               after every step (`mk_rev_app`) only for the recursive call to
+               take it apart again, allocating O(|args|) app nodes per step
+               that die immediately. Here the spine only exists in `args`;
+               it is rebuilt at most once, when the head gets stuck. */
+            do {
+                unsigned num_args = args.size();
+                unsigned m = 1;
+                while (is_lambda(binding_body(f)) && m < num_args) {
+                    f = binding_body(f);
+                    m++;
+                }
+                lean_assert(m <= num_args);
+                expr h = instantiate(binding_body(f), m, args.data() + (num_args - m));
+                args.shrink(num_args - m);
+                /* `h` may itself be an application; its arguments are applied
+                   before the remaining ones, which is exactly the order in
+                   which `get_app_rev_args` appends them to `args`. */
+                f = whnf_core(get_app_rev_args(h, args), cheap);
+            } while (is_lambda(f) && !args.empty());
+            if (args.empty())
+                r = f;
+            else
+                r = whnf_core(mk_rev_app(f, args.size(), args.data()), cheap);
         } else if (f == f0) {
             if (auto r = reduce_recursor(e, cheap)) {
                 /* iota-reduction and quotient reduction rules */
@@ -469,7 +872,7 @@ expr type_checker::whnf_core(expr const & e, bool cheap) {
     }
 
     if (!cheap) {
-        m_st->m_whnf_core.insert(mk_pair(e, r));
+        m_st->m_whnf_core.insert(e, r);
     }
     return r;
 }
@@ -479,7 +882,7 @@ expr type_checker::whnf_core(expr const & e, bool cheap) {
 optional<constant_info> type_checker::is_delta(expr const & e) const {
     expr const & f = get_app_fn(e);
     if (is_constant(f)) {
-        if (optional<constant_info> info = env().find(const_name(f)))
+        if (optional<constant_info> info = find_constant(const_name(f)))
             if (info->has_value())
                 return info;
     }
@@ -489,8 +892,10 @@ optional<constant_info> type_checker::is_delta(expr const & e) const {
 optional<expr> type_checker::unfold_definition_core(expr const & e) {
     if (is_constant(e)) {
         if (auto d = is_delta(e)) {
-            if (length(const_levels(e)) == d->get_num_lparams())
+            if (length(const_levels(e)) == d->get_num_lparams()) {
+                m_st->m_counters.m_unfolded++;
                 return some_expr(instantiate_value_lparams(*d, const_levels(e)));
+            }
         }
     }
     return none_expr();
@@ -616,25 +1021,39 @@ expr type_checker::whnf(expr const & e) {
         break;
     }
 
+    m_st->m_counters.m_whnf++;
+
     // check cache
-    auto it = m_st->m_whnf.find(e);
-    if (it != m_st->m_whnf.end())
-        return it->second;
+    if (expr * it = m_st->m_whnf.find(e))
+        return *it;
+
+    /* Closed terms can also be served from/recorded in the memo table shared
+       across checker instances; see `whnf_shared_cache`. */
+    bool shared = !has_fvar(e) && !has_mvar(e);
+    if (shared) {
+        if (optional<expr> r = g_whnf_shared_cache->find(env(), e)) {
+            m_st->m_whnf.insert(e, *r);
+            return *r;
+        }
+    }
 
     expr t = e;
     while (true) {
         expr t1 = whnf_core(t);
         if (auto v = reduce_native(env(), t1)) {
-            m_st->m_whnf.insert(mk_pair(e, *v));
+            m_st->m_whnf.insert(e, *v);
+            if (shared) g_whnf_shared_cache->insert(env(), e, *v);
             return *v;
         } else if (auto v = reduce_nat(t1)) {
-            m_st->m_whnf.insert(mk_pair(e, *v));
+            m_st->m_whnf.insert(e, *v);
+            if (shared) g_whnf_shared_cache->insert(env(), e, *v);
             return *v;
         } else if (auto next_t = unfold_definition(t1)) {
             t = *next_t;
         } else {
             auto r = t1;
-            m_st->m_whnf.insert(mk_pair(e, r));
+            m_st->m_whnf.insert(e, r);
+            if (shared) g_whnf_shared_cache->insert(env(), e, r);
             return r;
         }
     }
@@ -785,14 +1204,20 @@ bool type_checker::is_def_eq_proof_irrel(expr const & t, expr const & s) {
 
 bool type_checker::failed_before(expr const & t, expr const & s) const {
     if (hash(t) < hash(s)) {
-        return m_st->m_failure.find(mk_pair(t, s)) != m_st->m_failure.end();
+        if (m_st->m_failure.find(mk_pair(t, s)) != m_st->m_failure.end())
+            return true;
     } else if (hash(t) > hash(s)) {
-        return m_st->m_failure.find(mk_pair(s, t)) != m_st->m_failure.end();
+        if (m_st->m_failure.find(mk_pair(s, t)) != m_st->m_failure.end())
+            return true;
     } else {
-        return
-            m_st->m_failure.find(mk_pair(t, s)) != m_st->m_failure.end() ||
-            m_st->m_failure.find(mk_pair(s, t)) != m_st->m_failure.end();
+        if (m_st->m_failure.find(mk_pair(t, s)) != m_st->m_failure.end() ||
+            m_st->m_failure.find(mk_pair(s, t)) != m_st->m_failure.end())
+            return true;
     }
+    /* Pairs without free variables may have been recorded by a previous
+       checker instance; see `defeq_failure_cache`. */
+    return !has_fvar(t) && !has_fvar(s) && !has_mvar(t) && !has_mvar(s) &&
+        g_defeq_failure_cache->contains(env(), t, s);
 }
 
 void type_checker::cache_failure(expr const & t, expr const & s) {
@@ -800,6 +1225,8 @@ void type_checker::cache_failure(expr const & t, expr const & s) {
         m_st->m_failure.insert(mk_pair(t, s));
     else
         m_st->m_failure.insert(mk_pair(s, t));
+    if (!has_fvar(t) && !has_fvar(s) && !has_mvar(t) && !has_mvar(s))
+        g_defeq_failure_cache->insert(env(), t, s);
 }
 
 /** \brief Perform one lazy delta-reduction step.
@@ -1056,9 +1483,21 @@ void initialize_type_checker() {
     g_lean_reduce_nat  = new expr(mk_constant(name{"Lean", "reduceNat"}));
     mark_persistent(g_lean_reduce_nat->raw());
     register_name_generator_prefix(*g_kernel_fresh);
+    g_whnf_shared_cache    = new whnf_shared_cache();
+    g_defeq_failure_cache  = new defeq_failure_cache();
 }
 
 void finalize_type_checker() {
+    if (getenv("LEAN_KERNEL_CACHE_STATS")) {
+        fprintf(stderr, "shared whnf cache hits: %llu, misses: %llu, defeq failure cache hits: %llu\n",
+                static_cast<unsigned long long>(g_whnf_shared_cache->hits()),
+                static_cast<unsigned long long>(g_whnf_shared_cache->misses()),
+                static_cast<unsigned long long>(g_defeq_failure_cache->hits()));
+    }
+    delete g_defeq_failure_cache;
+    g_defeq_failure_cache = nullptr;
+    delete g_whnf_shared_cache;
+    g_whnf_shared_cache = nullptr;
     delete g_dont_care;
     delete g_kernel_fresh;
     delete g_nat_succ;
@@ -6,11 +6,14 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <unordered_set>
+#include <vector>
 #include <memory>
 #include <utility>
 #include <algorithm>
+#include <lean/alloc.h>
 #include "util/lbool.h"
 #include "util/name_set.h"
+#include "util/name_hash_map.h"
 #include "util/name_generator.h"
 #include "kernel/environment.h"
 #include "kernel/local_ctx.h"
@@ -18,32 +21,134 @@ Author: Leonardo de Moura
 #include "kernel/equiv_manager.h"
 
 namespace lean {
+/** \brief Flat open-addressing map from expressions to expressions, keyed by
+    expression identity (pointer). The type checker's infer/whnf caches are hit
+    on every node it visits, and the node-based `expr_map` spent most of that
+    time chasing bucket pointers. Entries carry a generation stamp, so `reset`
+    invalidates the whole table in O(1); stale entries are treated as free
+    slots and reclaimed as they are overwritten. Hit/miss counters are
+    cumulative (they survive `reset`) so the caches can be sized per workload. */
+class expr_ptr_cache {
+    struct entry {
+        optional<expr> m_key;
+        expr           m_result;
+        uint64_t       m_gen{0};
+    };
+    std::vector<entry> m_entries;
+    unsigned           m_size{0};
+    uint64_t           m_gen{1};
+    uint64_t           m_hits{0};
+    uint64_t           m_misses{0};
+    static unsigned hash_ptr(expr const & e) {
+        return static_cast<unsigned>(reinterpret_cast<uintptr_t>(e.raw()) >> 4);
+    }
+    static bool is_dead(entry const & en);
+    void grow();
+public:
+    /* `capacity` must be a power of two. */
+    explicit expr_ptr_cache(unsigned capacity = 1024):m_entries(capacity) {}
+    expr * find(expr const & e);
+    void insert(expr const & e, expr const & v);
+    /* Invalidate every entry without touching them. */
+    void reset() { m_gen++; m_size = 0; }
+    /* Drop every entry whose key is not referenced outside this table (the
+       term cannot be looked up by identity anymore, so the entry only
+       retains memory), and release entries invalidated by `reset`. Entries
+       are weak in aggregate: a long-lived table converges to the live
+       working set over successive sweeps without a hook into the reference
+       counting fast path. Returns true if the sweep freed at least a
+       quarter of the table, i.e., growing can be postponed. */
+    bool sweep_dead();
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+};
+
+/* Open-addressing cache from constant name (by pointer identity) to its
+   `constant_info`. A checker state works against a fixed environment, so
+   entries never go stale and the table only grows. The kernel resolves the
+   same few names millions of times per declaration; a hit here replaces the
+   structural name hash and persistent-map walk of `environment::find` with a
+   single probe. Entries pin their keys, so misses caused by structurally
+   equal but not pointer-equal names stay correct — they merely occupy a
+   second slot. */
+class const_info_cache {
+    struct entry {
+        name          m_key; /* slot is free iff anonymous */
+        constant_info m_info;
+    };
+    std::vector<entry> m_entries;
+    unsigned           m_size{0};
+    static unsigned hash_ptr(name const & n) {
+        return static_cast<unsigned>(reinterpret_cast<uintptr_t>(n.raw()) >> 4);
+    }
+    void grow();
+public:
+    /* `capacity` must be a power of two. */
+    explicit const_info_cache(unsigned capacity = 256):m_entries(capacity) {}
+    constant_info const * find(name const & n);
+    void insert(name const & n, constant_info const & info);
+};
+
 /** \brief Lean Type Checker. It can also be used to infer types, check whether a
     type \c A is convertible to a type \c B, etc. */
 class type_checker {
 public:
     class state {
-        typedef expr_map<expr> infer_cache;
-        typedef std::unordered_set<expr_pair, expr_pair_hash, expr_pair_eq> expr_pair_set;
+    public:
+        /** \brief Cheap operation counters accumulated over the state's lifetime
+            (one declaration in the `environment::add` paths). With
+            `LEAN_KERNEL_DECL_STATS` set they are printed per declaration, so CI
+            can flag declarations whose unfolding work regresses. */
+        struct counters {
+            uint64_t m_whnf{0};
+            uint64_t m_unfolded{0};
+            uint64_t m_recursor{0};
+            uint64_t m_max_depth{0};
+        };
+    private:
+        /* The failure set is scratch data that dies together when the state is
+           dropped, so its node storage comes from a region that is released
+           wholesale instead of going through the small allocator's free lists.
+           Must be declared before the set below. */
+        typedef std::unordered_set<expr_pair, expr_pair_hash, expr_pair_eq,
+                                   region_allocator<expr_pair>> expr_pair_set;
+        region                    m_cache_region;
         environment               m_env;
         name_generator            m_ngen;
-        infer_cache               m_infer_type[2];
-        expr_map<expr>            m_whnf_core;
-        expr_map<expr>            m_whnf;
+        expr_ptr_cache            m_infer_type[2];
+        expr_ptr_cache            m_whnf_core;
+        expr_ptr_cache            m_whnf;
+        const_info_cache          m_const_info;
         equiv_manager             m_eqv_manager;
         expr_pair_set             m_failure;
+        /* Projection reduction memo: number of parameters of a constructor,
+           `UINT_MAX` for constants that are not constructors. Avoids resolving
+           the same head through the environment on every `reduce_proj`. */
+        name_hash_map<unsigned>   m_cnstr_nparams;
+        counters                  m_counters;
+        /* name of the declaration being checked; labels `LEAN_KERNEL_DECL_STATS` output */
+        name                      m_decl;
         friend type_checker;
     public:
         state(environment const & env);
+        ~state();
         environment & env() { return m_env; }
         environment const & env() const { return m_env; }
         name_generator & ngen() { return m_ngen; }
+        void set_decl(name const & n) { m_decl = n; }
+        counters const & get_counters() const { return m_counters; }
+        /* Aggregate hit/miss counters over the infer/whnf caches. */
+        uint64_t cache_hits() const;
+        uint64_t cache_misses() const;
     };
 private:
     bool                      m_st_owner;
     state *                   m_st;
     local_ctx                 m_lctx;
     bool                      m_safe_only;
+    /* current `infer_type_core` recursion depth; its high-water mark is recorded
+       in the state's counters */
+    unsigned                  m_depth{0};
     /* When `m_lparams != nullptr, the `check` method makes sure all level parameters
        are in `m_lparams`. */
     names const *             m_lparams;
@@ -52,6 +157,8 @@ private:
     expr ensure_pi_core(expr e, expr const & s);
     void check_level(level const & l);
     expr infer_fvar(expr const & e);
+    optional<constant_info> find_constant(name const & n) const;
+    constant_info get_constant(name const & n) const;
     expr infer_constant(expr const & e, bool infer_only);
     expr infer_lambda(expr const & e, bool infer_only);
     expr infer_pi(expr const & e, bool infer_only);
@@ -104,6 +211,10 @@ public:
 
     environment const & env() const { return m_st->m_env; }
 
+    /* Label the checker's state with the declaration being checked; see
+       `state::counters`. */
+    void set_decl(name const & n) { m_st->set_decl(n); }
+
     /** \brief Return the type of \c t.
         It does not check whether the input expression is type correct or not.
         The contract is: IF the input expression is type correct, then the inferred
@@ -142,6 +253,11 @@ public:
     optional<expr> unfold_definition(expr const & e);
 };
 
+/* Tell the shared kernel caches (whnf memo table, defeq failure cache) that
+   `to` was obtained by extending `from`, so entries recorded against `from`
+   remain valid. Called by `environment::add`. */
+void mark_kernel_cache_extension(environment const & from, environment const & to);
+
 void initialize_type_checker();
 void finalize_type_checker();
 }
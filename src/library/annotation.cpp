@@ -26,29 +26,44 @@ void register_annotation(name const & kind) {
     g_annotation_maps->insert(mk_pair(kind, mk_annotation_kvmap(kind)));
 }
 
+/* Return a pointer to the annotation kind stored in `e`'s mdata map, or
+   nullptr if `e` is not an annotation. This is the single primitive the
+   public predicates/accessors are built on: annotation kvmaps are singleton
+   lists, so one walk suffices, and returning a borrowed pointer avoids the
+   `optional<name>`/`optional<expr>` reference-count traffic the passes that
+   strip annotations (e.g. erase_irrelevant, csimp) would otherwise pay on
+   every node they visit. */
+static name const * annotation_kind_core(expr const & e) {
+    if (!is_mdata(e))
+        return nullptr;
+    for (kvmap_entry const & entry : mdata_data(e)) {
+        if (entry.fst() == *g_annotation && entry.snd().kind() == data_value_kind::Name)
+            return &entry.snd().get_name();
+    }
+    return nullptr;
+}
+
 optional<expr> is_annotation(expr const & e) {
-    expr e2 = e;
-    if (is_mdata(e2) && get_name(mdata_data(e2), *g_annotation))
-        return some_expr(e2);
+    if (annotation_kind_core(e))
+        return some_expr(e);
     else
         return none_expr();
 }
 
 name get_annotation_kind(expr const & e) {
-    auto o = is_annotation(e);
-    lean_assert(o);
-    return *get_name(mdata_data(*o), *g_annotation);
+    name const * kind = annotation_kind_core(e);
+    lean_assert(kind);
+    return *kind;
 }
 
 bool is_annotation(expr const & e, name const & kind) {
-    auto o = is_annotation(e);
-    return o && get_annotation_kind(*o) == kind;
+    name const * k = annotation_kind_core(e);
+    return k && *k == kind;
 }
 
 expr const & get_annotation_arg(expr const & e) {
-    auto o = is_annotation(e);
-    lean_assert(o);
-    return mdata_expr(*o);
+    lean_assert(annotation_kind_core(e));
+    return mdata_expr(e);
 }
 
 expr mk_annotation(name const & kind, expr const & e) {
@@ -65,33 +80,35 @@ expr mk_annotation(name const & kind, expr const & e) {
 
 bool is_nested_annotation(expr const & e, name const & kind) {
     expr const * it = &e;
-    while (is_annotation(*it)) {
-        if (get_annotation_kind(*it) == kind)
+    while (name const * k = annotation_kind_core(*it)) {
+        if (*k == kind)
             return true;
-        it = &get_annotation_arg(*it);
+        it = &mdata_expr(*it);
     }
     return false;
 }
 
 expr const & get_nested_annotation_arg(expr const & e) {
     expr const * it = &e;
-    while (is_annotation(*it))
-        it = &get_annotation_arg(*it);
+    while (annotation_kind_core(*it))
+        it = &mdata_expr(*it);
     return *it;
 }
 
 expr copy_annotations(expr const & from, expr const & to) {
     buffer<expr> trace;
     expr const * it = &from;
-    while (is_annotation(*it)) {
+    while (annotation_kind_core(*it)) {
         trace.push_back(*it);
-        it = &get_annotation_arg(*it);
+        it = &mdata_expr(*it);
     }
     expr r     = to;
     unsigned i = trace.size();
     while (i > 0) {
         --i;
-        r = mk_annotation(get_annotation_kind(trace[i]), r);
+        /* Reuse the traced node's kvmap instead of re-resolving the kind
+           through the registration table. */
+        r = mk_mdata(mdata_data(trace[i]), r);
     }
     return r;
 }
@@ -100,11 +117,17 @@ static name * g_have       = nullptr;
 static name * g_show       = nullptr;
 static name * g_suffices   = nullptr;
 static name * g_checkpoint = nullptr;
-
-expr mk_have_annotation(expr const & e) { return mk_annotation(*g_have, e); }
-expr mk_show_annotation(expr const & e) { return mk_annotation(*g_show, e); }
-expr mk_suffices_annotation(expr const & e) { return mk_annotation(*g_suffices, e); }
-expr mk_checkpoint_annotation(expr const & e) { return mk_annotation(*g_checkpoint, e); }
+/* Cached kvmaps for the pre-registered kinds: the helpers below are on hot
+   elaboration paths, so they skip the `g_annotation_maps` lookup. */
+static kvmap * g_have_map       = nullptr;
+static kvmap * g_show_map       = nullptr;
+static kvmap * g_suffices_map   = nullptr;
+static kvmap * g_checkpoint_map = nullptr;
+
+expr mk_have_annotation(expr const & e) { return mk_mdata(*g_have_map, e); }
+expr mk_show_annotation(expr const & e) { return mk_mdata(*g_show_map, e); }
+expr mk_suffices_annotation(expr const & e) { return mk_mdata(*g_suffices_map, e); }
+expr mk_checkpoint_annotation(expr const & e) { return mk_mdata(*g_checkpoint_map, e); }
 bool is_have_annotation(expr const & e) { return is_annotation(e, *g_have); }
 bool is_show_annotation(expr const & e) { return is_annotation(e, *g_show); }
 bool is_suffices_annotation(expr const & e) { return is_annotation(e, *g_suffices); }
@@ -127,9 +150,22 @@ void initialize_annotation() {
     register_annotation(*g_show);
     register_annotation(*g_suffices);
     register_annotation(*g_checkpoint);
+
+    g_have_map       = new kvmap(g_annotation_maps->find(*g_have)->second);
+    g_show_map       = new kvmap(g_annotation_maps->find(*g_show)->second);
+    g_suffices_map   = new kvmap(g_annotation_maps->find(*g_suffices)->second);
+    g_checkpoint_map = new kvmap(g_annotation_maps->find(*g_checkpoint)->second);
+    mark_persistent(g_have_map->raw());
+    mark_persistent(g_show_map->raw());
+    mark_persistent(g_suffices_map->raw());
+    mark_persistent(g_checkpoint_map->raw());
 }
 
 void finalize_annotation() {
+    delete g_checkpoint_map;
+    delete g_suffices_map;
+    delete g_show_map;
+    delete g_have_map;
     delete g_checkpoint;
     delete g_show;
     delete g_have;
@@ -4,6 +4,8 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <lean/thread.h>
+#include "util/name_hash_map.h"
 #include "library/aux_recursors.h"
 
 namespace lean {
@@ -20,11 +22,40 @@ environment add_no_confusion(environment const & env, name const & r) {
     return environment(lean_mark_no_confusion(env.to_obj_arg(), r.to_obj_arg()));
 }
 
+/* Per-environment memo for the two tag queries, same scheme as the class
+   predicate cache in library/class.cpp (a "known" bit and a value bit per
+   predicate). Both are asked per constant by the compiler front end and
+   resolve through a dynamic extension lookup on the Lean side. */
+struct aux_rec_cache {
+    optional<environment>   m_env;
+    name_hash_map<unsigned> m_flags;
+};
+
+MK_THREAD_LOCAL_GET_DEF(aux_rec_cache, get_aux_rec_cache);
+
+static bool is_cached_pred(environment const & env, name const & n, unsigned known_bit, unsigned value_bit,
+                           uint8 (*fn)(object *, object *)) {
+    aux_rec_cache & cache = get_aux_rec_cache();
+    if (!cache.m_env || !is_eqp(*cache.m_env, env)) {
+        cache.m_env = optional<environment>(env);
+        cache.m_flags.clear();
+    }
+    auto it        = cache.m_flags.find(n);
+    unsigned flags = it != cache.m_flags.end() ? it->second : 0;
+    if (!(flags & known_bit)) {
+        if (fn(env.to_obj_arg(), n.to_obj_arg()))
+            flags |= value_bit;
+        flags |= known_bit;
+        cache.m_flags[n] = flags;
+    }
+    return (flags & value_bit) != 0;
+}
+
 bool is_aux_recursor(environment const & env, name const & r) {
-    return lean_is_aux_recursor(env.to_obj_arg(), r.to_obj_arg());
+    return is_cached_pred(env, r, 1 << 0, 1 << 1, lean_is_aux_recursor);
 }
 
 bool is_no_confusion(environment const & env, name const & r) {
-    return lean_is_no_confusion(env.to_obj_arg(), r.to_obj_arg());
+    return is_cached_pred(env, r, 1 << 2, 1 << 3, lean_is_no_confusion);
 }
 }
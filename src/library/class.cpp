@@ -5,7 +5,9 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <string>
+#include <lean/thread.h>
 #include "util/io.h"
+#include "util/name_hash_map.h"
 #include "library/class.h"
 
 namespace lean {
@@ -14,10 +16,45 @@ extern "C" uint8 lean_is_instance(object* env, object* n);
 extern "C" uint8 lean_is_out_param(object* e);
 extern "C" uint8 lean_has_out_params(object* env, object* n);
 
+/* Per-environment memo for the class predicates.
+
+   Each query crosses into Lean code and resolves the class extension state
+   through a dynamic extension lookup. The compiler passes ask the same
+   questions about the same constants over and over against the same
+   environment, so the answers are memoized per constant in a thread-local
+   table tagged with the environment it was filled against; a query against a
+   different environment resets it. Each entry stores a bit pair per
+   predicate: "answer is cached" and the cached answer. */
+struct class_pred_cache {
+    optional<environment>   m_env;
+    name_hash_map<unsigned> m_flags;
+};
+
+MK_THREAD_LOCAL_GET_DEF(class_pred_cache, get_class_pred_cache);
+
+/* `known_bit`/`value_bit` select the bit pair for one of the predicates below. */
+static bool is_cached_pred(environment const & env, name const & n, unsigned known_bit, unsigned value_bit,
+                           uint8 (*fn)(object *, object *)) {
+    class_pred_cache & cache = get_class_pred_cache();
+    if (!cache.m_env || !is_eqp(*cache.m_env, env)) {
+        cache.m_env = optional<environment>(env);
+        cache.m_flags.clear();
+    }
+    auto it        = cache.m_flags.find(n);
+    unsigned flags = it != cache.m_flags.end() ? it->second : 0;
+    if (!(flags & known_bit)) {
+        if (fn(env.to_obj_arg(), n.to_obj_arg()))
+            flags |= value_bit;
+        flags |= known_bit;
+        cache.m_flags[n] = flags;
+    }
+    return (flags & value_bit) != 0;
+}
+
 bool is_class_out_param(expr const & e) { return lean_is_out_param(e.to_obj_arg()); }
-bool has_class_out_params(environment const & env, name const & c) { return lean_has_out_params(env.to_obj_arg(), c.to_obj_arg()); }
-bool is_class(environment const & env, name const & c) { return lean_is_class(env.to_obj_arg(), c.to_obj_arg()); }
-bool is_instance(environment const & env, name const & i) { return lean_is_instance(env.to_obj_arg(), i.to_obj_arg()); }
+bool has_class_out_params(environment const & env, name const & c) { return is_cached_pred(env, c, 1 << 0, 1 << 1, lean_has_out_params); }
+bool is_class(environment const & env, name const & c) { return is_cached_pred(env, c, 1 << 2, 1 << 3, lean_is_class); }
+bool is_instance(environment const & env, name const & i) { return is_cached_pred(env, i, 1 << 4, 1 << 5, lean_is_instance); }
 
 static name * g_anonymous_inst_name_prefix = nullptr;
 
@@ -4,17 +4,97 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <lean/thread.h>
+#include "kernel/expr_maps.h"
+#include "kernel/expr_eq_fn.h"
 #include "library/util.h"
+#include "library/compiler/util.h"
+#include "library/compiler/closed_term_cache.h"
 
 namespace lean {
 extern "C" object * lean_cache_closed_term_name(object * env, object * e, object * n);
 extern "C" object * lean_get_closed_term_name(object * env, object * e);
 
+/* Process-wide content-addressed index over the persistent `closedTermCache`
+   environment extension. The extension remains authoritative — it is what
+   reaches the .olean and what `isClosedTermName` consults — but probing it
+   means deep structural comparisons inside a persistent map, and under the
+   parallel compilation pipeline every task repeats that work for the popular
+   closed terms (instances, literals) it shares with every other task. The
+   index is insert-only and striped by the expression's cached hash, so
+   concurrent tasks rarely touch the same lock and never funnel through one
+   structure.
+
+   A hit is only trusted after the named auxiliary declaration is visible in
+   the *given* environment AND its stage2 value is the probed term: entries
+   outlive the environment lineage that produced them, and closed-term names
+   are generated sequentially (`<decl>._closed_<idx>`), so across
+   re-elaborations in the language server the same name is routinely rebound
+   to a declaration with different content. A name-existence check alone
+   would let such a stale entry through and make the compiler reference the
+   wrong declaration. The value comparison is cheap: valid entries hold the
+   very object that was registered, so it usually succeeds by pointer
+   equality. A false negative (e.g. the registered value was simplified
+   further) merely falls through to the authoritative extension probe. */
+class closed_term_index {
+    /* Power of two; indexed by the low bits of the expression hash. */
+    static constexpr unsigned s_num_shards = 16;
+    struct shard {
+        mutex          m_mutex;
+        expr_map<name> m_map;
+    };
+    shard m_shards[s_num_shards];
+    shard & of(expr const & e) { return m_shards[hash(e) & (s_num_shards - 1)]; }
+public:
+    optional<name> find(expr const & e) {
+        shard & s = of(e);
+        lock_guard<mutex> _(s.m_mutex);
+        auto it = s.m_map.find(e);
+        if (it == s.m_map.end()) return optional<name>();
+        return optional<name>(it->second);
+    }
+    void insert(expr const & e, name const & n) {
+        /* The key and value escape the inserting task and stay reachable for
+           the rest of the process; persistent objects are free to share
+           across threads and exempt from RC updates. */
+        mark_persistent(e.raw());
+        mark_persistent(n.raw());
+        shard & s = of(e);
+        lock_guard<mutex> _(s.m_mutex);
+        s.m_map.emplace(e, n); /* insert-only: the first writer wins */
+    }
+};
+
+static closed_term_index * g_closed_term_index = nullptr;
+
 optional<name> get_closed_term_name(environment const & env, expr const & e) {
-    return to_optional<name>(lean_get_closed_term_name(env.to_obj_arg(), e.to_obj_arg()));
+    if (optional<name> n = g_closed_term_index->find(e)) {
+        optional<constant_info> info = env.find(mk_cstage2_name(*n));
+        if (info && info->is_definition() && info->get_value() == e)
+            return n;
+        /* The declaration is not (or not yet) part of this environment, or
+           this lineage rebound the name to a different term; fall through
+           as a miss so the term gets re-materialized. */
+    }
+    optional<name> n = to_optional<name>(lean_get_closed_term_name(env.to_obj_arg(), e.to_obj_arg()));
+    if (n) {
+        /* Populate the index from extension hits (e.g. imported entries) so
+           subsequent probes by any task short-circuit here. */
+        g_closed_term_index->insert(e, *n);
+    }
+    return n;
 }
 
 environment cache_closed_term_name(environment const & env, expr const & e, name const & n) {
+    g_closed_term_index->insert(e, n);
     return environment(lean_cache_closed_term_name(env.to_obj_arg(), e.to_obj_arg(), n.to_obj_arg()));
 }
+
+void initialize_closed_term_cache() {
+    g_closed_term_index = new closed_term_index();
+}
+
+void finalize_closed_term_cache() {
+    delete g_closed_term_index;
+}
 }
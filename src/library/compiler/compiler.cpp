@@ -4,10 +4,15 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <memory>
+#include <vector>
+#include <lean/thread.h>
+#include <lean/object.h>
 #include "util/option_declarations.h"
 #include "util/io.h"
 #include "kernel/type_checker.h"
 #include "kernel/kernel_exception.h"
+#include "kernel/for_each_fn.h"
 #include "library/max_sharing.h"
 #include "library/trace.h"
 #include "library/time_task.h"
@@ -23,6 +28,7 @@ Author: Leonardo de Moura
 #include "library/compiler/lambda_lifting.h"
 #include "library/compiler/extract_closed.h"
 #include "library/compiler/reduce_arity.h"
+#include "library/compiler/fused_cleanup.h"
 #include "library/compiler/ll_infer_type.h"
 #include "library/compiler/simp_app_args.h"
 #include "library/compiler/llnf.h"
@@ -56,14 +62,89 @@ static expr eta_expand(environment const & env, expr const & e) {
     return type_checker(env).eta_expand(e);
 }
 
+/* The passes take the declaration list by value: when the caller hands over its
+   only reference (`std::move(ds)`), `map` reuses the cons cells in place instead
+   of rebuilding the spine after every pass. */
 template<typename F>
-comp_decls apply(F && f, environment const & env, comp_decls const & ds) {
-    return map(ds, [&](comp_decl const & d) { return comp_decl(d.fst(), f(env, d.snd())); });
+comp_decls apply(F && f, environment const & env, comp_decls ds) {
+    return map(std::move(ds), [&](comp_decl const & d) { return comp_decl(d.fst(), f(env, d.snd())); });
 }
 
 template<typename F>
-comp_decls apply(F && f, comp_decls const & ds) {
-    return map(ds, [&](comp_decl const & d) { return comp_decl(d.fst(), f(d.snd())); });
+comp_decls apply(F && f, comp_decls ds) {
+    return map(std::move(ds), [&](comp_decl const & d) { return comp_decl(d.fst(), f(d.snd())); });
+}
+
+#if defined(LEAN_MULTI_THREAD)
+/* Apply the pure pass `f : expr -> expr` to the declarations of a group in parallel.
+
+   The passes routed through this helper process each declaration of a (mutual) group
+   independently, so the group can be distributed over worker threads. The stages that
+   update the environment (`cache_stage1`, `specialize`, `lambda_lifting`, ...) keep
+   running on this thread and act as serial commit points between the parallel ones.
+
+   Remark: the trace state is thread local, so worker threads would silently drop
+   nested traces. The callers fall back to the sequential `apply` when tracing is
+   enabled. */
+template<typename F>
+static comp_decls par_apply_core(F const & f, comp_decls const & ds) {
+    buffer<comp_decl> in;
+    to_buffer(ds, in);
+    unsigned n = in.size();
+    /* The declarations (and everything reachable from them) are shared with the workers. */
+    mark_mt(ds.raw());
+    std::vector<expr> rs(n);
+    std::vector<std::exception_ptr> errors(n);
+    std::atomic<unsigned> next(0);
+    unsigned num_workers = std::min(n, hardware_concurrency());
+    std::vector<std::unique_ptr<lthread>> workers;
+    for (unsigned w = 0; w < num_workers; w++) {
+        workers.push_back(std::unique_ptr<lthread>(new lthread([&]() {
+            while (true) {
+                unsigned i = next.fetch_add(1);
+                if (i >= n) return;
+                try {
+                    rs[i] = f(in[i].snd());
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        })));
+    }
+    for (std::unique_ptr<lthread> & w : workers) w->join();
+    /* Report the failure the sequential loop would have reported first. */
+    for (unsigned i = 0; i < n; i++) {
+        if (errors[i]) std::rethrow_exception(errors[i]);
+    }
+    comp_decls r;
+    unsigned i = n;
+    while (i > 0) {
+        --i;
+        r = comp_decls(comp_decl(in[i].fst(), rs[i]), r);
+    }
+    return r;
+}
+#endif
+
+template<typename F>
+comp_decls par_apply(F && f, environment const & env, comp_decls ds) {
+#if defined(LEAN_MULTI_THREAD)
+    if (length(ds) >= 2 && hardware_concurrency() >= 2 && !is_trace_enabled()) {
+        mark_mt(env.raw());
+        return par_apply_core([&](expr const & e) { return f(env, e); }, ds);
+    }
+#endif
+    return apply(f, env, std::move(ds));
+}
+
+template<typename F>
+comp_decls par_apply(F && f, comp_decls ds) {
+#if defined(LEAN_MULTI_THREAD)
+    if (length(ds) >= 2 && hardware_concurrency() >= 2 && !is_trace_enabled()) {
+        return par_apply_core([&](expr const & e) { return f(e); }, ds);
+    }
+#endif
+    return apply(f, std::move(ds));
 }
 
 void trace_comp_decl(comp_decl const & d) {
@@ -157,14 +238,45 @@ bool is_main_fn_type(expr const & type) {
     }
 }
 
-#define trace_compiler(k, ds) lean_trace(k, trace_comp_decls(ds););
+static unsigned num_nodes(expr const & e) {
+    unsigned n = 0;
+    for_each(e, [&](expr const &, unsigned) { n++; return true; });
+    return n;
+}
+
+/* Per-pass size and time accounting (`trace.compiler.stats`). Each pipeline
+   stage reports its elapsed time and the resulting node count per declaration;
+   diffing consecutive stages shows which pass bloats which declaration. Shared
+   subterms are counted once, so the counts track real term size under
+   hash-consing. */
+class pass_stats {
+    bool                                  m_enabled;
+    std::chrono::steady_clock::time_point m_last;
+public:
+    pass_stats():m_enabled(is_trace_class_enabled(name({"compiler", "stats"}))) {
+        m_last = std::chrono::steady_clock::now();
+    }
+    void step(name const & pass, comp_decls const & ds) {
+        if (!m_enabled)
+            return;
+        auto now = std::chrono::steady_clock::now();
+        second_duration d(now - m_last);
+        m_last = now;
+        tout() << "[compiler.stats] " << pass << " " << display_profiling_time{d} << "\n";
+        for (comp_decl const & decl : ds) {
+            tout() << "  " << decl.fst() << " " << num_nodes(decl.snd()) << " nodes\n";
+        }
+    }
+};
+
+#define trace_compiler(k, ds) lean_trace(k, trace_comp_decls(ds);); stats.step(k, ds);
 
 environment compile(environment const & env, options const & opts, names cs) {
     if (!is_codegen_enabled(opts))
         return env;
 
     /* Do not generate code for irrelevant decls */
-    cs = filter(cs, [&](name const & c) { return !is_irrelevant_type(env, env.get(c).get_type());});
+    cs = filter(std::move(cs), [&](name const & c) { return !is_irrelevant_type(env, env.get(c).get_type());});
     if (empty(cs)) return env;
 
     for (name const & c : cs) {
@@ -190,6 +302,15 @@ environment compile(environment const & env, options const & opts, names cs) {
     time_task t("compilation", opts, head(cs));
     scope_trace_env scope_trace(env, opts);
 
+    /* Hash-cons every term built by the pass pipeline: structurally identical
+       subterms produced from `to_lcnf` onward collapse to one node, so
+       common-subexpression detection in `cse` reduces to a table probe over
+       canonical terms, structural comparisons short-circuit on pointer
+       equality, and the pointer-keyed traversal caches used by the passes
+       (for_each/replace) stop re-visiting duplicated subterms. */
+    scoped_expr_hash_cons hash_cons_scope;
+
+    pass_stats stats;
     comp_decls ds = to_comp_decls(env, cs);
     csimp_cfg cfg(opts);
     // Use the following line to see compiler intermediate steps
@@ -197,56 +318,65 @@ environment compile(environment const & env, options const & opts, names cs) {
     auto simp  = [&](environment const & env, expr const & e) { return csimp(env, e, cfg); };
     auto esimp = [&](environment const & env, expr const & e) { return cesimp(env, e, cfg); };
     trace_compiler(name({"compiler", "input"}), ds);
-    ds = apply(eta_expand, env, ds);
+    ds = par_apply(eta_expand, env, std::move(ds));
     trace_compiler(name({"compiler", "eta_expand"}), ds);
-    ds = apply(to_lcnf, env, ds);
-    ds = apply(find_jp, env, ds);
+    ds = par_apply(to_lcnf, env, std::move(ds));
+    ds = par_apply(find_jp, env, std::move(ds));
     // trace(ds);
     trace_compiler(name({"compiler", "lcnf"}), ds);
     // trace(ds);
-    ds = apply(cce, env, ds);
+    ds = par_apply(cce, env, std::move(ds));
     trace_compiler(name({"compiler", "cce"}), ds);
-    ds = apply(simp, env, ds);
+    ds = par_apply(simp, env, std::move(ds));
     trace_compiler(name({"compiler", "simp"}), ds);
     // trace(ds);
     environment new_env = env;
     std::tie(new_env, ds) = eager_lambda_lifting(new_env, ds, cfg);
     trace_compiler(name({"compiler", "eager_lambda_lifting"}), ds);
-    ds = apply(max_sharing, ds);
+    /* The sharing table persists across declarations (see max_sharing_env), so identical
+       subterms in different declarations of a module are discovered only once and mapped
+       to the same representatives. */
+    max_sharing_env & max_share = get_max_sharing_env();
+    ds = apply([&](expr const & e) { return max_share.share(e); }, std::move(ds));
     trace_compiler(name({"compiler", "stage1"}), ds);
     new_env = cache_stage1(new_env, ds);
     std::tie(new_env, ds) = specialize(new_env, ds, cfg);
     lean_assert(lcnf_check_let_decls(new_env, ds));
     trace_compiler(name({"compiler", "specialize"}), ds);
-    ds = apply(elim_dead_let, ds);
+    ds = par_apply(elim_dead_let, std::move(ds));
     trace_compiler(name({"compiler", "elim_dead_let"}), ds);
-    ds = apply(erase_irrelevant, new_env, ds);
+    ds = par_apply(erase_irrelevant, new_env, std::move(ds));
     trace_compiler(name({"compiler", "erase_irrelevant"}), ds);
-    ds = apply(struct_cases_on, new_env, ds);
+    ds = par_apply(struct_cases_on, new_env, std::move(ds));
     trace_compiler(name({"compiler", "struct_cases_on"}), ds);
-    ds = apply(esimp, new_env, ds);
+    ds = par_apply(esimp, new_env, std::move(ds));
     trace_compiler(name({"compiler", "simp"}), ds);
     ds = reduce_arity(new_env, ds);
     trace_compiler(name({"compiler", "reduce_arity"}), ds);
     std::tie(new_env, ds) = lambda_lifting(new_env, ds);
     trace_compiler(name({"compiler", "lambda_lifting"}), ds);
     // trace(ds);
-    ds = apply(esimp, new_env, ds);
+    ds = par_apply(esimp, new_env, std::move(ds));
     trace_compiler(name({"compiler", "simp"}), ds);
     new_env = cache_stage2(new_env, ds);
     trace_compiler(name({"compiler", "stage2"}), ds);
     if (is_extract_closed_enabled(opts)) {
         std::tie(new_env, ds) = extract_closed(new_env, ds);
-        ds = apply(elim_dead_let, ds);
-        ds = apply(esimp, new_env, ds);
+        ds = par_apply(elim_dead_let, std::move(ds));
+        ds = par_apply(esimp, new_env, std::move(ds));
         trace_compiler(name({"compiler", "extract_closed"}), ds);
     }
     new_env = cache_new_stage2(new_env, ds);
-    ds = apply(esimp, new_env, ds);
+    ds = par_apply(esimp, new_env, std::move(ds));
     trace_compiler(name({"compiler", "simp"}), ds);
-    ds = apply(simp_app_args, new_env, ds);
-    ds = apply(ecse, new_env, ds);
-    ds = apply(elim_dead_let, ds);
+    /* Final cleanup used to be three whole-term traversals
+       (`simp_app_args`, `ecse`, `elim_dead_let`); on big declarations the
+       traversal overhead dominates these local rewrites, so they are fused
+       into a single pass. */
+    auto cleanup = [&](environment const & env, expr const & e) {
+        return fused_cleanup(env, e, fused_cleanup_cfg());
+    };
+    ds = par_apply(cleanup, new_env, std::move(ds));
     trace_compiler(name({"compiler", "simp_app_args"}), ds);
     // std::cout << trace_scope.get_string() << "\n";
     /* compile IR. */
@@ -279,6 +409,7 @@ void initialize_compiler() {
     register_trace_class({"compiler", "cce"});
     register_trace_class({"compiler", "simp"});
     register_trace_class({"compiler", "simp_detail"});
+    register_trace_class({"compiler", "stats"});
     register_trace_class({"compiler", "simp_float_cases"});
     register_trace_class({"compiler", "elim_dead_let"});
     register_trace_class({"compiler", "cse"});
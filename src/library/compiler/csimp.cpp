@@ -8,6 +8,7 @@ Author: Leonardo de Moura
 #include <unordered_set>
 #include <unordered_map>
 #include <lean/flet.h>
+#include <lean/thread.h>
 #include "kernel/type_checker.h"
 #include "kernel/for_each_fn.h"
 #include "kernel/find_fn.h"
@@ -74,6 +75,19 @@ class csimp_fn {
     unsigned                 m_next_idx{1};
     unsigned                 m_next_jp_idx{1};
     expr_set                 m_simplified;
+    /* Values of let declarations whose last visit was the identity. `csimp_core`
+       reaches its fixpoint by re-running this functor, and most bindings are
+       untouched from one round to the next; this set lets `visit_let` reuse them
+       instead of re-simplifying the whole spine. It is keyed on the
+       uninstantiated value, which is structurally stable across rounds (the free
+       variables in the instantiated value are recreated every round). */
+    expr_set                 m_clean_let_vals;
+    /* Free variables created in the current round whose let value did not
+       change. Reset at the start of every round. */
+    name_hash_set            m_clean_fvars;
+    unsigned                 m_num_visited{0};
+    unsigned                 m_num_let_vals{0};
+    unsigned                 m_num_reused_let_vals{0};
     /* Cache for the method `mk_new_join_point`. It maps the pair `(jp, lambda(x, e))` to the new joint point. */
     jp_cache                 m_jp_cache;
     /* Maps a free variables to a list of joint points that must be inserted after it. */
@@ -169,6 +183,29 @@ class csimp_fn {
         return m_simplified.find(e) != m_simplified.end();
     }
 
+    /* Return true if `val` (the instantiation of `raw_val`) can be reused as is:
+       its last visit returned it unchanged, and none of the let/join-point
+       bindings it references were modified in the current round. Binders without
+       a value (e.g. lambda parameters) cannot change and do not make `val`
+       dirty. */
+    bool reusable_let_val(expr const & raw_val, expr const & val) {
+        if (m_clean_let_vals.find(raw_val) == m_clean_let_vals.end())
+            return false;
+        if (!has_fvar(val))
+            return true;
+        bool ok = true;
+        for_each(val, [&](expr const & x, unsigned) {
+                if (!ok || !has_fvar(x)) return false;
+                if (is_fvar(x) && m_clean_fvars.find(fvar_name(x)) == m_clean_fvars.end()) {
+                    optional<local_decl> d = m_lctx.find_local_decl(x);
+                    if (!d || d->get_value())
+                        ok = false;
+                }
+                return ok;
+            });
+        return ok;
+    }
+
     bool is_join_point_app(expr const & e) const {
         if (!is_app(e)) return false;
         expr const & fn = get_app_fn(e);
@@ -1123,8 +1160,17 @@ class csimp_fn {
     expr visit_let(expr e) {
         buffer<expr> let_fvars;
         while (is_let(e)) {
+            expr raw_val  = let_value(e);
             expr new_type = instantiate_rev(let_type(e), let_fvars.size(), let_fvars.data());
-            expr new_val  = visit(instantiate_rev(let_value(e), let_fvars.size(), let_fvars.data()), true);
+            expr val      = instantiate_rev(raw_val, let_fvars.size(), let_fvars.data());
+            m_num_let_vals++;
+            expr new_val;
+            if (reusable_let_val(raw_val, val)) {
+                m_num_reused_let_vals++;
+                new_val = val;
+            } else {
+                new_val = visit(val, true);
+            }
             if (!is_pseudo_do_join_point_name(let_name(e)) && is_lcnf_atom(new_val)) {
                 let_fvars.push_back(new_val);
             } else {
@@ -1132,6 +1178,12 @@ class csimp_fn {
                 expr new_fvar = m_lctx.mk_local_decl(ngen(), n, new_type, new_val);
                 let_fvars.push_back(new_fvar);
                 m_fvars.push_back(new_fvar);
+                if (new_val == val) {
+                    m_clean_fvars.insert(fvar_name(new_fvar));
+                    m_clean_let_vals.insert(raw_val);
+                } else {
+                    m_clean_let_vals.erase(raw_val);
+                }
             }
             e = let_body(e);
         }
@@ -1932,6 +1984,7 @@ class csimp_fn {
     }
 
     expr visit(expr const & e, bool is_let_val) {
+        m_num_visited++;
         switch (e.kind()) {
         case expr_kind::Lambda: return is_let_val ? e : visit_lambda(e, false, false);
         case expr_kind::Let:    return visit_let(e);
@@ -1947,6 +2000,8 @@ public:
         m_st(env), m_lctx(lctx), m_before_erasure(before_erasure), m_cfg(cfg), m_x("_x"), m_j("j") {}
 
     expr operator()(expr const & e) {
+        /* Free variable ids are not stable across rounds. */
+        m_clean_fvars.clear();
         if (is_lambda(e)) {
             return visit_lambda(e, false, true);
         } else {
@@ -1955,6 +2010,10 @@ public:
             return mk_let(empty_xs, 0, r, true);
         }
     }
+
+    unsigned num_visited() const { return m_num_visited; }
+    unsigned num_let_vals() const { return m_num_let_vals; }
+    unsigned num_reused_let_vals() const { return m_num_reused_let_vals; }
 };
 
 extern "C" uint8 lean_at_most_once(obj_arg e, obj_arg x);
@@ -2077,11 +2136,70 @@ public:
     bool expanded() const { return m_expanded; }
 };
 
+#ifndef LEAN_CSIMP_CACHE_MAX_SIZE
+#define LEAN_CSIMP_CACHE_MAX_SIZE 8192
+#endif
+
+/* In-process memo for `csimp_core` results.
+
+   The simplifier is re-run for every declaration of every compiled module,
+   even when the input is identical to one already processed (duplicated
+   instance bodies, repeated specializations, fix-point re-invocations). The
+   result only depends on the input term, the phase, the configuration, and
+   the referenced constants; the cache is tagged with the environment it was
+   filled against and reset when queried with a different one, and it is only
+   consulted for top-level invocations (empty local context). Results are
+   keyed by the input's structural hash; persisting the table to disk next to
+   the olean is not expressible from C++ in this code base, so the cache lives
+   for the duration of the process. */
+struct csimp_result_cache {
+    struct key {
+        expr      m_e;
+        bool      m_before_erasure;
+        csimp_cfg m_cfg;
+    };
+    struct key_hash {
+        unsigned operator()(key const & k) const {
+            unsigned h = hash(hash(k.m_e), k.m_before_erasure ? 17u : 31u);
+            h = hash(h, hash(k.m_cfg.m_inline ? 1u : 0u, k.m_cfg.m_inline_threshold));
+            return hash(h, hash(k.m_cfg.m_float_cases_threshold, k.m_cfg.m_inline_jp_threshold));
+        }
+    };
+    struct key_eq {
+        bool operator()(key const & k1, key const & k2) const {
+            return
+                k1.m_before_erasure == k2.m_before_erasure &&
+                k1.m_cfg.m_inline == k2.m_cfg.m_inline &&
+                k1.m_cfg.m_inline_threshold == k2.m_cfg.m_inline_threshold &&
+                k1.m_cfg.m_float_cases_threshold == k2.m_cfg.m_float_cases_threshold &&
+                k1.m_cfg.m_inline_jp_threshold == k2.m_cfg.m_inline_jp_threshold &&
+                k1.m_e == k2.m_e;
+        }
+    };
+    optional<environment> m_env;
+    std::unordered_map<key, expr, key_hash, key_eq> m_map;
+};
+
+MK_THREAD_LOCAL_GET_DEF(csimp_result_cache, get_csimp_result_cache);
+
 expr csimp_core(environment const & env, local_ctx const & lctx, expr const & e0, bool before_erasure, csimp_cfg const & cfg) {
+    bool cacheable = lctx.empty();
+    csimp_result_cache & cache = get_csimp_result_cache();
+    if (cacheable) {
+        if (!cache.m_env || !is_eqp(*cache.m_env, env)) {
+            cache.m_env = optional<environment>(env);
+            cache.m_map.clear();
+        }
+        auto it = cache.m_map.find(csimp_result_cache::key{e0, before_erasure, cfg});
+        if (it != cache.m_map.end())
+            return it->second;
+    }
     csimp_fn simp(env, lctx, before_erasure, cfg);
     elim_jp1_fn elim_jp1(env, lctx, before_erasure);
     expr e = e0;
+    unsigned num_rounds = 0;
     while (true) {
+        num_rounds++;
         e = simp(e);
         bool modified = false;
         e = elim_jp1(e);
@@ -2092,8 +2210,20 @@ expr csimp_core(environment const & env, local_ctx const & lctx, expr const & e0
         if (e != new_e)
             modified = true;
         if (!modified)
-            return e;
+            break;
         e = new_e;
     }
+    if (is_trace_class_enabled(name({"compiler", "stats"}))) {
+        tout() << "[compiler.stats] csimp " << num_rounds << " round(s), "
+               << simp.num_visited() << " nodes visited, "
+               << simp.num_reused_let_vals() << "/" << simp.num_let_vals()
+               << " let values reused\n";
+    }
+    if (cacheable) {
+        if (cache.m_map.size() > LEAN_CSIMP_CACHE_MAX_SIZE)
+            cache.m_map.clear();
+        cache.m_map.insert(mk_pair(csimp_result_cache::key{e0, before_erasure, cfg}, e));
+    }
+    return e;
 }
 }
@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2018 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <algorithm>
+#include <vector>
+#include "util/name_hash_set.h"
+#include "kernel/instantiate.h"
+#include "kernel/for_each_fn.h"
+#include "kernel/expr_maps.h"
+#include "library/compiler/util.h"
+#include "library/compiler/ll_infer_type.h"
+#include "library/compiler/fused_cleanup.h"
+
+namespace lean {
+/* Fused cleanup traversal.
+
+   `simp_app_args`, `ecse`, and `elim_dead_let` are local rewrites, but each
+   used to run as its own whole-term traversal; on big declarations the
+   instantiate/abstract churn of the traversals dominates the actual rewrite
+   work. This functor performs the enabled rewrites in a single pass:
+   argument atomization and CSE are applied while visiting each let value
+   (forward, so earlier bindings dominate later lookups), and dead
+   declarations are pruned when a group of bindings is flushed at a binder
+   boundary (backward, so transitively dead bindings go too).
+
+   The functor assumes it runs after erasure: types are closed, so a CSE key
+   can pair the type with the value the way `cse_fn::mk_key` does, and
+   atomized literal arguments live in `_obj`. */
+class fused_cleanup_fn {
+    type_checker::state m_st;
+    fused_cleanup_cfg   m_cfg;
+    local_ctx           m_lctx;
+    buffer<expr>        m_fvars;
+    expr_map<expr>      m_cse_map;
+    std::vector<expr>   m_cse_keys;
+    name_hash_set       m_used;
+    name                m_x;
+    unsigned            m_next_idx{1};
+
+    environment const & env() const { return m_st.env(); }
+    name_generator & ngen() { return m_st.ngen(); }
+
+    name next_name() {
+        name r = m_x.append_after(m_next_idx);
+        m_next_idx++;
+        return r;
+    }
+
+    /* See `cse_fn::mk_key`: after erasure values of different types may have
+       the same representation, so the type is part of the key. */
+    expr mk_key(expr const & type, expr const & val) {
+        return mk_app(type, val);
+    }
+
+    bool has_never_extract(expr const & e) {
+        expr const & fn = get_app_fn(e);
+        return is_constant(fn) && has_never_extract_attribute(env(), const_name(fn));
+    }
+
+    bool cse_candidate(expr const & v) {
+        return m_cfg.m_cse && !is_cases_on_app(env(), v) && !has_never_extract(v);
+    }
+
+    void mark_used(expr const & e) {
+        if (!has_fvar(e))
+            return;
+        for_each(e, [&](expr const & x, unsigned) {
+                if (!has_fvar(x)) return false;
+                if (is_fvar(x)) m_used.insert(fvar_name(x));
+                return true;
+            });
+    }
+
+    /* Flush the let declarations created since `saved_fvars_size` around `r`,
+       dropping the ones enabled rewrites have made (or found) dead, and close
+       the CSE scope opened at `saved_keys_size`. */
+    expr mk_let(unsigned saved_fvars_size, unsigned saved_keys_size, expr r) {
+        lean_assert(saved_fvars_size <= m_fvars.size());
+        for (unsigned i = saved_keys_size; i < m_cse_keys.size(); i++)
+            m_cse_map.erase(m_cse_keys[i]);
+        m_cse_keys.resize(saved_keys_size);
+        if (saved_fvars_size == m_fvars.size())
+            return r;
+        if (m_cfg.m_elim_dead_let) {
+            mark_used(r);
+            buffer<expr> kept;
+            unsigned i = m_fvars.size();
+            while (i > saved_fvars_size) {
+                --i;
+                expr const & fvar = m_fvars[i];
+                if (m_used.find(fvar_name(fvar)) != m_used.end()) {
+                    local_decl decl = m_lctx.get_local_decl(fvar);
+                    lean_assert(decl.get_value());
+                    mark_used(*decl.get_value());
+                    kept.push_back(fvar);
+                }
+            }
+            std::reverse(kept.begin(), kept.end());
+            r = m_lctx.mk_lambda(kept, r);
+            m_fvars.shrink(saved_fvars_size);
+            return r;
+        }
+        r = m_lctx.mk_lambda(m_fvars.size() - saved_fvars_size, m_fvars.data() + saved_fvars_size, r);
+        m_fvars.shrink(saved_fvars_size);
+        return r;
+    }
+
+    expr visit_let(expr e) {
+        buffer<expr> curr_fvars;
+        while (is_let(e)) {
+            lean_assert(!has_loose_bvars(let_type(e)));
+            expr t     = let_type(e);
+            expr v     = visit(instantiate_rev(let_value(e), curr_fvars.size(), curr_fvars.data()));
+            name n     = let_name(e);
+            if (m_cfg.m_cse) {
+                auto it = m_cse_map.find(mk_key(t, v));
+                if (it != m_cse_map.end()) {
+                    /* Uses of this binding are redirected to the dominating
+                       one; the dead-let sweep never sees a declaration. */
+                    curr_fvars.push_back(it->second);
+                    e = let_body(e);
+                    continue;
+                }
+            }
+            /* Pseudo "do" joinpoints are used to implement a temporary HACK. See `visit_let` method at `lcnf.cpp` */
+            if (is_internal_name(n) && !is_join_point_name(n) && !is_pseudo_do_join_point_name(n)) {
+                n = next_name();
+            }
+            expr fvar  = m_lctx.mk_local_decl(ngen(), n, t, v);
+            curr_fvars.push_back(fvar);
+            m_fvars.push_back(fvar);
+            if (cse_candidate(v)) {
+                expr key = mk_key(t, v);
+                m_cse_map.insert(mk_pair(key, fvar));
+                m_cse_keys.push_back(key);
+            }
+            e = let_body(e);
+        }
+        return visit(instantiate_rev(e, curr_fvars.size(), curr_fvars.data()));
+    }
+
+    expr visit_lambda(expr e) {
+        buffer<expr> binding_fvars;
+        while (is_lambda(e)) {
+            lean_assert(!has_loose_bvars(binding_domain(e)));
+            expr new_fvar = m_lctx.mk_local_decl(ngen(), binding_name(e), binding_domain(e), binding_info(e));
+            binding_fvars.push_back(new_fvar);
+            e = binding_body(e);
+        }
+        e = instantiate_rev(e, binding_fvars.size(), binding_fvars.data());
+        unsigned saved_fvars_size = m_fvars.size();
+        unsigned saved_keys_size  = m_cse_keys.size();
+        expr r = mk_let(saved_fvars_size, saved_keys_size, visit(e));
+        lean_assert(!is_lambda(r));
+        return m_lctx.mk_lambda(binding_fvars, r);
+    }
+
+    expr mk_aux_decl(expr const & type, expr const & e) {
+        if (m_cfg.m_cse) {
+            expr key = mk_key(type, e);
+            auto it  = m_cse_map.find(key);
+            if (it != m_cse_map.end())
+                return it->second;
+            expr fvar = m_lctx.mk_local_decl(ngen(), next_name(), type, e);
+            m_fvars.push_back(fvar);
+            m_cse_map.insert(mk_pair(key, fvar));
+            m_cse_keys.push_back(key);
+            return fvar;
+        }
+        expr fvar = m_lctx.mk_local_decl(ngen(), next_name(), type, e);
+        m_fvars.push_back(fvar);
+        return fvar;
+    }
+
+    expr ensure_simple_arg(expr const & e) {
+        if (is_fvar(e) || is_enf_neutral(e)) {
+            return e;
+        } else if (is_lit(e)) {
+            return mk_aux_decl(mk_enf_object_type(), e);
+        } else if (is_constant(e)) {
+            return mk_aux_decl(ll_infer_type(env(), e), e);
+        } else {
+            lean_unreachable();
+        }
+    }
+
+    expr visit_proj(expr const & e) {
+        if (!m_cfg.m_simp_app_args)
+            return e;
+        expr arg = ensure_simple_arg(proj_expr(e));
+        return update_proj(e, arg);
+    }
+
+    expr visit_app(expr const & e) {
+        buffer<expr> args;
+        expr const & fn = get_app_args(e, args);
+        if (is_cases_on_app(env(), e)) {
+            if (m_cfg.m_simp_app_args)
+                args[0] = ensure_simple_arg(args[0]);
+            for (unsigned i = 1; i < args.size(); i++) {
+                if (is_lambda(args[i])) {
+                    args[i] = visit(args[i]);
+                } else {
+                    unsigned saved_fvars_size = m_fvars.size();
+                    unsigned saved_keys_size  = m_cse_keys.size();
+                    args[i] = mk_let(saved_fvars_size, saved_keys_size, visit(args[i]));
+                }
+            }
+        } else if (is_morally_num_lit(e)) {
+            /* Do not convert `x := uint*.of_nat <val>` into `y := <val>, x := uint*.of_nat y` */
+            return e;
+        } else if (m_cfg.m_simp_app_args) {
+            for (expr & arg : args)
+                arg = ensure_simple_arg(arg);
+        } else {
+            return e;
+        }
+        return mk_app(fn, args);
+    }
+
+    expr visit(expr const & e) {
+        switch (e.kind()) {
+        case expr_kind::App:    return visit_app(e);
+        case expr_kind::Lambda: return visit_lambda(e);
+        case expr_kind::Let:    return visit_let(e);
+        case expr_kind::Proj:   return visit_proj(e);
+        default:                return e;
+        }
+    }
+
+public:
+    fused_cleanup_fn(environment const & env, fused_cleanup_cfg const & cfg):
+        m_st(env), m_cfg(cfg), m_x("_x") {}
+
+    expr operator()(expr const & e) {
+        return mk_let(0, 0, visit(e));
+    }
+};
+
+expr fused_cleanup(environment const & env, expr const & e, fused_cleanup_cfg const & cfg) {
+    return fused_cleanup_fn(env, cfg)(e);
+}
+}
@@ -0,0 +1,23 @@
+/*
+Copyright (c) 2018 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#pragma once
+#include "kernel/environment.h"
+namespace lean {
+/* Configuration for `fused_cleanup`. Each flag enables one of the local
+   rewrites that used to be a standalone whole-term traversal; the pipeline
+   picks the combination appropriate for the stage. */
+struct fused_cleanup_cfg {
+    /* Make sure every argument of applications and projections is a free
+       variable (or neutral element). See `simp_app_args`. */
+    bool m_simp_app_args{true};
+    /* Common subexpression elimination on let values. See `ecse`. */
+    bool m_cse{true};
+    /* Remove unused let declarations. See `elim_dead_let`. */
+    bool m_elim_dead_let{true};
+};
+expr fused_cleanup(environment const & env, expr const & e, fused_cleanup_cfg const & cfg);
+}
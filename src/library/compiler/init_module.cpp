@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include "library/compiler/util.h"
+#include "library/compiler/closed_term_cache.h"
 #include "library/compiler/lcnf.h"
 #include "library/compiler/elim_dead_let.h"
 #include "library/compiler/cse.h"
@@ -19,6 +20,7 @@ Author: Leonardo de Moura
 namespace lean {
 void initialize_compiler_module() {
     initialize_compiler_util();
+    initialize_closed_term_cache();
     initialize_lcnf();
     initialize_elim_dead_let();
     initialize_cse();
@@ -42,6 +44,7 @@ void finalize_compiler_module() {
     finalize_cse();
     finalize_elim_dead_let();
     finalize_lcnf();
+    finalize_closed_term_cache();
     finalize_compiler_util();
 }
 }
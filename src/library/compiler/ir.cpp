@@ -569,16 +569,22 @@ extern "C" object* lean_add_extern(object * env, object * fn) {
 
 extern "C" object * lean_ir_emit_c(object * env, object * mod_name);
 
-string_ref emit_c(environment const & env, name const & mod_name) {
+void emit_c(std::ostream & out, environment const & env, name const & mod_name) {
     object * r = lean_ir_emit_c(env.to_obj_arg(), mod_name.to_obj_arg());
-    string_ref s(cnstr_get(r, 0), true);
     if (cnstr_tag(r) == 0) {
+        string_ref s(cnstr_get(r, 0), true);
         dec_ref(r);
         throw exception(s.to_std_string());
-    } else {
-        dec_ref(r);
-        return s;
     }
+    /* The emitter produces the translation unit as a sequence of chunks;
+       write them to the stream as-is instead of materializing one string. */
+    object * chunks = cnstr_get(r, 0);
+    size_t n = array_size(chunks);
+    for (size_t i = 0; i < n; i++) {
+        object * s = array_get(chunks, i);
+        out.write(string_cstr(s), string_size(s) - 1);
+    }
+    dec_ref(r);
 }
 
 /*
@@ -6,6 +6,7 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include <string>
+#include <ostream>
 #include "kernel/environment.h"
 #include "library/compiler/util.h"
 namespace lean {
@@ -36,7 +37,8 @@ std::string decl_to_string(decl const & d);
 void test(decl const & d);
 environment compile(environment const & env, options const & opts, comp_decls const & decls);
 environment add_extern(environment const & env, name const & fn);
-string_ref emit_c(environment const & env, name const & mod_name);
+/* Emit the C code for module `mod_name` directly into `out`. */
+void emit_c(std::ostream & out, environment const & env, name const & mod_name);
 }
 void initialize_ir();
 void finalize_ir();
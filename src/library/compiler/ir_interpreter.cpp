@@ -42,6 +42,7 @@ functions, which have a (relatively) homogeneous ABI that we can use without run
 #include "library/trace.h"
 #include "library/compiler/ir.h"
 #include "library/compiler/init_attribute.h"
+#include "util/name_hash_map.h"
 #include "util/option_ref.h"
 #include "util/array_ref.h"
 #include "util/nat.h"
@@ -56,6 +57,12 @@ functions, which have a (relatively) homogeneous ABI that we can use without run
 #endif
 #endif
 
+/* GCC and Clang support "labels as values", which we use for threaded dispatch in the
+   instruction evaluation loop; other compilers fall back to `switch` dispatch. */
+#if defined(__GNUC__) || defined(__clang__)
+#define LEAN_IR_THREADED_DISPATCH
+#endif
+
 namespace lean {
 namespace ir {
 // C++ wrappers of Lean data types
@@ -309,9 +316,12 @@ class interpreter {
         name m_fn;
         // base pointers into the stack above
         size_t m_arg_bp;
+        // end of this frame's variable slots (`m_arg_bp` + frame size)
+        size_t m_arg_top;
         size_t m_jp_bp;
 
-        frame(name const & mFn, size_t mArgBp, size_t mJpBp) : m_fn(mFn), m_arg_bp(mArgBp), m_jp_bp(mJpBp) {}
+        frame(name const & mFn, size_t mArgBp, size_t mArgTop, size_t mJpBp) :
+            m_fn(mFn), m_arg_bp(mArgBp), m_arg_top(mArgTop), m_jp_bp(mJpBp) {}
     };
     std::vector<frame> m_call_stack;
     environment const & m_env;
@@ -322,17 +332,58 @@ class interpreter {
       bool m_is_scalar;
       value m_val;
     };
-    // caches values of nullary functions ("constants")
-    name_map<constant_cache_entry> m_constant_cache;
+    // caches values of nullary functions ("constants").
+    // NOTE: hash maps instead of `name_map`s: these caches are probed on every
+    // interpreted call, and the rb-tree lookups (pointer chasing plus name
+    // comparisons) showed up prominently on call-heavy interpreted code.
+    name_hash_map<constant_cache_entry> m_constant_cache;
     struct symbol_cache_entry {
         decl m_decl;
         // symbol address; `nullptr` if function does not have native code
         void * m_addr;
         // true iff we chose the boxed version of a function where the IR uses the unboxed version
         bool m_boxed;
+        // address of the plain (unwrapped) symbol, set only when the signature contains no
+        // unboxed values. The boxed wrapper then exists solely because of borrowed parameters,
+        // so saturated calls can invoke the plain symbol directly under the IR borrow
+        // discipline and skip the wrapper frame and its compensating RC operations (see
+        // `call`). Closures must keep pointing at the wrapper, whose fully owned ABI is what
+        // `apply_n` expects.
+        void * m_direct_addr;
     };
     // caches symbol lookup successes _and_ failures
-    name_map<symbol_cache_entry> m_symbol_cache;
+    name_hash_map<symbol_cache_entry> m_symbol_cache;
+    // caches the number of variable slots needed by a frame of each interpreted declaration
+    name_hash_map<size_t> m_frame_sizes;
+    struct lit_cache_entry {
+        // keeps the key alive, so the pointer cannot be reused for another object
+        object_ref m_lit;
+        // the type the literal was converted at; a literal object shared by
+        // instructions of different scalar types must not share the conversion
+        type       m_type;
+        value      m_val;
+    };
+    // pools scalar values of numeric literals, keyed by the literal IR object.
+    // Boxed literals need no pool: the `Nat`/`String` object stored in the IR is
+    // returned directly, so loading one is just a reference count increment.
+    std::unordered_map<object *, lit_cache_entry> m_lit_cache;
+    struct callsite_cache_entry {
+        // keeps the key alive, so the pointer cannot be reused for another object
+        object_ref m_instr;
+        symbol_cache_entry const * m_sym;
+    };
+    // per-call-site ("inline") cache: maps an FAp/PAp instruction to its resolved
+    // callee, so a site pays the by-name symbol resolution only on its first
+    // execution. The IR is immutable, so the resolved pointer lives in this side
+    // table rather than in the instruction itself. Entries are valid for one
+    // environment epoch: `with_interpreter` constructs a fresh interpreter (and
+    // hence fresh caches) whenever the environment or options change.
+    std::unordered_map<object *, callsite_cache_entry> m_callsite_cache;
+    /* Tail-recursive jumps are system-checked once per this many iterations
+       (power of two); the whole batch of heartbeats is credited at the check,
+       so the budget total stays accurate up to one partial batch per loop. */
+    static constexpr unsigned s_tail_check_batch = 64;
+    unsigned m_tail_iters = 0;
 
     /** \brief Get current stack frame */
     inline frame & get_frame() {
@@ -343,13 +394,73 @@ class interpreter {
     inline value & var(var_id const & v) {
         // variables are 1-indexed
         size_t i = get_frame().m_arg_bp + v.get_small_value() - 1;
-        // we don't know the frame size (unless we do an additional IR pass), so we extend it dynamically
-        if (i >= m_arg_stack.size()) {
-            m_arg_stack.resize(i + 1);
-        }
+        // the frame was fully sized by `push_frame` (see `get_frame_size`)
+        lean_assert(i < m_arg_stack.size());
         return m_arg_stack[i];
     }
 
+    /** \brief Return the number of variable slots needed by a frame of `d`, i.e. the maximum
+        variable index declared in it (variables are 1-indexed). All slot-writing instructions
+        write either a parameter (of the function or of a join point) or a `VDecl` variable, so
+        it suffices to scan those. The result is cached per declaration, so the scan runs once
+        no matter how often the function is invoked. */
+    size_t get_frame_size(decl const & d) {
+        if (decl_tag(d) != decl_kind::Fun)
+            return decl_params(d).size();
+        name const & fn = decl_fun_id(d);
+        auto it = m_frame_sizes.find(fn);
+        if (it != m_frame_sizes.end())
+            return it->second;
+        size_t max_var = 0;
+        auto visit_var = [&](var_id const & v) {
+            size_t i = v.get_small_value();
+            if (i > max_var)
+                max_var = i;
+        };
+        for (param const & p : decl_params(d))
+            visit_var(param_var(p));
+        std::vector<fn_body const *> todo;
+        todo.push_back(&decl_fun_body(d));
+        while (!todo.empty()) {
+            fn_body const & b = *todo.back();
+            todo.pop_back();
+            switch (fn_body_tag(b)) {
+                case fn_body_kind::VDecl:
+                    visit_var(fn_body_vdecl_var(b));
+                    todo.push_back(&fn_body_vdecl_cont(b));
+                    break;
+                case fn_body_kind::JDecl:
+                    for (param const & p : fn_body_jdecl_params(b))
+                        visit_var(param_var(p));
+                    todo.push_back(&fn_body_jdecl_body(b));
+                    todo.push_back(&fn_body_jdecl_cont(b));
+                    break;
+                case fn_body_kind::Set: todo.push_back(&fn_body_set_cont(b)); break;
+                case fn_body_kind::SetTag: todo.push_back(&fn_body_set_tag_cont(b)); break;
+                case fn_body_kind::USet: todo.push_back(&fn_body_uset_cont(b)); break;
+                case fn_body_kind::SSet: todo.push_back(&fn_body_sset_cont(b)); break;
+                case fn_body_kind::Inc: todo.push_back(&fn_body_inc_cont(b)); break;
+                case fn_body_kind::Dec: todo.push_back(&fn_body_dec_cont(b)); break;
+                case fn_body_kind::Del: todo.push_back(&fn_body_del_cont(b)); break;
+                case fn_body_kind::MData: todo.push_back(&fn_body_mdata_cont(b)); break;
+                case fn_body_kind::Case:
+                    for (alt_core const & a : fn_body_case_alts(b)) {
+                        switch (alt_core_tag(a)) {
+                            case alt_core_kind::Ctor: todo.push_back(&alt_core_ctor_cont(a)); break;
+                            case alt_core_kind::Default: todo.push_back(&alt_core_default_cont(a)); break;
+                        }
+                    }
+                    break;
+                case fn_body_kind::Ret:
+                case fn_body_kind::Jmp:
+                case fn_body_kind::Unreachable:
+                    break;
+            }
+        }
+        m_frame_sizes.insert(mk_pair(fn, max_var));
+        return max_var;
+    }
+
 public:
     template<class T>
     static inline T with_interpreter(environment const & env, options const & opts, std::function<T(interpreter &)> const & f) {
@@ -458,14 +569,14 @@ private:
             }
             case expr_kind::FAp: { // satured ("full") application of top-level function
                 if (expr_fap_args(e).size()) {
-                    return call(expr_fap_fun(e), expr_fap_args(e));
+                    return call(lookup_callee(e, expr_fap_fun(e)), expr_fap_args(e));
                 } else {
                     // nullary function ("constant")
                     return load(expr_fap_fun(e), t);
                 }
             }
             case expr_kind::PAp: { // unsatured (partial) application of top-level function
-                symbol_cache_entry sym = lookup_symbol(expr_pap_fun(e));
+                symbol_cache_entry const & sym = lookup_callee(e, expr_pap_fun(e));
                 if (sym.m_addr) {
                     // point closure directly at native symbol
                     object * cls = alloc_closure(sym.m_addr, decl_params(sym.m_decl).size(), expr_pap_args(e).size());
@@ -494,31 +605,37 @@ private:
                 return box_t(var(expr_box_obj(e)).m_num, expr_box_type(e));
             case expr_kind::Unbox: // unbox boxed value
                 return unbox_t(var(expr_unbox_obj(e)).m_obj, t);
-            case expr_kind::Lit: // load numeric or string literal
-                switch (lit_val_tag(expr_lit_val(e))) {
-                    case lit_val_kind::Num: {
-                        nat const & n = lit_val_num(expr_lit_val(e));
-                        switch (t) {
-                            case type::Float:
-                                return value::from_float(lean_float_of_nat(n.raw()));
-                            case type::UInt8:
-                            case type::UInt16:
-                            case type::UInt32:
-                            case type::USize:
-                                return lean_usize_of_nat(n.raw());
-                            case type::UInt64:
-                                return lean_uint64_of_nat(n.raw());
-                            // `nat` literal
-                            case type::Object:
-                            case type::TObject:
-                                return n.to_obj_arg();
-                            default:
-                                throw exception("invalid instruction");
-                        }
-                    }
-                    case lit_val_kind::Str:
-                        return lit_val_str(expr_lit_val(e)).to_obj_arg();
+            case expr_kind::Lit: { // load numeric or string literal
+                lit_val const & l = expr_lit_val(e);
+                if (lit_val_tag(l) == lit_val_kind::Str)
+                    return lit_val_str(l).to_obj_arg();
+                nat const & n = lit_val_num(l);
+                if (t == type::Object || t == type::TObject)
+                    return n.to_obj_arg(); // `nat` literal; the IR object itself is (re)used
+                // scalar literals are converted from the `Nat` object once and pooled
+                auto it = m_lit_cache.find(l.raw());
+                if (it != m_lit_cache.end() && it->second.m_type == t)
+                    return it->second.m_val;
+                value v;
+                switch (t) {
+                    case type::Float:
+                        v = value::from_float(lean_float_of_nat(n.raw()));
+                        break;
+                    case type::UInt8:
+                    case type::UInt16:
+                    case type::UInt32:
+                    case type::USize:
+                        v = lean_usize_of_nat(n.raw());
+                        break;
+                    case type::UInt64:
+                        v = lean_uint64_of_nat(n.raw());
+                        break;
+                    default:
+                        throw exception("invalid instruction");
                 }
+                m_lit_cache[l.raw()] = lit_cache_entry { l, t, v };
+                return v;
+            }
             case expr_kind::IsShared:
                 return !is_exclusive(var(expr_is_shared_obj(e)).m_obj);
             case expr_kind::IsTaggedPtr:
@@ -528,9 +645,9 @@ private:
         }
     }
 
-    void check_system() {
+    void check_system(size_t heartbeats = 1) {
         try {
-            lean::check_system("interpreter");
+            lean::check_system("interpreter", heartbeats);
         } catch (stack_space_exception & ex) {
             sstream ss;
             ss << ex.what() << "\n";
@@ -547,11 +664,32 @@ private:
 
         // make reference reassignable...
         std::reference_wrapper<fn_body const> b(b0);
-        while (true) {
-            DEBUG_CODE(lean_trace(name({"interpreter", "step"}),
-                                  tout() << std::string(m_call_stack.size(), ' ') << format_fn_body_head(b) << "\n";);)
-            switch (fn_body_tag(b)) {
-                case fn_body_kind::VDecl: { // variable declaration
+#define TRACE_STEP() DEBUG_CODE(lean_trace(name({"interpreter", "step"}), \
+                                tout() << std::string(m_call_stack.size(), ' ') << format_fn_body_head(b) << "\n";);)
+#ifdef LEAN_IR_THREADED_DISPATCH
+        /* Threaded dispatch: every handler ends with its own indirect jump to the next
+           handler, so the branch predictor sees one dispatch site per instruction kind
+           instead of a single shared one, which reduces mispredictions on
+           instruction-heavy interpreted code. There is no separate "program counter":
+           each IR instruction directly references its continuation, so the instruction
+           stream is already threaded and we merely change how we dispatch on it.
+           The table is indexed by `fn_body_kind`. */
+        static void * const dispatch_table[] = {
+            &&case_VDecl, &&case_JDecl, &&case_Set, &&case_SetTag, &&case_USet,
+            &&case_SSet, &&case_Inc, &&case_Dec, &&case_Del, &&case_MData,
+            &&case_Case, &&case_Ret, &&case_Jmp, &&case_Unreachable
+        };
+#define BEGIN_DISPATCH() DISPATCH();
+#define CASE(k) case_##k
+#define DISPATCH() do { TRACE_STEP(); goto *dispatch_table[static_cast<unsigned>(fn_body_tag(b))]; } while (0)
+#else
+#define BEGIN_DISPATCH() next_instr: TRACE_STEP(); switch (fn_body_tag(b))
+#define CASE(k) case fn_body_kind::k
+#define DISPATCH() goto next_instr
+#endif
+        BEGIN_DISPATCH()
+        {
+                CASE(VDecl): { // variable declaration
                     expr const & e = fn_body_vdecl_expr(b);
                     fn_body const & cont = fn_body_vdecl_cont(b);
                     // tail recursion?
@@ -569,10 +707,15 @@ private:
                         for (size_t i = 0; i < args.size(); i++) {
                             m_arg_stack[get_frame().m_arg_bp + i] = m_arg_stack[old_size + i];
                         }
-                        m_arg_stack.resize(get_frame().m_arg_bp + args.size());
+                        m_arg_stack.resize(get_frame().m_arg_top);
                         b = b0;
-                        check_system();
-                        break;
+                        /* The frame does not grow across tail-recursive jumps, so batch the
+                           per-iteration accounting: poll the system once per batch and credit
+                           all of its heartbeats in one step instead of paying an increment
+                           and a budget check per iteration. */
+                        if ((++m_tail_iters & (s_tail_check_batch - 1)) == 0)
+                            check_system(s_tail_check_batch);
+                        DISPATCH();
                     }
                     value v = eval_expr(fn_body_vdecl_expr(b), fn_body_vdecl_type(b));
                     // NOTE: `var` must be called *after* `eval_expr` because the stack may get resized and invalidate
@@ -584,39 +727,39 @@ private:
                                           print_value(tout(), var(fn_body_vdecl_var(b)), fn_body_vdecl_type(b));
                                           tout() << "\n";);)
                     b = fn_body_vdecl_cont(b);
-                    break;
+                    DISPATCH();
                 }
-                case fn_body_kind::JDecl: { // join-point declaration; store in stack slot just like variables
+                CASE(JDecl): { // join-point declaration; store in stack slot just like variables
                     size_t i = get_frame().m_jp_bp + fn_body_jdecl_id(b).get_small_value();
                     if (i >= m_jp_stack.size()) {
                         m_jp_stack.resize(i + 1);
                     }
                     m_jp_stack[i] = &b.get();
                     b = fn_body_jdecl_cont(b);
-                    break;
+                    DISPATCH();
                 }
-                case fn_body_kind::Set: { // set boxed field of unique reference
+                CASE(Set): { // set boxed field of unique reference
                     object * o = var(fn_body_set_var(b)).m_obj;
                     lean_assert(is_exclusive(o));
                     cnstr_set(o, fn_body_set_idx(b).get_small_value(), eval_arg(fn_body_set_arg(b)).m_obj);
                     b = fn_body_set_cont(b);
-                    break;
+                    DISPATCH();
                 }
-                case fn_body_kind::SetTag: { // set constructor tag of unique reference
+                CASE(SetTag): { // set constructor tag of unique reference
                     object * o = var(fn_body_set_tag_var(b)).m_obj;
                     lean_assert(is_exclusive(o));
                     cnstr_set_tag(o, fn_body_set_tag_cidx(b).get_small_value());
                     b = fn_body_set_tag_cont(b);
-                    break;
+                    DISPATCH();
                 }
-                case fn_body_kind::USet: { // set USize field of unique reference
+                CASE(USet): { // set USize field of unique reference
                     object * o = var(fn_body_uset_target(b)).m_obj;
                     lean_assert(is_exclusive(o));
                     cnstr_set_usize(o, fn_body_uset_idx(b).get_small_value(), var(fn_body_uset_source(b)).m_num);
                     b = fn_body_uset_cont(b);
-                    break;
+                    DISPATCH();
                 }
-                case fn_body_kind::SSet: { // set other unboxed field of unique reference
+                CASE(SSet): { // set other unboxed field of unique reference
                     object * o = var(fn_body_sset_target(b)).m_obj;
                     size_t offset = fn_body_sset_idx(b).get_small_value() * sizeof(void *) +
                                     fn_body_sset_offset(b).get_small_value();
@@ -631,28 +774,28 @@ private:
                         default: throw exception(sstream() << "invalid instruction");
                     }
                     b = fn_body_sset_cont(b);
-                    break;
+                    DISPATCH();
                 }
-                case fn_body_kind::Inc: // increment reference counter
+                CASE(Inc): // increment reference counter
                     inc(var(fn_body_inc_var(b)).m_obj, fn_body_inc_val(b).get_small_value());
                     b = fn_body_inc_cont(b);
-                    break;
-                case fn_body_kind::Dec: { // decrement reference counter
+                    DISPATCH();
+                CASE(Dec): { // decrement reference counter
                     size_t n = fn_body_dec_val(b).get_small_value();
                     for (size_t i = 0; i < n; i++) {
                         dec(var(fn_body_dec_var(b)).m_obj);
                     }
                     b = fn_body_dec_cont(b);
-                    break;
+                    DISPATCH();
                 }
-                case fn_body_kind::Del: // delete object of unique reference
+                CASE(Del): // delete object of unique reference
                     lean_free_object(var(fn_body_del_var(b)).m_obj);
                     b = fn_body_del_cont(b);
-                    break;
-                case fn_body_kind::MData: // metadata; no-op
+                    DISPATCH();
+                CASE(MData): // metadata; no-op
                     b = fn_body_mdata_cont(b);
-                    break;
-                case fn_body_kind::Case: { // branch according to constructor tag
+                    DISPATCH();
+                CASE(Case): { // branch according to constructor tag
                     array_ref<alt_core> const & alts = fn_body_case_alts(b);
                     unsigned tag;
                     value v = var(fn_body_case_var(b));
@@ -675,37 +818,46 @@ private:
                         }
                     }
                     throw exception("incomplete case");
-                    done: break;
+                    done: DISPATCH();
                 }
-                case fn_body_kind::Ret:
+                CASE(Ret):
                     return eval_arg(fn_body_ret_arg(b));
-                case fn_body_kind::Jmp: { // jump to join-point
+                CASE(Jmp): { // jump to join-point
                     fn_body const & jp = *m_jp_stack[get_frame().m_jp_bp + fn_body_jmp_jp(b).get_small_value()];
                     lean_assert(fn_body_jdecl_params(jp).size() == fn_body_jmp_args(b).size());
                     for (size_t i = 0; i < fn_body_jdecl_params(jp).size(); i++) {
                         var(param_var(fn_body_jdecl_params(jp)[i])) = eval_arg(fn_body_jmp_args(b)[i]);
                     }
                     b = fn_body_jdecl_body(jp);
-                    break;
+                    DISPATCH();
                 }
-                case fn_body_kind::Unreachable:
+                CASE(Unreachable):
                     throw exception("unreachable code");
-            }
         }
+        lean_unreachable();
+#undef BEGIN_DISPATCH
+#undef CASE
+#undef DISPATCH
+#undef TRACE_STEP
     }
 
     // specify argument base pointer explicitly because we've usually already pushed some function arguments
-    void push_frame(decl const & d, size_t arg_bp) {
+    void push_frame(decl const & d, size_t arg_bp, bool interpreted = true) {
         DEBUG_CODE({
             lean_trace(name({"interpreter", "call"}),
                        tout() << std::string(m_call_stack.size(), ' ')
                               << decl_fun_id(d);
-                       for (size_t i = arg_bp; i < m_arg_stack.size(); i++) {
+                       for (size_t i = arg_bp; i < arg_bp + decl_params(d).size(); i++) {
                            tout() << " "; print_value(tout(), m_arg_stack[i], param_type(decl_params(d)[i - arg_bp]));
                        }
                        tout() << "\n";);
         });
-        m_call_stack.emplace_back(decl_fun_id(d), arg_bp, m_jp_stack.size());
+        size_t arg_top = arg_bp + (interpreted ? get_frame_size(d) : decl_params(d).size());
+        if (interpreted) {
+            // size the frame once so `var` never has to grow the stack
+            m_arg_stack.resize(arg_top);
+        }
+        m_call_stack.emplace_back(decl_fun_id(d), arg_bp, arg_top, m_jp_stack.size());
     }
 
     void pop_frame(value DEBUG_CODE(r), type DEBUG_CODE(t)) {
@@ -721,12 +873,15 @@ private:
        });
     }
 
-    /** \brief Return cached lookup result for given unmangled function name in the current binary. */
-    symbol_cache_entry lookup_symbol(name const & fn) {
-        if (symbol_cache_entry const * e = m_symbol_cache.find(fn)) {
-            return *e;
+    /** \brief Return cached lookup result for given unmangled function name in the current binary.
+        The returned reference stays valid for the lifetime of the interpreter: the cache is
+        node-based and entries are never erased, so call sites may hold on to the pointer. */
+    symbol_cache_entry const & lookup_symbol(name const & fn) {
+        auto it = m_symbol_cache.find(fn);
+        if (it != m_symbol_cache.end()) {
+            return it->second;
         } else {
-            symbol_cache_entry e_new { get_decl(fn), nullptr, false };
+            symbol_cache_entry e_new { get_decl(fn), nullptr, false, nullptr };
             if (m_prefer_native || decl_tag(e_new.m_decl) == decl_kind::Extern || has_init_attribute(m_env, fn)) {
                 string_ref mangled = name_mangle(fn, *g_mangle_prefix);
                 string_ref boxed_mangled(string_append(mangled.to_obj_arg(), g_boxed_mangled_suffix->raw()));
@@ -734,16 +889,38 @@ private:
                 if (void *p_boxed = lookup_symbol_in_cur_exe(boxed_mangled.data())) {
                     e_new.m_addr = p_boxed;
                     e_new.m_boxed = true;
+                    bool all_boxed = !type_is_scalar(decl_type(e_new.m_decl));
+                    if (all_boxed) {
+                        for (param const & p : decl_params(e_new.m_decl)) {
+                            if (type_is_scalar(param_type(p))) {
+                                all_boxed = false;
+                                break;
+                            }
+                        }
+                    }
+                    if (all_boxed)
+                        e_new.m_direct_addr = lookup_symbol_in_cur_exe(mangled.data());
                 } else if (void *p = lookup_symbol_in_cur_exe(mangled.data())) {
                     // if there is no boxed version, there are no unboxed parameters, so use default version
                     e_new.m_addr = p;
                 }
             }
-            m_symbol_cache.insert(fn, e_new);
-            return e_new;
+            return m_symbol_cache.insert(mk_pair(fn, e_new)).first->second;
         }
     }
 
+    /** \brief Resolve the callee of call site `e` (an FAp/PAp instruction applying `fn`).
+        After the first execution the site resolves by pointer identity, skipping the
+        name hashing and comparison of `lookup_symbol`. */
+    symbol_cache_entry const & lookup_callee(expr const & e, name const & fn) {
+        auto it = m_callsite_cache.find(e.raw());
+        if (it != m_callsite_cache.end())
+            return *it->second.m_sym;
+        symbol_cache_entry const & sym = lookup_symbol(fn);
+        m_callsite_cache.insert(mk_pair(e.raw(), callsite_cache_entry { e, &sym }));
+        return sym;
+    }
+
     /** \brief Retrieve Lean declaration from environment. */
     decl get_decl(name const & fn) {
         option_ref<decl> d = find_ir_decl(m_env, fn);
@@ -755,11 +932,12 @@ private:
 
     /** \brief Evaluate nullary function ("constant"). */
     value load(name const & fn, type t) {
-        if (constant_cache_entry const * cached = m_constant_cache.find(fn)) {
-            if (!cached->m_is_scalar) {
-                inc(cached->m_val.m_obj);
+        auto cached = m_constant_cache.find(fn);
+        if (cached != m_constant_cache.end()) {
+            if (!cached->second.m_is_scalar) {
+                inc(cached->second.m_val.m_obj);
             }
-            return cached->m_val;
+            return cached->second.m_val;
         }
         if (object * const * o = g_init_globals->find(fn)) {
             // persistent, so no `inc` needed
@@ -770,7 +948,7 @@ private:
             // We don't know whether `[init]` decls can be re-executed, so let's not.
             throw exception(sstream() << "cannot evaluate `[init]` declaration '" << fn << "' in the same module");
         }
-        symbol_cache_entry e = lookup_symbol(fn);
+        symbol_cache_entry const & e = lookup_symbol(fn);
         if (e.m_addr) {
             // constants do not have boxed wrappers, but we'll survive
             switch (t) {
@@ -792,21 +970,22 @@ private:
             if (!type_is_scalar(t)) {
                 inc(r.m_obj);
             }
-            m_constant_cache.insert(fn, constant_cache_entry { type_is_scalar(t), r });
+            m_constant_cache.insert(mk_pair(fn, constant_cache_entry { type_is_scalar(t), r }));
             return r;
         }
     }
 
-    value call(name const & fn, array_ref<arg> const & args) {
+    value call(symbol_cache_entry const & e, array_ref<arg> const & args) {
         size_t old_size = m_arg_stack.size();
         value r;
-        symbol_cache_entry e = lookup_symbol(fn);
         if (e.m_addr) {
+            // when the plain symbol is usable (see `symbol_cache_entry`), call it directly
+            bool direct = e.m_direct_addr != nullptr;
             object ** args2 = static_cast<object **>(LEAN_ALLOCA(args.size() * sizeof(object *))); // NOLINT
             for (size_t i = 0; i < args.size(); i++) {
                 type t = param_type(decl_params(e.m_decl)[i]);
                 args2[i] = box_t(eval_arg(args[i]), t);
-                if (e.m_boxed && param_borrow(decl_params(e.m_decl)[i])) {
+                if (!direct && e.m_boxed && param_borrow(decl_params(e.m_decl)[i])) {
                     // NOTE: If we chose the boxed version where the IR chose the unboxed one, we need to manually increment
                     // originally borrowed parameters because the wrapper will decrement these after the call.
                     // Basically the wrapper is more homogeneous (removing both unboxed and borrowed parameters) than we
@@ -814,8 +993,8 @@ private:
                     inc(args2[i]);
                 }
             }
-            push_frame(e.m_decl, old_size);
-            object * o = curry(e.m_addr, args.size(), args2);
+            push_frame(e.m_decl, old_size, /* interpreted */ false);
+            object * o = curry(direct ? e.m_direct_addr : e.m_addr, args.size(), args2);
             type t = decl_type(e.m_decl);
             if (type_is_scalar(t)) {
                 lean_assert(e.m_boxed);
@@ -827,6 +1006,7 @@ private:
             }
         } else {
             if (decl_tag(e.m_decl) == decl_kind::Extern) {
+                name const & fn = decl_fun_id(e.m_decl);
                 string_ref mangled = name_mangle(fn, *g_mangle_prefix);
                 string_ref boxed_mangled(string_append(mangled.to_obj_arg(), g_boxed_mangled_suffix->raw()));
                 throw exception(sstream() << "could not find native implementation of external declaration '" << fn
@@ -911,11 +1091,11 @@ public:
     }
 
     ~interpreter() {
-        for_each(m_constant_cache, [](name const &, constant_cache_entry const & e) {
-            if (!e.m_is_scalar) {
-                dec(e.m_val.m_obj);
+        for (auto const & e : m_constant_cache) {
+            if (!e.second.m_is_scalar) {
+                dec(e.second.m_val.m_obj);
             }
-        });
+        }
     }
 
     /** A variant of `call` designed for external uses.
@@ -6,7 +6,10 @@ Author: Leonardo de Moura
 */
 #include <algorithm>
 #include <lean/flet.h>
+#include <lean/thread.h>
+#include "util/name_hash_map.h"
 #include "kernel/instantiate.h"
+#include "kernel/expr_maps.h"
 #include "kernel/for_each_fn.h"
 #include "kernel/abstract.h"
 #include "library/class.h"
@@ -108,8 +111,30 @@ static environment save_specialization_info(environment const & env, name const
     return environment(lean_add_specialization_info(env.to_obj_arg(), fn.to_obj_arg(), si.to_obj_arg()));
 }
 
+/* Per-environment memo for specialization info. The specializer queries the
+   info of the same functions many times per pass, and each query resolves the
+   extension state on the Lean side through a dynamic extension lookup. The
+   cache is thread-local and tagged with the environment it was filled
+   against; a query against a different environment resets it. */
+struct spec_info_cache {
+    optional<environment>              m_env;
+    name_hash_map<optional<spec_info>> m_info;
+};
+
+MK_THREAD_LOCAL_GET_DEF(spec_info_cache, get_spec_info_cache);
+
 static optional<spec_info> get_specialization_info(environment const & env, name const & fn) {
-    return to_optional<spec_info>(lean_get_specialization_info(env.to_obj_arg(), fn.to_obj_arg()));
+    spec_info_cache & cache = get_spec_info_cache();
+    if (!cache.m_env || !is_eqp(*cache.m_env, env)) {
+        cache.m_env = optional<environment>(env);
+        cache.m_info.clear();
+    }
+    auto it = cache.m_info.find(fn);
+    if (it != cache.m_info.end())
+        return it->second;
+    optional<spec_info> r = to_optional<spec_info>(lean_get_specialization_info(env.to_obj_arg(), fn.to_obj_arg()));
+    cache.m_info.insert(mk_pair(fn, r));
+    return r;
 }
 
 typedef buffer<pair<name, buffer<spec_arg_kind>>> spec_info_buffer;
@@ -256,6 +281,13 @@ class specialize_fn {
     name                m_spec;
     unsigned            m_next_idx{1};
     name_set            m_to_respecialize;
+    /* In-run memo for the content-addressed global specialization cache
+       (see `get_cached_specialization`). The global cache is an environment
+       extension and is monotone while this object runs — the environment is
+       only extended — so hits and insertions recorded here stay valid, and
+       repeated call sites of the same specialization skip the cross-language
+       extension lookup. */
+    std::unordered_map<expr, name, expr_hash> m_gcache;
 
     environment const & env() { return m_st.env(); }
 
@@ -357,7 +389,10 @@ class specialize_fn {
     }
 
     struct spec_ctx {
-        typedef rb_expr_map<name> cache;
+        /* Cache is only queried and extended (never snapshotted), so a hash map
+           keyed on the structural term is cheaper than the ordered map: probes are
+           settled by the cached hash instead of a comparison-guided descent. */
+        typedef expr_map<name>    cache;
         names                 m_mutual;
         /* `m_params` contains all variables that must be lambda abstracted in the specialization.
            It may contain let-variables that occurs inside of binders.
@@ -792,9 +827,10 @@ class specialize_fn {
         lean_assert(is_constant(fn));
         lean_assert(ctx.in_mutual_decl(const_name(fn)));
         expr key = mk_cache_key(fn, mask);
-        if (name const * r = ctx.m_cache.find(key)) {
-            lean_trace(name({"compiler", "specialize"}), tout() << "spec_preprocess: " << trace_pp_expr(key) << " ==> " << *r << "\n";);
-            return optional<name>(*r);
+        auto it = ctx.m_cache.find(key);
+        if (it != ctx.m_cache.end()) {
+            lean_trace(name({"compiler", "specialize"}), tout() << "spec_preprocess: " << trace_pp_expr(key) << " ==> " << it->second << "\n";);
+            return optional<name>(it->second);
         }
 
         optional<expr> new_code_opt = get_code(fn);
@@ -802,7 +838,7 @@ class specialize_fn {
         expr new_code = *new_code_opt;
 
         name new_name = mk_spec_name(const_name(fn));
-        ctx.m_cache.insert(key, new_name);
+        ctx.m_cache.insert(mk_pair(key, new_name));
         lean_trace(name({"compiler", "specialize"}), tout() << "spec_preprocess update cache: " << trace_pp_expr(key) << " ===> " << new_name << "\n";);
         flet<local_ctx> save_lctx(m_lctx, m_lctx);
         buffer<expr> fvars;
@@ -1035,7 +1071,10 @@ class specialize_fn {
            TODO: when we reimplement this module in Lean, we should have a better caching heuristic. */
         if (gcache_enabled && ctx.m_params.size() <= 1) {
             key = mk_app(fn, gcache_key_args);
-            if (optional<name> it = get_cached_specialization(env(), key)) {
+            auto memo_it = m_gcache.find(key);
+            if (memo_it != m_gcache.end()) {
+                new_fn_name = memo_it->second;
+            } else if (optional<name> it = get_cached_specialization(env(), key)) {
                 lean_trace(name({"compiler", "specialize"}), tout() << "get_cached_specialization [" << ctx.m_params.size() << "]: " << *it << "\n";
                            unsigned i = 0;
                            type_checker tc(m_st, m_lctx);
@@ -1046,6 +1085,7 @@ class specialize_fn {
                            tout() << trace_pp_expr(key) << "\n";);
                 // std::cerr << *it << " " << ctx.m_vars.size() << " " << ctx.m_params.size() << "\n";
                 new_fn_name = *it;
+                m_gcache.insert(mk_pair(key, *it));
             }
         }
         if (!new_fn_name) {
@@ -1081,6 +1121,7 @@ class specialize_fn {
                            }
                            tout()  << trace_pp_expr(key) << "\n";);
                 m_st.env() = cache_specialization(env(), key, *new_fn_name);
+                m_gcache.insert(mk_pair(key, *new_fn_name));
             }
         }
         expr r = mk_constant(*new_fn_name);
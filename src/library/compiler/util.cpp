@@ -27,6 +27,31 @@ Author: Leonardo de Moura
 #include "library/compiler/util.h"
 
 namespace lean {
+/* Return true if all binders in the type of the constructor `c` (inductive parameters and fields)
+   are erased by the compiler. The runtime representation of such a constructor carries no data
+   besides the constructor index, like a fieldless one. Example: the constructors of
+   ```
+   inductive may_fail (p : Prop) : Type
+   | fail : p → may_fail
+   | ok   : may_fail
+   ```
+   bind only a proposition and a proof, both erased. Data parameters disqualify a type: in
+   `inductive cmp_result (a b : nat)` whose constructors store only proofs such as `a < b`,
+   the `nat` parameters are constructor binders stored at runtime, so such a type is
+   (intentionally) not treated as an enumeration. */
+static bool has_only_irrelevant_fields(environment const & env, name const & c) {
+    type_checker::state st(env);
+    local_ctx lctx;
+    expr type = env.get(c).get_type();
+    while (is_pi(type)) {
+        if (!is_irrelevant_type(st, lctx, binding_domain(type)))
+            return false;
+        expr fvar = lctx.mk_local_decl(st.ngen(), binding_name(type), binding_domain(type));
+        type = instantiate(binding_body(type), fvar);
+    }
+    return true;
+}
+
 optional<unsigned> is_enum_type(environment const & env, name const & I) {
     constant_info info  = env.get(I);
     if (!info.is_inductive()) return optional<unsigned>();
@@ -43,7 +68,11 @@ optional<unsigned> is_enum_type(environment const & env, name const & I) {
         return optional<unsigned>();
     }
     for (name const & c : cs) {
-        if (is_pi(env.get(c).get_type()))
+        /* A constructor whose fields are all erased is represented exactly like a fieldless
+           one, so it does not prevent `I` from being treated as an enumeration type. This
+           generalizes the `decidable` special case above, and gives types whose constructors
+           only carry proofs the unboxed (scalar) result convention instead of `lean_box(cidx)`. */
+        if (is_pi(env.get(c).get_type()) && !has_only_irrelevant_fields(env, c))
             return optional<unsigned>();
         if (n == std::numeric_limits<unsigned>::max())
             return optional<unsigned>();
@@ -364,34 +393,20 @@ bool is_llnf_void_type(expr const & e) {
     return e == *g_void_type;
 }
 
+/* The builtin type predicates below are consulted per constant by the LCNF
+   conversion and the type inference passes, so membership is a single hash
+   probe (names cache their hash) instead of a chain of structural
+   comparisons. The sets are populated in `initialize_compiler_util`. */
+static name_hash_set * g_runtime_builtin_types = nullptr;
+static name_hash_set * g_runtime_scalar_types  = nullptr;
+
 bool is_runtime_builtin_type(name const & n) {
     /* TODO(Leo): use an attribute? */
-    return
-        n == get_string_name() ||
-        n == get_uint8_name()  ||
-        n == get_uint16_name() ||
-        n == get_uint32_name() ||
-        n == get_uint64_name() ||
-        n == get_usize_name()  ||
-        n == get_float_name()  ||
-        n == get_thunk_name()  ||
-        n == get_task_name()   ||
-        n == get_array_name()  ||
-        n == get_mut_quot_name()  ||
-        n == get_byte_array_name()  ||
-        n == get_float_array_name()  ||
-        n == get_nat_name()    ||
-        n == get_int_name();
+    return g_runtime_builtin_types->find(n) != g_runtime_builtin_types->end();
 }
 
 bool is_runtime_scalar_type(name const & n) {
-    return
-        n == get_uint8_name()  ||
-        n == get_uint16_name() ||
-        n == get_uint32_name() ||
-        n == get_uint64_name() ||
-        n == get_usize_name()  ||
-        n == get_float_name();
+    return g_runtime_scalar_types->find(n) != g_runtime_scalar_types->end();
 }
 
 bool is_llnf_unboxed_type(expr const & type) {
@@ -774,6 +789,14 @@ void initialize_compiler_util() {
     g_builtin_scalar_size->emplace_back(get_uint32_name(), 4);
     g_builtin_scalar_size->emplace_back(get_uint64_name(), 8);
     g_builtin_scalar_size->emplace_back(get_float_name(),  8);
+    g_runtime_scalar_types = new name_hash_set({
+        get_uint8_name(), get_uint16_name(), get_uint32_name(), get_uint64_name(),
+        get_usize_name(), get_float_name()});
+    g_runtime_builtin_types = new name_hash_set(*g_runtime_scalar_types);
+    for (name const & n : {get_string_name(), get_thunk_name(), get_task_name(), get_array_name(),
+                           get_mut_quot_name(), get_byte_array_name(), get_float_array_name(),
+                           get_nat_name(), get_int_name()})
+        g_runtime_builtin_types->insert(n);
 }
 
 void finalize_compiler_util() {
@@ -787,5 +810,7 @@ void finalize_compiler_util() {
     delete g_uint32;
     delete g_uint64;
     delete g_builtin_scalar_size;
+    delete g_runtime_scalar_types;
+    delete g_runtime_builtin_types;
 }
 }
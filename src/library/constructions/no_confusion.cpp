@@ -71,8 +71,9 @@ static optional<environment> mk_no_confusion_type(environment const & env, name
     cases_on       = mk_app(cases_on, nindices, args.data() + nparams);
     expr cases_on1 = mk_app(cases_on, v1);
     expr cases_on2 = mk_app(cases_on, v2);
-    expr t1        = type_checker(env, lctx).infer(cases_on1);
-    expr t2        = type_checker(env, lctx).infer(cases_on2);
+    type_checker tc0(env, lctx);
+    expr t1        = tc0.infer(cases_on1);
+    expr t2        = tc0.infer(cases_on2);
     buffer<expr> outer_cases_on_args;
     unsigned idx1 = 0;
     while (is_pi(t1)) {
@@ -91,16 +92,24 @@ static optional<environment> mk_no_confusion_type(environment const & env, name
                 if (minor1_args.size() != minor2_args.size())
                     throw_corrupted(n);
                 buffer<expr> rtype_hyp;
+                /* One checker for all the fields of this constructor pair: the
+                   field types only mention locals that already exist at this
+                   point (the `_eq` hypotheses below are never inferred), and
+                   reusing the checker keeps its caches warm across fields —
+                   the previous per-field `type_checker(env, lctx)` calls made
+                   this O(constructors^2) loop rebuild them from scratch for
+                   every field. */
+                type_checker tc(env, lctx);
                 // add equalities
                 for (unsigned i = 0; i < minor1_args.size(); i++) {
                     expr lhs      = minor1_args[i];
                     expr rhs      = minor2_args[i];
                     expr lhs_type = lctx.get_type(lhs);
-                    if (!type_checker(env, lctx).is_prop(lhs_type)) {
+                    if (!tc.is_prop(lhs_type)) {
                         expr rhs_type = lctx.get_type(rhs);
-                        level l       = sort_level(type_checker(env, lctx).ensure_type(lhs_type));
+                        level l       = sort_level(tc.ensure_type(lhs_type));
                         expr h_type;
-                        if (type_checker(env, lctx).is_def_eq(lhs_type, rhs_type)) {
+                        if (tc.is_def_eq(lhs_type, rhs_type)) {
                             h_type = mk_app(mk_constant(get_eq_name(), levels(l)), lhs_type, lhs, rhs);
                         } else {
                             h_type = mk_app(mk_constant(get_heq_name(), levels(l)), lhs_type, lhs, rhs_type, rhs);
@@ -10,11 +10,15 @@ Author: Leonardo de Moura
 namespace lean {
 bool is_lt(expr const & a, expr const & b, bool use_hash, local_ctx const * lctx) {
     if (is_eqp(a, b))                    return false;
-    if (a.kind() != b.kind())            return a.kind() < b.kind();
     if (use_hash) {
-        if (hash(a) < hash(b))           return true;
-        if (hash(a) > hash(b))           return false;
+        /* The cached hash settles almost every comparison of distinct terms
+           with two field probes; the kind test and the structural walk below
+           are only reached on hash ties. */
+        unsigned ha = hash(a);
+        unsigned hb = hash(b);
+        if (ha != hb)                    return ha < hb;
     }
+    if (a.kind() != b.kind())            return a.kind() < b.kind();
     if (a == b)                          return false;
     switch (a.kind()) {
     case expr_kind::Lit:
@@ -8,9 +8,14 @@ Author: Leonardo de Moura
 #include <unordered_set>
 #include <functional>
 #include <lean/interrupt.h>
+#include <lean/thread.h>
 #include "util/buffer.h"
 #include "library/max_sharing.h"
 
+#ifndef LEAN_MAX_SHARING_ENV_MAX_SIZE
+#define LEAN_MAX_SHARING_ENV_MAX_SIZE 1024*1024
+#endif
+
 namespace lean {
 /**
    \brief Implementation of the functional object for creating expressions with maximally
@@ -110,9 +115,24 @@ struct max_sharing_fn::imp {
 max_sharing_fn::max_sharing_fn():m_ptr(new imp) {}
 max_sharing_fn::~max_sharing_fn() {}
 expr max_sharing_fn::operator()(expr const & a) { return (*m_ptr)(a); }
-void max_sharing_fn::clear() { m_ptr->m_expr_cache.clear(); }
+unsigned max_sharing_fn::size() const { return m_ptr->m_expr_cache.size(); }
+void max_sharing_fn::clear() { m_ptr->m_expr_cache.clear(); m_ptr->m_lvl_cache.clear(); }
 bool max_sharing_fn::already_processed(expr const & a) const { return m_ptr->already_processed(a); }
 
+max_sharing_env::max_sharing_env():m_max_size(LEAN_MAX_SHARING_ENV_MAX_SIZE) {}
+
+expr max_sharing_env::share(expr const & a) {
+    if (m_fn.size() > m_max_size)
+        m_fn.clear();
+    return m_fn(a);
+}
+
+MK_THREAD_LOCAL_GET_DEF(max_sharing_env, get_max_sharing_env_core);
+
+max_sharing_env & get_max_sharing_env() {
+    return get_max_sharing_env_core();
+}
+
 expr max_sharing(expr const & a) {
     return max_sharing_fn::imp()(a);
 }
@@ -26,10 +26,33 @@ public:
     /** \brief Return true iff \c a was already processed by this object. */
     bool already_processed(expr const & a) const;
 
+    /** \brief Number of expressions in the cache. */
+    unsigned size() const;
+
     /** \brief Clear the cache. */
     void clear();
 };
 
+/**
+   \brief Maximal-sharing table that persists across declarations.
+
+   `max_sharing` rebuilds its table per invocation, so identical subterms
+   occurring in different declarations of a module are rediscovered for every
+   declaration. This object keeps one incrementally growing table: terms from
+   different declarations are mapped to the same representatives, and work done
+   for one declaration is reused by the next. The table is discarded when it
+   grows past a threshold to keep memory consumption bounded. */
+class max_sharing_env {
+    max_sharing_fn m_fn;
+    unsigned       m_max_size;
+public:
+    max_sharing_env();
+    expr share(expr const & a);
+};
+
+/** \brief Return a thread-local max_sharing_env. */
+max_sharing_env & get_max_sharing_env();
+
 /**
    \brief The resultant expression is structurally identical to the input one, but
    it uses maximally shared sub-expressions.
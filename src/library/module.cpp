@@ -7,11 +7,18 @@ Authors: Leonardo de Moura, Gabriel Ebner, Sebastian Ullrich
 #include <unordered_map>
 #include <vector>
 #include <utility>
+#include <memory>
+#include <cstdlib>
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
 #include <sys/stat.h>
+#if !defined(LEAN_WINDOWS) && !defined(LEAN_EMSCRIPTEN)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include <lean/thread.h>
 #include <lean/interrupt.h>
 #include <lean/sstream.h>
@@ -37,19 +44,78 @@ namespace lean {
 // manually padded to multiple of word size, see `initialize_module`
 static char const * g_olean_header   = "oleanfile!!!!!!!";
 
+/* The magic string is followed by a checksum of the region body. The format is
+   toolchain-internal (word size and layout are already baked into the region),
+   so a simple stable FNV-1a suffices; `hash_bytes` is documented as unstable
+   across versions and must not be stored on disk. */
+static uint64 olean_checksum(char const * data, size_t sz) {
+    uint64 h = 14695981039346656037ull;
+    for (size_t i = 0; i < sz; i++) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/* Checksum verification is opt-in: it protects the loader against corrupted
+   files (which otherwise cause undefined behavior during pointer fixup), but
+   the extra linear pass touches every page of the mapping and toolchain-internal
+   artifacts are normally trusted. */
+static bool olean_verify() {
+    static bool r = getenv("LEAN_OLEAN_VERIFY") != nullptr;
+    return r;
+}
+
+/* When set, `lean_save_module_data` seeds the compactor with the body of the .olean file
+   being overwritten. Unchanged declaration subgraphs are then shared with the existing
+   data through the compactor's max-sharing table and only new/changed subgraphs are
+   appended, so the compaction phase of an incremental rebuild is proportional to the
+   change rather than to the module. The price is that subgraphs that became garbage
+   stay in the file until the next non-incremental rebuild, so the feature is opt-in
+   and intended for edit-compile loops. */
+static bool olean_incremental() {
+    static bool r = getenv("LEAN_OLEAN_INCREMENTAL") != nullptr;
+    return r;
+}
+
 extern "C" object * lean_save_module_data(object * fname, object * mdata, object *) {
     std::string olean_fn(string_cstr(fname));
     object_ref mdata_ref(mdata);
     try {
         exclusive_file_lock output_lock(olean_fn);
+        size_t header_size = strlen(g_olean_header) + sizeof(uint64);
+        std::unique_ptr<object_compactor> compactor;
+        if (olean_incremental()) {
+            std::ifstream prev(olean_fn, std::ios_base::binary);
+            if (!prev.fail()) {
+                prev.seekg(0, prev.end);
+                size_t prev_size = prev.tellg();
+                prev.seekg(0);
+                if (prev_size > header_size) {
+                    std::vector<char> prev_data(prev_size);
+                    prev.read(prev_data.data(), prev_size);
+                    if (prev && strncmp(prev_data.data(), g_olean_header, strlen(g_olean_header)) == 0) {
+                        char const * body = prev_data.data() + header_size;
+                        size_t body_size  = prev_size - header_size;
+                        uint64 checksum;
+                        memcpy(&checksum, prev_data.data() + strlen(g_olean_header), sizeof(checksum));
+                        if (!olean_verify() || olean_checksum(body, body_size) == checksum)
+                            compactor.reset(new object_compactor(body, body_size));
+                    }
+                }
+            }
+        }
+        if (!compactor)
+            compactor.reset(new object_compactor());
         std::ofstream out(olean_fn, std::ios_base::binary);
         if (out.fail()) {
             return io_result_mk_error((sstream() << "failed to create file '" << olean_fn << "'").str());
         }
-        object_compactor compactor;
-        compactor(mdata_ref.raw());
+        (*compactor)(mdata_ref.raw());
+        uint64 checksum = olean_checksum(static_cast<char const *>(compactor->data()), compactor->size());
         out.write(g_olean_header, strlen(g_olean_header));
-        out.write(static_cast<char const *>(compactor.data()), compactor.size());
+        out.write(reinterpret_cast<char const *>(&checksum), sizeof(checksum));
+        out.write(static_cast<char const *>(compactor->data()), compactor->size());
         out.close();
         return io_result_mk_ok(box(0));
     } catch (exception & ex) {
@@ -57,36 +123,132 @@ extern "C" object * lean_save_module_data(object * fname, object * mdata, object
     }
 }
 
+#if !defined(LEAN_WINDOWS) && !defined(LEAN_EMSCRIPTEN)
+/* Faults a mapped region's pages in sequentially on a background (pooled)
+   thread, so the disk keeps streaming while `compacted_region::read` fixes up
+   the already-resident prefix, instead of idling between demand faults. The
+   destructor stops and joins the thread, so the warmer can never outlive the
+   mapping it touches. */
+class region_warmer {
+    atomic_bool              m_stop{false};
+    std::unique_ptr<lthread> m_thread;
+public:
+    /* Readahead alone covers small files; only many pages repay a thread handoff. */
+    static constexpr size_t s_min_size = 1024 * 1024;
+    void start(char const * p, size_t size) {
+        m_thread.reset(new lthread([this, p, size]() {
+            size_t const page_size = 4096;
+            char volatile const * vp = p;
+            char sink = 0;
+            for (size_t off = 0; off < size; off += page_size) {
+                /* poll the stop flag every 512 KB */
+                if ((off & (128 * page_size - 1)) == 0 && m_stop.load(memory_order_relaxed))
+                    break;
+                sink ^= vp[off];
+            }
+            (void) sink;
+        }));
+    }
+    ~region_warmer() {
+        if (m_thread) {
+            m_stop = true;
+            m_thread->join();
+        }
+    }
+};
+#endif
+
 extern "C" object * lean_read_module_data(object * fname, object *) {
     std::string olean_fn(string_cstr(fname));
     try {
         shared_file_lock olean_lock(olean_fn);
-        std::ifstream in(olean_fn, std::ios_base::binary);
-        if (in.fail()) {
-            return io_result_mk_error((sstream() << "failed to open file '" << olean_fn << "'").str());
-        }
-        /* Get file size */
-        in.seekg(0, in.end);
-        size_t size = in.tellg();
-        in.seekg(0);
-        size_t header_size = strlen(g_olean_header);
-        if (size < header_size) {
-            return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', invalid header").str());
-        }
-        char * header = new char[header_size];
-        in.read(header, header_size);
-        if (strncmp(header, g_olean_header, header_size) != 0) {
-            return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', invalid header").str());
+        size_t magic_size  = strlen(g_olean_header);
+        size_t header_size = magic_size + sizeof(uint64);
+        compacted_region * region = nullptr;
+#if !defined(LEAN_WINDOWS) && !defined(LEAN_EMSCRIPTEN)
+        region_warmer warmer;
+        /* Map the file copy-on-write instead of reading it into a private buffer. References
+           inside the region are stored as offsets, so the mapping address does not matter; pages
+           are faulted in on demand, and pages `compacted_region::read` does not touch while fixing
+           pointers (e.g., string and scalar array payloads) remain backed by the shared page
+           cache across all processes importing the module. On failure (e.g., the file system does
+           not support mmap), we fall through to the read-based path below. */
+        int fd = open(olean_fn.c_str(), O_RDONLY);
+        if (fd != -1) {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= header_size) {
+                size_t size = st.st_size;
+                void * base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                if (base != MAP_FAILED) {
+                    /* `compacted_region::read` walks the region linearly exactly once; tell the
+                       kernel so it uses aggressive readahead and drops already fixed pages from
+                       the readahead window. */
+#if defined(MADV_SEQUENTIAL)
+                    madvise(base, size, MADV_SEQUENTIAL);
+#endif
+#if defined(MADV_WILLNEED)
+                    /* Start readahead for the whole file immediately rather than
+                       from inside the fault handler; fixup then mostly finds its
+                       pages already in the page cache. */
+                    madvise(base, size, MADV_WILLNEED);
+#endif
+                    if (strncmp(static_cast<char *>(base), g_olean_header, magic_size) != 0) {
+                        munmap(base, size);
+                        close(fd);
+                        return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', invalid header").str());
+                    }
+                    if (olean_verify()) {
+                        uint64 checksum;
+                        memcpy(&checksum, static_cast<char *>(base) + magic_size, sizeof(checksum));
+                        if (olean_checksum(static_cast<char *>(base) + header_size, size - header_size) != checksum) {
+                            munmap(base, size);
+                            close(fd);
+                            return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', checksum mismatch").str());
+                        }
+                    }
+                    region = new compacted_region(size - header_size, static_cast<char *>(base) + header_size, base, size);
+                    /* With verification on, the checksum pass above has already
+                       touched every page. */
+                    if (!olean_verify() && size >= region_warmer::s_min_size)
+                        warmer.start(static_cast<char const *>(base), size);
+                }
+            }
+            close(fd);
         }
-        delete[] header;
-        // use `malloc` here as expected by `compacted_region`
-        char * buffer = static_cast<char *>(malloc(size - header_size));
-        in.read(buffer, size - header_size);
-        if (!in) {
-            return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "'").str());
+#endif
+        if (region == nullptr) {
+            std::ifstream in(olean_fn, std::ios_base::binary);
+            if (in.fail()) {
+                return io_result_mk_error((sstream() << "failed to open file '" << olean_fn << "'").str());
+            }
+            /* Get file size */
+            in.seekg(0, in.end);
+            size_t size = in.tellg();
+            in.seekg(0);
+            if (size < header_size) {
+                return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', invalid header").str());
+            }
+            char * header = new char[header_size];
+            in.read(header, header_size);
+            if (strncmp(header, g_olean_header, magic_size) != 0) {
+                return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', invalid header").str());
+            }
+            uint64 checksum;
+            memcpy(&checksum, header + magic_size, sizeof(checksum));
+            delete[] header;
+            // use `malloc` here as expected by `compacted_region`
+            char * buffer = static_cast<char *>(malloc(size - header_size));
+            in.read(buffer, size - header_size);
+            if (!in) {
+                return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "'").str());
+            }
+            in.close();
+            if (olean_verify() && olean_checksum(buffer, size - header_size) != checksum) {
+                free(buffer);
+                return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', checksum mismatch").str());
+            }
+            region = new compacted_region(size - header_size, buffer);
         }
-        in.close();
-        compacted_region * region = new compacted_region(size - header_size, buffer);
 #if defined(__has_feature)
 #if __has_feature(address_sanitizer)
         // do not report as leak
@@ -103,6 +265,122 @@ extern "C" object * lean_read_module_data(object * fname, object *) {
     }
 }
 
+/* Cross-process cache of compacted object graphs in POSIX shared memory.
+
+   A parallel build runs many `lean` processes that materialize the same merged
+   environment for overlapping import sets. The first process to finish merging
+   publishes the compacted graph under a caller-chosen key (e.g., the hash of
+   the sorted import set); later processes attach instead of re-merging, and
+   only pay the pointer-fixup pass over a copy-on-write mapping, so payload
+   pages the fixup does not dirty are shared with every attacher through the
+   page cache.
+
+   Segment layout: a uint64 magic (written only after the payload is fully
+   copied, so a concurrent attacher never observes a partially initialized
+   segment), the uint64 payload size, and the compacted region. Segments are
+   never reclaimed automatically; the build system is expected to drop them
+   (`lean_shared_region_drop`) when the corresponding imports change. */
+static uint64 g_shared_region_magic = 0x6c65616e72656769ull; /* "leanregi" */
+
+static void shared_region_name(uint64 key, char * buf, size_t buf_sz) {
+    snprintf(buf, buf_sz, "/lean-region-%016llx", static_cast<unsigned long long>(key));
+}
+
+#if !defined(LEAN_WINDOWS) && !defined(LEAN_EMSCRIPTEN)
+extern "C" object * lean_shared_region_publish(uint64 key, object * val, object *) {
+    object_ref val_ref(val);
+    char name[64];
+    shared_region_name(key, name, sizeof(name));
+    object_compactor compactor;
+    compactor(val_ref.raw());
+    size_t total = 2 * sizeof(uint64) + compactor.size();
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1)
+        return io_result_mk_ok(box(0)); /* already published (or shm unavailable) */
+    if (ftruncate(fd, total) == -1) {
+        close(fd);
+        shm_unlink(name);
+        return io_result_mk_ok(box(0));
+    }
+    void * base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name);
+        return io_result_mk_ok(box(0));
+    }
+    char * p = static_cast<char *>(base);
+    uint64 payload_sz = compactor.size();
+    memcpy(p + 2 * sizeof(uint64), compactor.data(), payload_sz);
+    memcpy(p + sizeof(uint64), &payload_sz, sizeof(payload_sz));
+    atomic_thread_fence(memory_order_release);
+    memcpy(p, &g_shared_region_magic, sizeof(g_shared_region_magic));
+    munmap(base, total);
+    return io_result_mk_ok(box(1));
+}
+
+extern "C" object * lean_shared_region_attach(uint64 key, object *) {
+    char name[64];
+    shared_region_name(key, name, sizeof(name));
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1)
+        return io_result_mk_ok(box(0)); /* none */
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < 2 * sizeof(uint64)) {
+        close(fd);
+        return io_result_mk_ok(box(0));
+    }
+    size_t total = st.st_size;
+    /* Private copy-on-write mapping: the fixup pass below writes pointer fields,
+       but pages it does not touch stay shared with other attachers. */
+    void * base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return io_result_mk_ok(box(0));
+    char * p = static_cast<char *>(base);
+    uint64 magic, payload_sz;
+    memcpy(&magic, p, sizeof(magic));
+    atomic_thread_fence(memory_order_acquire);
+    memcpy(&payload_sz, p + sizeof(uint64), sizeof(payload_sz));
+    if (magic != g_shared_region_magic || payload_sz > total - 2 * sizeof(uint64)) {
+        munmap(base, total);
+        return io_result_mk_ok(box(0));
+    }
+    compacted_region * region = new compacted_region(payload_sz, p + 2 * sizeof(uint64), base, total);
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+    // do not report as leak
+    __lsan_ignore_object(region);
+#endif
+#endif
+    /* Like the regions backing imported modules, the region must stay alive as
+       long as the value read from it; it is intentionally leaked. */
+    object * val = region->read();
+    object * r = alloc_cnstr(1, 1, 0);
+    cnstr_set(r, 0, val);
+    return io_result_mk_ok(r);
+}
+
+extern "C" object * lean_shared_region_drop(uint64 key, object *) {
+    char name[64];
+    shared_region_name(key, name, sizeof(name));
+    shm_unlink(name);
+    return io_result_mk_ok(box(0));
+}
+#else
+extern "C" object * lean_shared_region_publish(uint64, object * val, object *) {
+    dec(val);
+    return io_result_mk_ok(box(0));
+}
+
+extern "C" object * lean_shared_region_attach(uint64, object *) {
+    return io_result_mk_ok(box(0));
+}
+
+extern "C" object * lean_shared_region_drop(uint64, object *) {
+    return io_result_mk_ok(box(0));
+}
+#endif
+
 /*
 @[export lean.write_module_core]
 def writeModule (env : Environment) (fname : String) : IO Unit := */
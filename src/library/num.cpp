@@ -93,32 +93,66 @@ bool is_signed_num(expr const & e) {
         return false;
 }
 
-static optional<mpz> to_num(expr const & e, bool first) {
-    if (is_zero(e)) {
-        return first ? some(mpz(0)) : optional<mpz>();
-    } else if (is_one(e)) {
-        return some(mpz(1));
-    } else if (auto a = is_of_nat(e)) {
-        return to_num(*a, false);
-    } else if (is_lit(e) && lit_value(e).kind() == literal_kind::Nat) {
-        return some(lit_value(e).get_nat().to_mpz());
-    } else if (auto a = is_bit0(e)) {
-        if (auto r = to_num(*a, false))
-            return some(2*(*r));
-    } else if (auto a = is_bit1(e)) {
-        if (auto r = to_num(*a, false))
-            return some(2*(*r)+1);
-    } else if (first) {
-        if (auto a = is_neg(e)) {
-            if (auto r = to_num(*a, false))
-                return some(neg(*r));
+optional<mpz> to_num(expr const & e) {
+    /* The bit0/bit1 chain stores the least significant bit outermost, so an
+       outside-in walk yields the bits LSB first. We gather them into machine
+       words and build the mpz with a single limb import at the end, instead
+       of one `2*r(+1)` mpz temporary per bit: reflection tactics convert
+       numerals with thousands of bits. */
+    expr curr     = e;
+    bool negated  = false;
+    if (auto a = is_neg(curr)) {
+        negated = true;
+        curr    = *a;
+    }
+    bool top = !negated;
+    buffer<mp_limb_t> limbs;
+    mp_limb_t word      = 0;
+    unsigned  word_bits = 0;
+    size_t    nbits     = 0;
+    while (true) {
+        if (auto a = is_of_nat(curr)) {
+            curr = *a;
+            top  = false;
+            continue;
+        } else if (auto a = is_bit0(curr)) {
+            curr = *a;
+        } else if (auto a = is_bit1(curr)) {
+            word |= static_cast<mp_limb_t>(1) << word_bits;
+            curr = *a;
+        } else {
+            break;
+        }
+        nbits++;
+        word_bits++;
+        if (word_bits == GMP_NUMB_BITS) {
+            limbs.push_back(word);
+            word      = 0;
+            word_bits = 0;
         }
+        top = false;
     }
-    return optional<mpz>();
-}
-
-optional<mpz> to_num(expr const & e) {
-    return to_num(e, true);
+    /* Terminator: `one` closes the chain as its most significant bit; a `Nat`
+       literal contributes an arbitrary most significant part; `zero` is only
+       a valid numeral on its own. */
+    mpz r;
+    if (is_one(curr)) {
+        r = 1;
+    } else if (is_lit(curr) && lit_value(curr).kind() == literal_kind::Nat) {
+        r = lit_value(curr).get_nat().to_mpz();
+    } else if (is_zero(curr) && top) {
+        lean_assert(nbits == 0);
+        return some(mpz(0));
+    } else {
+        return optional<mpz>();
+    }
+    if (nbits > 0) {
+        mul2k(r, r, nbits);
+        if (word_bits > 0)
+            limbs.push_back(word);
+        r += mpz::of_limbs(limbs.size(), limbs.data());
+    }
+    return some(negated ? neg(r) : r);
 }
 
 bool is_num_leaf_constant(name const & n) {
@@ -128,13 +162,19 @@ bool is_num_leaf_constant(name const & n) {
 }
 
 expr to_nat_expr_core(mpz const & n) {
-    lean_assert(n >= 0);
-    if (n == 1)
-        return mk_nat_one();
-    else if (n % mpz(2) == 0)
-        return mk_nat_bit0(to_nat_expr(n / 2));
-    else
-        return mk_nat_bit1(to_nat_expr(n / 2));
+    lean_assert(n > 0);
+    /* Emit the chain from the most significant bit inward: the leading bit is
+       the `one` terminator, every lower bit wraps a bit0/bit1 node around it.
+       Reading the bits with `test_bit` avoids the `n % 2`/`n / 2` mpz
+       temporaries the old structural recursion allocated per bit. */
+    size_t msb = n.log2();
+    expr r = mk_nat_one();
+    size_t i = msb;
+    while (i > 0) {
+        --i;
+        r = n.test_bit(i) ? mk_nat_bit1(r) : mk_nat_bit0(r);
+    }
+    return r;
 }
 
 expr to_nat_expr(mpz const & n) {
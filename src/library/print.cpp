@@ -6,6 +6,8 @@ Author: Leonardo de Moura
 */
 #include <string>
 #include <utility>
+#include <sstream>
+#include <unordered_map>
 #include "util/escaped.h"
 #include "kernel/environment.h"
 #include "kernel/find_fn.h"
@@ -106,9 +108,18 @@ name fix_name(name const & a) {
    It is mainly used when debugging code.
 */
 struct print_expr_fn {
-    std::ostream & m_out;
+    std::ostream * m_out;
+    /* Occurrence counts for composite subterms reachable from the root, and
+       the rendered text of the ones that occur more than once. Heavily-shared
+       proof terms are DAGs whose tree expansion is exponential; rendering a
+       shared node once and replaying its text keeps printing proportional to
+       the DAG size. Both tables are keyed by node address, which is stable
+       while the root keeps the term alive; subterms rebuilt by
+       `binding_body_fresh` simply miss the cache. */
+    std::unordered_map<object *, unsigned>    m_num_refs;
+    std::unordered_map<object *, std::string> m_cache;
 
-    std::ostream & out() { return m_out; }
+    std::ostream & out() { return *m_out; }
 
     static bool is_atomic(expr const & a) {
         if (::lean::is_atomic(a)) return true;
@@ -236,7 +247,7 @@ struct print_expr_fn {
         out() << "]";
     }
 
-    void print(expr const & a) {
+    void print_core(expr const & a) {
         switch (a.kind()) {
         case expr_kind::MVar:
             out() << "?" << fix_name(mvar_name(a));
@@ -289,9 +300,82 @@ struct print_expr_fn {
         }
     }
 
-    print_expr_fn(std::ostream & out):m_out(out) {}
+    static bool is_cacheable(expr const & a) {
+        /* Only composite kinds can be expensive to re-render; atomic ones
+           (and `BVar`, which prints as `#idx` regardless of position) are
+           cheaper to print than to look up. */
+        switch (a.kind()) {
+        case expr_kind::App:    case expr_kind::Lambda: case expr_kind::Pi:
+        case expr_kind::Let:    case expr_kind::MData:  case expr_kind::Proj:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void collect_num_refs(expr const & root) {
+        buffer<expr> todo;
+        todo.push_back(root);
+        while (!todo.empty()) {
+            expr e = todo.back();
+            todo.pop_back();
+            if (!is_cacheable(e))
+                continue;
+            if (++m_num_refs[e.raw()] > 1)
+                continue;
+            switch (e.kind()) {
+            case expr_kind::App:
+                todo.push_back(app_fn(e));
+                todo.push_back(app_arg(e));
+                break;
+            case expr_kind::Lambda: case expr_kind::Pi:
+                todo.push_back(binding_domain(e));
+                todo.push_back(binding_body(e));
+                break;
+            case expr_kind::Let:
+                todo.push_back(let_type(e));
+                todo.push_back(let_value(e));
+                todo.push_back(let_body(e));
+                break;
+            case expr_kind::MData:
+                todo.push_back(mdata_expr(e));
+                break;
+            case expr_kind::Proj:
+                todo.push_back(proj_expr(e));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void print(expr const & a) {
+        if (is_cacheable(a)) {
+            auto nit = m_num_refs.find(a.raw());
+            if (nit != m_num_refs.end() && nit->second > 1) {
+                auto it = m_cache.find(a.raw());
+                if (it != m_cache.end()) {
+                    out() << it->second;
+                    return;
+                }
+                std::ostringstream tmp;
+                std::ostream * saved = m_out;
+                m_out = &tmp;
+                print_core(a);
+                m_out = saved;
+                std::string s = tmp.str();
+                out() << s;
+                m_cache.emplace(a.raw(), std::move(s));
+                return;
+            }
+        }
+        print_core(a);
+    }
+
+    print_expr_fn(std::ostream & out):m_out(&out) {}
 
     void operator()(expr const & e) {
+        collect_num_refs(e);
         print(e);
     }
 };
@@ -19,6 +19,8 @@ namespace lean {
 
 static name * g_profiler           = nullptr;
 static name * g_profiler_threshold = nullptr;
+static name * g_profiler_counters  = nullptr;
+static name * g_profiler_trace_out = nullptr;
 
 bool get_profiler(options const & opts) {
     return opts.get_bool(*g_profiler, LEAN_DEFAULT_PROFILER);
@@ -28,6 +30,14 @@ second_duration get_profiling_threshold(options const & opts) {
     return second_duration(static_cast<double>(opts.get_unsigned(*g_profiler_threshold, LEAN_DEFAULT_PROFILER_THRESHOLD))/1000.0);
 }
 
+bool get_profiler_counters(options const & opts) {
+    return opts.get_bool(*g_profiler_counters, false);
+}
+
+std::string get_profiler_trace_out(options const & opts) {
+    return opts.get_string(*g_profiler_trace_out, "");
+}
+
 void initialize_profiling() {
     g_profiler           = new name{"profiler"};
     mark_persistent(g_profiler->raw());
@@ -36,11 +46,22 @@ void initialize_profiling() {
     register_bool_option(*g_profiler, LEAN_DEFAULT_PROFILER, "(profiler) profile tactics and vm_eval command");
     register_unsigned_option(*g_profiler_threshold, LEAN_DEFAULT_PROFILER_THRESHOLD,
                              "(profiler) threshold in milliseconds, profiling times under threshold will not be reported");
+    g_profiler_counters  = new name{"profiler", "counters"};
+    mark_persistent(g_profiler_counters->raw());
+    register_bool_option(*g_profiler_counters, false,
+                         "(profiler) also collect hardware performance counters (cycles, instructions, "
+                         "cache misses, branch misses) per profiling category; Linux perf_event only");
+    g_profiler_trace_out = new name{"profiler", "trace", "out"};
+    mark_persistent(g_profiler_trace_out->raw());
+    register_option(*g_profiler_trace_out, data_value_kind::String, "",
+                    "(profiler) write profiled spans as Chrome trace-event JSON to the given file");
 }
 
 void finalize_profiling() {
     delete g_profiler;
     delete g_profiler_threshold;
+    delete g_profiler_counters;
+    delete g_profiler_trace_out;
 }
 
 }
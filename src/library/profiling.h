@@ -14,6 +14,10 @@ using second_duration = std::chrono::duration<double>;
 
 bool get_profiler(options const &);
 second_duration get_profiling_threshold(options const &);
+/* Whether hardware performance counters should be collected per profiling category. */
+bool get_profiler_counters(options const &);
+/* Path of the Chrome trace-event JSON file written at shutdown, or "" when disabled. */
+std::string get_profiler_trace_out(options const &);
 
 void initialize_profiling();
 void finalize_profiling();
@@ -6,6 +6,8 @@ Author: Leonardo de Moura
 */
 #include <string>
 #include <lean/sstream.h>
+#include <lean/thread.h>
+#include "util/name_hash_map.h"
 #include "kernel/kernel_exception.h"
 #include "kernel/instantiate.h"
 #include "kernel/inductive.h"
@@ -29,8 +31,30 @@ environment save_projection_info(environment const & env, name const & p, name c
     return environment(lean_add_projection_info(env.to_obj_arg(), p.to_obj_arg(), mk.to_obj_arg(), mk_nat_obj(nparams), mk_nat_obj(i), inst_implicit));
 }
 
+/* Per-environment memo for projection info, same scheme as the class predicate
+   cache in library/class.cpp. The LCNF conversion consults this for every
+   constant application it visits, and each uncached query resolves the
+   extension state on the Lean side; the answers are immutable per constant
+   once the environment is fixed. */
+struct projection_info_cache {
+    optional<environment>                      m_env;
+    name_hash_map<optional<projection_info>>   m_info;
+};
+
+MK_THREAD_LOCAL_GET_DEF(projection_info_cache, get_projection_info_cache);
+
 optional<projection_info> get_projection_info(environment const & env, name const & p) {
-    return to_optional<projection_info>(lean_get_projection_info(env.to_obj_arg(), p.to_obj_arg()));
+    projection_info_cache & cache = get_projection_info_cache();
+    if (!cache.m_env || !is_eqp(*cache.m_env, env)) {
+        cache.m_env = optional<environment>(env);
+        cache.m_info.clear();
+    }
+    auto it = cache.m_info.find(p);
+    if (it != cache.m_info.end())
+        return it->second;
+    optional<projection_info> r = to_optional<projection_info>(lean_get_projection_info(env.to_obj_arg(), p.to_obj_arg()));
+    cache.m_info.emplace(p, r);
+    return r;
 }
 
 /** \brief Return true iff the type named \c S can be viewed as
@@ -5,7 +5,9 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <string>
+#include <lean/thread.h>
 #include "kernel/environment.h"
+#include "util/name_hash_map.h"
 #include "library/reducible.h"
 
 namespace lean {
@@ -18,7 +20,29 @@ environment set_reducible(environment const & env, name const & n, reducible_sta
     return environment(lean_set_reducibility_status(env.to_obj_arg(), n.to_obj_arg(), static_cast<uint8>(s)));
 }
 
+/* Per-environment memo for reducibility queries, same scheme as the class
+   predicate cache in library/class.cpp: the unfolding heuristics ask for the
+   status of the same constants over and over in inner elaboration loops, and
+   each uncached query crosses into Lean code and walks the attribute state.
+   Setting a status produces a new environment, which resets the memo. */
+struct reducible_cache {
+    optional<environment>   m_env;
+    name_hash_map<unsigned> m_status;
+};
+
+MK_THREAD_LOCAL_GET_DEF(reducible_cache, get_reducible_cache);
+
 reducible_status get_reducible_status(environment const & env, name const & n) {
-    return static_cast<reducible_status>(lean_get_reducibility_status(env.to_obj_arg(), n.to_obj_arg()));
+    reducible_cache & cache = get_reducible_cache();
+    if (!cache.m_env || !is_eqp(*cache.m_env, env)) {
+        cache.m_env = optional<environment>(env);
+        cache.m_status.clear();
+    }
+    auto it = cache.m_status.find(n);
+    if (it != cache.m_status.end())
+        return static_cast<reducible_status>(it->second);
+    uint8 s = lean_get_reducibility_status(env.to_obj_arg(), n.to_obj_arg());
+    cache.m_status[n] = s;
+    return static_cast<reducible_status>(s);
 }
 }
@@ -5,60 +5,252 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Sebastian Ullrich
 */
 #include <string>
-#include <map>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+#include <fstream>
+#include <thread>
 #include "library/time_task.h"
 #include "library/trace.h"
 
 namespace lean {
 
-static std::map<std::string, second_duration> * g_cum_times;
 static mutex * g_cum_times_mutex;
+/* Dense category ids. The profiler's category set is small and settles early,
+   so per-thread accumulators can be plain vectors indexed by id instead of
+   maps keyed by strings; ids are assigned under the mutex, everything else on
+   the hot path is thread-local. */
+static std::unordered_map<std::string, unsigned> * g_category_ids;
+/* id -> name; a deque so existing entries stay put while categories are added */
+static std::deque<std::string> * g_category_names;
+/* accumulators of threads that have already exited, indexed by category id */
+static std::vector<second_duration> * g_cum_times;
+static std::vector<perf_counters> * g_cum_counters;
+
+struct thread_times;
+static std::vector<thread_times *> * g_live_thread_times;
+
+/* Per-thread profiling accumulators. `time_task` construction and destruction
+   only touch these (no lock, and no allocation once the vectors cover the ids
+   in use), so fine-grained instrumentation does not perturb what it measures.
+   The accumulators are merged into the globals when the thread exits and read
+   in place by `display_cumulative_profiling_times`, which runs after the
+   workers have quiesced. */
+struct thread_times {
+    std::vector<second_duration>              m_times;
+    std::vector<perf_counters>                m_counters;
+    /* thread-local view of `g_category_ids` */
+    std::unordered_map<std::string, unsigned> m_ids;
+    thread_times() {
+        lock_guard<mutex> _(*g_cum_times_mutex);
+        g_live_thread_times->push_back(this);
+    }
+    ~thread_times() {
+        /* `finalize_time_task` may have run first on shutdown */
+        if (g_live_thread_times == nullptr)
+            return;
+        lock_guard<mutex> _(*g_cum_times_mutex);
+        if (g_cum_times->size() < m_times.size())
+            g_cum_times->resize(m_times.size(), second_duration(0));
+        for (unsigned i = 0; i < m_times.size(); i++)
+            (*g_cum_times)[i] += m_times[i];
+        if (g_cum_counters->size() < m_counters.size())
+            g_cum_counters->resize(m_counters.size());
+        for (unsigned i = 0; i < m_counters.size(); i++)
+            (*g_cum_counters)[i] += m_counters[i];
+        g_live_thread_times->erase(std::find(g_live_thread_times->begin(), g_live_thread_times->end(), this));
+    }
+    void add_time(unsigned id, second_duration d) {
+        if (id >= m_times.size())
+            m_times.resize(id + 1, second_duration(0));
+        m_times[id] += d;
+    }
+    void add_counters(unsigned id, perf_counters const & c) {
+        if (id >= m_counters.size())
+            m_counters.resize(id + 1);
+        m_counters[id] += c;
+    }
+};
+MK_THREAD_LOCAL_GET_DEF(thread_times, get_thread_times);
+
+static unsigned category_id(std::string const & category, thread_times & tt) {
+    auto it = tt.m_ids.find(category);
+    if (it != tt.m_ids.end())
+        return it->second;
+    unsigned id;
+    {
+        lock_guard<mutex> _(*g_cum_times_mutex);
+        auto p = g_category_ids->emplace(category, static_cast<unsigned>(g_category_names->size()));
+        if (p.second)
+            g_category_names->push_back(category);
+        id = p.first->second;
+    }
+    tt.m_ids.emplace(category, id);
+    return id;
+}
+
+static std::string category_name(unsigned id) {
+    lock_guard<mutex> _(*g_cum_times_mutex);
+    return (*g_category_names)[id];
+}
 LEAN_THREAD_PTR(time_task, g_current_time_task);
 
+/* Chrome trace-event collection (`profiler.trace.out`). Every profiled scope becomes a
+   complete ("X") event with its thread id; trace viewers reconstruct the nesting and the
+   critical path of a parallel build from the per-thread scope overlaps. */
+struct trace_event {
+    std::string m_name;
+    size_t      m_tid;
+    double      m_ts;  /* microseconds since profiling start */
+    double      m_dur; /* microseconds */
+};
+static std::vector<trace_event> * g_trace_events;
+static std::string * g_trace_out;
+static second_duration g_trace_epoch;
+
+static void write_json_escaped(std::ostream & out, std::string const & s) {
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out << '\\';
+        out << c;
+    }
+}
+
 void report_profiling_time(std::string const & category, second_duration time) {
-    lock_guard<mutex> _(*g_cum_times_mutex);
-    (*g_cum_times)[category] += time;
+    thread_times & tt = get_thread_times();
+    tt.add_time(category_id(category, tt), time);
 }
 
 void display_cumulative_profiling_times(std::ostream & out) {
-    if (g_cum_times->empty())
+    lock_guard<mutex> _(*g_cum_times_mutex);
+    unsigned n = static_cast<unsigned>(g_category_names->size());
+    if (n == 0)
         return;
+    std::vector<second_duration> times(n, second_duration(0));
+    std::vector<perf_counters> counters(n);
+    for (unsigned i = 0; i < g_cum_times->size(); i++)
+        times[i] += (*g_cum_times)[i];
+    for (unsigned i = 0; i < g_cum_counters->size(); i++)
+        counters[i] += (*g_cum_counters)[i];
+    for (thread_times * tt : *g_live_thread_times) {
+        for (unsigned i = 0; i < tt->m_times.size(); i++)
+            times[i] += tt->m_times[i];
+        for (unsigned i = 0; i < tt->m_counters.size(); i++)
+            counters[i] += tt->m_counters[i];
+    }
+    /* ids are assigned in first-use order; sort by name for a stable report */
+    std::vector<unsigned> ids(n);
+    for (unsigned i = 0; i < n; i++) ids[i] = i;
+    std::sort(ids.begin(), ids.end(), [&](unsigned i, unsigned j) {
+        return (*g_category_names)[i] < (*g_category_names)[j];
+    });
     out << "cumulative profiling times:\n";
-    for (auto const & p : *g_cum_times)
-        out << "\t" << p.first << " " << display_profiling_time{p.second} << "\n";
+    for (unsigned id : ids) {
+        out << "\t" << (*g_category_names)[id] << " " << display_profiling_time{times[id]};
+        perf_counters const & c = counters[id];
+        if (c.m_cycles || c.m_instructions || c.m_cache_misses || c.m_branch_misses) {
+            out << " (cycles: " << c.m_cycles << ", instructions: " << c.m_instructions
+                << ", cache misses: " << c.m_cache_misses << ", branch misses: " << c.m_branch_misses << ")";
+        }
+        out << "\n";
+    }
 }
 
 void initialize_time_task() {
     g_cum_times_mutex = new mutex;
-    g_cum_times = new std::map<std::string, second_duration>;
+    g_category_ids = new std::unordered_map<std::string, unsigned>;
+    g_category_names = new std::deque<std::string>;
+    g_live_thread_times = new std::vector<thread_times *>;
+    g_cum_times = new std::vector<second_duration>;
+    g_cum_counters = new std::vector<perf_counters>;
+    g_trace_events = new std::vector<trace_event>;
+    g_trace_out = new std::string;
+    g_trace_epoch = fast_now();
 }
 
 void finalize_time_task() {
+    if (!g_trace_out->empty() && !g_trace_events->empty()) {
+        std::ofstream out(*g_trace_out);
+        out << "[\n";
+        bool first = true;
+        for (auto const & e : *g_trace_events) {
+            if (!first)
+                out << ",\n";
+            first = false;
+            out << "{\"name\":\"";
+            write_json_escaped(out, e.m_name);
+            out << "\",\"cat\":\"lean\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.m_tid
+                << ",\"ts\":" << e.m_ts << ",\"dur\":" << e.m_dur << "}";
+        }
+        out << "\n]\n";
+    }
+    delete g_trace_events;
+    delete g_trace_out;
+    delete g_cum_counters;
+    g_cum_counters = nullptr;
     delete g_cum_times;
+    g_cum_times = nullptr;
+    delete g_live_thread_times;
+    g_live_thread_times = nullptr;
+    delete g_category_names;
+    g_category_names = nullptr;
+    delete g_category_ids;
+    g_category_ids = nullptr;
     delete g_cum_times_mutex;
+    g_cum_times_mutex = nullptr;
 }
 
-time_task::time_task(std::string const & category, options const & opts, name decl) :
-        m_category(category) {
+time_task::time_task(std::string const & category, options const & opts, name decl) {
     if (get_profiler(opts)) {
-        m_timeit = optional<xtimeit>(get_profiling_threshold(opts), [=](second_duration duration) mutable {
-            tout() << m_category;
-            if (decl)
-                tout() << " of " << decl;
+        m_category_id = category_id(category, get_thread_times());
+        m_decl = decl;
+        /* capturing only `this` keeps the std::function within its small-object
+           buffer, so no allocation */
+        m_timeit = optional<xtimeit>(get_profiling_threshold(opts), [this](second_duration duration) {
+            tout() << category_name(m_category_id);
+            if (m_decl)
+                tout() << " of " << m_decl;
             tout() << " took " << display_profiling_time{duration} << "\n";
         });
         m_parent_task = g_current_time_task;
         g_current_time_task = this;
+        if (!get_profiler_trace_out(opts).empty()) {
+            m_trace = true;
+            m_start = fast_now();
+            lock_guard<mutex> _(*g_cum_times_mutex);
+            if (g_trace_out->empty())
+                *g_trace_out = get_profiler_trace_out(opts);
+        }
+        if (get_profiler_counters(opts))
+            m_perf = new perf_scope(m_counters);
     }
 }
 
 time_task::~time_task() {
+    if (m_perf) {
+        // samples the end counters and stores the delta in m_counters
+        delete m_perf;
+        get_thread_times().add_counters(m_category_id, m_counters);
+    }
     if (m_timeit) {
         g_current_time_task = m_parent_task;
-        report_profiling_time(m_category, m_timeit->get_elapsed());
+        get_thread_times().add_time(m_category_id, m_timeit->get_elapsed());
         if (m_parent_task && m_parent_task->m_timeit)
             // report exclusive times
             m_parent_task->m_timeit->exclude_duration(m_timeit->get_elapsed_inclusive());
+        if (m_trace) {
+            auto end = fast_now();
+            trace_event e;
+            e.m_name = category_name(m_category_id);
+            if (m_decl)
+                e.m_name += " of " + m_decl.to_string();
+            e.m_tid  = std::hash<std::thread::id>()(std::this_thread::get_id());
+            e.m_ts   = std::chrono::duration<double, std::micro>(m_start - g_trace_epoch).count();
+            e.m_dur  = std::chrono::duration<double, std::micro>(end - m_start).count();
+            lock_guard<mutex> _(*g_cum_times_mutex);
+            g_trace_events->push_back(std::move(e));
+        }
     }
 }
 
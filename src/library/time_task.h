@@ -16,9 +16,18 @@ void display_cumulative_profiling_times(std::ostream & out);
 
 /** Measure time of some task and report it for the final cumulative profile. */
 class time_task {
-    std::string     m_category;
+    /* dense id of the category; see `category_id` in the .cpp */
+    unsigned        m_category_id = 0;
     optional<xtimeit> m_timeit;
     time_task *     m_parent_task;
+    /* set when `profiler.trace.out` is active; the scope is then also recorded as a
+       Chrome trace event */
+    bool            m_trace = false;
+    name            m_decl;
+    second_duration m_start;
+    /* set when `profiler.counters` is active; hardware counter deltas for this scope */
+    perf_counters   m_counters;
+    perf_scope *    m_perf = nullptr;
 public:
     time_task(std::string const & category, options const & opts, name decl = name());
     ~time_task();
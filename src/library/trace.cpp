@@ -6,6 +6,7 @@ Author: Leonardo de Moura
 */
 #include <vector>
 #include <string>
+#include <atomic>
 #include "util/io.h"
 #include "util/option_declarations.h"
 #include "kernel/environment.h"
@@ -34,8 +35,14 @@ void register_trace_class_alias(name const & n, name const & alias) {
     g_trace_aliases->insert(n, new_s);
 }
 
+/* Total number of enabled trace classes across all threads. Trace points check this
+   first, so with tracing off everywhere each check is a single relaxed load instead of
+   a thread-local lookup; a thread only consults its own class lists once some thread
+   has enabled tracing. */
+static std::atomic<unsigned> g_num_enabled_classes{0};
+
 bool is_trace_enabled() {
-    return !get_enabled_trace_classes().empty();
+    return g_num_enabled_classes.load(std::memory_order_relaxed) != 0;
 }
 
 static void update_class(std::vector<name> & cs, name const & c) {
@@ -45,7 +52,11 @@ static void update_class(std::vector<name> & cs, name const & c) {
 }
 
 static void enable_trace_class(name const & c) {
-    update_class(get_enabled_trace_classes(), c);
+    std::vector<name> & cs = get_enabled_trace_classes();
+    if (std::find(cs.begin(), cs.end(), c) == cs.end()) {
+        cs.push_back(c);
+        g_num_enabled_classes.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 static void disable_trace_class(name const & c) {
@@ -118,7 +129,10 @@ scope_trace_env::scope_trace_env(environment const & env, options const & o) {
 scope_trace_env::~scope_trace_env() {
     g_env  = const_cast<environment*>(m_old_env);
     g_opts = const_cast<options*>(m_old_opts);
-    get_enabled_trace_classes().resize(m_enable_sz);
+    std::vector<name> & enabled = get_enabled_trace_classes();
+    if (enabled.size() > m_enable_sz)
+        g_num_enabled_classes.fetch_sub(enabled.size() - m_enable_sz, std::memory_order_relaxed);
+    enabled.resize(m_enable_sz);
     get_disabled_trace_classes().resize(m_disable_sz);
 }
 
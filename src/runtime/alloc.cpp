@@ -5,15 +5,42 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <vector>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
 #include <lean/thread.h>
 #include <lean/debug.h>
 #include <lean/alloc.h>
+#include <lean/allocprof.h>
 #include <lean/lean.h>
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <sched.h>
+#if defined(SYS_mbind) && defined(SYS_getcpu)
+#define LEAN_NUMA
+#endif
+#endif
 
 #define LEAN_PAGE_SIZE             8192        // 8 Kb
+#ifdef __EMSCRIPTEN__
+/* Wasm profile: linear memory only grows (memory.grow), never shrinks, and
+   browsers charge each grab against the page's memory budget immediately, so
+   8 MB segments translate into slow growth steps and a bloated initial heap.
+   Small segments keep growth incremental; wasm builds are single-threaded, so
+   segments never migrate and the per-segment overhead stays local. */
+#define LEAN_SEGMENT_SIZE          256*1024    // 256 Kb
+#else
 #define LEAN_SEGMENT_SIZE          8*1024*1024 // 8 Mb
+#endif
+/* Max number of detached heaps kept intact for `lean_attach_thread`. */
+#define LEAN_MAX_CACHED_HEAPS      8
 #define LEAN_NUM_SLOTS             (LEAN_MAX_SMALL_OBJECT_SIZE / LEAN_OBJECT_SIZE_DELTA)
 #define LEAN_MAX_TO_EXPORT_OBJS    1024
+#define LEAN_NUM_IMPORT_SHARDS     8
 
 LEAN_CASSERT(LEAN_PAGE_SIZE > LEAN_MAX_SMALL_OBJECT_SIZE);
 LEAN_CASSERT(LEAN_SEGMENT_SIZE > LEAN_PAGE_SIZE);
@@ -44,6 +71,58 @@ struct alloc_stats {
 static alloc_stats g_alloc_stats;
 #endif
 
+static numa_policy g_numa_policy = numa_policy::none;
+static unsigned    g_num_numa_nodes = 1;
+
+#ifdef LEAN_NUMA
+static int get_current_numa_node() {
+    unsigned cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+        return static_cast<int>(node);
+    return -1;
+}
+
+static unsigned detect_num_numa_nodes() {
+    /* `/sys/devices/system/node/possible` contains a range such as `0-3` (or just `0`). */
+    if (FILE * f = fopen("/sys/devices/system/node/possible", "r")) {
+        unsigned lo = 0, hi = 0;
+        int n = fscanf(f, "%u-%u", &lo, &hi);
+        fclose(f);
+        if (n == 2) return hi + 1;
+        if (n == 1) return lo + 1;
+    }
+    return 1;
+}
+
+static bool read_node_cpuset(unsigned node, cpu_set_t & out) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+    FILE * f = fopen(path, "r");
+    if (!f) return false;
+    CPU_ZERO(&out);
+    bool any = false;
+    unsigned lo, hi;
+    while (true) {
+        if (fscanf(f, "%u", &lo) != 1) break;
+        hi = lo;
+        int c = fgetc(f);
+        if (c == '-') {
+            if (fscanf(f, "%u", &hi) != 1) break;
+            c = fgetc(f);
+        }
+        for (unsigned cpu = lo; cpu <= hi && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &out);
+            any = true;
+        }
+        if (c != ',') break;
+    }
+    fclose(f);
+    return any;
+}
+#else
+static int get_current_numa_node() { return -1; }
+#endif
+
 struct heap;
 struct page;
 struct page_header {
@@ -56,6 +135,9 @@ struct page_header {
     unsigned         m_num_free;
     unsigned         m_slot_idx;
     bool             m_in_page_free_list;
+    /* True when the page's data area was returned to the OS while the page was
+       fully free; the object free list must be rebuilt before reuse. */
+    bool             m_trimmed;
 };
 
 struct page {
@@ -79,6 +161,8 @@ inline char * align_ptr(char * p, size_t a) {
 
 struct segment {
     segment *    m_next{nullptr};
+    /* Chain of every segment ever allocated (see g_all_segments). */
+    segment *    m_next_global{nullptr};
     char *       m_next_page_mem;
     char         m_data[LEAN_SEGMENT_SIZE];
 
@@ -102,36 +186,122 @@ struct segment {
 struct heap {
     segment * m_curr_segment{nullptr};
     heap *    m_next_orphan{nullptr};
+    /* NUMA node the heap's segments are bound to, or -1 when the `none` policy
+       is active or the node is unknown. Updated whenever a segment is allocated. */
+    int       m_numa_node{-1};
     page *    m_curr_page[LEAN_NUM_SLOTS];
     page *    m_page_free_list[LEAN_NUM_SLOTS];
     /* Objects that must be sent to other heaps. */
     void *    m_to_export_list{nullptr};
     unsigned  m_to_export_list_size{0};
-    mutex     m_mutex; /* for the following fields */
-    /* The following list contains object by this heap that were deallocated
-       by other heaps. */
-    void *    m_to_import_list{nullptr};
+    /* Sharded lock-free (Treiber) stacks containing objects owned by this heap
+       that were deallocated by other heaps. Producers splice whole batches onto
+       the shard associated with their own heap, so concurrent producers rarely
+       contend on the same cache line; only this heap pops (via exchange). */
+    atomic<void *> m_to_import[LEAN_NUM_IMPORT_SHARDS];
     uint64_t  m_heartbeat{0}; /* Counter for implementing "deterministic timeouts". It is currently the number of small allocations */
+    uint64_t  m_alloc_bytes{0}; /* Total bytes handed out by lean_alloc_small; used for per-task allocation attribution. */
+    /* Number of pages currently parked on the page free lists; used to trigger
+       trimming when it crosses the configured watermark. */
+    unsigned  m_num_free_pages{0};
+    /* Subset of m_num_free_pages whose data area is already decommitted. */
+    unsigned  m_num_trimmed_pages{0};
+    heap() {
+        for (unsigned i = 0; i < LEAN_NUM_IMPORT_SHARDS; i++)
+            m_to_import[i].store(nullptr, memory_order_relaxed);
+    }
     void import_objs();
     void export_objs();
+    void push_import_batch(void * head, void * tail, heap const * producer);
     void alloc_segment();
+    void trim_free_pages();
 };
 
+/* When non-zero, a heap whose page free lists grow beyond this many pages
+   returns the data area of fully-free pages to the OS. */
+static unsigned g_page_trim_watermark = 0;
+
+/* Number of pages a fresh heap provisions per size class. The slot geometry
+   itself (lean_get_slot_idx) is compiled into call sites and cannot change at
+   runtime, but per-class provisioning can be tuned from a profile so hot
+   classes start warm and unused ones stop costing a page per thread. */
+static unsigned g_slot_prealloc[LEAN_NUM_SLOTS];
+
+static void init_slot_prealloc() {
+    for (unsigned i = 0; i < LEAN_NUM_SLOTS; i++)
+        g_slot_prealloc[i] = 1;
+}
+
+/* Load a size-class profile: one `<object size> <num pages>` pair per line,
+   e.g. produced from allocprof histograms. Unlisted classes keep one page. */
+static void load_alloc_profile(char const * path) {
+    FILE * f = fopen(path, "r");
+    if (!f) return;
+    unsigned obj_size, num_pages;
+    while (fscanf(f, "%u %u", &obj_size, &num_pages) == 2) {
+        obj_size = lean_align(obj_size, LEAN_OBJECT_SIZE_DELTA);
+        if (obj_size == 0 || obj_size > LEAN_MAX_SMALL_OBJECT_SIZE)
+            continue;
+        /* every class needs at least one page: lean_alloc_small assumes m_curr_page is populated. */
+        g_slot_prealloc[lean_get_slot_idx(obj_size)] = num_pages == 0 ? 1 : num_pages;
+    }
+    fclose(f);
+}
+
 struct heap_manager {
-    /* The mutex protects the list of orphan segments. */
-    mutex             m_mutex;
+    /* The mutex protects the list of orphan segments. Critical sections are a few
+       pointer updates, so spinning briefly beats a futex round trip under
+       contention (e.g., many threads detaching at once). */
+    adaptive_mutex    m_mutex{"alloc/heap_manager"};
     heap *            m_orphans{nullptr};
+    /* Heaps handed back by `lean_detach_thread`, kept intact (pages still
+       provisioned) for the next attach. Bounded by LEAN_MAX_CACHED_HEAPS
+       single-segment heaps, so the cache holds at most that many segments. */
+    heap *            m_heap_cache{nullptr};
+    unsigned          m_num_cached{0};
+
+    bool try_push_cached(heap * h) {
+        lock_guard<adaptive_mutex> lock(m_mutex);
+        if (m_num_cached >= LEAN_MAX_CACHED_HEAPS)
+            return false;
+        h->m_next_orphan = m_heap_cache;
+        m_heap_cache = h;
+        m_num_cached++;
+        return true;
+    }
+
+    heap * pop_cached() {
+        lock_guard<adaptive_mutex> lock(m_mutex);
+        if (m_heap_cache == nullptr)
+            return nullptr;
+        heap * h = m_heap_cache;
+        m_heap_cache = h->m_next_orphan;
+        m_num_cached--;
+        return h;
+    }
 
     void push_orphan(heap * h) {
         /* TODO(Leo): avoid mutex */
-        lock_guard<mutex> lock(m_mutex);
+        lock_guard<adaptive_mutex> lock(m_mutex);
         h->m_next_orphan = m_orphans;
         m_orphans = h;
     }
 
-    heap * pop_orphan() {
+    heap * pop_orphan(int preferred_node) {
         /* TODO(Leo): avoid mutex */
-        lock_guard<mutex> lock(m_mutex);
+        lock_guard<adaptive_mutex> lock(m_mutex);
+        if (preferred_node >= 0) {
+            /* Prefer an orphan whose segments live on `preferred_node`. */
+            heap ** it = &m_orphans;
+            while (*it) {
+                if ((*it)->m_numa_node == preferred_node) {
+                    heap * h = *it;
+                    *it = h->m_next_orphan;
+                    return h;
+                }
+                it = &(*it)->m_next_orphan;
+            }
+        }
         if (m_orphans) {
             heap * h = m_orphans;
             m_orphans = h->m_next_orphan;
@@ -142,14 +312,73 @@ struct heap_manager {
     }
 };
 
+/* Per-thread cache for objects above LEAN_MAX_SMALL_OBJECT_SIZE.
+
+   Blocks are rounded up to a power of two and kept on per-bucket free lists,
+   so array-heavy workloads stop serializing on the system allocator's global
+   lock. Both `alloc` and `dealloc` derive the bucket from the (aligned)
+   requested size, so a block always returns to the bucket it came from. */
+#define LEAN_LARGE_MIN_SHIFT    13 /* 8 KB, first power of two above LEAN_MAX_SMALL_OBJECT_SIZE */
+#define LEAN_LARGE_MAX_SHIFT    22 /* 4 MB, bigger blocks go straight to malloc */
+#define LEAN_LARGE_NUM_BUCKETS  (LEAN_LARGE_MAX_SHIFT - LEAN_LARGE_MIN_SHIFT + 1)
+#ifdef __EMSCRIPTEN__
+/* See the segment-size note above: memory retained by the cache is never
+   returned to the browser, so keep the per-thread reserve small. */
+#define LEAN_LARGE_CACHE_CAPACITY (2*1024*1024)
+#else
+#define LEAN_LARGE_CACHE_CAPACITY (32*1024*1024) /* max bytes cached per thread */
+#endif
+
+struct large_cache {
+    void * m_buckets[LEAN_LARGE_NUM_BUCKETS];
+    size_t m_cached_bytes{0};
+    large_cache() {
+        for (unsigned i = 0; i < LEAN_LARGE_NUM_BUCKETS; i++)
+            m_buckets[i] = nullptr;
+    }
+};
+LEAN_THREAD_PTR(large_cache, g_large_cache);
+
+static unsigned large_bucket_shift(size_t sz) {
+    unsigned shift = LEAN_LARGE_MIN_SHIFT;
+    while ((static_cast<size_t>(1) << shift) < sz)
+        shift++;
+    return shift;
+}
+
 static inline page * get_page_of(void * o) {
     return reinterpret_cast<page*>((reinterpret_cast<size_t>(o)/LEAN_PAGE_SIZE)*LEAN_PAGE_SIZE);
 }
 
 LEAN_THREAD_GLOBAL_PTR(page *, g_curr_pages);
-LEAN_THREAD_PTR(heap, g_heap);
+/* The heap pointer lives in the consolidated `thread_ctx` TLS block (one
+   thread-pointer-relative load shared with the heartbeat state) and is typed
+   there as `void *`; this alias casts it back. */
+#define g_heap (reinterpret_cast<heap * &>(get_thread_ctx().m_heap))
 static heap_manager * g_heap_manager = nullptr;
 
+/* Global chain of every segment ever allocated. Segments migrate between
+   heaps but are never returned to the OS, so the chain can be walked (e.g.
+   by the heap census) without coordinating with the owning heaps. */
+static atomic<segment *> g_all_segments(nullptr);
+
+/* Live segment bytes. Segments are never returned to the OS, so the counter
+   only grows; maintaining it costs one relaxed add per 8 MB of heap growth,
+   cheap enough to keep on unconditionally (unlike the LEAN_RUNTIME_STATS
+   counters). Read by `check_memory` to enforce the memory budget without a
+   syscall. */
+static atomic<size_t> g_segment_bytes(0);
+
+static void register_segment(segment * s) {
+    g_segment_bytes.fetch_add(sizeof(segment), memory_order_relaxed);
+    s->m_next_global = g_all_segments.load(memory_order_relaxed);
+    while (!g_all_segments.compare_exchange_weak(s->m_next_global, s)) {}
+}
+
+/* Set by the SIGUSR1 handler; checked at the next page allocation. */
+static volatile sig_atomic_t g_census_requested = 0;
+static void maybe_dump_heap_census();
+
 inline void set_next_obj(void * obj, void * next) {
     *reinterpret_cast<void**>(obj) = next;
 }
@@ -201,6 +430,10 @@ void page::push_free_obj(void * o) {
             m_header.m_in_page_free_list = true;
             page_list_remove(h->m_curr_page[slot_idx], this);
             page_list_insert(h->m_page_free_list[slot_idx], this);
+            h->m_num_free_pages++;
+            if (LEAN_UNLIKELY(g_page_trim_watermark != 0 &&
+                              h->m_num_free_pages - h->m_num_trimmed_pages > g_page_trim_watermark))
+                h->trim_free_pages();
         }
     }
 }
@@ -215,6 +448,9 @@ void segment::move_to_heap(heap * h) {
         unsigned slot_idx = p.get_slot_idx();
         if (p.in_page_free_list()) {
             page_list_insert(h->m_page_free_list[slot_idx], &p);
+            h->m_num_free_pages++;
+            if (p.m_header.m_trimmed)
+                h->m_num_trimmed_pages++;
         } else {
             page_list_insert(h->m_curr_page[slot_idx], &p);
         }
@@ -222,20 +458,27 @@ void segment::move_to_heap(heap * h) {
 }
 
 void heap::import_objs() {
-    void * to_import = nullptr;
-    {   // TODO(Leo): avoid mutex using compare and swap
-        lock_guard<mutex> lock(m_mutex);
-        to_import = m_to_import_list;
-        m_to_import_list = nullptr;
-    }
-    while (to_import) {
-        page * p = get_page_of(to_import);
-        void * n = get_next_obj(to_import);
-        p->push_free_obj(to_import);
-        to_import = n;
+    for (unsigned i = 0; i < LEAN_NUM_IMPORT_SHARDS; i++) {
+        void * to_import = m_to_import[i].exchange(nullptr, memory_order_acquire);
+        while (to_import) {
+            page * p = get_page_of(to_import);
+            void * n = get_next_obj(to_import);
+            p->push_free_obj(to_import);
+            to_import = n;
+        }
     }
 }
 
+void heap::push_import_batch(void * head, void * tail, heap const * producer) {
+    /* Distribute producers over the shards so concurrent foreign frees do not
+       all hammer the same atomic. The low pointer bits are alignment noise. */
+    atomic<void *> & shard = m_to_import[(reinterpret_cast<size_t>(producer) >> 6) % LEAN_NUM_IMPORT_SHARDS];
+    void * curr = shard.load(memory_order_relaxed);
+    do {
+        set_next_obj(tail, curr);
+    } while (!shard.compare_exchange_weak(curr, head, memory_order_release, memory_order_relaxed));
+}
+
 struct export_entry {
     heap * m_heap;
     void * m_head;
@@ -280,15 +523,73 @@ void heap::export_objs() {
     m_to_export_list      = nullptr;
     m_to_export_list_size = 0;
     for (export_entry const & e : to_export) {
-        unique_lock<mutex> lock(e.m_heap->m_mutex);
-        set_next_obj(e.m_tail, e.m_heap->m_to_import_list);
-        e.m_heap->m_to_import_list = e.m_head;
+        e.m_heap->push_import_batch(e.m_head, e.m_tail, this);
     }
 }
 
+static bool g_huge_page_segments = false;
+
+#if defined(__linux__)
+#define LEAN_HUGE_PAGE_SIZE (2*1024*1024)
+/* mmap a segment-sized region aligned to 2 MB so transparent huge pages can
+   back it fully; trim the excess head/tail of the over-sized mapping. */
+static void * mmap_segment_aligned() {
+    size_t sz   = lean_align(sizeof(segment), LEAN_HUGE_PAGE_SIZE);
+    size_t ex   = sz + LEAN_HUGE_PAGE_SIZE;
+    char * mem  = static_cast<char*>(mmap(nullptr, ex, PROT_READ | PROT_WRITE,
+                                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (mem == MAP_FAILED) return nullptr;
+    char * base = align_ptr(mem, LEAN_HUGE_PAGE_SIZE);
+    if (base != mem)
+        munmap(mem, base - mem);
+    if (size_t tail = ex - (base - mem) - sz)
+        munmap(base + sz, tail);
+    return base;
+}
+#endif
+
+/* Allocate the memory for a new segment. When huge-page mode is enabled, the
+   segment is backed by a 2 MB-aligned mapping marked MADV_HUGEPAGE; when the
+   `local` NUMA policy is active, the memory is additionally bound to the node
+   of the calling thread. Both modes fall back gracefully to a plain
+   allocation on failure or on unsupported platforms. */
+static segment * alloc_segment_mem() {
+#if defined(__linux__)
+    if (g_huge_page_segments || g_numa_policy == numa_policy::local) {
+        void * mem = nullptr;
+        if (g_huge_page_segments) {
+            mem = mmap_segment_aligned();
+#ifdef MADV_HUGEPAGE
+            if (mem)
+                madvise(mem, lean_align(sizeof(segment), LEAN_HUGE_PAGE_SIZE), MADV_HUGEPAGE);
+#endif
+        } else {
+            void * r = mmap(nullptr, sizeof(segment), PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            mem = r == MAP_FAILED ? nullptr : r;
+        }
+        if (mem) {
+#ifdef LEAN_NUMA
+            if (g_numa_policy == numa_policy::local) {
+                int node = get_current_numa_node();
+                if (node >= 0) {
+                    unsigned long nodemask = 1ul << node;
+                    /* MPOL_PREFERRED (2): fall back to other nodes when the preferred one is full. */
+                    syscall(SYS_mbind, mem, sizeof(segment), 2, &nodemask, sizeof(nodemask)*8, 0);
+                }
+            }
+#endif
+            return new (mem) segment();
+        }
+    }
+#endif
+    return new segment();
+}
+
 void heap::alloc_segment() {
+    int node = g_numa_policy == numa_policy::local ? get_current_numa_node() : -1;
     while (true) {
-        if (heap * h = g_heap_manager->pop_orphan()) {
+        if (heap * h = g_heap_manager->pop_orphan(node)) {
             lean_assert(h->m_curr_segment);
             /* import pending objects, before moving `h`'s segment to *this* heap. */
             h->import_objs();
@@ -310,29 +611,19 @@ void heap::alloc_segment() {
                contains at least one free page. */
         } else {
             LEAN_RUNTIME_STAT_CODE(g_num_segments++);
-            segment * s = new segment();
+            segment * s = alloc_segment_mem();
+            register_segment(s);
             s->m_next   = m_curr_segment;
             m_curr_segment = s;
             break;
         }
     }
+    m_numa_node = node;
 }
 
-static page * alloc_page(heap * h, unsigned obj_size) {
-    lean_assert(lean_align(obj_size, LEAN_OBJECT_SIZE_DELTA) == obj_size);
-    segment * s = h->m_curr_segment;
-    LEAN_RUNTIME_STAT_CODE(g_num_pages++);
-    page * p    = new (s->m_next_page_mem) page();
-    s->m_next_page_mem += LEAN_PAGE_SIZE;
-    if (s->is_full()) {
-        /* s is full, we need to allocate a new one. */
-        h->alloc_segment();
-    }
-    unsigned slot_idx        = lean_get_slot_idx(obj_size);
-    p->m_header.m_heap       = h;
-    page_list_insert(h->m_curr_page[slot_idx], p);
-    p->m_header.m_slot_idx   = slot_idx;
-    p->m_header.m_obj_size   = obj_size;
+/* Thread a fresh object free list through the page's data area, and return
+   the number of free objects. */
+static unsigned build_page_free_list(page * p, unsigned obj_size) {
     char * curr_free         = p->m_data;
     set_next_obj(curr_free, nullptr);
     char * end               = p->m_data + (LEAN_PAGE_SIZE - sizeof(page_header));
@@ -348,18 +639,66 @@ static page * alloc_page(heap * h, unsigned obj_size) {
         num_free++;
     }
 #ifdef LEAN_DEBUG
-            void * it  = curr_free;
-            unsigned n = 0;
-            while (it != nullptr) {
-                it = get_next_obj(it);
-                n++;
-            }
-            lean_assert(n == num_free);
+    void * it  = curr_free;
+    unsigned n = 0;
+    while (it != nullptr) {
+        it = get_next_obj(it);
+        n++;
+    }
+    lean_assert(n == num_free);
 #endif
     p->m_header.m_free_list  = curr_free;
+    return num_free;
+}
+
+/* Return the data area of fully-free pages on the page free lists to the OS.
+   The object free list lives inside the objects themselves, so a trimmed page
+   is flagged and its free list rebuilt when the page is reused. Only the
+   OS-page-aligned interior past the header can be decommitted. */
+void heap::trim_free_pages() {
+#if defined(__linux__) || defined(__APPLE__)
+    long os_page = sysconf(_SC_PAGESIZE);
+    if (os_page <= 0 || static_cast<size_t>(os_page) >= LEAN_PAGE_SIZE)
+        return;
+    for (unsigned i = 0; i < LEAN_NUM_SLOTS; i++) {
+        for (page * p = m_page_free_list[i]; p != nullptr; p = p->get_next()) {
+            page_header & h = p->m_header;
+            if (h.m_trimmed || h.m_num_free != h.m_max_free)
+                continue;
+            char * start = align_ptr(reinterpret_cast<char*>(p) + sizeof(page_header), os_page);
+            char * end   = reinterpret_cast<char*>(p) + LEAN_PAGE_SIZE;
+            if (start < end && madvise(start, end - start, MADV_DONTNEED) == 0) {
+                h.m_trimmed   = true;
+                h.m_free_list = nullptr;
+                m_num_trimmed_pages++;
+            }
+        }
+    }
+#endif
+}
+
+static page * alloc_page(heap * h, unsigned obj_size) {
+    lean_assert(lean_align(obj_size, LEAN_OBJECT_SIZE_DELTA) == obj_size);
+    if (LEAN_UNLIKELY(g_census_requested))
+        maybe_dump_heap_census();
+    segment * s = h->m_curr_segment;
+    LEAN_RUNTIME_STAT_CODE(g_num_pages++);
+    page * p    = new (s->m_next_page_mem) page();
+    s->m_next_page_mem += LEAN_PAGE_SIZE;
+    if (s->is_full()) {
+        /* s is full, we need to allocate a new one. */
+        h->alloc_segment();
+    }
+    unsigned slot_idx        = lean_get_slot_idx(obj_size);
+    p->m_header.m_heap       = h;
+    page_list_insert(h->m_curr_page[slot_idx], p);
+    p->m_header.m_slot_idx   = slot_idx;
+    p->m_header.m_obj_size   = obj_size;
+    unsigned num_free        = build_page_free_list(p, obj_size);
     p->m_header.m_max_free   = num_free;
     p->m_header.m_num_free   = num_free;
     p->m_header.m_in_page_free_list = false;
+    p->m_header.m_trimmed    = false;
     return p;
 }
 
@@ -382,7 +721,8 @@ static void init_heap(bool main) {
     unsigned obj_size = LEAN_OBJECT_SIZE_DELTA;
     for (unsigned i = 0; i < LEAN_NUM_SLOTS; i++) {
         if (g_heap->m_curr_page[i] == nullptr) {
-            alloc_page(g_heap, obj_size);
+            for (unsigned j = 0; j < g_slot_prealloc[i]; j++)
+                alloc_page(g_heap, obj_size);
         }
         obj_size += LEAN_OBJECT_SIZE_DELTA;
     }
@@ -396,9 +736,47 @@ void init_thread_heap() {
     init_heap(false);
 }
 
+/* ---- Fast thread attach/detach ----
+
+   Foreign threads that enter the runtime only briefly should not pay for a
+   fresh heap (segment mmap plus one page per size class) on every visit.
+   `lean_attach_thread` borrows an intact heap handed back by a previous
+   `lean_detach_thread` when one is cached; only a cache miss builds a heap.
+   On detach, a heap still in its first segment goes back to the cache, while
+   one that grew past it (the thread's allocation volume justified a private
+   heap) is pushed to the orphan list and dismantled like any retired worker
+   heap, so the cache never hoards a large working set. */
+
+extern "C" void lean_attach_thread() {
+    if (g_heap != nullptr)
+        return; /* runtime-managed thread, or already attached */
+    if (heap * h = g_heap_manager->pop_cached()) {
+        g_heap       = h;
+        g_curr_pages = h->m_curr_page;
+        h->import_objs();
+        return;
+    }
+    /* No thread finalizer: the heap is handed over in `lean_detach_thread`. */
+    init_heap(true);
+}
+
+extern "C" void lean_detach_thread() {
+    heap * h = g_heap;
+    if (h == nullptr)
+        return;
+    g_heap       = nullptr;
+    g_curr_pages = nullptr;
+    h->export_objs();
+    h->import_objs();
+    if (h->m_curr_segment->m_next != nullptr || !g_heap_manager->try_push_cached(h))
+        g_heap_manager->push_orphan(h);
+}
+
 extern "C" void * lean_alloc_small(unsigned sz, unsigned slot_idx) {
+    if (LEAN_UNLIKELY(g_alloc_sampling)) allocprof_sample(sz);
     page * p = g_heap->m_curr_page[slot_idx];
     g_heap->m_heartbeat++;
+    g_heap->m_alloc_bytes += sz;
     void * r = p->m_header.m_free_list;
     if (LEAN_UNLIKELY(r == nullptr)) {
         if (g_heap->m_page_free_list[slot_idx] == nullptr) {
@@ -410,6 +788,16 @@ extern "C" void * lean_alloc_small(unsigned sz, unsigned slot_idx) {
         } else {
             p = page_list_pop(g_heap->m_page_free_list[slot_idx]);
             p->m_header.m_in_page_free_list = false;
+            if (g_heap->m_num_free_pages > 0)
+                g_heap->m_num_free_pages--;
+            if (LEAN_UNLIKELY(p->m_header.m_trimmed)) {
+                /* The data area was decommitted while the page was idle. */
+                build_page_free_list(p, p->m_header.m_obj_size);
+                p->m_header.m_num_free = p->m_header.m_max_free;
+                p->m_header.m_trimmed  = false;
+                if (g_heap->m_num_trimmed_pages > 0)
+                    g_heap->m_num_trimmed_pages--;
+            }
             page_list_insert(g_heap->m_curr_page[slot_idx], p);
         }
         r = p->m_header.m_free_list;
@@ -434,15 +822,93 @@ uint64_t get_num_heartbeats() {
         return 0;
 }
 
+uint64_t get_alloc_bytes() {
+    if (g_heap)
+        return g_heap->m_alloc_bytes;
+    else
+        return 0;
+}
+
+static void finalize_large_cache(void * _c) {
+    large_cache * c = static_cast<large_cache*>(_c);
+    for (unsigned i = 0; i < LEAN_LARGE_NUM_BUCKETS; i++) {
+        void * o = c->m_buckets[i];
+        while (o) {
+            void * n = get_next_obj(o);
+            free(o);
+            o = n;
+        }
+    }
+    delete c;
+    g_large_cache = nullptr;
+}
+
+static void * alloc_large(size_t sz) {
+    if (sz > (static_cast<size_t>(1) << LEAN_LARGE_MAX_SHIFT)) {
+        void * r = malloc(sz);
+        if (r == nullptr) lean_internal_panic_out_of_memory();
+        return r;
+    }
+    unsigned shift = large_bucket_shift(sz);
+    large_cache * c = g_large_cache;
+    if (c != nullptr) {
+        void * r = c->m_buckets[shift - LEAN_LARGE_MIN_SHIFT];
+        if (r != nullptr) {
+            c->m_buckets[shift - LEAN_LARGE_MIN_SHIFT] = get_next_obj(r);
+            c->m_cached_bytes -= static_cast<size_t>(1) << shift;
+            return r;
+        }
+    }
+    void * r = malloc(static_cast<size_t>(1) << shift);
+    if (r == nullptr) lean_internal_panic_out_of_memory();
+    return r;
+}
+
+static void dealloc_large(void * o, size_t sz) {
+    if (sz > (static_cast<size_t>(1) << LEAN_LARGE_MAX_SHIFT)) {
+        free(o);
+        return;
+    }
+    unsigned shift = large_bucket_shift(sz);
+    large_cache * c = g_large_cache;
+    if (c == nullptr) {
+        c = new large_cache();
+        g_large_cache = c;
+        register_thread_finalizer(finalize_large_cache, c);
+    }
+    if (c->m_cached_bytes + (static_cast<size_t>(1) << shift) > LEAN_LARGE_CACHE_CAPACITY) {
+        free(o);
+        return;
+    }
+    set_next_obj(o, c->m_buckets[shift - LEAN_LARGE_MIN_SHIFT]);
+    c->m_buckets[shift - LEAN_LARGE_MIN_SHIFT] = o;
+    c->m_cached_bytes += static_cast<size_t>(1) << shift;
+}
+
+/* Return the number of bytes actually usable in the block backing `o`, which
+   was allocated via `alloc(sz)`. Small objects can use their whole slot and
+   cached large objects their whole power-of-two bucket, enabling in-place
+   growth of arrays and strings up to the real block size. */
+size_t alloc_usable_size(void * o, size_t sz) {
+    sz = lean_align(sz, LEAN_OBJECT_SIZE_DELTA);
+    if (sz <= LEAN_MAX_SMALL_OBJECT_SIZE)
+        return lean_small_mem_size(o);
+    if (sz > (static_cast<size_t>(1) << LEAN_LARGE_MAX_SHIFT))
+        return sz;
+    return static_cast<size_t>(1) << large_bucket_shift(sz);
+}
+
 void * alloc(size_t sz) {
     sz = lean_align(sz, LEAN_OBJECT_SIZE_DELTA);
     LEAN_RUNTIME_STAT_CODE(g_num_alloc++);
     if (LEAN_UNLIKELY(sz > LEAN_MAX_SMALL_OBJECT_SIZE)) {
-        void * r = malloc(sz);
-        if (r == nullptr) lean_internal_panic_out_of_memory();
-        return r;
+        if (LEAN_UNLIKELY(g_alloc_sampling)) allocprof_sample(sz);
+        return alloc_large(sz);
+    }
+    if (LEAN_UNLIKELY(g_heap == nullptr)) {
+        /* e.g., a GMP limb allocation on a foreign thread */
+        init_heap(false);
     }
-    lean_assert(g_heap);
     LEAN_RUNTIME_STAT_CODE(g_num_small_alloc++);
     unsigned slot_idx = lean_get_slot_idx(sz);
     return lean_alloc_small(sz, slot_idx);
@@ -472,7 +938,7 @@ void dealloc(void * o, size_t sz) {
     LEAN_RUNTIME_STAT_CODE(g_num_dealloc++);
     sz = lean_align(sz, LEAN_OBJECT_SIZE_DELTA);
     if (LEAN_UNLIKELY(sz > LEAN_MAX_SMALL_OBJECT_SIZE)) {
-        return free(o);
+        return dealloc_large(o, sz);
     }
     dealloc_small_core(o);
 }
@@ -481,12 +947,230 @@ extern "C" void lean_free_small(void * o) {
     dealloc_small_core(o);
 }
 
+static void mem_stats_count_page_list(lean_mem_stats * s, page * p, bool free_list) {
+    for (; p != nullptr; p = p->get_next()) {
+        unsigned slot_idx = p->get_slot_idx();
+        s->pages++;
+        if (free_list)
+            s->free_pages++;
+        s->class_pages[slot_idx]++;
+        s->class_free_slots[slot_idx] += p->m_header.m_num_free;
+        s->free_bytes += static_cast<size_t>(p->m_header.m_num_free) * p->m_header.m_obj_size;
+    }
+}
+
+extern "C" void lean_get_mem_stats(lean_mem_stats * s) {
+    memset(s, 0, sizeof(*s));
+    heap * h = g_heap;
+    if (h == nullptr)
+        return;
+    for (segment * seg = h->m_curr_segment; seg != nullptr; seg = seg->m_next) {
+        s->segments++;
+        s->reserved_bytes += sizeof(segment);
+    }
+    for (unsigned i = 0; i < LEAN_NUM_SLOTS; i++) {
+        mem_stats_count_page_list(s, h->m_curr_page[i], false);
+        mem_stats_count_page_list(s, h->m_page_free_list[i], true);
+    }
+}
+
+static unsigned census_kind_of(uint8_t tag) {
+    if (tag <= LeanMaxCtorTag) return LEAN_CENSUS_CTOR;
+    switch (tag) {
+    case LeanClosure:     return LEAN_CENSUS_CLOSURE;
+    case LeanArray:
+    case LeanStructArray: return LEAN_CENSUS_ARRAY;
+    case LeanScalarArray: return LEAN_CENSUS_SARRAY;
+    case LeanString:      return LEAN_CENSUS_STRING;
+    case LeanMPZ:         return LEAN_CENSUS_MPZ;
+    case LeanThunk:       return LEAN_CENSUS_THUNK;
+    case LeanTask:        return LEAN_CENSUS_TASK;
+    case LeanRef:         return LEAN_CENSUS_REF;
+    default:              return LEAN_CENSUS_OTHER;
+    }
+}
+
+static void census_page(lean_heap_census * c, page * p) {
+    page_header & h = p->m_header;
+    if (h.m_trimmed || h.m_num_free == h.m_max_free)
+        return; /* fully free */
+    unsigned obj_size = h.m_obj_size;
+    char * data       = p->m_data;
+    char * end        = data + static_cast<size_t>(h.m_max_free) * obj_size;
+    /* Mark the slots sitting on the page's object free list; every other slot
+       holds a live object. The entries are validated (and the walk bounded)
+       because the owning thread may be mutating the list concurrently. */
+    bool free_slot[LEAN_PAGE_SIZE / LEAN_OBJECT_SIZE_DELTA] = {};
+    unsigned marked = 0;
+    for (void * o = h.m_free_list; o != nullptr && marked < h.m_max_free; o = get_next_obj(o)) {
+        char * q = static_cast<char*>(o);
+        if (q < data || q >= end || (q - data) % obj_size != 0)
+            break;
+        free_slot[(q - data) / obj_size] = true;
+        marked++;
+    }
+    for (unsigned i = 0; i < h.m_max_free; i++) {
+        if (free_slot[i])
+            continue;
+        lean_object * o = reinterpret_cast<lean_object*>(data + static_cast<size_t>(i) * obj_size);
+        unsigned k = census_kind_of(lean_ptr_tag(o));
+        c->num_objects[k]++;
+        c->num_bytes[k] += obj_size;
+    }
+}
+
+extern "C" void lean_get_heap_census(lean_heap_census * c) {
+    memset(c, 0, sizeof(*c));
+    for (segment * s = g_all_segments.load(memory_order_acquire); s != nullptr; s = s->m_next_global) {
+        page * it  = reinterpret_cast<page*>(s->get_first_page_mem());
+        page * end = reinterpret_cast<page*>(s->m_next_page_mem);
+        for (; it != end; ++it)
+            census_page(c, it);
+    }
+}
+
+static char const * const g_census_kind_names[LEAN_CENSUS_NUM_KINDS] = {
+    "ctor", "closure", "array", "sarray", "string", "mpz", "thunk", "task", "ref", "other"
+};
+
+static void dump_heap_census() {
+    lean_heap_census c;
+    lean_get_heap_census(&c);
+    FILE * f = fopen("leancensus.out", "w");
+    if (!f) return;
+    for (unsigned k = 0; k < LEAN_CENSUS_NUM_KINDS; k++)
+        fprintf(f, "%s %zu %zu\n", g_census_kind_names[k], c.num_objects[k], c.num_bytes[k]);
+    fclose(f);
+}
+
+#ifdef SIGUSR1
+static void request_census_handler(int) {
+    /* Walking the heaps from a signal handler is unsafe; defer the dump to
+       the allocator's next page allocation. */
+    g_census_requested = 1;
+}
+#endif
+
+void allocator::maybe_dump_heap_census() {
+    g_census_requested = 0;
+    dump_heap_census();
+}
+
+size_t get_segment_bytes() {
+    return g_segment_bytes.load(memory_order_relaxed);
+}
+
+void display_heap_census(std::ostream & out) {
+    lean_heap_census c;
+    lean_get_heap_census(&c);
+    out << "heap: " << g_segment_bytes.load(memory_order_relaxed) / (1024 * 1024) << " MB in segments\n";
+    for (unsigned k = 0; k < LEAN_CENSUS_NUM_KINDS; k++) {
+        if (c.num_objects[k] == 0)
+            continue;
+        out << "  " << g_census_kind_names[k] << ": " << c.num_objects[k]
+            << " objects, " << c.num_bytes[k] / 1024 << " KB\n";
+    }
+}
+
 extern "C" unsigned lean_small_mem_size(void * o) {
     page * p = get_page_of(o);
     return p->m_header.m_obj_size;
 }
 
+void set_numa_policy(numa_policy p) {
+#ifdef LEAN_NUMA
+    if (p == numa_policy::local)
+        g_num_numa_nodes = detect_num_numa_nodes();
+    g_numa_policy = p;
+#else
+    (void) p; /* NUMA binding is not supported on this platform. */
+#endif
+}
+
+numa_policy get_numa_policy() {
+    return g_numa_policy;
+}
+
+unsigned get_num_numa_nodes() {
+    return g_num_numa_nodes;
+}
+
+void bind_worker_to_numa_node(unsigned worker_idx) {
+#ifdef LEAN_NUMA
+    if (g_numa_policy != numa_policy::local || g_num_numa_nodes <= 1)
+        return;
+    cpu_set_t cpus;
+    if (read_node_cpuset(worker_idx % g_num_numa_nodes, cpus))
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+    /* Record the (possibly new) node so orphan adoption prefers local segments. */
+    if (g_heap)
+        g_heap->m_numa_node = get_current_numa_node();
+#else
+    (void) worker_idx;
+#endif
+}
+
+void set_page_trim_watermark(unsigned num_pages) {
+    g_page_trim_watermark = num_pages;
+}
+
+void set_huge_page_segments(bool flag) {
+#if defined(__linux__)
+    g_huge_page_segments = flag;
+#else
+    (void) flag; /* huge-page backing is not supported on this platform. */
+#endif
+}
+
+#define LEAN_REGION_CHUNK_SIZE (64*1024)
+
+void region::alloc_chunk(size_t min_sz) {
+    size_t data_sz = min_sz > LEAN_REGION_CHUNK_SIZE ? min_sz : LEAN_REGION_CHUNK_SIZE;
+    chunk * c  = static_cast<chunk*>(malloc(sizeof(chunk) + data_sz));
+    if (c == nullptr) lean_internal_panic_out_of_memory();
+    c->m_next  = m_chunks;
+    c->m_size  = data_sz;
+    m_chunks   = c;
+    m_next     = reinterpret_cast<char*>(c) + sizeof(chunk);
+    m_end      = m_next + data_sz;
+}
+
+void * region::alloc(size_t sz) {
+    sz = lean_align(sz, LEAN_OBJECT_SIZE_DELTA);
+    if (LEAN_UNLIKELY(m_next + sz > m_end))
+        alloc_chunk(sz);
+    void * r = m_next;
+    m_next += sz;
+    return r;
+}
+
+void region::clear() {
+    chunk * c = m_chunks;
+    while (c) {
+        chunk * n = c->m_next;
+        free(c);
+        c = n;
+    }
+    m_chunks = nullptr;
+    m_next   = nullptr;
+    m_end    = nullptr;
+}
+
 void initialize_alloc() {
+    /* Must be decided before the first segment is carved out below. */
+    if (getenv("LEAN_HUGE_PAGES"))
+        set_huge_page_segments(true);
+    if (char const * v = getenv("LEAN_PAGE_TRIM"))
+        set_page_trim_watermark(atoi(v));
+    init_slot_prealloc();
+    if (char const * v = getenv("LEAN_ALLOC_PROFILE"))
+        load_alloc_profile(v);
+#ifdef SIGUSR1
+    /* Claim SIGUSR1 only on request: the runtime is also linked into user
+       programs, which may use the signal themselves. */
+    if (getenv("LEAN_HEAP_CENSUS"))
+        signal(SIGUSR1, request_census_handler);
+#endif
     g_heap_manager = new heap_manager();
     init_heap(true);
 }
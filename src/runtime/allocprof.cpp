@@ -4,7 +4,16 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <unordered_map>
+#include <vector>
+#include <fstream>
+#include <csignal>
 #include <lean/allocprof.h>
+#include <lean/thread.h>
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#define LEAN_ALLOCPROF_BACKTRACE
+#endif
 namespace lean {
 allocprof::allocprof(std::ostream & out, char const * msg):
     m_out(out), m_msg(msg) {
@@ -44,4 +53,108 @@ allocprof::~allocprof() {
     m_out << "Allocation profiling data is not available, compile lean using `-D RUNTIME_STATS=ON`\n";
 #endif
 }
+
+#define LEAN_ALLOCPROF_MAX_DEPTH 16
+
+bool g_alloc_sampling = false;
+static unsigned g_sampling_period = 1024;
+static volatile sig_atomic_t g_dump_requested = 0;
+LEAN_THREAD_LOCAL static unsigned g_sample_countdown = 0;
+
+struct sample_site {
+    uint64_t m_count{0};
+    uint64_t m_bytes{0};
+};
+
+struct sample_key {
+    std::vector<void *> m_frames;
+    bool operator==(sample_key const & o) const { return m_frames == o.m_frames; }
+};
+
+struct sample_key_hash {
+    size_t operator()(sample_key const & k) const {
+        size_t h = 17;
+        for (void * f : k.m_frames)
+            h = h * 31 + reinterpret_cast<size_t>(f);
+        return h;
+    }
+};
+
+/* Aggregated samples from all threads. The table is only touched once per
+   `period` allocations, so a plain mutex is fine. */
+static mutex * g_samples_mutex = nullptr;
+static std::unordered_map<sample_key, sample_site, sample_key_hash> * g_samples = nullptr;
+
+static void request_dump_handler(int) {
+    /* Dumping from a signal handler is unsafe; defer to the next sample. */
+    g_dump_requested = 1;
+}
+
+void enable_alloc_sampling(unsigned period) {
+    if (!g_samples_mutex) {
+        g_samples_mutex = new mutex();
+        g_samples = new std::unordered_map<sample_key, sample_site, sample_key_hash>();
+#ifdef SIGUSR2
+        signal(SIGUSR2, request_dump_handler);
+#endif
+    }
+    g_sampling_period = period == 0 ? 1 : period;
+    g_alloc_sampling  = true;
+}
+
+void disable_alloc_sampling() {
+    g_alloc_sampling = false;
+}
+
+void dump_alloc_samples(std::ostream & out) {
+    if (!g_samples) return;
+    lock_guard<mutex> lock(*g_samples_mutex);
+    for (auto const & e : *g_samples) {
+        auto const & frames = e.first.m_frames;
+#ifdef LEAN_ALLOCPROF_BACKTRACE
+        char ** syms = backtrace_symbols(frames.data(), frames.size());
+#else
+        char ** syms = nullptr;
+#endif
+        /* leaf-last order, as expected by flamegraph collapsed-stack input */
+        for (unsigned i = frames.size(); i > 0; i--) {
+            if (syms)
+                out << syms[i-1];
+            else
+                out << frames[i-1];
+            out << (i == 1 ? ' ' : ';');
+        }
+        out << e.second.m_count << " (" << e.second.m_bytes << " bytes, x" << g_sampling_period << ")\n";
+        if (syms) free(syms);
+    }
+}
+
+void allocprof_sample(size_t sz) {
+    if (g_sample_countdown > 0) {
+        g_sample_countdown--;
+        return;
+    }
+    g_sample_countdown = g_sampling_period;
+    sample_key k;
+#ifdef LEAN_ALLOCPROF_BACKTRACE
+    void * frames[LEAN_ALLOCPROF_MAX_DEPTH];
+    int depth = backtrace(frames, LEAN_ALLOCPROF_MAX_DEPTH);
+    /* skip this function and the allocator entry point */
+    for (int i = 2; i < depth; i++)
+        k.m_frames.push_back(frames[i]);
+#else
+    k.m_frames.push_back(__builtin_return_address(0));
+#endif
+    {
+        lock_guard<mutex> lock(*g_samples_mutex);
+        sample_site & s = (*g_samples)[std::move(k)];
+        s.m_count++;
+        s.m_bytes += sz;
+    }
+    if (g_dump_requested) {
+        g_dump_requested = 0;
+        std::ofstream out("allocprof.out");
+        dump_alloc_samples(out);
+    }
+}
 }
@@ -4,8 +4,9 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
-// DO NOT EDIT, this is an automatically generated file
-// Generated using script: ../../gen/apply.lean
+// Originally generated using script: ../../gen/apply.lean
+// Now maintained by hand: the dispatch tables and the fused
+// over-application loop below are not expressible in the generator.
 #include <lean/apply.h>
 namespace lean {
 #define obj lean_object
@@ -74,80 +75,132 @@ typedef obj* (*fn16)(obj*, obj*, obj*, obj*, obj*, obj*, obj*, obj*, obj*, obj*,
 #define FN16(f) reinterpret_cast<fn16>(lean_closure_fun(f))
 typedef obj* (*fnn)(obj**); // NOLINT
 #define FNN(f) reinterpret_cast<fnn>(lean_closure_fun(f))
+/* Dispatch tables mapping a (small) argument count to a call through the
+   corresponding function-pointer type. An indexed load plus an indirect call
+   replaces the compare chains the nested switches used to compile to. */
+typedef obj* (*curry_fn)(void*, obj**); // NOLINT
+static obj* curry_1(void* f, obj** as) { return reinterpret_cast<fn1>(f)(as[0]); }
+static obj* curry_2(void* f, obj** as) { return reinterpret_cast<fn2>(f)(as[0], as[1]); }
+static obj* curry_3(void* f, obj** as) { return reinterpret_cast<fn3>(f)(as[0], as[1], as[2]); }
+static obj* curry_4(void* f, obj** as) { return reinterpret_cast<fn4>(f)(as[0], as[1], as[2], as[3]); }
+static obj* curry_5(void* f, obj** as) { return reinterpret_cast<fn5>(f)(as[0], as[1], as[2], as[3], as[4]); }
+static obj* curry_6(void* f, obj** as) { return reinterpret_cast<fn6>(f)(as[0], as[1], as[2], as[3], as[4], as[5]); }
+static obj* curry_7(void* f, obj** as) { return reinterpret_cast<fn7>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6]); }
+static obj* curry_8(void* f, obj** as) { return reinterpret_cast<fn8>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7]); }
+static obj* curry_9(void* f, obj** as) { return reinterpret_cast<fn9>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8]); }
+static obj* curry_10(void* f, obj** as) { return reinterpret_cast<fn10>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9]); }
+static obj* curry_11(void* f, obj** as) { return reinterpret_cast<fn11>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10]); }
+static obj* curry_12(void* f, obj** as) { return reinterpret_cast<fn12>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11]); }
+static obj* curry_13(void* f, obj** as) { return reinterpret_cast<fn13>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12]); }
+static obj* curry_14(void* f, obj** as) { return reinterpret_cast<fn14>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13]); }
+static obj* curry_15(void* f, obj** as) { return reinterpret_cast<fn15>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13], as[14]); }
+static obj* curry_16(void* f, obj** as) { return reinterpret_cast<fn16>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13], as[14], as[15]); }
+static obj* curry_n(void* f, obj** as) { return reinterpret_cast<fnn>(f)(as); }
+static curry_fn const g_curry_fns[17] = {
+    nullptr, curry_1, curry_2, curry_3, curry_4, curry_5, curry_6, curry_7, curry_8,
+    curry_9, curry_10, curry_11, curry_12, curry_13, curry_14, curry_15, curry_16
+};
 obj* curry(void* f, unsigned n, obj** as) {
-switch (n) {
-case 0: lean_unreachable();
-case 1: return reinterpret_cast<fn1>(f)(as[0]);
-case 2: return reinterpret_cast<fn2>(f)(as[0], as[1]);
-case 3: return reinterpret_cast<fn3>(f)(as[0], as[1], as[2]);
-case 4: return reinterpret_cast<fn4>(f)(as[0], as[1], as[2], as[3]);
-case 5: return reinterpret_cast<fn5>(f)(as[0], as[1], as[2], as[3], as[4]);
-case 6: return reinterpret_cast<fn6>(f)(as[0], as[1], as[2], as[3], as[4], as[5]);
-case 7: return reinterpret_cast<fn7>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6]);
-case 8: return reinterpret_cast<fn8>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7]);
-case 9: return reinterpret_cast<fn9>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8]);
-case 10: return reinterpret_cast<fn10>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9]);
-case 11: return reinterpret_cast<fn11>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10]);
-case 12: return reinterpret_cast<fn12>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11]);
-case 13: return reinterpret_cast<fn13>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12]);
-case 14: return reinterpret_cast<fn14>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13]);
-case 15: return reinterpret_cast<fn15>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13], as[14]);
-case 16: return reinterpret_cast<fn16>(f)(as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13], as[14], as[15]);
-default: return reinterpret_cast<fnn>(f)(as);
-}
+    lean_assert(n > 0);
+    return n <= 16 ? g_curry_fns[n](f, as) : curry_n(f, as);
 }
 static obj* curry(obj* f, unsigned n, obj** as) { return curry(lean_closure_fun(f), n, as); }
 extern "C" obj* lean_apply_n(obj*, unsigned, obj**);
+extern "C" obj* lean_apply_m(obj*, unsigned, obj**);
+static obj* fix_args(obj* f, unsigned n, obj*const* as);
+/* Over-application: `f` takes fewer than `n` further arguments. Call the
+   function pointer with exactly `arity` arguments and immediately re-apply the
+   result, looping while it is still over-applied, so no intermediate closure
+   objects are materialized and the per-arity entry points are only re-entered
+   once the application has become exact. */
+static obj* apply_over(obj* f, unsigned n, obj** as) {
+    obj * buf[16];
+    while (true) {
+        unsigned arity = lean_closure_arity(f);
+        unsigned fixed = lean_closure_num_fixed(f);
+        lean_assert(arity < fixed + n);
+        obj ** args = arity <= 16 ? buf : static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
+        for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
+        for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
+        obj * r = curry(f, arity, args);
+        n  -= arity - fixed;
+        as += arity - fixed;
+        lean_dec_ref(f);
+        lean_assert(lean_is_closure(r));
+        f = r;
+        arity = lean_closure_arity(f);
+        fixed = lean_closure_num_fixed(f);
+        if (arity > fixed + n) return fix_args(f, n, as);
+        if (arity == fixed + n) return lean_apply_n(f, n, as);
+    }
+}
+/* Exact application with arity > 16: marshal the fixed and new arguments into a
+   stack-allocated array for the `fnn` calling convention. Kept out of line so the
+   per-arity entry points remain `alloca`-free; the compiler never inlines a
+   function that calls `alloca` back into its caller. */
+static obj* apply_exact_big(obj* f, unsigned n, obj*const* as) {
+    unsigned arity = lean_closure_arity(f);
+    unsigned fixed = lean_closure_num_fixed(f);
+    lean_assert(arity > 16 && arity == fixed + n);
+    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
+    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
+    for (unsigned i = 0; i < n; i++) args[fixed+i] = as[i];
+    obj * r = FNN(f)(args);
+    lean_dec_ref(f);
+    return r;
+}
+/* The exact-application cases below release the closure *before* entering the
+   target function, so every call sits in tail position and sibling-call
+   optimization collapses it into a jump. Mutually recursive compiled functions
+   that tail-call each other through closures therefore run in constant C stack
+   instead of growing a frame per `lean_apply_n` round trip. Paths that build an
+   argument array on the caller's stack (over-application, arity > 16) cannot be
+   tail calls; they allocate or loop instead. */
 extern "C" obj* lean_apply_1(obj* f, obj* a1) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 1) {
+if (LEAN_LIKELY(arity == fixed + 1)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 1: { obj* r = FN1(f)(a1); lean_free_small_object(f); return r; }
-    case 2: { obj* r = FN2(f)(fx(0), a1); lean_free_small_object(f); return r; }
-    case 3: { obj* r = FN3(f)(fx(0), fx(1), a1); lean_free_small_object(f); return r; }
-    case 4: { obj* r = FN4(f)(fx(0), fx(1), fx(2), a1); lean_free_small_object(f); return r; }
-    case 5: { obj* r = FN5(f)(fx(0), fx(1), fx(2), fx(3), a1); lean_free_small_object(f); return r; }
-    case 6: { obj* r = FN6(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1); lean_free_small_object(f); return r; }
-    case 7: { obj* r = FN7(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1); lean_free_small_object(f); return r; }
-    case 8: { obj* r = FN8(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1); lean_free_small_object(f); return r; }
-    case 9: { obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), a1); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), a1); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), fx(13), a1); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), fx(13), fx(14), a1); lean_free_small_object(f); return r; }
+    case 1: { fn1 g = FN1(f); lean_free_small_object(f); return g(a1); }
+    case 2: { fn2 g = FN2(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1); }
+    case 3: { fn3 g = FN3(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1); }
+    case 4: { fn4 g = FN4(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1); }
+    case 5: { fn5 g = FN5(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1); }
+    case 6: { fn6 g = FN6(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1); }
+    case 7: { fn7 g = FN7(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1); }
+    case 8: { fn8 g = FN8(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1); }
+    case 9: { fn9 g = FN9(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, a1); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, a1); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); obj* x13 = fx(13); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, a1); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); obj* x13 = fx(13); obj* x14 = fx(14); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, a1); }
     }
   }
   switch (arity) {
-  case 1: { obj* r = FN1(f)(a1); lean_dec_ref(f); return r; }
-  case 2: { lean_inc(fx(0)); obj* r = FN2(f)(fx(0), a1); lean_dec_ref(f); return r; }
-  case 3: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN3(f)(fx(0), fx(1), a1); lean_dec_ref(f); return r; }
-  case 4: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN4(f)(fx(0), fx(1), fx(2), a1); lean_dec_ref(f); return r; }
-  case 5: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN5(f)(fx(0), fx(1), fx(2), fx(3), a1); lean_dec_ref(f); return r; }
-  case 6: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN6(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1); lean_dec_ref(f); return r; }
-  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN7(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1); lean_dec_ref(f); return r; }
-  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN8(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1); lean_dec_ref(f); return r; }
-  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), a1); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), a1); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); lean_inc(fx(13)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), fx(13), a1); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); lean_inc(fx(13)); lean_inc(fx(14)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), fx(13), fx(14), a1); lean_dec_ref(f); return r; }
+  case 1: { fn1 g = FN1(f); lean_dec_ref(f); return g(a1); }
+  case 2: { lean_inc(fx(0)); obj* x0 = fx(0); fn2 g = FN2(f); lean_dec_ref(f); return g(x0, a1); }
+  case 3: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn3 g = FN3(f); lean_dec_ref(f); return g(x0, x1, a1); }
+  case 4: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn4 g = FN4(f); lean_dec_ref(f); return g(x0, x1, x2, a1); }
+  case 5: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn5 g = FN5(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1); }
+  case 6: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn6 g = FN6(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1); }
+  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn7 g = FN7(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1); }
+  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn8 g = FN8(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1); }
+  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); fn9 g = FN9(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1); }
+  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, a1); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, a1); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); lean_inc(fx(13)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); obj* x13 = fx(13); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, a1); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); lean_inc(fx(13)); lean_inc(fx(14)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); obj* x13 = fx(13); obj* x14 = fx(14); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, a1); }
   default:
     lean_assert(arity > 16);
     obj * as[1] = { a1 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 1; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 1, as);
   }
 } else if (arity < fixed + 1) {
   lean_assert(fixed < arity);
@@ -159,60 +212,50 @@ if (arity == fixed + 1) {
 extern "C" obj* lean_apply_2(obj* f, obj* a1, obj* a2) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 2) {
+if (LEAN_LIKELY(arity == fixed + 2)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 2: { obj* r = FN2(f)(a1, a2); lean_free_small_object(f); return r; }
-    case 3: { obj* r = FN3(f)(fx(0), a1, a2); lean_free_small_object(f); return r; }
-    case 4: { obj* r = FN4(f)(fx(0), fx(1), a1, a2); lean_free_small_object(f); return r; }
-    case 5: { obj* r = FN5(f)(fx(0), fx(1), fx(2), a1, a2); lean_free_small_object(f); return r; }
-    case 6: { obj* r = FN6(f)(fx(0), fx(1), fx(2), fx(3), a1, a2); lean_free_small_object(f); return r; }
-    case 7: { obj* r = FN7(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2); lean_free_small_object(f); return r; }
-    case 8: { obj* r = FN8(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2); lean_free_small_object(f); return r; }
-    case 9: { obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1, a2); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), a1, a2); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), a1, a2); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), fx(13), a1, a2); lean_free_small_object(f); return r; }
+    case 2: { fn2 g = FN2(f); lean_free_small_object(f); return g(a1, a2); }
+    case 3: { fn3 g = FN3(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2); }
+    case 4: { fn4 g = FN4(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2); }
+    case 5: { fn5 g = FN5(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2); }
+    case 6: { fn6 g = FN6(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2); }
+    case 7: { fn7 g = FN7(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2); }
+    case 8: { fn8 g = FN8(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2); }
+    case 9: { fn9 g = FN9(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1, a2); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, a1, a2); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, a1, a2); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); obj* x13 = fx(13); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, a1, a2); }
     }
   }
   switch (arity) {
-  case 2: { obj* r = FN2(f)(a1, a2); lean_dec_ref(f); return r; }
-  case 3: { lean_inc(fx(0)); obj* r = FN3(f)(fx(0), a1, a2); lean_dec_ref(f); return r; }
-  case 4: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN4(f)(fx(0), fx(1), a1, a2); lean_dec_ref(f); return r; }
-  case 5: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN5(f)(fx(0), fx(1), fx(2), a1, a2); lean_dec_ref(f); return r; }
-  case 6: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN6(f)(fx(0), fx(1), fx(2), fx(3), a1, a2); lean_dec_ref(f); return r; }
-  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN7(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2); lean_dec_ref(f); return r; }
-  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN8(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2); lean_dec_ref(f); return r; }
-  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1, a2); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), a1, a2); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), a1, a2); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); lean_inc(fx(13)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), fx(13), a1, a2); lean_dec_ref(f); return r; }
+  case 2: { fn2 g = FN2(f); lean_dec_ref(f); return g(a1, a2); }
+  case 3: { lean_inc(fx(0)); obj* x0 = fx(0); fn3 g = FN3(f); lean_dec_ref(f); return g(x0, a1, a2); }
+  case 4: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn4 g = FN4(f); lean_dec_ref(f); return g(x0, x1, a1, a2); }
+  case 5: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn5 g = FN5(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2); }
+  case 6: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn6 g = FN6(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2); }
+  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn7 g = FN7(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2); }
+  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn8 g = FN8(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2); }
+  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn9 g = FN9(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2); }
+  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1, a2); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, a1, a2); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, a1, a2); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); lean_inc(fx(13)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); obj* x13 = fx(13); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, a1, a2); }
   default:
     lean_assert(arity > 16);
     obj * as[2] = { a1, a2 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 2; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 2, as);
   }
 } else if (arity < fixed + 2) {
   obj * as[2] = { a1, a2 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 2+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 2, as);
 } else {
   return fix_args(f, {a1, a2});
 }
@@ -220,58 +263,48 @@ if (arity == fixed + 2) {
 extern "C" obj* lean_apply_3(obj* f, obj* a1, obj* a2, obj* a3) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 3) {
+if (LEAN_LIKELY(arity == fixed + 3)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 3: { obj* r = FN3(f)(a1, a2, a3); lean_free_small_object(f); return r; }
-    case 4: { obj* r = FN4(f)(fx(0), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 5: { obj* r = FN5(f)(fx(0), fx(1), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 6: { obj* r = FN6(f)(fx(0), fx(1), fx(2), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 7: { obj* r = FN7(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 8: { obj* r = FN8(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 9: { obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), a1, a2, a3); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), a1, a2, a3); lean_free_small_object(f); return r; }
+    case 3: { fn3 g = FN3(f); lean_free_small_object(f); return g(a1, a2, a3); }
+    case 4: { fn4 g = FN4(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3); }
+    case 5: { fn5 g = FN5(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3); }
+    case 6: { fn6 g = FN6(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3); }
+    case 7: { fn7 g = FN7(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3); }
+    case 8: { fn8 g = FN8(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3); }
+    case 9: { fn9 g = FN9(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2, a3); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1, a2, a3); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, a1, a2, a3); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, a1, a2, a3); }
     }
   }
   switch (arity) {
-  case 3: { obj* r = FN3(f)(a1, a2, a3); lean_dec_ref(f); return r; }
-  case 4: { lean_inc(fx(0)); obj* r = FN4(f)(fx(0), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 5: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN5(f)(fx(0), fx(1), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 6: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN6(f)(fx(0), fx(1), fx(2), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN7(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN8(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), a1, a2, a3); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), fx(12), a1, a2, a3); lean_dec_ref(f); return r; }
+  case 3: { fn3 g = FN3(f); lean_dec_ref(f); return g(a1, a2, a3); }
+  case 4: { lean_inc(fx(0)); obj* x0 = fx(0); fn4 g = FN4(f); lean_dec_ref(f); return g(x0, a1, a2, a3); }
+  case 5: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn5 g = FN5(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3); }
+  case 6: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn6 g = FN6(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3); }
+  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn7 g = FN7(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3); }
+  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn8 g = FN8(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3); }
+  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn9 g = FN9(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3); }
+  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2, a3); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1, a2, a3); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, a1, a2, a3); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); lean_inc(fx(12)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); obj* x12 = fx(12); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, a1, a2, a3); }
   default:
     lean_assert(arity > 16);
     obj * as[3] = { a1, a2, a3 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 3; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 3, as);
   }
 } else if (arity < fixed + 3) {
   obj * as[3] = { a1, a2, a3 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 3+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 3, as);
 } else {
   return fix_args(f, {a1, a2, a3});
 }
@@ -279,56 +312,46 @@ if (arity == fixed + 3) {
 extern "C" obj* lean_apply_4(obj* f, obj* a1, obj* a2, obj* a3, obj* a4) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 4) {
+if (LEAN_LIKELY(arity == fixed + 4)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 4: { obj* r = FN4(f)(a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 5: { obj* r = FN5(f)(fx(0), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 6: { obj* r = FN6(f)(fx(0), fx(1), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 7: { obj* r = FN7(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 8: { obj* r = FN8(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 9: { obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1, a2, a3, a4); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), a1, a2, a3, a4); lean_free_small_object(f); return r; }
+    case 4: { fn4 g = FN4(f); lean_free_small_object(f); return g(a1, a2, a3, a4); }
+    case 5: { fn5 g = FN5(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4); }
+    case 6: { fn6 g = FN6(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4); }
+    case 7: { fn7 g = FN7(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4); }
+    case 8: { fn8 g = FN8(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4); }
+    case 9: { fn9 g = FN9(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3, a4); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2, a3, a4); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1, a2, a3, a4); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, a1, a2, a3, a4); }
     }
   }
   switch (arity) {
-  case 4: { obj* r = FN4(f)(a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 5: { lean_inc(fx(0)); obj* r = FN5(f)(fx(0), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 6: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN6(f)(fx(0), fx(1), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN7(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN8(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1, a2, a3, a4); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), fx(11), a1, a2, a3, a4); lean_dec_ref(f); return r; }
+  case 4: { fn4 g = FN4(f); lean_dec_ref(f); return g(a1, a2, a3, a4); }
+  case 5: { lean_inc(fx(0)); obj* x0 = fx(0); fn5 g = FN5(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4); }
+  case 6: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn6 g = FN6(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4); }
+  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn7 g = FN7(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4); }
+  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn8 g = FN8(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4); }
+  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn9 g = FN9(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4); }
+  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3, a4); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2, a3, a4); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1, a2, a3, a4); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); lean_inc(fx(11)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); obj* x11 = fx(11); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, a1, a2, a3, a4); }
   default:
     lean_assert(arity > 16);
     obj * as[4] = { a1, a2, a3, a4 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 4; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 4, as);
   }
 } else if (arity < fixed + 4) {
   obj * as[4] = { a1, a2, a3, a4 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 4+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 4, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4});
 }
@@ -336,54 +359,44 @@ if (arity == fixed + 4) {
 extern "C" obj* lean_apply_5(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 5) {
+if (LEAN_LIKELY(arity == fixed + 5)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 5: { obj* r = FN5(f)(a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 6: { obj* r = FN6(f)(fx(0), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 7: { obj* r = FN7(f)(fx(0), fx(1), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 8: { obj* r = FN8(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 9: { obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1, a2, a3, a4, a5); lean_free_small_object(f); return r; }
+    case 5: { fn5 g = FN5(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5); }
+    case 6: { fn6 g = FN6(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5); }
+    case 7: { fn7 g = FN7(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5); }
+    case 8: { fn8 g = FN8(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5); }
+    case 9: { fn9 g = FN9(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4, a5); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3, a4, a5); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2, a3, a4, a5); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1, a2, a3, a4, a5); }
     }
   }
   switch (arity) {
-  case 5: { obj* r = FN5(f)(a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 6: { lean_inc(fx(0)); obj* r = FN6(f)(fx(0), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN7(f)(fx(0), fx(1), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN8(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN9(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), fx(10), a1, a2, a3, a4, a5); lean_dec_ref(f); return r; }
+  case 5: { fn5 g = FN5(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5); }
+  case 6: { lean_inc(fx(0)); obj* x0 = fx(0); fn6 g = FN6(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5); }
+  case 7: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn7 g = FN7(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5); }
+  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn8 g = FN8(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5); }
+  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn9 g = FN9(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5); }
+  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4, a5); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3, a4, a5); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2, a3, a4, a5); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); lean_inc(fx(10)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); obj* x10 = fx(10); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, a1, a2, a3, a4, a5); }
   default:
     lean_assert(arity > 16);
     obj * as[5] = { a1, a2, a3, a4, a5 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 5; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 5, as);
   }
 } else if (arity < fixed + 5) {
   obj * as[5] = { a1, a2, a3, a4, a5 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 5+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 5, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5});
 }
@@ -391,52 +404,42 @@ if (arity == fixed + 5) {
 extern "C" obj* lean_apply_6(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 6) {
+if (LEAN_LIKELY(arity == fixed + 6)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 6: { obj* r = FN6(f)(a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 7: { obj* r = FN7(f)(fx(0), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 8: { obj* r = FN8(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 9: { obj* r = FN9(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2, a3, a4, a5, a6); lean_free_small_object(f); return r; }
+    case 6: { fn6 g = FN6(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6); }
+    case 7: { fn7 g = FN7(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6); }
+    case 8: { fn8 g = FN8(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6); }
+    case 9: { fn9 g = FN9(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5, a6); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4, a5, a6); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3, a4, a5, a6); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2, a3, a4, a5, a6); }
     }
   }
   switch (arity) {
-  case 6: { obj* r = FN6(f)(a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 7: { lean_inc(fx(0)); obj* r = FN7(f)(fx(0), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN8(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN9(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN10(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), fx(9), a1, a2, a3, a4, a5, a6); lean_dec_ref(f); return r; }
+  case 6: { fn6 g = FN6(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6); }
+  case 7: { lean_inc(fx(0)); obj* x0 = fx(0); fn7 g = FN7(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6); }
+  case 8: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn8 g = FN8(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6); }
+  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn9 g = FN9(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6); }
+  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5, a6); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4, a5, a6); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3, a4, a5, a6); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); lean_inc(fx(9)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); obj* x9 = fx(9); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, a1, a2, a3, a4, a5, a6); }
   default:
     lean_assert(arity > 16);
     obj * as[6] = { a1, a2, a3, a4, a5, a6 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 6; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 6, as);
   }
 } else if (arity < fixed + 6) {
   obj * as[6] = { a1, a2, a3, a4, a5, a6 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 6+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 6, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6});
 }
@@ -444,50 +447,40 @@ if (arity == fixed + 6) {
 extern "C" obj* lean_apply_7(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 7) {
+if (LEAN_LIKELY(arity == fixed + 7)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 7: { obj* r = FN7(f)(a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 8: { obj* r = FN8(f)(fx(0), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 9: { obj* r = FN9(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3, a4, a5, a6, a7); lean_free_small_object(f); return r; }
+    case 7: { fn7 g = FN7(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7); }
+    case 8: { fn8 g = FN8(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7); }
+    case 9: { fn9 g = FN9(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6, a7); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5, a6, a7); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4, a5, a6, a7); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3, a4, a5, a6, a7); }
     }
   }
   switch (arity) {
-  case 7: { obj* r = FN7(f)(a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 8: { lean_inc(fx(0)); obj* r = FN8(f)(fx(0), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN9(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN10(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN11(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), fx(8), a1, a2, a3, a4, a5, a6, a7); lean_dec_ref(f); return r; }
+  case 7: { fn7 g = FN7(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7); }
+  case 8: { lean_inc(fx(0)); obj* x0 = fx(0); fn8 g = FN8(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7); }
+  case 9: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn9 g = FN9(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7); }
+  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6, a7); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5, a6, a7); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4, a5, a6, a7); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); lean_inc(fx(8)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); obj* x8 = fx(8); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, x8, a1, a2, a3, a4, a5, a6, a7); }
   default:
     lean_assert(arity > 16);
     obj * as[7] = { a1, a2, a3, a4, a5, a6, a7 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 7; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 7, as);
   }
 } else if (arity < fixed + 7) {
   obj * as[7] = { a1, a2, a3, a4, a5, a6, a7 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 7+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 7, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7});
 }
@@ -495,48 +488,38 @@ if (arity == fixed + 7) {
 extern "C" obj* lean_apply_8(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 8) {
+if (LEAN_LIKELY(arity == fixed + 8)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 8: { obj* r = FN8(f)(a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
-    case 9: { obj* r = FN9(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4, a5, a6, a7, a8); lean_free_small_object(f); return r; }
+    case 8: { fn8 g = FN8(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8); }
+    case 9: { fn9 g = FN9(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7, a8); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6, a7, a8); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5, a6, a7, a8); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4, a5, a6, a7, a8); }
     }
   }
   switch (arity) {
-  case 8: { obj* r = FN8(f)(a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
-  case 9: { lean_inc(fx(0)); obj* r = FN9(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN10(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN11(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN12(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), fx(7), a1, a2, a3, a4, a5, a6, a7, a8); lean_dec_ref(f); return r; }
+  case 8: { fn8 g = FN8(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8); }
+  case 9: { lean_inc(fx(0)); obj* x0 = fx(0); fn9 g = FN9(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8); }
+  case 10: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7, a8); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6, a7, a8); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5, a6, a7, a8); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); lean_inc(fx(7)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); obj* x7 = fx(7); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, x7, a1, a2, a3, a4, a5, a6, a7, a8); }
   default:
     lean_assert(arity > 16);
     obj * as[8] = { a1, a2, a3, a4, a5, a6, a7, a8 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 8; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 8, as);
   }
 } else if (arity < fixed + 8) {
   obj * as[8] = { a1, a2, a3, a4, a5, a6, a7, a8 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 8+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 8, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8});
 }
@@ -544,46 +527,36 @@ if (arity == fixed + 8) {
 extern "C" obj* lean_apply_9(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8, obj* a9) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 9) {
+if (LEAN_LIKELY(arity == fixed + 9)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 9: { obj* r = FN9(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_free_small_object(f); return r; }
-    case 10: { obj* r = FN10(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_free_small_object(f); return r; }
+    case 9: { fn9 g = FN9(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+    case 10: { fn10 g = FN10(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
     }
   }
   switch (arity) {
-  case 9: { obj* r = FN9(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_dec_ref(f); return r; }
-  case 10: { lean_inc(fx(0)); obj* r = FN10(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN11(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN12(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN13(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), fx(6), a1, a2, a3, a4, a5, a6, a7, a8, a9); lean_dec_ref(f); return r; }
+  case 9: { fn9 g = FN9(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+  case 10: { lean_inc(fx(0)); obj* x0 = fx(0); fn10 g = FN10(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+  case 11: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); lean_inc(fx(6)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); obj* x6 = fx(6); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, x6, a1, a2, a3, a4, a5, a6, a7, a8, a9); }
   default:
     lean_assert(arity > 16);
     obj * as[9] = { a1, a2, a3, a4, a5, a6, a7, a8, a9 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 9; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 9, as);
   }
 } else if (arity < fixed + 9) {
   obj * as[9] = { a1, a2, a3, a4, a5, a6, a7, a8, a9 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 9+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 9, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8, a9});
 }
@@ -591,44 +564,34 @@ if (arity == fixed + 9) {
 extern "C" obj* lean_apply_10(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8, obj* a9, obj* a10) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 10) {
+if (LEAN_LIKELY(arity == fixed + 10)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 10: { obj* r = FN10(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_free_small_object(f); return r; }
-    case 11: { obj* r = FN11(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_free_small_object(f); return r; }
+    case 10: { fn10 g = FN10(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+    case 11: { fn11 g = FN11(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
     }
   }
   switch (arity) {
-  case 10: { obj* r = FN10(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_dec_ref(f); return r; }
-  case 11: { lean_inc(fx(0)); obj* r = FN11(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN12(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN13(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN14(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), fx(5), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); lean_dec_ref(f); return r; }
+  case 10: { fn10 g = FN10(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+  case 11: { lean_inc(fx(0)); obj* x0 = fx(0); fn11 g = FN11(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+  case 12: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); lean_inc(fx(5)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); obj* x5 = fx(5); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, x5, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10); }
   default:
     lean_assert(arity > 16);
     obj * as[10] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 10; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 10, as);
   }
 } else if (arity < fixed + 10) {
   obj * as[10] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 10+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 10, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8, a9, a10});
 }
@@ -636,42 +599,32 @@ if (arity == fixed + 10) {
 extern "C" obj* lean_apply_11(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8, obj* a9, obj* a10, obj* a11) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 11) {
+if (LEAN_LIKELY(arity == fixed + 11)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 11: { obj* r = FN11(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_free_small_object(f); return r; }
-    case 12: { obj* r = FN12(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_free_small_object(f); return r; }
+    case 11: { fn11 g = FN11(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+    case 12: { fn12 g = FN12(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); lean_free_small_object(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
     }
   }
   switch (arity) {
-  case 11: { obj* r = FN11(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_dec_ref(f); return r; }
-  case 12: { lean_inc(fx(0)); obj* r = FN12(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN13(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN14(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN15(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), fx(4), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); lean_dec_ref(f); return r; }
+  case 11: { fn11 g = FN11(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+  case 12: { lean_inc(fx(0)); obj* x0 = fx(0); fn12 g = FN12(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+  case 13: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); lean_inc(fx(4)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); obj* x4 = fx(4); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, x4, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11); }
   default:
     lean_assert(arity > 16);
     obj * as[11] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 11; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 11, as);
   }
 } else if (arity < fixed + 11) {
   obj * as[11] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 11+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 11, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11});
 }
@@ -679,40 +632,30 @@ if (arity == fixed + 11) {
 extern "C" obj* lean_apply_12(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8, obj* a9, obj* a10, obj* a11, obj* a12) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 12) {
+if (LEAN_LIKELY(arity == fixed + 12)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 12: { obj* r = FN12(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_free_small_object(f); return r; }
-    case 13: { obj* r = FN13(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_free_small_object(f); return r; }
+    case 12: { fn12 g = FN12(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
+    case 13: { fn13 g = FN13(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); lean_free_small_object(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
     }
   }
   switch (arity) {
-  case 12: { obj* r = FN12(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_dec_ref(f); return r; }
-  case 13: { lean_inc(fx(0)); obj* r = FN13(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN14(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN15(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* r = FN16(f)(fx(0), fx(1), fx(2), fx(3), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); lean_dec_ref(f); return r; }
+  case 12: { fn12 g = FN12(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
+  case 13: { lean_inc(fx(0)); obj* x0 = fx(0); fn13 g = FN13(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
+  case 14: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); lean_inc(fx(3)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); obj* x3 = fx(3); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, x3, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12); }
   default:
     lean_assert(arity > 16);
     obj * as[12] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 12; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 12, as);
   }
 } else if (arity < fixed + 12) {
   obj * as[12] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 12+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 12, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12});
 }
@@ -720,38 +663,28 @@ if (arity == fixed + 12) {
 extern "C" obj* lean_apply_13(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8, obj* a9, obj* a10, obj* a11, obj* a12, obj* a13) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 13) {
+if (LEAN_LIKELY(arity == fixed + 13)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 13: { obj* r = FN13(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); lean_free_small_object(f); return r; }
-    case 14: { obj* r = FN14(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); lean_free_small_object(f); return r; }
+    case 13: { fn13 g = FN13(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); }
+    case 14: { fn14 g = FN14(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); lean_free_small_object(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); }
     }
   }
   switch (arity) {
-  case 13: { obj* r = FN13(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); lean_dec_ref(f); return r; }
-  case 14: { lean_inc(fx(0)); obj* r = FN14(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN15(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* r = FN16(f)(fx(0), fx(1), fx(2), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); lean_dec_ref(f); return r; }
+  case 13: { fn13 g = FN13(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); }
+  case 14: { lean_inc(fx(0)); obj* x0 = fx(0); fn14 g = FN14(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); }
+  case 15: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); lean_inc(fx(2)); obj* x0 = fx(0); obj* x1 = fx(1); obj* x2 = fx(2); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, x2, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13); }
   default:
     lean_assert(arity > 16);
     obj * as[13] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 13; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 13, as);
   }
 } else if (arity < fixed + 13) {
   obj * as[13] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 13+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 13, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13});
 }
@@ -759,36 +692,26 @@ if (arity == fixed + 13) {
 extern "C" obj* lean_apply_14(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8, obj* a9, obj* a10, obj* a11, obj* a12, obj* a13, obj* a14) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 14) {
+if (LEAN_LIKELY(arity == fixed + 14)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 14: { obj* r = FN14(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); lean_free_small_object(f); return r; }
-    case 15: { obj* r = FN15(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); lean_free_small_object(f); return r; }
+    case 14: { fn14 g = FN14(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); }
+    case 15: { fn15 g = FN15(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); obj* x1 = fx(1); lean_free_small_object(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); }
     }
   }
   switch (arity) {
-  case 14: { obj* r = FN14(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); lean_dec_ref(f); return r; }
-  case 15: { lean_inc(fx(0)); obj* r = FN15(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); obj* r = FN16(f)(fx(0), fx(1), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); lean_dec_ref(f); return r; }
+  case 14: { fn14 g = FN14(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); }
+  case 15: { lean_inc(fx(0)); obj* x0 = fx(0); fn15 g = FN15(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); }
+  case 16: { lean_inc(fx(0)); lean_inc(fx(1)); obj* x0 = fx(0); obj* x1 = fx(1); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, x1, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14); }
   default:
     lean_assert(arity > 16);
     obj * as[14] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 14; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 14, as);
   }
 } else if (arity < fixed + 14) {
   obj * as[14] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 14+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 14, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14});
 }
@@ -796,34 +719,24 @@ if (arity == fixed + 14) {
 extern "C" obj* lean_apply_15(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8, obj* a9, obj* a10, obj* a11, obj* a12, obj* a13, obj* a14, obj* a15) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 15) {
+if (LEAN_LIKELY(arity == fixed + 15)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 15: { obj* r = FN15(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15); lean_free_small_object(f); return r; }
-    case 16: { obj* r = FN16(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15); lean_free_small_object(f); return r; }
+    case 15: { fn15 g = FN15(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15); }
+    case 16: { fn16 g = FN16(f); obj* x0 = fx(0); lean_free_small_object(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15); }
     }
   }
   switch (arity) {
-  case 15: { obj* r = FN15(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15); lean_dec_ref(f); return r; }
-  case 16: { lean_inc(fx(0)); obj* r = FN16(f)(fx(0), a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15); lean_dec_ref(f); return r; }
+  case 15: { fn15 g = FN15(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15); }
+  case 16: { lean_inc(fx(0)); obj* x0 = fx(0); fn16 g = FN16(f); lean_dec_ref(f); return g(x0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15); }
   default:
     lean_assert(arity > 16);
     obj * as[15] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 15; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 15, as);
   }
 } else if (arity < fixed + 15) {
   obj * as[15] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 15+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 15, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15});
 }
@@ -831,32 +744,22 @@ if (arity == fixed + 15) {
 extern "C" obj* lean_apply_16(obj* f, obj* a1, obj* a2, obj* a3, obj* a4, obj* a5, obj* a6, obj* a7, obj* a8, obj* a9, obj* a10, obj* a11, obj* a12, obj* a13, obj* a14, obj* a15, obj* a16) {
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
-if (arity == fixed + 16) {
+if (LEAN_LIKELY(arity == fixed + 16)) {
   if (is_exclusive(f)) {
     switch (arity) {
-    case 16: { obj* r = FN16(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16); lean_free_small_object(f); return r; }
+    case 16: { fn16 g = FN16(f); lean_free_small_object(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16); }
     }
   }
   switch (arity) {
-  case 16: { obj* r = FN16(f)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16); lean_dec_ref(f); return r; }
+  case 16: { fn16 g = FN16(f); lean_dec_ref(f); return g(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16); }
   default:
     lean_assert(arity > 16);
     obj * as[16] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16 };
-    obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-    for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-    for (unsigned i = 0; i < 16; i++) args[fixed+i] = as[i];
-    obj * r = FNN(f)(args);
-    lean_dec_ref(f);
-    return r;
+    return apply_exact_big(f, 16, as);
   }
 } else if (arity < fixed + 16) {
   obj * as[16] = { a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16 };
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = curry(f, arity, args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, 16+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, 16, as);
 } else {
   return fix_args(f, {a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16});
 }
@@ -866,43 +769,37 @@ lean_assert(n > 16);
 unsigned arity = lean_closure_arity(f);
 unsigned fixed = lean_closure_num_fixed(f);
 if (arity == fixed + n) {
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < n; i++) args[fixed+i] = as[i];
-  obj * r = FNN(f)(args);
-  lean_dec_ref(f);
-  return r;
+  return apply_exact_big(f, n, as);
 } else if (arity < fixed + n) {
-  obj ** args = static_cast<obj**>(LEAN_ALLOCA(arity*sizeof(obj*))); // NOLINT
-  for (unsigned i = 0; i < fixed; i++) { lean_inc(fx(i)); args[i] = fx(i); }
-  for (unsigned i = 0; i < arity-fixed; i++) args[fixed+i] = as[i];
-  obj * new_f = FNN(f)(args);
-  lean_dec_ref(f);
-  return lean_apply_n(new_f, n+fixed-arity, &as[arity-fixed]);
+  return apply_over(f, n, as);
 } else {
   return fix_args(f, n, as);
 }
 }
+typedef obj* (*apply_fn)(obj*, obj**); // NOLINT
+static obj* apply_1(obj* f, obj** as) { return lean_apply_1(f, as[0]); }
+static obj* apply_2(obj* f, obj** as) { return lean_apply_2(f, as[0], as[1]); }
+static obj* apply_3(obj* f, obj** as) { return lean_apply_3(f, as[0], as[1], as[2]); }
+static obj* apply_4(obj* f, obj** as) { return lean_apply_4(f, as[0], as[1], as[2], as[3]); }
+static obj* apply_5(obj* f, obj** as) { return lean_apply_5(f, as[0], as[1], as[2], as[3], as[4]); }
+static obj* apply_6(obj* f, obj** as) { return lean_apply_6(f, as[0], as[1], as[2], as[3], as[4], as[5]); }
+static obj* apply_7(obj* f, obj** as) { return lean_apply_7(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6]); }
+static obj* apply_8(obj* f, obj** as) { return lean_apply_8(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7]); }
+static obj* apply_9(obj* f, obj** as) { return lean_apply_9(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8]); }
+static obj* apply_10(obj* f, obj** as) { return lean_apply_10(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9]); }
+static obj* apply_11(obj* f, obj** as) { return lean_apply_11(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10]); }
+static obj* apply_12(obj* f, obj** as) { return lean_apply_12(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11]); }
+static obj* apply_13(obj* f, obj** as) { return lean_apply_13(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12]); }
+static obj* apply_14(obj* f, obj** as) { return lean_apply_14(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13]); }
+static obj* apply_15(obj* f, obj** as) { return lean_apply_15(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13], as[14]); }
+static obj* apply_16(obj* f, obj** as) { return lean_apply_16(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13], as[14], as[15]); }
+static apply_fn const g_apply_fns[17] = {
+    nullptr, apply_1, apply_2, apply_3, apply_4, apply_5, apply_6, apply_7, apply_8,
+    apply_9, apply_10, apply_11, apply_12, apply_13, apply_14, apply_15, apply_16
+};
 extern "C" obj* lean_apply_n(obj* f, unsigned n, obj** as) {
-switch (n) {
-case 0: lean_unreachable();
-case 1: return lean_apply_1(f, as[0]);
-case 2: return lean_apply_2(f, as[0], as[1]);
-case 3: return lean_apply_3(f, as[0], as[1], as[2]);
-case 4: return lean_apply_4(f, as[0], as[1], as[2], as[3]);
-case 5: return lean_apply_5(f, as[0], as[1], as[2], as[3], as[4]);
-case 6: return lean_apply_6(f, as[0], as[1], as[2], as[3], as[4], as[5]);
-case 7: return lean_apply_7(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6]);
-case 8: return lean_apply_8(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7]);
-case 9: return lean_apply_9(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8]);
-case 10: return lean_apply_10(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9]);
-case 11: return lean_apply_11(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10]);
-case 12: return lean_apply_12(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11]);
-case 13: return lean_apply_13(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12]);
-case 14: return lean_apply_14(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13]);
-case 15: return lean_apply_15(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13], as[14]);
-case 16: return lean_apply_16(f, as[0], as[1], as[2], as[3], as[4], as[5], as[6], as[7], as[8], as[9], as[10], as[11], as[12], as[13], as[14], as[15]);
-default: return lean_apply_m(f, n, as);
-}
+lean_assert(n > 0);
+if (n <= 16) return g_apply_fns[n](f, as);
+return lean_apply_m(f, n, as);
 }
 }
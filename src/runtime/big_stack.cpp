@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Run a closure on a heap-allocated stack. Several kernel traversals recurse
+proportionally to term depth; machine-generated terms exceed any fixed thread
+stack, so callers retry depth-bound work here when they run out of stack.
+*/
+#include <exception>
+#include <lean/big_stack.h>
+#include <lean/stackinfo.h>
+#include <lean/thread.h>
+#if defined(__linux__)
+#include <ucontext.h>
+#include <sys/mman.h>
+#endif
+
+namespace lean {
+#if defined(__linux__)
+struct big_stack_ctx {
+    std::function<void()> const * m_fn;
+    std::exception_ptr            m_ex;
+    size_t                        m_stack_size;
+    ucontext_t                    m_caller;
+    ucontext_t                    m_callee;
+};
+/* makecontext entry points only take int arguments, so the context travels in
+   a thread local instead */
+LEAN_THREAD_PTR(big_stack_ctx, g_big_stack_ctx);
+
+static void big_stack_entry() {
+    big_stack_ctx * c = g_big_stack_ctx;
+    /* point the stack guard at the custom stack; the caller restores it */
+    set_custom_stack_info(c->m_stack_size);
+    try {
+        (*c->m_fn)();
+    } catch (...) {
+        /* unwinding must not cross the context switch; rethrown by the caller */
+        c->m_ex = std::current_exception();
+    }
+    /* returning resumes `uc_link`, i.e. the caller */
+}
+
+void run_with_big_stack(std::function<void()> const & fn, size_t stack_size) {
+    void * stack = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (stack == MAP_FAILED) {
+        fn();
+        return;
+    }
+    big_stack_ctx c;
+    c.m_fn         = &fn;
+    c.m_stack_size = stack_size;
+    getcontext(&c.m_callee);
+    c.m_callee.uc_stack.ss_sp   = stack;
+    c.m_callee.uc_stack.ss_size = stack_size;
+    c.m_callee.uc_link          = &c.m_caller;
+    makecontext(&c.m_callee, big_stack_entry, 0);
+    stack_info_snapshot old_info = get_stack_info();
+    big_stack_ctx * old_ctx = g_big_stack_ctx;
+    g_big_stack_ctx = &c;
+    swapcontext(&c.m_caller, &c.m_callee);
+    g_big_stack_ctx = old_ctx;
+    set_stack_info(old_info);
+    munmap(stack, stack_size);
+    if (c.m_ex)
+        std::rethrow_exception(c.m_ex);
+}
+#else
+void run_with_big_stack(std::function<void()> const & fn, size_t) {
+    fn();
+}
+#endif
+}
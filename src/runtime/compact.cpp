@@ -8,12 +8,16 @@ Author: Leonardo de Moura
 #include <algorithm>
 #include <string>
 #include <vector>
+#if !defined(LEAN_WINDOWS) && !defined(LEAN_EMSCRIPTEN)
+#include <sys/mman.h>
+#endif
 #include <lean/hash.h>
 #include <lean/lean.h>
 #include <lean/compact.h>
 
 #define LEAN_COMPACTOR_INIT_SZ 1024*1024
 #define LEAN_MAX_SHARING_TABLE_INITIAL_SIZE 1024*1024
+#define LEAN_OBJECT_TABLE_INITIAL_SIZE 1024*1024
 
 // uncomment to track the number of each kind of object in an .olean file
 // #define LEAN_TAG_COUNTERS
@@ -29,8 +33,8 @@ struct max_sharing_key {
 struct max_sharing_hash {
     object_compactor * m;
     max_sharing_hash(object_compactor * manager):m(manager) {}
-    unsigned operator()(max_sharing_key const & k) const {
-        return hash_str(k.m_size, reinterpret_cast<char const *>(m->m_begin) + k.m_offset, 17);
+    size_t operator()(max_sharing_key const & k) const {
+        return hash_bytes(k.m_size, reinterpret_cast<char const *>(m->m_begin) + k.m_offset, 17);
     }
 };
 
@@ -67,6 +71,75 @@ object_compactor::object_compactor():
     m_begin(malloc(LEAN_COMPACTOR_INIT_SZ)),
     m_end(m_begin),
     m_capacity(static_cast<char*>(m_begin) + LEAN_COMPACTOR_INIT_SZ) {
+    /* `m_obj_table` receives one entry per compacted object. Reserving upfront avoids a long
+       sequence of rehashes (each one a full pass over the table) while compacting large modules. */
+    m_obj_table.reserve(LEAN_OBJECT_TABLE_INITIAL_SIZE);
+}
+
+object_compactor::object_compactor(void const * base, size_t base_sz):
+    object_compactor() {
+    if (base_sz < sizeof(terminator_object) || base_sz % sizeof(void*) != 0)
+        return;
+    if (base_sz > capacity()) {
+        size_t new_capacity = capacity();
+        while (new_capacity < base_sz)
+            new_capacity *= 2;
+        m_begin    = realloc(m_begin, new_capacity);
+        m_capacity = static_cast<char*>(m_begin) + new_capacity;
+    }
+    memcpy(m_begin, base, base_sz);
+    object * last = reinterpret_cast<object*>(static_cast<char*>(m_begin) + base_sz - sizeof(terminator_object));
+    if (lean_ptr_tag(last) != LeanReserved)
+        return; /* not terminated as expected; ignore the base and start empty */
+    /* Drop the trailing terminator: the one written by the next `operator()` call
+       defines the root of the combined region. */
+    m_end = last;
+    index_existing_objects();
+}
+
+/* Rebuild the max-sharing table for the objects already in the buffer (seeded from a
+   previously compacted region), so that structurally identical new objects are shared
+   with them instead of being appended again. The walk mirrors `compacted_region::read`,
+   but only needs object sizes; child fields are offsets and are not inspected. */
+void object_compactor::index_existing_objects() {
+    char * it  = static_cast<char*>(m_begin);
+    char * end = static_cast<char*>(m_end);
+    while (it < end) {
+        object * curr = reinterpret_cast<object*>(it);
+        uint8 tag     = lean_ptr_tag(curr);
+        size_t sz;
+        bool shareable = true;
+        if (tag <= LeanMaxCtorTag) {
+            sz = lean_object_byte_size(curr);
+        } else {
+            switch (tag) {
+            case LeanArray:       sz = lean_object_byte_size(curr); break;
+            case LeanScalarArray: sz = lean_sarray_byte_size(curr); break;
+            case LeanString:      sz = lean_string_byte_size(curr); break;
+            case LeanThunk:       sz = sizeof(lean_thunk_object); break;
+            case LeanRef:         sz = sizeof(lean_ref_object); break;
+            case LeanTask:        sz = sizeof(lean_task_object); break;
+            case LeanMPZ: {
+                /* An mpz is followed by its string representation (see `insert_mpz`). */
+                char const * s = it + sizeof(mpz_object);
+                sz = sizeof(mpz_object) + std::max(strlen(s) + 1, sizeof(mpz_object*));
+                break;
+            }
+            case LeanReserved:
+                /* Terminator of an earlier root. */
+                sz = sizeof(terminator_object);
+                shareable = false;
+                break;
+            default:              lean_unreachable();
+            }
+        }
+        if (shareable)
+            m_max_sharing_table->m_table.insert(max_sharing_key(it - static_cast<char*>(m_begin), sz));
+        size_t rem = sz % sizeof(void*);
+        if (rem != 0)
+            sz += sizeof(void*) - rem;
+        it += sz;
+    }
 }
 
 object_compactor::~object_compactor() {
@@ -86,11 +159,12 @@ void * object_compactor::alloc(size_t sz) {
         sz = sz + sizeof(void*) - rem;
     while (static_cast<char*>(m_end) + sz > m_capacity) {
         size_t new_capacity = capacity()*2;
-        void * new_begin = malloc(new_capacity);
-        memcpy(new_begin, m_begin, size());
-        m_end      = static_cast<char*>(new_begin) + size();
+        size_t curr_size    = size();
+        /* `realloc` can often extend the block in place (e.g., `mremap` on Linux),
+           avoiding the copy of the already compacted prefix. */
+        void * new_begin = realloc(m_begin, new_capacity);
+        m_end      = static_cast<char*>(new_begin) + curr_size;
         m_capacity = static_cast<char*>(new_begin) + new_capacity;
-        free(m_begin);
         m_begin    = new_begin;
     }
     void * r = m_end;
@@ -276,9 +350,12 @@ void object_compactor::insert_mpz(object * o) {
     size_t sz      = sizeof(mpz_object) + extra_space;
     object * new_o = (lean_object*)alloc(sz);
     lean_set_non_heap_header((lean_object*)new_o, sz, LeanMPZ, 0);
-    save(o, (lean_object*)new_o);
     void * data    = reinterpret_cast<char*>(new_o) + sizeof(mpz_object);
     memcpy(data, s.c_str(), s.size() + 1);
+    /* The image is the header plus the string representation (the `m_value` area
+       is left zeroed and only initialized after load), so byte-identical images
+       mean equal values and mpz literals can be max-shared like strings. */
+    save_max_sharing(o, (lean_object*)new_o, sz);
 }
 
 #ifdef LEAN_TAG_COUNTERS
@@ -357,14 +434,31 @@ compacted_region::compacted_region(size_t sz, void * data):
     m_begin(data),
     m_next(data),
     m_end(static_cast<char*>(data)+sz),
-    m_nested_mpzs(nullptr) {
+    m_nested_mpzs(nullptr),
+    m_mmap_base(nullptr),
+    m_mmap_size(0) {
 }
 
+#if !defined(LEAN_WINDOWS) && !defined(LEAN_EMSCRIPTEN)
+compacted_region::compacted_region(size_t sz, void * data, void * mmap_base, size_t mmap_size):
+    m_begin(data),
+    m_next(data),
+    m_end(static_cast<char*>(data)+sz),
+    m_nested_mpzs(nullptr),
+    m_mmap_base(mmap_base),
+    m_mmap_size(mmap_size) {
+    lean_assert(mmap_base <= data);
+    lean_assert(static_cast<char*>(data) + sz <= static_cast<char*>(mmap_base) + mmap_size);
+}
+#endif
+
 compacted_region::compacted_region(object_compactor const & c):
     m_begin(malloc(c.size())),
     m_next(m_begin),
     m_end(static_cast<char*>(m_begin) + c.size()),
-    m_nested_mpzs(nullptr) {
+    m_nested_mpzs(nullptr),
+    m_mmap_base(nullptr),
+    m_mmap_size(0) {
     memcpy(m_begin, c.data(), c.size());
 }
 
@@ -373,6 +467,12 @@ compacted_region::~compacted_region() {
         m_nested_mpzs->m_value.~mpz();
         m_nested_mpzs = *reinterpret_cast<mpz_object**>(reinterpret_cast<char*>(m_nested_mpzs) + sizeof(mpz_object));
     }
+#if !defined(LEAN_WINDOWS) && !defined(LEAN_EMSCRIPTEN)
+    if (m_mmap_base != nullptr) {
+        munmap(m_mmap_base, m_mmap_size);
+        return;
+    }
+#endif
     free(m_begin);
 }
 
@@ -5,6 +5,8 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <cstddef>
+#include <cstring>
+#include <lean/hash.h>
 
 namespace lean {
 
@@ -63,4 +65,53 @@ unsigned hash_str(size_t length, char const * str, unsigned init_value) {
     return c;
 }
 
+static inline uint64 load_u64(char const * p) { uint64 v; memcpy(&v, p, 8); return v; }
+static inline uint64 load_u32(char const * p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+/* 64x64->128 bit multiply folded to 64 bits. */
+static inline uint64 mum(uint64 a, uint64 b) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64>(r) ^ static_cast<uint64>(r >> 64);
+#else
+    uint64 ha = a >> 32, la = static_cast<uint32_t>(a);
+    uint64 hb = b >> 32, lb = static_cast<uint32_t>(b);
+    uint64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64 t  = rl + (rm0 << 32);
+    uint64 c  = t < rl;
+    uint64 lo = t + (rm1 << 32);
+    c        += lo < t;
+    uint64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    return lo ^ hi;
+#endif
+}
+
+/*
+  Wide multiply-mix hash (wyhash-style): 16 bytes per iteration through a 128-bit multiply,
+  so long keys cost one multiply per two words instead of one `mix` round per 12 bytes.
+  Only for process-local tables — the result is not stable across platforms or versions,
+  unlike `hash_str`, whose value feeds `String.hash`/`Name.hash` and is stored in .olean files.
+*/
+uint64 hash_bytes(size_t len, char const * str, uint64 init_value) {
+    uint64 const s0 = 0x2d358dccaa6c78a5ull;
+    uint64 const s1 = 0x8bb84b93962eacc9ull;
+    uint64 h = init_value ^ mum(static_cast<uint64>(len) ^ s0, s1);
+    while (len >= 16) {
+        h = mum(load_u64(str) ^ s0, load_u64(str + 8) ^ h);
+        str += 16; len -= 16;
+    }
+    uint64 a = 0, b = 0;
+    if (len >= 8) {
+        a = load_u64(str);
+        b = load_u64(str + len - 8);
+    } else if (len >= 4) {
+        a = load_u32(str);
+        b = load_u32(str + len - 4);
+    } else if (len > 0) {
+        a = (static_cast<uint64>(static_cast<unsigned char>(str[0])) << 16) |
+            (static_cast<uint64>(static_cast<unsigned char>(str[len >> 1])) << 8) |
+            static_cast<uint64>(static_cast<unsigned char>(str[len - 1]));
+    }
+    return mum(a ^ s0, b ^ h);
+}
 }
@@ -6,21 +6,25 @@ Author: Leonardo de Moura
 */
 #include <lean/alloc.h>
 #include <lean/debug.h>
+#include <lean/mpz.h>
 #include <lean/serializer.h>
 #include <lean/thread.h>
 #include <lean/object.h>
 #include <lean/io.h>
 #include <lean/stack_overflow.h>
+#include <lean/timer.h>
 #include <lean/process.h>
 
 namespace lean {
 extern "C" void lean_initialize_runtime_module() {
     initialize_alloc();
+    initialize_mpz();
     initialize_debug();
     initialize_object();
     initialize_io();
     initialize_serializer();
     initialize_thread();
+    initialize_timer();
     initialize_process();
     initialize_stack_overflow();
 }
@@ -30,11 +34,13 @@ void initialize_runtime_module() {
 void finalize_runtime_module() {
     finalize_stack_overflow();
     finalize_process();
+    finalize_timer();
     finalize_thread();
     finalize_serializer();
     finalize_io();
     finalize_object();
     finalize_debug();
+    finalize_mpz();
     finalize_alloc();
 }
 }
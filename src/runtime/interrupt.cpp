@@ -10,35 +10,156 @@ Author: Leonardo de Moura
 #include <lean/exception.h>
 #include <lean/memory.h>
 
+#ifndef LEAN_HEARTBEAT_FLUSH_PERIOD
+#define LEAN_HEARTBEAT_FLUSH_PERIOD 1024 // must be a power of two
+#endif
+
 namespace lean {
-LEAN_THREAD_VALUE(size_t, g_max_heartbeat, 0);
-LEAN_THREAD_VALUE(size_t, g_heartbeat, 0);
+/* The heartbeat state lives in the consolidated `thread_ctx` TLS block
+   (see lean/thread.h); these aliases keep the code below readable. */
+#define g_max_heartbeat     (get_thread_ctx().m_max_heartbeat)
+#define g_heartbeat         (get_thread_ctx().m_heartbeat)
+#define g_heartbeat_token   (get_thread_ctx().m_heartbeat_token)
+/* Portion of `g_heartbeat` already flushed into `g_heartbeat_token`. */
+#define g_heartbeat_flushed (get_thread_ctx().m_heartbeat_flushed)
+
+heartbeat_token::heartbeat_token(size_t max):m_rc(1), m_count(0), m_max(max) {}
+
+void heartbeat_token::inc_ref() {
+    m_rc.fetch_add(1, memory_order_relaxed);
+}
+
+void heartbeat_token::dec_ref() {
+    if (m_rc.fetch_sub(1, memory_order_acq_rel) == 1)
+        delete this;
+}
+
+void heartbeat_token::flush(size_t n) {
+    m_count.fetch_add(n, memory_order_relaxed);
+}
+
+bool heartbeat_token::expired() const {
+    return m_max > 0 && m_count.load(memory_order_relaxed) > m_max;
+}
+
+static void flush_heartbeat() {
+    if (g_heartbeat > g_heartbeat_flushed) {
+        g_heartbeat_token->flush(g_heartbeat - g_heartbeat_flushed);
+        g_heartbeat_flushed = g_heartbeat;
+    }
+}
+
+heartbeat_token * get_heartbeat_token() { return g_heartbeat_token; }
+
+void set_heartbeat_token(heartbeat_token * t) {
+    if (t)
+        t->inc_ref();
+    if (g_heartbeat_token) {
+        flush_heartbeat();
+        g_heartbeat_token->dec_ref();
+    }
+    g_heartbeat_token   = t;
+    g_heartbeat_flushed = g_heartbeat;
+}
+
+scope_heartbeat_token::scope_heartbeat_token(heartbeat_token * t):m_old(g_heartbeat_token) {
+    if (m_old)
+        m_old->inc_ref();
+    set_heartbeat_token(t);
+}
+
+scope_heartbeat_token::~scope_heartbeat_token() {
+    set_heartbeat_token(m_old);
+    if (m_old)
+        m_old->dec_ref();
+}
 
 void inc_heartbeat() { g_heartbeat++; }
 
-void reset_heartbeat() { g_heartbeat = 0; }
+void reset_heartbeat() {
+    if (g_heartbeat_token)
+        flush_heartbeat();
+    g_heartbeat         = 0;
+    g_heartbeat_flushed = 0;
+}
 
-void set_max_heartbeat(size_t max) { g_max_heartbeat = max; }
+void set_max_heartbeat(size_t max) {
+    g_max_heartbeat = max;
+    /* Tasks spawned from here on inherit (a reference to) this token and
+       charge their heartbeats against the shared budget. */
+    if (max > 0) {
+        heartbeat_token * t = new heartbeat_token(max);
+        set_heartbeat_token(t);
+        t->dec_ref();
+    } else {
+        set_heartbeat_token(nullptr);
+    }
+}
 
 size_t get_max_heartbeat() { return g_max_heartbeat; }
 
-void set_max_heartbeat_thousands(unsigned max) { g_max_heartbeat = static_cast<size_t>(max) * 1000; }
+void set_max_heartbeat_thousands(unsigned max) { set_max_heartbeat(static_cast<size_t>(max) * 1000); }
 
 scope_heartbeat::scope_heartbeat(size_t max):flet<size_t>(g_heartbeat, max) {}
 scope_max_heartbeat::scope_max_heartbeat(size_t max):flet<size_t>(g_max_heartbeat, max) {}
 
-void check_heartbeat() {
-    inc_heartbeat();
+void add_heartbeats(size_t n) {
+    g_heartbeat += n;
     if (g_max_heartbeat > 0 && g_heartbeat > g_max_heartbeat)
         throw heartbeat_exception();
+    if (g_heartbeat_token != nullptr && g_heartbeat - g_heartbeat_flushed >= LEAN_HEARTBEAT_FLUSH_PERIOD) {
+        flush_heartbeat();
+        if (g_heartbeat_token->expired())
+            throw heartbeat_exception();
+    }
+}
+
+void check_heartbeat() {
+    add_heartbeats(1);
+}
+
+#define g_cancel_token (get_thread_ctx().m_cancel_token)
+
+cancel_token::cancel_token():m_rc(1), m_canceled(false) {}
+
+void cancel_token::inc_ref() {
+    m_rc.fetch_add(1, memory_order_relaxed);
+}
+
+void cancel_token::dec_ref() {
+    if (m_rc.fetch_sub(1, memory_order_acq_rel) == 1)
+        delete this;
+}
+
+cancel_token * get_cancel_token() { return g_cancel_token; }
+
+void set_cancel_token(cancel_token * t) {
+    if (t)
+        t->inc_ref();
+    if (g_cancel_token)
+        g_cancel_token->dec_ref();
+    g_cancel_token = t;
+}
+
+scope_cancel_token::scope_cancel_token(cancel_token * t):m_old(g_cancel_token) {
+    if (m_old)
+        m_old->inc_ref();
+    set_cancel_token(t);
+}
+
+scope_cancel_token::~scope_cancel_token() {
+    set_cancel_token(m_old);
+    if (m_old)
+        m_old->dec_ref();
 }
 
-LEAN_THREAD_VALUE(atomic_bool *, g_interrupt_flag, nullptr);
+#define g_interrupt_flag (get_thread_ctx().m_interrupt_flag)
 
 scoped_interrupt_flag::scoped_interrupt_flag(atomic_bool * flag) : flet(g_interrupt_flag, flag) {}
 
 static bool interrupt_requested() {
-    return g_interrupt_flag && g_interrupt_flag->load();
+    return (g_interrupt_flag && g_interrupt_flag->load()) ||
+           (g_cancel_token && g_cancel_token->canceled());
 }
 
 void check_interrupted() {
@@ -54,6 +175,13 @@ void check_system(char const * component_name) {
     check_heartbeat();
 }
 
+void check_system(char const * component_name, size_t heartbeats) {
+    check_stack(component_name);
+    check_memory(component_name);
+    check_interrupted();
+    add_heartbeats(heartbeats);
+}
+
 void sleep_for(unsigned ms, unsigned step_ms) {
     if (step_ms == 0)
         step_ms = 1;
@@ -37,6 +37,7 @@ Authors: Leonardo de Moura, Sebastian Ullrich
 #include <lean/io.h>
 #include <lean/utf8.h>
 #include <lean/object.h>
+#include <lean/timer.h>
 #include <lean/thread.h>
 #include <lean/allocprof.h>
 
@@ -72,6 +73,7 @@ extern "C" lean_object* lean_mk_io_error_time_expired(uint32_t, lean_object*);
 extern "C" lean_object* lean_mk_io_error_unsatisfied_constraints(uint32_t, lean_object*);
 extern "C" lean_object* lean_mk_io_error_unsupported_operation(uint32_t, lean_object*);
 
+extern "C" obj_res lean_sarray_ensure_capacity(obj_arg a, size_t min_cap, bool exact);
 
 extern "C" void lean_io_result_show_error(b_obj_arg r) {
     object * err = io_result_get_error(r);
@@ -171,6 +173,78 @@ static FILE * io_get_handle(lean_object * hfile) {
     return static_cast<FILE *>(lean_get_external_data(hfile));
 }
 
+/* Per-thread staging buffer for the process-wide stdout stream.
+
+   Writing through the libc stream directly serializes every `put_str` on the stream
+   lock and interleaves output from parallel tasks at the granularity of individual
+   writes. Instead we stage output in a thread-local buffer and publish it with a
+   single `fwrite` per complete line (or once the buffer grows past a threshold), so
+   concurrently produced messages stay coherent and threads contend on the stream
+   lock only once per message instead of once per write. */
+struct out_staging {
+    std::string m_out;
+    ~out_staging() {
+        // publish any partial line left behind when the thread exits
+        if (!m_out.empty()) std::fwrite(m_out.data(), 1, m_out.size(), stdout);
+    }
+};
+MK_THREAD_LOCAL_GET_DEF(out_staging, get_out_staging);
+
+static constexpr size_t g_out_staging_limit = 8 * 1024;
+
+/* Return this thread's staging buffer if `fp` is the process stdout, and `nullptr`
+   otherwise. Regular file handles are already buffered per handle by libc, and
+   stderr is exempt on purpose: it is unbuffered by convention, so diagnostics must
+   reach the fd immediately, in order with the runtime's direct `std::cerr` writes,
+   and must not be lost when the process aborts before the finalizers run. */
+static std::string * out_staging_buf(FILE * fp) {
+    if (fp == stdout) return &get_out_staging().m_out;
+    return nullptr;
+}
+
+/* Publish the first `n` staged bytes. A single `fwrite` takes the stream lock once,
+   so the published range cannot be interleaved with output from other threads. */
+static bool out_staging_publish(FILE * fp, std::string & buf, size_t n) {
+    bool ok = std::fwrite(buf.data(), 1, n, fp) == n;
+    buf.erase(0, n);
+    return ok;
+}
+
+/* Publish whatever the exiting thread has staged. Registered with `atexit` so a
+   trailing partial line is not lost when the program terminates via `exit`, which
+   bypasses the thread finalizer that normally drains the staging buffers. */
+static void out_staging_atexit() {
+    if (out_staging * s = get_out_staging_tlocal) {
+        if (!s->m_out.empty()) out_staging_publish(stdout, s->m_out, s->m_out.size());
+    }
+}
+
+/* Publish the calling thread's staged stdout bytes before a read from stdin blocks.
+   An interactive prompt is typically a partial line (`IO.print "...: "` followed by
+   `Handle.getLine`); libc line buffering would flush it when the tty read blocks,
+   but the staging buffer is invisible to that mechanism, so we drain it ourselves. */
+static void out_staging_drain_before_read(FILE * fp) {
+    if (fp != stdin) return;
+    if (out_staging * s = get_out_staging_tlocal) {
+        if (!s->m_out.empty()) {
+            out_staging_publish(stdout, s->m_out, s->m_out.size());
+            std::fflush(stdout);
+        }
+    }
+}
+
+static bool out_staging_write(FILE * fp, std::string & buf, char const * s, size_t n) {
+    buf.append(s, n);
+    // publish whole lines only so a message is never split across a flush; fall back
+    // to publishing everything when a single message outgrows the staging buffer
+    size_t nl = buf.rfind('\n');
+    if (nl != std::string::npos)
+        return out_staging_publish(fp, buf, nl + 1);
+    if (buf.size() >= g_out_staging_limit)
+        return out_staging_publish(fp, buf, buf.size());
+    return true;
+}
+
 obj_res decode_io_error(int errnum, b_obj_arg fname) {
     object * details = mk_string(strerror(errnum));
     switch (errnum) {
@@ -278,6 +352,9 @@ extern "C" obj_res lean_io_prim_handle_mk(b_obj_arg filename, b_obj_arg modeStr,
     if (!fp) {
         return io_result_mk_error(decode_io_error(errno, filename));
     } else {
+        /* Use a larger stream buffer than the libc default; code generation and log
+           writers issue millions of small writes through these handles. */
+        setvbuf(fp, nullptr, _IOFBF, 64 * 1024);
         return io_result_mk_ok(io_wrap_handle(fp));
     }
 }
@@ -291,6 +368,11 @@ extern "C" obj_res lean_io_prim_handle_is_eof(b_obj_arg h, obj_arg /* w */) {
 /* Handle.flush : (@& Handle) → IO Bool */
 extern "C" obj_res lean_io_prim_handle_flush(b_obj_arg h, obj_arg /* w */) {
     FILE * fp = io_get_handle(h);
+    if (std::string * buf = out_staging_buf(fp)) {
+        if (!buf->empty() && !out_staging_publish(fp, *buf, buf->size())) {
+            return io_result_mk_error(decode_io_error(errno, nullptr));
+        }
+    }
     if (!std::fflush(fp)) {
         return io_result_mk_ok(box(0));
     } else {
@@ -301,6 +383,7 @@ extern "C" obj_res lean_io_prim_handle_flush(b_obj_arg h, obj_arg /* w */) {
 /* Handle.read : (@& Handle) → USize → IO ByteArray */
 extern "C" obj_res lean_io_prim_handle_read(b_obj_arg h, usize nbytes, obj_arg /* w */) {
     FILE * fp = io_get_handle(h);
+    out_staging_drain_before_read(fp);
     if (feof(fp)) {
         return io_result_mk_ok(alloc_sarray(1, 0, 0));
     }
@@ -322,6 +405,13 @@ extern "C" obj_res lean_io_prim_handle_read(b_obj_arg h, usize nbytes, obj_arg /
 extern "C" obj_res lean_io_prim_handle_write(b_obj_arg h, b_obj_arg buf, obj_arg /* w */) {
     FILE * fp = io_get_handle(h);
     usize n = lean_sarray_size(buf);
+    if (std::string * stage = out_staging_buf(fp)) {
+        if (out_staging_write(fp, *stage, reinterpret_cast<char const *>(lean_sarray_cptr(buf)), n)) {
+            return io_result_mk_ok(box(0));
+        } else {
+            return io_result_mk_error(decode_io_error(errno, nullptr));
+        }
+    }
     usize m = std::fwrite(lean_sarray_cptr(buf), 1, n, fp);
     if (m == n) {
         return io_result_mk_ok(box(0));
@@ -339,6 +429,7 @@ static object * g_io_error_getline = nullptr;
   rest of the line is discarded. */
 extern "C" obj_res lean_io_prim_handle_get_line(b_obj_arg h, obj_arg /* w */) {
     FILE * fp = io_get_handle(h);
+    out_staging_drain_before_read(fp);
     if (feof(fp)) {
         return io_result_mk_ok(mk_string(""));
     }
@@ -370,13 +461,58 @@ extern "C" obj_res lean_io_prim_handle_get_line(b_obj_arg h, obj_arg /* w */) {
 /* Handle.putStr : (@& Handle) → (@& String) → IO Unit */
 extern "C" obj_res lean_io_prim_handle_put_str(b_obj_arg h, b_obj_arg s, obj_arg /* w */) {
     FILE * fp = io_get_handle(h);
-    if (std::fputs(lean_string_cstr(s), fp) != EOF) {
+    /* We know the byte size, so use fwrite instead of fputs and skip its strlen pass. */
+    usize n = lean_string_size(s) - 1;
+    if (std::string * stage = out_staging_buf(fp)) {
+        if (out_staging_write(fp, *stage, lean_string_cstr(s), n)) {
+            return io_result_mk_ok(box(0));
+        } else {
+            return io_result_mk_error(decode_io_error(errno, nullptr));
+        }
+    }
+    if (std::fwrite(lean_string_cstr(s), 1, n, fp) == n) {
         return io_result_mk_ok(box(0));
     } else {
         return io_result_mk_error(decode_io_error(errno, nullptr));
     }
 }
 
+/* readBinFile (fname : @& FilePath) : IO ByteArray */
+extern "C" obj_res lean_io_prim_read_bin_file(b_obj_arg fname, obj_arg /* w */) {
+    FILE * fp = fopen(lean_string_cstr(fname), "rb");
+    if (!fp) {
+        return io_result_mk_error(decode_io_error(errno, fname));
+    }
+    /* Size the result from the file metadata so regular files are read with a single
+       allocation and a single fread, instead of a chunked read/append loop. */
+    size_t sz = 0;
+    struct stat st;
+    if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        sz = static_cast<size_t>(st.st_size);
+    obj_res res = lean_alloc_sarray(1, 0, sz);
+    size_t n = std::fread(lean_sarray_cptr(res), 1, sz, fp);
+    lean_sarray_set_size(res, n);
+    /* Drain files that do not report a size (pipes, virtual filesystems) or that grew
+       since the fstat with the regular growth loop. */
+    while (true) {
+        size_t len = lean_sarray_size(res);
+        if (len == lean_sarray_capacity(res))
+            res = lean_sarray_ensure_capacity(res, len + 4096, /* exact */ false);
+        size_t m = std::fread(lean_sarray_cptr(res) + len, 1, lean_sarray_capacity(res) - len, fp);
+        if (m == 0)
+            break;
+        lean_sarray_set_size(res, len + m);
+    }
+    if (std::ferror(fp)) {
+        int ec = errno;
+        fclose(fp);
+        dec_ref(res);
+        return io_result_mk_error(decode_io_error(ec, fname));
+    }
+    fclose(fp);
+    return io_result_mk_ok(res);
+}
+
 /* monoMsNow : IO Nat */
 extern "C" obj_res lean_io_mono_ms_now(obj_arg /* w */) {
     auto now = std::chrono::steady_clock::now();
@@ -412,6 +548,18 @@ extern "C" obj_res lean_io_get_num_heartbeats(obj_arg /* w */) {
     return io_result_mk_ok(lean_uint64_to_nat(get_num_heartbeats()));
 }
 
+extern "C" obj_res lean_io_get_task_cpu_time(obj_arg /* w */) {
+    lean_task_stats s;
+    lean_get_task_stats(&s);
+    return io_result_mk_ok(lean_uint64_to_nat(s.cpu_time_ns));
+}
+
+extern "C" obj_res lean_io_get_task_alloc_bytes(obj_arg /* w */) {
+    lean_task_stats s;
+    lean_get_task_stats(&s);
+    return io_result_mk_ok(lean_uint64_to_nat(s.alloc_bytes));
+}
+
 extern "C" obj_res lean_io_getenv(b_obj_arg env_var, obj_arg) {
 #if defined(LEAN_EMSCRIPTEN)
     // HACK(WN): getenv doesn't seem to work in Emscripten even though it should
@@ -504,6 +652,70 @@ extern "C" obj_res lean_io_read_dir(b_obj_arg dirname, obj_arg) {
     return io_result_mk_ok(arr);
 }
 
+/*
+constant readDirWithFileType : @& FilePath → IO (Array (IO.FS.DirEntry × IO.FS.FileType))
+
+Takes the entry type from the directory enumeration itself (`d_type`) where the
+filesystem provides it, so a tree walk does not need a `stat` call per entry; only
+entries reported as unknown fall back to one `stat`. The `FileType` encoding matches
+`lean_io_metadata`. */
+extern "C" obj_res lean_io_read_dir_with_file_type(b_obj_arg dirname, obj_arg) {
+    object * arr = array_mk_empty();
+    DIR * dp = opendir(string_cstr(dirname));
+    if (!dp) {
+        return io_result_mk_error(decode_io_error(errno, dirname));
+    }
+    while (dirent * entry = readdir(dp)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        uint8 ty = 4; /* not reported; resolved below */
+#if defined(DT_UNKNOWN)
+        switch (entry->d_type) {
+        case DT_DIR:     ty = 0; break;
+        case DT_REG:     ty = 1; break;
+        case DT_LNK:     ty = 2; break;
+        case DT_UNKNOWN: break;
+        default:         ty = 3; break;
+        }
+#endif
+        if (ty == 4) {
+            std::string full(string_cstr(dirname));
+#if defined(LEAN_WINDOWS)
+            full += '\\';
+#else
+            full += '/';
+#endif
+            full += entry->d_name;
+            struct stat st;
+#if defined(LEAN_WINDOWS)
+            if (stat(full.c_str(), &st) == 0) {
+#else
+            if (lstat(full.c_str(), &st) == 0) {
+#endif
+                ty = S_ISDIR(st.st_mode) ? 0 :
+                     S_ISREG(st.st_mode) ? 1 :
+#ifndef LEAN_WINDOWS
+                     S_ISLNK(st.st_mode) ? 2 :
+#endif
+                     3;
+            } else {
+                ty = 3;
+            }
+        }
+        object * lentry = alloc_cnstr(0, 2, 0);
+        lean_inc(dirname);
+        cnstr_set(lentry, 0, dirname);
+        cnstr_set(lentry, 1, lean_mk_string(entry->d_name));
+        object * pair = alloc_cnstr(0, 2, 0);
+        cnstr_set(pair, 0, lentry);
+        cnstr_set(pair, 1, box(ty));
+        arr = lean_array_push(arr, pair);
+    }
+    lean_always_assert(closedir(dp) == 0);
+    return io_result_mk_ok(arr);
+}
+
 /*
 inductive FileType where
   | dir
@@ -779,6 +991,15 @@ extern "C" obj_res lean_io_as_task(obj_arg act, obj_arg prio, obj_arg) {
     return io_result_mk_ok(t);
 }
 
+/* Like `lean_io_as_task`, for actions that block on I/O: the task runs on the
+   blocking-I/O pool and leaves the CPU workers to compute-bound tasks. */
+extern "C" obj_res lean_io_as_blocking_task(obj_arg act, obj_arg) {
+    object * c = lean_alloc_closure((void*)lean_io_as_task_fn, 2, 1);
+    lean_closure_set(c, 0, act);
+    object * t = lean_task_spawn_blocking_core(c, /* keep_alive */ true);
+    return io_result_mk_ok(t);
+}
+
 static obj_res lean_io_map_task_fn(obj_arg f, obj_arg a) {
     object_ref r(apply_2(f, a, io_mk_world()));
     if (io_result_is_ok(r.raw())) {
@@ -822,6 +1043,34 @@ extern "C" obj_res lean_io_cancel(b_obj_arg t, obj_arg) {
     return io_result_mk_ok(box(0));
 }
 
+extern "C" obj_res lean_io_cancel_token_new(obj_arg) {
+    return io_result_mk_ok(lean_io_cancel_token_new_core());
+}
+
+extern "C" obj_res lean_io_cancel_token_cancel(b_obj_arg tk, obj_arg) {
+    lean_io_cancel_token_cancel_core(tk);
+    return io_result_mk_ok(box(0));
+}
+
+extern "C" obj_res lean_io_cancel_token_is_canceled(b_obj_arg tk, obj_arg) {
+    return io_result_mk_ok(box(lean_io_cancel_token_is_canceled_core(tk)));
+}
+
+extern "C" obj_res lean_io_cancel_token_set_current(b_obj_arg tk, obj_arg) {
+    lean_io_cancel_token_set_current_core(tk);
+    return io_result_mk_ok(box(0));
+}
+
+/* Arm a fire-and-forget deadline: `tk` is cancelled after `ms` milliseconds.
+   Combined with task-tree token inheritance this gives every request a
+   timeout that stops its whole subtree. */
+extern "C" obj_res lean_io_cancel_token_cancel_after(b_obj_arg tk, obj_arg ms, obj_arg) {
+    cancel_token * t = static_cast<cancel_token*>(lean_get_external_data(tk));
+    if (timer_event * e = set_timer(t, lean_unbox(ms)))
+        release_timer(e);
+    return io_result_mk_ok(box(0));
+}
+
 extern "C" obj_res lean_io_has_finished(b_obj_arg t, obj_arg) {
     return io_result_mk_ok(box(lean_io_has_finished_core(t)));
 }
@@ -847,6 +1096,7 @@ void initialize_io() {
     g_io_error_getline = mk_io_user_error(mk_string("getLine failed"));
     mark_persistent(g_io_error_getline);
     g_io_handle_external_class = lean_register_external_class(io_handle_finalizer, io_handle_foreach);
+    atexit(out_staging_atexit);
 #if defined(LEAN_WINDOWS)
     _setmode(_fileno(stdout), _O_BINARY);
     _setmode(_fileno(stderr), _O_BINARY);
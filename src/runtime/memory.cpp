@@ -10,6 +10,7 @@ Author: Leonardo de Moura
 #include <lean/exception.h>
 #include <lean/memory.h>
 #include <lean/thread.h>
+#include <lean/alloc.h>
 
 #ifndef LEAN_CHECK_MEM_THRESHOLD
 #define LEAN_CHECK_MEM_THRESHOLD 200
@@ -112,20 +113,49 @@ size_t get_current_rss() {
 
 namespace lean {
 static size_t g_max_memory = 0;
-LEAN_THREAD_VALUE(size_t, g_counter, 0);
+/* sampling counter in the consolidated `thread_ctx` TLS block */
+#define g_counter (get_thread_ctx().m_memory_counter)
 
 void set_max_memory(size_t max) {
     g_max_memory = max;
 }
 
+/* Default the budget from the environment (value in MB) so containerized runs
+   can impose one without touching the command line of every child. An
+   explicit `set_max_memory` (e.g. from the `-M` option) overrides it. */
+static struct max_memory_from_env {
+    max_memory_from_env() {
+        if (char const * v = getenv("LEAN_MAX_MEMORY"))
+            set_max_memory_megabyte(atoi(v));
+    }
+} g_max_memory_from_env;
+
 void set_max_memory_megabyte(unsigned max) {
     size_t m = max;
     m *= 1024 * 1024;
     set_max_memory(m);
 }
 
+/* Raise the catchable out-of-memory exception, printing the heap census to
+   stderr on the way out so a breached budget leaves diagnostics instead of
+   the silence of a later OOM-kill. The census is printed only once per
+   process: with a shared budget many tasks typically fail in quick
+   succession, and they would all report the same heap. */
+static void report_memory_budget_breach(char const * component_name) {
+    static atomic_bool g_census_reported(false);
+    if (!g_census_reported.exchange(true)) {
+        std::cerr << "maximum memory exceeded while executing " << component_name << "\n";
+        display_heap_census(std::cerr);
+    }
+    throw memory_exception(component_name);
+}
+
 void check_memory(char const * component_name) {
     if (g_max_memory == 0) return;
+    /* Segment bytes are maintained by the allocator and cost one load to
+       read, so heap growth is checked on every call rather than sampled. */
+    if (get_segment_bytes() > g_max_memory)
+        report_memory_budget_breach(component_name);
     g_counter++;
     if (g_counter >= LEAN_CHECK_MEM_THRESHOLD) {
         g_counter = 0;
@@ -135,7 +165,7 @@ void check_memory(char const * component_name) {
         if (r > 0 && r < g_max_memory) return;
         r = get_current_rss();
         if (r == 0 || r < g_max_memory) return;
-        throw memory_exception(component_name);
+        report_memory_budget_breach(component_name);
     }
 }
 
@@ -6,11 +6,45 @@ Author: Leonardo de Moura
 */
 #include <memory>
 #include <string>
+#include <cstring>
+#include <vector>
 #include <lean/sstream.h>
 #include <lean/thread.h>
+#include <lean/alloc.h>
 #include <lean/mpz.h>
 
 namespace lean {
+/* GMP memory hooks.
+
+   Bignum-heavy workloads allocate and free huge numbers of tiny limb buffers;
+   routing them through the Lean small-object heap avoids the system
+   allocator's global lock and its per-call overhead. GMP passes the old size
+   to its free/realloc hooks, which matches the `dealloc(ptr, sz)` interface
+   exactly. Limb buffers may be freed from a different thread than the one
+   that allocated them; the heap's cross-thread deallocation path handles
+   that. */
+static void * mpz_limb_alloc(size_t sz) {
+    return alloc(sz);
+}
+
+static void * mpz_limb_realloc(void * p, size_t old_sz, size_t new_sz) {
+    void * r = alloc(new_sz);
+    memcpy(r, p, old_sz < new_sz ? old_sz : new_sz);
+    dealloc(p, old_sz);
+    return r;
+}
+
+static void mpz_limb_free(void * p, size_t sz) {
+    dealloc(p, sz);
+}
+
+void initialize_mpz() {
+    mp_set_memory_functions(mpz_limb_alloc, mpz_limb_realloc, mpz_limb_free);
+}
+
+void finalize_mpz() {
+}
+
 mpz::mpz(uint64 v):
     mpz(static_cast<unsigned>(v)) {
     mpz tmp(static_cast<unsigned>(v >> 32));
@@ -79,16 +113,57 @@ bool root(mpz & root, mpz const & a, unsigned k) {
     return rem.is_zero();
 }
 
+/* Decimal conversion.
+
+   GMP's `mpz_get_str` already switches to a subquadratic divide-and-conquer
+   algorithm for large operands, but each call here paid for a fresh heap
+   buffer, and for the two-limb values that dominate in practice (counters and
+   hashes that just left the scalar range) the generic entry point is
+   overkill. We keep a per-thread scratch buffer so conversion stops hitting
+   the allocator after warm-up, and convert values below 2^128 with plain
+   integer division without entering GMP at all. */
+MK_THREAD_LOCAL_GET_DEF(std::vector<char>, get_str_scratch);
+
+#ifdef LEAN_MPZ_U128
+/* Write the decimal digits of \c n ending just before \c end, and return a
+   pointer to the first digit. \c end must have at least 39 bytes of headroom. */
+static char * u128_to_digits(unsigned __int128 n, char * end) {
+    char * p = end;
+    do {
+        *--p = static_cast<char>('0' + static_cast<unsigned>(n % 10));
+        n /= 10;
+    } while (n != 0);
+    return p;
+}
+#endif
+
 void display(std::ostream & out, __mpz_struct const * v) {
+#ifdef LEAN_MPZ_U128
+    int limbs = v->_mp_size;
+    if (limbs >= -2 && limbs <= 2) {
+        int n = limbs < 0 ? -limbs : limbs;
+        uint64 lo = n >= 1 ? v->_mp_d[0] : 0;
+        uint64 hi = n == 2 ? v->_mp_d[1] : 0;
+        char buffer[40]; // up to 39 digits plus a sign
+        char * end = buffer + sizeof(buffer);
+        char * p   = u128_to_digits((static_cast<unsigned __int128>(hi) << 64) | lo, end);
+        if (limbs < 0)
+            *--p = '-';
+        out.write(p, end - p);
+        return;
+    }
+#endif
     size_t sz = mpz_sizeinbase(v, 10) + 2;
     if (sz < 1024) {
         char buffer[1024];
         mpz_get_str(buffer, 10, v);
         out << buffer;
     } else {
-        std::unique_ptr<char> buffer(new char[sz]);
-        mpz_get_str(buffer.get(), 10, v);
-        out << buffer.get();
+        std::vector<char> & buffer = get_str_scratch();
+        if (buffer.size() < sz)
+            buffer.resize(sz);
+        mpz_get_str(buffer.data(), 10, v);
+        out << buffer.data();
     }
 }
 
@@ -7,8 +7,10 @@ Author: Leonardo de Moura
 #include <string>
 #include <algorithm>
 #include <vector>
+#include <memory>
 #include <deque>
 #include <cmath>
+#include <climits>
 #include <lean/object.h>
 #include <lean/mpq.h>
 #include <lean/thread.h>
@@ -18,10 +20,29 @@ Author: Leonardo de Moura
 #include <lean/hash.h>
 #include <lean/flet.h>
 #include <lean/interrupt.h>
+#include <unordered_map>
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__linux__) || defined(__APPLE__)
+#include <dlfcn.h>
+#endif
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define LEAN_SCAN_SSE2
+#include <emmintrin.h>
+#endif
 #include "util/buffer.h" // move to runtime
 
 // see `Task.Priority.max`
 #define LEAN_MAX_PRIO 8
+/* Cap on the elastic blocking-I/O worker pool; workers past the demand
+   park and exit after this idle period. */
+#define LEAN_MAX_IO_WORKERS 64
+#define LEAN_IO_WORKER_IDLE_MS 1000
+/* Number of ready dependents a worker may run inline after finishing a task
+   before going back to the scheduler (see run_task). */
+#define LEAN_TASK_FUSE_BUDGET 16
 
 namespace lean {
 extern "C" void lean_internal_panic(char const * msg) {
@@ -234,20 +255,184 @@ static void lean_del_core(object * o, object * & todo) {
     }
 }
 
+/* Incremental deletion.
+
+   When a slice budget is set, `lean_del` frees at most that many objects
+   synchronously and hands the rest of the todo list to a background
+   reclamation thread, so dropping a huge imported environment never stalls a
+   request thread for seconds. The background thread frees in bounded slices
+   as well, yielding in between, to stay out of the way of real work. */
+#if defined(LEAN_MULTI_THREAD)
+static size_t             g_del_slice = 0; /* 0: fully synchronous deletion (default) */
+static mutex *            g_del_mutex = nullptr;
+static condition_variable g_del_cv;
+static object *           g_del_queue = nullptr;
+static bool               g_del_shutdown = false;
+static lthread *          g_del_thread = nullptr;
+
+static void del_worker() {
+    save_stack_info(false);
+    unique_lock<mutex> lock(*g_del_mutex);
+    while (true) {
+        while (g_del_queue == nullptr && !g_del_shutdown)
+            g_del_cv.wait(lock);
+        if (g_del_queue == nullptr && g_del_shutdown)
+            return;
+        object * todo = g_del_queue;
+        g_del_queue = nullptr;
+        lock.unlock();
+        size_t slice = g_del_slice == 0 ? 1024 : g_del_slice;
+        size_t n     = 0;
+        while (todo != nullptr) {
+            object * o = pop_back(todo);
+            lean_del_core(o, todo);
+            if (++n == slice) {
+                n = 0;
+                this_thread::yield();
+            }
+        }
+        lock.lock();
+    }
+}
+
+static void defer_del(object * todo) {
+    lock_guard<mutex> lock(*g_del_mutex);
+    /* splice `todo` onto the queue */
+    object * last = todo;
+    while (object * n = get_next(last))
+        last = n;
+    set_next(last, g_del_queue);
+    g_del_queue = todo;
+    g_del_cv.notify_one();
+}
+
+extern "C" void lean_set_del_slice(size_t max_objs) {
+    if (max_objs != 0 && g_del_thread == nullptr) {
+        g_del_mutex  = new mutex();
+        g_del_thread = new lthread(del_worker);
+    }
+    g_del_slice = max_objs;
+}
+#else
+extern "C" void lean_set_del_slice(size_t) {}
+#endif
+
 extern "C" void lean_del(object * o) {
 #ifdef LEAN_LAZY_RC
     push_back(g_to_free, o);
 #else
     object * todo = nullptr;
+#if defined(LEAN_MULTI_THREAD)
+    size_t budget = g_del_slice;
+#endif
     while (true) {
         lean_del_core(o, todo);
         if (todo == nullptr)
             return;
+#if defined(LEAN_MULTI_THREAD)
+        if (LEAN_UNLIKELY(budget != 0) && --budget == 0) {
+            defer_del(todo);
+            return;
+        }
+#endif
         o = pop_back(todo);
     }
 #endif
 }
 
+#ifdef LEAN_DEFERRED_RC
+/* Number of slots; power of two. Flushed at 3/4 load so probe chains stay short. */
+#define LEAN_RC_LOG_SIZE 1024
+
+/* Per-thread table of pending decrements for multi-threaded objects, keyed by
+   pointer identity. A thread that is effectively the sole owner of a shared
+   object runs all of its RC churn against its private entry — increments cancel
+   pending decrements — and the shared counter is only touched when the log is
+   flushed, giving the owner-thread fast path of biased RC without storing an
+   owner hint in the (packed) object header. */
+struct rc_log_entry { object * m_obj{nullptr}; size_t m_decs{0}; };
+struct rc_log {
+    rc_log_entry m_entries[LEAN_RC_LOG_SIZE];
+    unsigned     m_used{0};
+
+    rc_log_entry & find(object * o) {
+        size_t i = (reinterpret_cast<size_t>(o) >> 4) & (LEAN_RC_LOG_SIZE - 1);
+        while (m_entries[i].m_obj != nullptr && m_entries[i].m_obj != o)
+            i = (i + 1) & (LEAN_RC_LOG_SIZE - 1);
+        return m_entries[i];
+    }
+};
+LEAN_THREAD_PTR(rc_log, g_rc_log);
+
+static void flush_rc_log(rc_log * log) {
+    for (rc_log_entry & e : log->m_entries) {
+        if (e.m_obj == nullptr)
+            continue;
+        if (e.m_decs > 0) {
+            LEAN_USING_STD;
+            size_t old = atomic_fetch_sub_explicit(lean_get_rc_mt_addr(e.m_obj), e.m_decs, memory_order_acq_rel);
+#if defined(LEAN_COMPRESSED_OBJECT_HEADER) || defined(LEAN_COMPRESSED_OBJECT_HEADER_SMALL_RC)
+            bool dead = (old & ((1ull << LEAN_RC_NBITS) - 1)) == e.m_decs;
+#else
+            bool dead = old == e.m_decs;
+#endif
+            if (dead)
+                lean_del(e.m_obj);
+        }
+        e.m_obj  = nullptr;
+        e.m_decs = 0;
+    }
+    log->m_used = 0;
+}
+
+static void finalize_rc_log(void * _log) {
+    rc_log * log = static_cast<rc_log*>(_log);
+    flush_rc_log(log);
+    delete log;
+    g_rc_log = nullptr;
+}
+
+extern "C" void lean_deferred_dec(object * o) {
+    rc_log * log = g_rc_log;
+    if (LEAN_UNLIKELY(log == nullptr)) {
+        log = new rc_log();
+        g_rc_log = log;
+        register_thread_finalizer(finalize_rc_log, log);
+    }
+    rc_log_entry & e = log->find(o);
+    if (e.m_obj == nullptr) {
+        e.m_obj = o;
+        log->m_used++;
+    }
+    e.m_decs++;
+    if (LEAN_UNLIKELY(log->m_used >= LEAN_RC_LOG_SIZE / 4 * 3))
+        flush_rc_log(log);
+}
+
+extern "C" void lean_deferred_inc(object * o) {
+    /* An increment may only cancel a decrement this thread has not published
+       yet: a pending dec means the shared count is higher than the true count,
+       so netting them out keeps the shared count >= the true count at every
+       instant. Deferring the increment itself would not be sound — another
+       thread could drop the count to zero before the flush. */
+    rc_log * log = g_rc_log;
+    if (log != nullptr) {
+        rc_log_entry & e = log->find(o);
+        if (e.m_obj != nullptr && e.m_decs > 0) {
+            e.m_decs--;
+            return;
+        }
+    }
+    LEAN_USING_STD;
+    atomic_fetch_add_explicit(lean_get_rc_mt_addr(o), (size_t)1, memory_order_relaxed);
+}
+
+extern "C" void lean_rc_log_flush() {
+    if (g_rc_log)
+        flush_rc_log(g_rc_log);
+}
+#endif
+
 // =======================================
 // Closures
 
@@ -295,6 +480,88 @@ extern "C" lean_obj_res lean_array_set_panic(lean_obj_arg a, lean_obj_arg v) {
     return lean_panic_fn(a, lean_mk_string("Error: index out of bounds"));
 }
 
+// =======================================
+// Address-based waiting
+
+/* Mini "parking lot": threads waiting for a memory slot to change (an
+   unevaluated thunk or an unfinished task result) park on a futex word picked
+   by hashing the slot's address, and the publisher issues a single wake-all.
+   Wakers only enter the kernel when the bucket shows parked waiters, so
+   publishing a result stays syscall-free in the common uncontended case.
+   Without futexes the buckets fall back to a mutex/condvar pair. */
+
+#if defined(__linux__) && defined(SYS_futex)
+#define LEAN_FUTEX
+#endif
+
+#define LEAN_PARK_BUCKETS 256
+
+struct park_bucket {
+    atomic<uint32_t> m_epoch{0};
+    atomic<uint32_t> m_waiters{0};
+#ifndef LEAN_FUTEX
+    mutex              m_mutex;
+    condition_variable m_cv;
+#endif
+};
+
+static park_bucket g_park_buckets[LEAN_PARK_BUCKETS];
+
+static park_bucket & park_bucket_of(void const * addr) {
+    size_t h = reinterpret_cast<size_t>(addr) >> 4;
+    return g_park_buckets[(h ^ (h >> 8)) % LEAN_PARK_BUCKETS];
+}
+
+#ifdef LEAN_FUTEX
+static void park_futex_wait(atomic<uint32_t> * w, uint32_t expected) {
+    /* FUTEX_WAIT | FUTEX_PRIVATE_FLAG */
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(w), 0 | 128, expected, nullptr, nullptr, 0);
+}
+
+static void park_futex_wake_all(atomic<uint32_t> * w) {
+    /* FUTEX_WAKE | FUTEX_PRIVATE_FLAG */
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(w), 1 | 128, INT_MAX, nullptr, nullptr, 0);
+}
+#endif
+
+/* Block until `pred()` holds; `addr` must be the slot `pred` reads, and the
+   publisher must call `park_wake_all(addr)` after making `pred` true. The
+   epoch word rules out the lost-wakeup race: a publication between the `pred`
+   check and the wait bumps the epoch, so the wait returns immediately. */
+template<typename Pred>
+static void park_wait(void const * addr, Pred const & pred) {
+    park_bucket & b = park_bucket_of(addr);
+    while (true) {
+        uint32_t epoch = b.m_epoch.load();
+        if (pred())
+            return;
+        b.m_waiters.fetch_add(1);
+#ifdef LEAN_FUTEX
+        park_futex_wait(&b.m_epoch, epoch);
+#else
+        {
+            unique_lock<mutex> lock(b.m_mutex);
+            if (b.m_epoch.load() == epoch)
+                b.m_cv.wait(lock);
+        }
+#endif
+        b.m_waiters.fetch_sub(1);
+    }
+}
+
+static void park_wake_all(void const * addr) {
+    park_bucket & b = park_bucket_of(addr);
+    b.m_epoch.fetch_add(1);
+    if (b.m_waiters.load() == 0)
+        return;
+#ifdef LEAN_FUTEX
+    park_futex_wake_all(&b.m_epoch);
+#else
+    { lock_guard<mutex> lock(b.m_mutex); }
+    b.m_cv.notify_all();
+#endif
+}
+
 // =======================================
 // Thunks
 
@@ -313,15 +580,15 @@ extern "C" b_obj_res lean_thunk_get_core(b_obj_arg t) {
         lean_assert(lean_to_thunk(t)->m_value == nullptr);
         mark_mt(r);
         lean_to_thunk(t)->m_value = r;
+        park_wake_all(&lean_to_thunk(t)->m_value);
         return r;
     } else {
         lean_assert(c == nullptr);
-        /* There is another thread executing the closure. We keep waiting for the m_value to be
-           set by another thread. */
-        while (!lean_to_thunk(t)->m_value) {
-            this_thread::yield();
-        }
-        return lean_to_thunk(t)->m_value;
+        /* There is another thread executing the closure; park until it
+           publishes `m_value`. */
+        lean_thunk_object * th = lean_to_thunk(t);
+        park_wait(&th->m_value, [&]() { return th->m_value != nullptr; });
+        return th->m_value;
     }
 }
 
@@ -526,18 +793,10 @@ static obj_res mark_mt_fn(obj_arg o) {
     return lean_box(0);
 }
 
-extern "C" void lean_mark_mt(object * o) {
-#ifndef LEAN_MULTI_THREAD
-    return;
-#endif
-    if (lean_is_scalar(o) || !lean_is_st(o)) return;
-
-    buffer<object*> todo;
-    todo.push_back(o);
-    while (!todo.empty()) {
-        object * o = todo.back();
-        todo.pop_back();
-        if (!lean_is_scalar(o) && lean_is_st(o)) {
+/* Mark `o` as multi-threaded and push its children onto `todo`.
+   Shared step of the sequential and parallel traversals below. */
+static void mark_mt_one(object * o, buffer<object*> & todo) {
+    if (!lean_is_scalar(o) && lean_is_st(o)) {
 #if defined(LEAN_COMPRESSED_OBJECT_HEADER)
             o->m_header &= ~(1ull << LEAN_ST_BIT);
             o->m_header |=  (1ull << LEAN_MT_BIT);
@@ -591,27 +850,152 @@ extern "C" void lean_mark_mt(object * o) {
                 }
             }
         }
+}
+
+extern "C" void lean_mark_mt(object * o) {
+#ifndef LEAN_MULTI_THREAD
+    return;
+#endif
+    if (lean_is_scalar(o) || !lean_is_st(o)) return;
+
+    buffer<object*> todo;
+    todo.push_back(o);
+    while (!todo.empty()) {
+        object * o = todo.back();
+        todo.pop_back();
+        mark_mt_one(o, todo);
+    }
+}
+
+#if defined(LEAN_MULTI_THREAD)
+/* Parallel mark-multi-threaded traversal.
+
+   Workers pull batches off a shared stack and expand them locally, donating
+   half of an oversized local stack back to keep everybody busy. The header
+   update in mark_mt_one is idempotent, and while an object graph is being
+   published to other threads nobody else is mutating its RC fields yet, so a
+   rare duplicate visit is benign. */
+struct mark_mt_ctx {
+    mutex              m_mutex;
+    condition_variable m_cv;
+    buffer<object*>    m_todo;
+    unsigned           m_active{0};
+};
+
+static void mark_mt_worker(mark_mt_ctx * ctx) {
+    buffer<object*> local;
+    unique_lock<mutex> lock(ctx->m_mutex);
+    while (true) {
+        if (ctx->m_todo.empty()) {
+            if (ctx->m_active == 0) {
+                ctx->m_cv.notify_all();
+                return;
+            }
+            ctx->m_cv.wait(lock);
+            continue;
+        }
+        unsigned batch = ctx->m_todo.size() < 128 ? ctx->m_todo.size() : 128;
+        for (unsigned i = 0; i < batch; i++) {
+            local.push_back(ctx->m_todo.back());
+            ctx->m_todo.pop_back();
+        }
+        ctx->m_active++;
+        lock.unlock();
+        while (!local.empty()) {
+            object * o = local.back();
+            local.pop_back();
+            mark_mt_one(o, local);
+            if (local.size() > 512) {
+                /* donate half back to the shared stack */
+                lock.lock();
+                for (unsigned i = 0; i < 256; i++) {
+                    ctx->m_todo.push_back(local.back());
+                    local.pop_back();
+                }
+                ctx->m_cv.notify_all();
+                lock.unlock();
+            }
+        }
+        lock.lock();
+        ctx->m_active--;
+        if (ctx->m_todo.empty() && ctx->m_active == 0)
+            ctx->m_cv.notify_all();
     }
 }
+#endif
+
+extern "C" void lean_mark_mt_parallel(object * o, unsigned num_workers) {
+#if defined(LEAN_MULTI_THREAD)
+    if (lean_is_scalar(o) || !lean_is_st(o)) return;
+    if (num_workers <= 1) return lean_mark_mt(o);
+    mark_mt_ctx ctx;
+    ctx.m_todo.push_back(o);
+    std::vector<std::unique_ptr<lthread>> helpers;
+    for (unsigned i = 0; i + 1 < num_workers; i++)
+        helpers.push_back(std::unique_ptr<lthread>(new lthread([&ctx]() { mark_mt_worker(&ctx); })));
+    mark_mt_worker(&ctx);
+    for (auto & h : helpers) h->join();
+#else
+    (void) o; (void) num_workers;
+#endif
+}
 
 // =======================================
 // Tasks
 
-LEAN_THREAD_PTR(lean_task_object, g_current_task_object);
+/* Stored untyped in the consolidated `thread_ctx` TLS block; see lean/thread.h. */
+#define g_current_task_object (reinterpret_cast<lean_task_object * &>(get_thread_ctx().m_current_task))
 
-static lean_task_imp * alloc_task_imp(obj_arg c, unsigned prio, bool keep_alive) {
+/* Totals folded in when a task finishes; see lean_get_task_stats. */
+static atomic<uint64_t> g_tasks_finished(0);
+static atomic<uint64_t> g_task_cpu_time_ns(0);
+static atomic<uint64_t> g_task_alloc_bytes(0);
+
+static uint64_t thread_cpu_time_ns() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#else
+    /* No thread CPU clock: fall back to wall time, which still orders tasks
+       usefully on an uncontended machine. */
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static lean_task_imp * alloc_task_imp(obj_arg c, unsigned prio, bool keep_alive, unsigned group) {
     lean_task_imp * imp = (lean_task_imp*)lean_alloc_small_object(sizeof(lean_task_imp));
     imp->m_closure     = c;
     imp->m_head_dep    = nullptr;
     imp->m_next_dep    = nullptr;
     imp->m_prio        = prio;
+    imp->m_group       = group;
     imp->m_canceled    = false;
     imp->m_keep_alive  = keep_alive;
     imp->m_deleted     = false;
+    imp->m_blocking    = false;
+    imp->m_cpu_time_ns = 0;
+    imp->m_alloc_bytes = 0;
+    if (heartbeat_token * hb = get_heartbeat_token()) {
+        hb->inc_ref();
+        imp->m_heartbeat = hb;
+    } else {
+        imp->m_heartbeat = nullptr;
+    }
+    if (cancel_token * ct = get_cancel_token()) {
+        ct->inc_ref();
+        imp->m_cancel = ct;
+    } else {
+        imp->m_cancel = nullptr;
+    }
     return imp;
 }
 
 static void free_task_imp(lean_task_imp * imp) {
+    if (imp->m_heartbeat)
+        static_cast<heartbeat_token*>(imp->m_heartbeat)->dec_ref();
+    if (imp->m_cancel)
+        static_cast<cancel_token*>(imp->m_cancel)->dec_ref();
     lean_free_small_object((lean_object*)imp);
 }
 
@@ -624,15 +1008,217 @@ struct scoped_current_task_object : flet<lean_task_object *> {
     scoped_current_task_object(lean_task_object * t):flet(g_current_task_object, t) {}
 };
 
+/* Fixed-size Chase-Lev work-stealing deque. The owning worker pushes and pops
+   at the bottom; thieves steal from the top with a CAS. A full deque makes the
+   producer fall back to the global injector queue. */
+#define LEAN_WORK_DEQUE_SIZE 1024 /* must be a power of two */
+
+struct work_deque {
+    atomic<size_t>             m_top{0};
+    atomic<size_t>             m_bottom{0};
+    atomic<lean_task_object *> m_tasks[LEAN_WORK_DEQUE_SIZE];
+
+    work_deque() {
+        for (unsigned i = 0; i < LEAN_WORK_DEQUE_SIZE; i++)
+            m_tasks[i].store(nullptr, memory_order_relaxed);
+    }
+
+    /* Owner only. Returns false when the deque is full. */
+    bool push(lean_task_object * t) {
+        size_t b   = m_bottom.load(memory_order_relaxed);
+        size_t top = m_top.load(memory_order_acquire);
+        if (b - top >= LEAN_WORK_DEQUE_SIZE)
+            return false;
+        m_tasks[b % LEAN_WORK_DEQUE_SIZE].store(t, memory_order_relaxed);
+        m_bottom.store(b + 1, memory_order_release);
+        return true;
+    }
+
+    /* Owner only. */
+    lean_task_object * pop() {
+        size_t b   = m_bottom.load(memory_order_relaxed);
+        size_t top = m_top.load(memory_order_relaxed);
+        if (b == top)
+            return nullptr; /* `m_top` never exceeds `m_bottom`, so the deque is empty */
+        b = b - 1;
+        m_bottom.store(b, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        top = m_top.load(memory_order_relaxed);
+        lean_task_object * r;
+        if (top <= b) {
+            r = m_tasks[b % LEAN_WORK_DEQUE_SIZE].load(memory_order_relaxed);
+            if (top == b) {
+                /* last element: race against thieves for it */
+                if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+                    r = nullptr;
+                m_bottom.store(b + 1, memory_order_relaxed);
+            }
+        } else {
+            r = nullptr;
+            m_bottom.store(b + 1, memory_order_relaxed);
+        }
+        return r;
+    }
+
+    /* Any thread. Returns nullptr when the deque looks empty or the CAS is
+       lost to a concurrent thief; callers just move on to the next victim. */
+    lean_task_object * steal() {
+        size_t top = m_top.load(memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        size_t b   = m_bottom.load(memory_order_acquire);
+        if (top >= b)
+            return nullptr;
+        lean_task_object * r = m_tasks[top % LEAN_WORK_DEQUE_SIZE].load(memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+            return nullptr;
+        return r;
+    }
+};
+
+/* Per-worker scheduler state. The inbox is a lock-free (Treiber) stack fed by
+   other threads routing affinity-group tasks to this worker; only the owner
+   drains it wholesale. Inbox links reuse `m_next_dep`, which is unused while
+   a task is queued for execution. */
+struct worker_state {
+    work_deque                 m_deque;
+    atomic<lean_task_object *> m_inbox{nullptr};
+};
+
+/* Deque of the std worker running on this thread, or nullptr on non-worker
+   and dedicated-worker threads. */
+LEAN_THREAD_PTR(work_deque, g_worker_deque);
+
+#if defined(LEAN_MULTI_THREAD)
+/* Sampling wall-clock profiler (`LEAN_SAMPLING_PROFILER=<file>`). Attaching an
+   external profiler is often impossible in containers (no perf privileges), so
+   the task manager can sample itself: each worker publishes the entry function
+   of the closure it is currently executing in a registered slot, and a timer
+   thread periodically reads the slots and counts what it sees. Only the pointer
+   value is read -- never the (possibly freed) closure object -- so the slots
+   are race-free by construction. At shutdown the counts are written one
+   `symbol count` line per function (resolved via dladdr where possible, raw
+   address otherwise) in the collapsed-stack format flamegraph tools consume.
+   `LEAN_SAMPLING_INTERVAL` overrides the default 10ms sampling period. */
+struct sampler_slot {
+    atomic<void *> m_fn{nullptr};
+};
+
+class sampling_profiler {
+    mutex                                m_mutex;
+    condition_variable                   m_cv;
+    std::vector<sampler_slot *>          m_slots;
+    std::unordered_map<void *, uint64_t> m_counts;
+    bool                                 m_stop{false};
+    std::string                          m_out;
+    unsigned                             m_interval_ms{10};
+    std::unique_ptr<lthread>             m_thread;
+
+    void loop() {
+        unique_lock<mutex> lock(m_mutex);
+        while (!m_stop) {
+            m_cv.wait_for(lock, chrono::milliseconds(m_interval_ms));
+            for (sampler_slot * s : m_slots) {
+                if (void * fn = s->m_fn.load(memory_order_relaxed))
+                    m_counts[fn]++;
+            }
+        }
+    }
+
+    void dump() {
+        FILE * out = fopen(m_out.c_str(), "w");
+        if (!out)
+            return;
+        for (auto const & p : m_counts) {
+            char const * sym = nullptr;
+#if defined(__linux__) || defined(__APPLE__)
+            Dl_info info;
+            if (dladdr(p.first, &info) && info.dli_sname)
+                sym = info.dli_sname;
+#endif
+            if (sym)
+                fprintf(out, "%s %llu\n", sym, static_cast<unsigned long long>(p.second));
+            else
+                fprintf(out, "%p %llu\n", p.first, static_cast<unsigned long long>(p.second));
+        }
+        fclose(out);
+    }
+public:
+    explicit sampling_profiler(char const * out):m_out(out) {
+        if (char const * v = getenv("LEAN_SAMPLING_INTERVAL"))
+            m_interval_ms = std::max(1, atoi(v));
+        m_thread.reset(new lthread([this]() { loop(); }));
+    }
+
+    ~sampling_profiler() {
+        {
+            lock_guard<mutex> _(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread->join();
+        dump();
+    }
+
+    void register_slot(sampler_slot * s) {
+        lock_guard<mutex> _(m_mutex);
+        m_slots.push_back(s);
+    }
+
+    void unregister_slot(sampler_slot * s) {
+        lock_guard<mutex> _(m_mutex);
+        m_slots.erase(std::find(m_slots.begin(), m_slots.end(), s));
+    }
+};
+
+static sampling_profiler * g_sampling_profiler = nullptr;
+LEAN_THREAD_PTR(sampler_slot, g_sampler_slot);
+
+/* Registers a sampling slot for the calling worker thread for its lifetime. */
+struct scoped_sampler_slot {
+    sampler_slot m_slot;
+    scoped_sampler_slot() {
+        if (g_sampling_profiler) {
+            g_sampler_slot = &m_slot;
+            g_sampling_profiler->register_slot(&m_slot);
+        }
+    }
+    ~scoped_sampler_slot() {
+        if (g_sampling_profiler) {
+            g_sampling_profiler->unregister_slot(&m_slot);
+            g_sampler_slot = nullptr;
+        }
+    }
+};
+#else
+struct scoped_sampler_slot {};
+#endif
+
 class task_manager {
     mutex                                         m_mutex;
-    unsigned                                      m_num_std_workers{0};
+    atomic<unsigned>                              m_num_std_workers{0};
     unsigned                                      m_max_std_workers{0};
     unsigned                                      m_num_dedicated_workers{0};
+    /* Elastic pool for tasks that block on I/O (file reads, child-process
+       waits): they would otherwise pin CPU workers and make the manager
+       oversubscribe cores by spawning replacements. Guarded by `m_mutex`. */
+    std::deque<lean_task_object *>                m_io_queue;
+    unsigned                                      m_num_io_workers{0};
+    unsigned                                      m_num_idle_io_workers{0};
+    /* Injector queues: strict priority order, guarded by `m_mutex`. Fed by
+       non-worker threads, priorities above 0, dependency propagation, and
+       local-deque overflow; workers check it before their own deque. */
     std::deque<lean_task_object *>                m_queues[LEAN_MAX_PRIO+1];
     unsigned                                      m_queues_size{0};
     unsigned                                      m_max_prio{0};
+    /* One work-stealing deque plus affinity inbox per std worker;
+       default-priority tasks spawned by a worker go to its own deque without
+       touching `m_mutex`, and grouped tasks funnel to their group's worker. */
+    std::unique_ptr<worker_state[]>               m_workers;
+    /* Number of workers parked on `m_queue_cv`; read without the lock by
+       producers deciding whether a wakeup is needed. */
+    atomic<unsigned>                              m_idle_workers{0};
     condition_variable                            m_queue_cv;
+    condition_variable                            m_io_queue_cv;
     condition_variable                            m_task_finished_cv;
     condition_variable                            m_worker_finished_cv;
     bool                                          m_shutting_down{false};
@@ -654,8 +1240,22 @@ class task_manager {
         return result;
     }
 
+    /* Caller must hold `m_mutex`. */
+    void enqueue_io_core(lean_task_object * t) {
+        m_io_queue.push_back(t);
+        if (m_num_idle_io_workers > 0)
+            m_io_queue_cv.notify_one();
+        else if (m_num_io_workers < LEAN_MAX_IO_WORKERS)
+            spawn_io_worker();
+        /* else: stays queued until an I/O worker frees up */
+    }
+
     void enqueue_core(lean_task_object * t) {
         lean_assert(t->m_imp);
+        if (t->m_imp->m_blocking) {
+            enqueue_io_core(t);
+            return;
+        }
         unsigned prio = t->m_imp->m_prio;
         if (prio > LEAN_MAX_PRIO) {
             spawn_dedicated_worker(t);
@@ -689,24 +1289,118 @@ class task_manager {
         lock.lock();
     }
 
+    static void inbox_push(worker_state & w, lean_task_object * t) {
+        lean_task_object * head = w.m_inbox.load(memory_order_relaxed);
+        do {
+            t->m_imp->m_next_dep = head;
+        } while (!w.m_inbox.compare_exchange_weak(head, t, memory_order_release, memory_order_relaxed));
+    }
+
+    /* Owner only: take one task to run; the rest of the inbox moves to the
+       owner's deque (it is affine to this worker). */
+    lean_task_object * drain_inbox(worker_state & w) {
+        lean_task_object * t = w.m_inbox.exchange(nullptr, memory_order_acquire);
+        if (t == nullptr)
+            return nullptr;
+        lean_task_object * rest = t->m_imp->m_next_dep;
+        t->m_imp->m_next_dep = nullptr;
+        while (rest) {
+            lean_task_object * next = rest->m_imp->m_next_dep;
+            rest->m_imp->m_next_dep = nullptr;
+            if (!w.m_deque.push(rest)) {
+                unique_lock<mutex> lock(m_mutex);
+                enqueue_core(rest);
+            }
+            rest = next;
+        }
+        return t;
+    }
+
+    /* Take one task from `victim`'s inbox; the remainder moves to the thief's
+       own deque. Splicing it back into the victim's inbox would race with the
+       victim exiting at shutdown, and the thief is about to go idle anyway. */
+    lean_task_object * steal_inbox(worker_state & victim, worker_state & thief) {
+        lean_task_object * t = victim.m_inbox.exchange(nullptr, memory_order_acquire);
+        if (t == nullptr)
+            return nullptr;
+        lean_task_object * rest = t->m_imp->m_next_dep;
+        t->m_imp->m_next_dep = nullptr;
+        while (rest) {
+            lean_task_object * next = rest->m_imp->m_next_dep;
+            rest->m_imp->m_next_dep = nullptr;
+            if (!thief.m_deque.push(rest)) {
+                unique_lock<mutex> lock(m_mutex);
+                enqueue_core(rest);
+            }
+            rest = next;
+        }
+        return t;
+    }
+
+    lean_task_object * try_steal(unsigned thief_idx) {
+        unsigned n = m_num_std_workers.load(memory_order_acquire);
+        for (unsigned i = 1; i <= n; i++) {
+            if (lean_task_object * t = m_workers[(thief_idx + i) % n].m_deque.steal())
+                return t;
+        }
+        /* Raiding an inbox breaks affinity, so it is the last resort before
+           going idle. */
+        for (unsigned i = 1; i <= n; i++) {
+            if (lean_task_object * t = steal_inbox(m_workers[(thief_idx + i) % n], m_workers[thief_idx]))
+                return t;
+        }
+        return nullptr;
+    }
+
     void spawn_worker() {
+        unsigned worker_idx = m_num_std_workers.load(memory_order_relaxed);
         m_num_std_workers++;
-        lthread([this]() {
+        lthread([this, worker_idx]() {
             save_stack_info(false);
+            bind_worker_to_numa_node(worker_idx);
+            scoped_sampler_slot sampler_slot;
+            worker_state * my_state = &m_workers[worker_idx];
+            g_worker_deque = &my_state->m_deque;
             unique_lock<mutex> lock(m_mutex);
             while (true) {
-                if (m_queues_size == 0) {
-                    if (m_shutting_down) {
-                        break;
-                    }
-                    m_queue_cv.wait(lock);
+                lean_task_object * t = nullptr;
+                if (m_queues_size != 0) {
+                    /* Check the injector first, so higher-priority tasks still
+                       run before default-priority local ones. */
+                    t = dequeue();
+                } else {
+                    lock.unlock();
+                    t = drain_inbox(*my_state);
+                    if (t == nullptr)
+                        t = my_state->m_deque.pop();
+                    if (t == nullptr)
+                        t = try_steal(worker_idx);
+                    lock.lock();
+                }
+                if (t != nullptr) {
+                    run_task(lock, t);
+                    reset_heartbeat();
                     continue;
                 }
-
-                lean_task_object * t = dequeue();
-                run_task(lock, t);
-                reset_heartbeat();
+                if (m_shutting_down)
+                    break; /* our own deque is drained at this point */
+                /* Advertise idleness, then re-scan the deques while still
+                   holding the lock: a producer that pushed before reading the
+                   idle count is seen by the scan, and one that pushed after
+                   sees the count and takes the lock to notify, which cannot
+                   happen before we enter the wait. */
+                m_idle_workers.fetch_add(1);
+                atomic_thread_fence(memory_order_seq_cst);
+                t = try_steal(worker_idx);
+                if (t == nullptr && m_queues_size == 0 && !m_shutting_down)
+                    m_queue_cv.wait(lock);
+                m_idle_workers.fetch_sub(1);
+                if (t != nullptr) {
+                    run_task(lock, t);
+                    reset_heartbeat();
+                }
             }
+            g_worker_deque = nullptr;
             m_num_std_workers--;
             m_worker_finished_cv.notify_all();
         });
@@ -717,6 +1411,7 @@ class task_manager {
         m_num_dedicated_workers++;
         lthread([this, t]() {
             save_stack_info(false);
+            scoped_sampler_slot sampler_slot;
             unique_lock<mutex> lock(m_mutex);
             run_task(lock, t);
             m_num_dedicated_workers--;
@@ -725,51 +1420,123 @@ class task_manager {
         // see above
     }
 
+    void spawn_io_worker() {
+        m_num_io_workers++;
+        lthread([this]() {
+            save_stack_info(false);
+            scoped_sampler_slot sampler_slot;
+            unique_lock<mutex> lock(m_mutex);
+            while (true) {
+                if (!m_io_queue.empty()) {
+                    lean_task_object * t = m_io_queue.front();
+                    m_io_queue.pop_front();
+                    run_task(lock, t);
+                    reset_heartbeat();
+                    continue;
+                }
+                if (m_shutting_down)
+                    break;
+                m_num_idle_io_workers++;
+                m_io_queue_cv.wait_for(lock, chrono::milliseconds(LEAN_IO_WORKER_IDLE_MS));
+                m_num_idle_io_workers--;
+                /* `enqueue_io_core` spawns a replacement when it finds neither
+                   an idle worker nor headroom; both are updated under the
+                   lock, so shrinking here cannot strand a queued task. */
+                if (m_io_queue.empty() && !m_shutting_down)
+                    break;
+            }
+            m_num_io_workers--;
+            m_worker_finished_cv.notify_all();
+        });
+        // see above
+    }
+
     void run_task(unique_lock<mutex> & lock, lean_task_object * t) {
-        lean_assert(t->m_imp);
-        if (t->m_imp->m_deleted) {
-            free_task(t);
-            return;
-        }
-        reset_heartbeat();
-        object * v = nullptr;
-        {
-            scoped_current_task_object scope_cur_task(t);
-            object * c = t->m_imp->m_closure;
-            t->m_imp->m_closure = nullptr;
-            lock.unlock();
-            v = lean_apply_1(c, box(0));
-            // If deactivation was delayed by `m_keep_alive`, deactivate after the final execution (`v != nulltpr`)
-            if (v != nullptr && t->m_imp->m_keep_alive) {
-                lean_dec_ref((lean_object*)t);
+        /* Chain fusion: a pipeline of `Task.map`/`Task.bind` combinators
+           readies exactly one dependent per completion. Instead of paying a
+           scheduler round-trip per link, `handle_finished` hands one ready
+           default-priority dependent back and we keep executing inline, up to
+           `LEAN_TASK_FUSE_BUDGET` links per scheduling event. */
+        unsigned fuse_budget = LEAN_TASK_FUSE_BUDGET;
+        while (true) {
+            lean_assert(t->m_imp);
+            if (t->m_imp->m_deleted) {
+                free_task(t);
+                return;
             }
-            lock.lock();
-        }
-        lean_assert(t->m_imp);
-        if (t->m_imp->m_deleted) {
-            lock.unlock();
-            if (v) lean_dec(v);
-            free_task(t);
-            lock.lock();
-        } else if (v != nullptr) {
-            lean_assert(t->m_imp->m_closure == nullptr);
-            handle_finished(t);
-            mark_mt(v);
-            t->m_value = v;
-            /* After the task has been finished and we propagated
-               dependecies, we can release `m_imp` and keep just the value */
-            free_task_imp(t->m_imp);
-            t->m_imp   = nullptr;
-            m_task_finished_cv.notify_all();
-        } else {
-            // `bind` task has not finished yet, re-add as dependency of nested task
-            lock.unlock();
-            add_dep(lean_to_task(closure_arg_cptr(t->m_imp->m_closure)[0]), t);
-            lock.lock();
+            reset_heartbeat();
+            object * v = nullptr;
+            {
+                scoped_current_task_object scope_cur_task(t);
+                scope_heartbeat_token scope_hb(static_cast<heartbeat_token*>(t->m_imp->m_heartbeat));
+                scope_cancel_token scope_ct(static_cast<cancel_token*>(t->m_imp->m_cancel));
+                object * c = t->m_imp->m_closure;
+                t->m_imp->m_closure = nullptr;
+                lock.unlock();
+#if defined(LEAN_MULTI_THREAD)
+                if (g_sampler_slot)
+                    g_sampler_slot->m_fn.store(lean_closure_fun(c), memory_order_relaxed);
+#endif
+                uint64_t cpu_start   = thread_cpu_time_ns();
+                uint64_t alloc_start = get_alloc_bytes();
+                v = lean_apply_1(c, box(0));
+#if defined(LEAN_MULTI_THREAD)
+                if (g_sampler_slot)
+                    g_sampler_slot->m_fn.store(nullptr, memory_order_relaxed);
+#endif
+                t->m_imp->m_cpu_time_ns += thread_cpu_time_ns() - cpu_start;
+                t->m_imp->m_alloc_bytes += get_alloc_bytes() - alloc_start;
+                // If deactivation was delayed by `m_keep_alive`, deactivate after the final execution (`v != nulltpr`)
+                if (v != nullptr && t->m_imp->m_keep_alive) {
+                    lean_dec_ref((lean_object*)t);
+                }
+                lock.lock();
+            }
+            lean_assert(t->m_imp);
+            if (t->m_imp->m_deleted) {
+                lock.unlock();
+                if (v) lean_dec(v);
+                free_task(t);
+                lock.lock();
+            } else if (v != nullptr) {
+                lean_assert(t->m_imp->m_closure == nullptr);
+                lean_task_object * fused = handle_finished(t);
+                mark_mt(v);
+                t->m_value = v;
+                g_tasks_finished.fetch_add(1, memory_order_relaxed);
+                g_task_cpu_time_ns.fetch_add(t->m_imp->m_cpu_time_ns, memory_order_relaxed);
+                g_task_alloc_bytes.fetch_add(t->m_imp->m_alloc_bytes, memory_order_relaxed);
+                /* After the task has been finished and we propagated
+                   dependecies, we can release `m_imp` and keep just the value */
+                free_task_imp(t->m_imp);
+                t->m_imp   = nullptr;
+                park_wake_all(&t->m_value);
+                /* `m_task_finished_cv` is still used by `wait_any`, which waits for
+                   any of a list of tasks and hence cannot park on a single slot. */
+                m_task_finished_cv.notify_all();
+                if (fused != nullptr) {
+                    if (fuse_budget > 0) {
+                        fuse_budget--;
+                        t = fused;
+                        continue;
+                    }
+                    enqueue_core(fused);
+                }
+            } else {
+                // `bind` task has not finished yet, re-add as dependency of nested task
+                lock.unlock();
+                add_dep(lean_to_task(closure_arg_cptr(t->m_imp->m_closure)[0]), t);
+                lock.lock();
+            }
+            return;
         }
     }
 
-    void handle_finished(lean_task_object * t) {
+    /* Propagate a finished task's state to its dependents. Dependents are
+       re-enqueued, except that one ready default-priority dependent is
+       returned to the caller to be run inline (see run_task). */
+    lean_task_object * handle_finished(lean_task_object * t) {
+        lean_task_object * fused = nullptr;
         lean_task_object * it = t->m_imp->m_head_dep;
         t->m_imp->m_head_dep = nullptr;
         while (it) {
@@ -779,11 +1546,14 @@ class task_manager {
             it->m_imp->m_next_dep = nullptr;
             if (it->m_imp->m_deleted) {
                 free_task(it);
+            } else if (fused == nullptr && it->m_imp->m_prio == 0 && !it->m_imp->m_blocking) {
+                fused = it;
             } else {
                 enqueue_core(it);
             }
             it = next_it;
         }
+        return fused;
     }
 
     object * wait_any_check(object * task_list) {
@@ -799,18 +1569,72 @@ class task_manager {
 
 public:
     task_manager(unsigned max_std_workers):
-        m_max_std_workers(max_std_workers) {
+        m_max_std_workers(max_std_workers),
+        m_workers(new worker_state[max_std_workers == 0 ? 1 : max_std_workers]) {
+#if defined(LEAN_MULTI_THREAD)
+        if (char const * out = getenv("LEAN_SAMPLING_PROFILER"))
+            g_sampling_profiler = new sampling_profiler(out);
+#endif
     }
 
     ~task_manager() {
-        unique_lock<mutex> lock(m_mutex);
-        m_shutting_down = true;
-        m_queue_cv.notify_all();
-        // wait for all workers to finish
-        m_worker_finished_cv.wait(lock, [&]() { return m_num_std_workers + m_num_dedicated_workers == 0; });
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_shutting_down = true;
+            m_queue_cv.notify_all();
+            m_io_queue_cv.notify_all();
+            // wait for all workers to finish
+            m_worker_finished_cv.wait(lock, [&]() { return m_num_std_workers + m_num_dedicated_workers + m_num_io_workers == 0; });
+        }
+#if defined(LEAN_MULTI_THREAD)
+        if (g_sampling_profiler) {
+            /* all workers have unregistered their slots at this point */
+            delete g_sampling_profiler;
+            g_sampling_profiler = nullptr;
+        }
+#endif
     }
 
     void enqueue(lean_task_object * t) {
+        lean_assert(t->m_imp);
+        if (t->m_imp->m_blocking) {
+            unique_lock<mutex> lock(m_mutex);
+            enqueue_io_core(t);
+            return;
+        }
+        /* Sticky scheduling: a grouped default-priority task funnels to its
+           group's worker inbox, so dependency chains operating on the same
+           data keep hitting a warm cache. Priorities above 0 keep the strict
+           injector order instead. */
+        unsigned group = t->m_imp->m_group;
+        if (group != 0 && t->m_imp->m_prio == 0 && m_max_std_workers != 0) {
+            unsigned target = group % m_max_std_workers;
+            if (target < m_num_std_workers.load(memory_order_acquire)) {
+                inbox_push(m_workers[target], t);
+                atomic_thread_fence(memory_order_seq_cst);
+                if (m_idle_workers.load(memory_order_relaxed) != 0) {
+                    unique_lock<mutex> lock(m_mutex);
+                    m_queue_cv.notify_one();
+                }
+                return;
+            }
+        }
+        /* Fast path for fine-grained fan-out: a worker spawning a
+           default-priority task pushes it onto its own deque without touching
+           the global mutex. Higher priorities go through the injector, which
+           keeps the strict priority order. */
+        if (t->m_imp->m_prio == 0 && g_worker_deque != nullptr && g_worker_deque->push(t)) {
+            atomic_thread_fence(memory_order_seq_cst);
+            if (m_idle_workers.load(memory_order_relaxed) != 0) {
+                unique_lock<mutex> lock(m_mutex);
+                m_queue_cv.notify_one();
+            } else if (m_num_std_workers.load(memory_order_relaxed) < m_max_std_workers) {
+                unique_lock<mutex> lock(m_mutex);
+                if (m_num_std_workers.load(memory_order_relaxed) < m_max_std_workers)
+                    spawn_worker();
+            }
+            return;
+        }
         unique_lock<mutex> lock(m_mutex);
         enqueue_core(t);
     }
@@ -834,10 +1658,10 @@ public:
     void wait_for(lean_task_object * t) {
         if (t->m_value)
             return;
-        unique_lock<mutex> lock(m_mutex);
-        if (t->m_value)
-            return;
-        m_task_finished_cv.wait(lock, [&]() { return t->m_value != nullptr; });
+        /* Park on the task's value slot instead of `m_task_finished_cv`: only
+           the waiters of this particular task are woken, and `m_mutex` is not
+           touched at all. */
+        park_wait(&t->m_value, [&]() { return t->m_value != nullptr; });
     }
 
     object * wait_any(object * task_list) {
@@ -902,6 +1726,14 @@ scoped_task_manager::~scoped_task_manager() {
     if (g_task_manager) {
         delete g_task_manager;
         g_task_manager = nullptr;
+        if (getenv("LEAN_TASK_STATS")) {
+            lean_task_stats s;
+            lean_get_task_stats(&s);
+            fprintf(stderr, "tasks finished: %llu, cpu time: %.3fs, allocated: %llu bytes\n",
+                    static_cast<unsigned long long>(s.num_finished),
+                    static_cast<double>(s.cpu_time_ns) / 1e9,
+                    static_cast<unsigned long long>(s.alloc_bytes));
+        }
     }
 }
 
@@ -928,12 +1760,15 @@ static inline void lean_set_task_header(lean_object * o) {
 #endif
 }
 
-static lean_task_object * alloc_task(obj_arg c, unsigned prio, bool keep_alive) {
+static lean_task_object * alloc_task(obj_arg c, unsigned prio, bool keep_alive, unsigned group = 0) {
     lean_mark_mt(c);
+    /* Tasks spawned by a grouped task stay in the parent's group. */
+    if (group == 0 && g_current_task_object != nullptr && g_current_task_object->m_imp != nullptr)
+        group = g_current_task_object->m_imp->m_group;
     lean_task_object * o = (lean_task_object*)lean_alloc_small_object(sizeof(lean_task_object));
     lean_set_task_header((lean_object*)o);
     o->m_value = nullptr;
-    o->m_imp   = alloc_task_imp(c, prio, keep_alive);
+    o->m_imp   = alloc_task_imp(c, prio, keep_alive, group);
     if (keep_alive)
         lean_inc_ref((lean_object*)o);
     return o;
@@ -958,6 +1793,27 @@ extern "C" obj_res lean_task_spawn_core(obj_arg c, unsigned prio, bool keep_aliv
     }
 }
 
+extern "C" obj_res lean_task_spawn_blocking_core(obj_arg c, bool keep_alive) {
+    if (!g_task_manager) {
+        return lean_task_pure(apply_1(c, box(0)));
+    } else {
+        lean_task_object * new_task = alloc_task(c, 0, keep_alive);
+        new_task->m_imp->m_blocking = true;
+        g_task_manager->enqueue(new_task);
+        return (lean_object*)new_task;
+    }
+}
+
+extern "C" obj_res lean_task_spawn_affinity_core(obj_arg c, unsigned prio, unsigned group, bool keep_alive) {
+    if (!g_task_manager) {
+        return lean_task_pure(apply_1(c, box(0)));
+    } else {
+        lean_task_object * new_task = alloc_task(c, prio, keep_alive, group);
+        g_task_manager->enqueue(new_task);
+        return (lean_object*)new_task;
+    }
+}
+
 extern "C" obj_res lean_task_pure(obj_arg a) {
     return (lean_object*)alloc_task(a);
 }
@@ -1025,7 +1881,10 @@ extern "C" obj_res lean_task_bind_core(obj_arg x, obj_arg f, unsigned prio, bool
 extern "C" bool lean_io_check_canceled_core() {
     if (lean_task_object * t = g_current_task_object) {
         lean_assert(t->m_imp); // task is being executed
-        return t->m_imp->m_canceled || g_task_manager->shutting_down();
+        if (t->m_imp->m_canceled || g_task_manager->shutting_down())
+            return true;
+        if (cancel_token * ct = static_cast<cancel_token*>(t->m_imp->m_cancel))
+            return ct->canceled();
     }
     return false;
 }
@@ -1040,6 +1899,39 @@ extern "C" bool lean_io_has_finished_core(b_obj_arg t) {
     return lean_to_task(t)->m_value != nullptr;
 }
 
+extern "C" void lean_get_task_stats(lean_task_stats * s) {
+    s->num_finished = g_tasks_finished.load(memory_order_relaxed);
+    s->cpu_time_ns  = g_task_cpu_time_ns.load(memory_order_relaxed);
+    s->alloc_bytes  = g_task_alloc_bytes.load(memory_order_relaxed);
+}
+
+// =======================================
+// Cancellation tokens
+
+static external_object_class * g_cancel_token_class = nullptr;
+
+static void cancel_token_finalizer(void * t) {
+    static_cast<cancel_token*>(t)->dec_ref();
+}
+
+static void cancel_token_foreach(void *, b_obj_arg) {}
+
+extern "C" obj_res lean_io_cancel_token_new_core() {
+    return lean_alloc_external(g_cancel_token_class, new cancel_token());
+}
+
+extern "C" void lean_io_cancel_token_cancel_core(b_obj_arg tk) {
+    static_cast<cancel_token*>(lean_get_external_data(tk))->cancel();
+}
+
+extern "C" bool lean_io_cancel_token_is_canceled_core(b_obj_arg tk) {
+    return static_cast<cancel_token*>(lean_get_external_data(tk))->canceled();
+}
+
+extern "C" void lean_io_cancel_token_set_current_core(b_obj_arg tk) {
+    set_cancel_token(tk ? static_cast<cancel_token*>(lean_get_external_data(tk)) : nullptr);
+}
+
 extern "C" b_obj_res lean_io_wait_any_core(b_obj_arg task_list) {
     return g_task_manager->wait_any(task_list);
 }
@@ -1066,6 +1958,21 @@ static inline obj_res mpz_to_nat(mpz const & m) {
         return mpz_to_nat_core(m);
 }
 
+#ifdef LEAN_MPZ_U128
+/* Box a 128-bit result, building a (at most) 2-limb mpz directly when it does
+   not fit the scalar encoding. The limbs come from the small allocator (see
+   the mpz allocation hooks), so no generic GMP routine is involved. */
+static obj_res u128_to_nat(unsigned __int128 n) {
+    if (LEAN_LIKELY(n <= LEAN_MAX_SMALL_NAT))
+        return lean_box(static_cast<size_t>(n));
+    return mpz_to_nat_core(mpz::of_u128(static_cast<uint64>(n >> 64), static_cast<uint64>(n)));
+}
+
+static inline unsigned __int128 u128_of(uint64 hi, uint64 lo) {
+    return (static_cast<unsigned __int128>(hi) << 64) | lo;
+}
+#endif
+
 extern "C" object * lean_cstr_to_nat(char const * n) {
     return mpz_to_nat(mpz(n));
 }
@@ -1118,6 +2025,20 @@ extern "C" object * lean_nat_big_sub(object * a1, object * a2) {
 
 extern "C" object * lean_nat_big_mul(object * a1, object * a2) {
     lean_assert(!lean_is_scalar(a1) || !lean_is_scalar(a2));
+#ifdef LEAN_MPZ_U128
+    /* A scalar times a single-limb mpz (values below 2^64 are the common
+       overflow neighborhood) still fits in 128 bits. */
+    uint64 hi, lo;
+    if (lean_is_scalar(a1) && mpz_value(a2).is_u128()) {
+        mpz_value(a2).get_u128(hi, lo);
+        if (hi == 0)
+            return u128_to_nat(static_cast<unsigned __int128>(lean_unbox(a1)) * lo);
+    } else if (lean_is_scalar(a2) && mpz_value(a1).is_u128()) {
+        mpz_value(a1).get_u128(hi, lo);
+        if (hi == 0)
+            return u128_to_nat(static_cast<unsigned __int128>(lean_unbox(a2)) * lo);
+    }
+#endif
     if (lean_is_scalar(a1))
         return mpz_to_nat(mpz::of_size_t(lean_unbox(a1)) * mpz_value(a2));
     else if (lean_is_scalar(a2))
@@ -1127,7 +2048,12 @@ extern "C" object * lean_nat_big_mul(object * a1, object * a2) {
 }
 
 extern "C" object * lean_nat_overflow_mul(size_t a1, size_t a2) {
+#ifdef LEAN_MPZ_U128
+    /* The product of two scalars always fits in two limbs. */
+    return u128_to_nat(static_cast<unsigned __int128>(a1) * a2);
+#else
     return mpz_to_nat(mpz::of_size_t(a1) * mpz::of_size_t(a2));
+#endif
 }
 
 extern "C" object * lean_nat_big_div(object * a1, object * a2) {
@@ -1138,9 +2064,26 @@ extern "C" object * lean_nat_big_div(object * a1, object * a2) {
         return lean_box(0);
     } else if (lean_is_scalar(a2)) {
         usize n2 = lean_unbox(a2);
-        return n2 == 0 ? a2 : mpz_to_nat(mpz_value(a1) / mpz::of_size_t(n2));
+        if (n2 == 0)
+            return a2;
+#ifdef LEAN_MPZ_U128
+        if (mpz_value(a1).is_u128()) {
+            uint64 hi, lo;
+            mpz_value(a1).get_u128(hi, lo);
+            return u128_to_nat(u128_of(hi, lo) / n2);
+        }
+#endif
+        return mpz_to_nat(mpz_value(a1) / mpz::of_size_t(n2));
     } else {
         lean_assert(mpz_value(a2) != 0);
+#ifdef LEAN_MPZ_U128
+        if (mpz_value(a1).is_u128() && mpz_value(a2).is_u128()) {
+            uint64 hi1, lo1, hi2, lo2;
+            mpz_value(a1).get_u128(hi1, lo1);
+            mpz_value(a2).get_u128(hi2, lo2);
+            return u128_to_nat(u128_of(hi1, lo1) / u128_of(hi2, lo2));
+        }
+#endif
         return mpz_to_nat(mpz_value(a1) / mpz_value(a2));
     }
 }
@@ -1555,9 +2498,68 @@ static object * string_ensure_capacity(object * o, size_t extra) {
     }
 }
 
+/* Small-string interning.
+
+   Parsing and IR emission create the same short strings (field names, common
+   identifiers) millions of times. When enabled, strings of at most
+   LEAN_STRING_INTERN_MAX_SZ bytes are looked up in a per-thread direct-mapped
+   cache before allocating; a hit returns the cached object with its RC
+   bumped, so equal short strings are usually pointer-identical, which also
+   speeds up downstream comparisons. Colliding entries are simply replaced. */
+#define LEAN_STRING_INTERN_MAX_SZ 32
+#define LEAN_STRING_INTERN_SLOTS  1024
+
+static bool g_string_interning = false;
+
+struct string_intern_cache {
+    object * m_entries[LEAN_STRING_INTERN_SLOTS];
+    string_intern_cache() {
+        for (unsigned i = 0; i < LEAN_STRING_INTERN_SLOTS; i++)
+            m_entries[i] = nullptr;
+    }
+};
+LEAN_THREAD_PTR(string_intern_cache, g_string_intern);
+
+static void finalize_string_intern(void * _c) {
+    string_intern_cache * c = static_cast<string_intern_cache*>(_c);
+    for (unsigned i = 0; i < LEAN_STRING_INTERN_SLOTS; i++)
+        if (c->m_entries[i]) lean_dec(c->m_entries[i]);
+    delete c;
+    g_string_intern = nullptr;
+}
+
+extern "C" void lean_set_string_interning(bool flag) {
+    g_string_interning = flag;
+}
+
+static object * intern_mk_string(char const * s, size_t sz, size_t len) {
+    string_intern_cache * c = g_string_intern;
+    if (LEAN_UNLIKELY(c == nullptr)) {
+        c = new string_intern_cache();
+        g_string_intern = c;
+        register_thread_finalizer(finalize_string_intern, c);
+    }
+    unsigned slot  = hash_str(sz, s, 11) & (LEAN_STRING_INTERN_SLOTS - 1);
+    object * entry = c->m_entries[slot];
+    if (entry != nullptr && lean_string_size(entry) == sz + 1 &&
+        memcmp(lean_string_cstr(entry), s, sz) == 0) {
+        lean_inc(entry);
+        return entry;
+    }
+    object * r = lean_alloc_string(sz + 1, sz + 1, len);
+    memcpy(w_string_cstr(r), s, sz);
+    w_string_cstr(r)[sz] = 0;
+    if (entry != nullptr) lean_dec(entry);
+    lean_inc(r);
+    c->m_entries[slot] = r;
+    return r;
+}
+
 extern "C" object * lean_mk_string(char const * s) {
     size_t sz  = strlen(s);
     size_t len = utf8_strlen(s);
+    if (LEAN_UNLIKELY(g_string_interning) && sz <= LEAN_STRING_INTERN_MAX_SZ)
+        return intern_mk_string(s, sz, len);
     size_t rsz = sz + 1;
     object * r = lean_alloc_string(rsz, rsz, len);
     memcpy(w_string_cstr(r), s, sz+1);
@@ -1584,6 +2586,8 @@ extern "C" obj_res lean_string_to_utf8(b_obj_arg s) {
 object * mk_string(std::string const & s) {
     size_t sz  = s.size();
     size_t len = utf8_strlen(s);
+    if (LEAN_UNLIKELY(g_string_interning) && sz <= LEAN_STRING_INTERN_MAX_SZ)
+        return intern_mk_string(s.data(), sz, len);
     size_t rsz = sz + 1;
     object * r = lean_alloc_string(rsz, rsz, len);
     memcpy(w_string_cstr(r), s.data(), sz);
@@ -1624,7 +2628,7 @@ extern "C" object * lean_string_append(object * s1, object * s2) {
     size_t len1     = lean_string_len(s1);
     size_t len2     = lean_string_len(s2);
     size_t new_len  = len1 + len2;
-    unsigned new_sz = sz1 + sz2 - 1;
+    size_t new_sz   = sz1 + sz2 - 1;
     object * r;
     if (!lean_is_exclusive(s1)) {
         r = lean_alloc_string(new_sz, mk_capacity(new_sz), new_len);
@@ -1654,6 +2658,14 @@ extern "C" bool lean_string_lt(object * s1, object * s2) {
     return r < 0 || (r == 0 && sz1 < sz2);
 }
 
+extern "C" int lean_string_cmp(object * s1, object * s2) {
+    size_t sz1 = lean_string_size(s1) - 1; // ignore null char in the end
+    size_t sz2 = lean_string_size(s2) - 1; // ignore null char in the end
+    if (int r = std::memcmp(lean_string_cstr(s1), lean_string_cstr(s2), std::min(sz1, sz2)))
+        return r;
+    return sz1 < sz2 ? -1 : (sz1 == sz2 ? 0 : 1);
+}
+
 static std::string list_as_string(b_obj_arg lst) {
     std::string s;
     b_obj_arg o = lst;
@@ -1712,7 +2724,7 @@ extern "C" uint32 lean_string_utf8_get(b_obj_arg s, b_obj_arg i0) {
     usize i = lean_unbox(i0);
     char const * str = lean_string_cstr(s);
     usize size = lean_string_size(s) - 1;
-    if (i >= lean_string_size(s) - 1)
+    if (i >= size)
         return lean_char_default_value();
     unsigned c = static_cast<unsigned char>(str[i]);
     /* zero continuation (0 to 127) */
@@ -1833,6 +2845,159 @@ extern "C" obj_res lean_string_utf8_prev(b_obj_arg s, b_obj_arg i0) {
     return lean_box(i);
 }
 
+/* Bulk scanning primitives.
+
+   Lean-side parsers and log processors that advance one character at a time
+   via `String.get`/`String.next` spend most of their time in per-character
+   classification. The primitives below skip over long uniform spans in one
+   call; all positions are byte indices (`String.Pos`). The scans classify
+   ASCII bytes only: `lean_string_find_non_ident_byte` also stops at the first
+   non-ASCII byte, so callers keep their own (unicode-aware) classification
+   for the rare cases, and the whitespace/newline scans are byte-safe because
+   UTF-8 continuation bytes never collide with ASCII values. */
+
+static inline bool is_ascii_ident_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_' || c == '\'';
+}
+
+static inline bool is_ascii_ws_byte(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+#ifdef LEAN_SCAN_SSE2
+/* Return a 16-bit mask with bit i set iff byte i of `chunk` is an ASCII
+   identifier byte. Bytes >= 0x80 are negative in the signed compares and
+   fall outside every range, so they never count as identifier bytes. */
+static inline int ident_mask16(__m128i chunk) {
+    __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20)); // fold A-Z onto a-z
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), lower));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chunk));
+    __m128i other = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')),
+                                 _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\'')));
+    return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), other));
+}
+
+static inline int ws_mask16(__m128i chunk) {
+    __m128i ws = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+    return _mm_movemask_epi8(ws);
+}
+#endif
+
+/* Return the position of the first byte at `>= pos` that cannot be part of an
+   ASCII identifier (letter, digit, `_`, `'`), or the first non-ASCII byte,
+   whichever comes first; returns the byte size if the scan reaches the end. */
+extern "C" obj_res lean_string_find_non_ident_byte(b_obj_arg s, b_obj_arg pos0) {
+    usize sz = lean_string_size(s) - 1;
+    if (!lean_is_scalar(pos0)) {
+        /* See comment at string_utf8_get */
+        return lean_box(sz);
+    }
+    usize i = lean_unbox(pos0);
+    char const * str = lean_string_cstr(s);
+#ifdef LEAN_SCAN_SSE2
+    while (i + 16 <= sz) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str + i));
+        int mask = ident_mask16(chunk);
+        if (mask != 0xffff)
+            return lean_box(i + __builtin_ctz(~mask));
+        i += 16;
+    }
+#endif
+    while (i < sz && is_ascii_ident_byte(str[i]))
+        i++;
+    return lean_box(i);
+}
+
+/* Return the position of the first whitespace byte (space, tab, CR, LF) at
+   `>= pos`, or the byte size if there is none. */
+extern "C" obj_res lean_string_find_ws_byte(b_obj_arg s, b_obj_arg pos0) {
+    usize sz = lean_string_size(s) - 1;
+    if (!lean_is_scalar(pos0)) {
+        /* See comment at string_utf8_get */
+        return lean_box(sz);
+    }
+    usize i = lean_unbox(pos0);
+    char const * str = lean_string_cstr(s);
+#ifdef LEAN_SCAN_SSE2
+    while (i + 16 <= sz) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str + i));
+        int mask = ws_mask16(chunk);
+        if (mask != 0)
+            return lean_box(i + __builtin_ctz(mask));
+        i += 16;
+    }
+#endif
+    while (i < sz && !is_ascii_ws_byte(str[i]))
+        i++;
+    return lean_box(i);
+}
+
+/* Return the position of the first non-whitespace byte at `>= pos`, i.e. skip
+   a whitespace run; returns the byte size if the rest is whitespace. */
+extern "C" obj_res lean_string_skip_ws(b_obj_arg s, b_obj_arg pos0) {
+    usize sz = lean_string_size(s) - 1;
+    if (!lean_is_scalar(pos0)) {
+        /* See comment at string_utf8_get */
+        return lean_box(sz);
+    }
+    usize i = lean_unbox(pos0);
+    char const * str = lean_string_cstr(s);
+#ifdef LEAN_SCAN_SSE2
+    while (i + 16 <= sz) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str + i));
+        int mask = ws_mask16(chunk);
+        if (mask != 0xffff)
+            return lean_box(i + __builtin_ctz(~mask));
+        i += 16;
+    }
+#endif
+    while (i < sz && is_ascii_ws_byte(str[i]))
+        i++;
+    return lean_box(i);
+}
+
+/* Return `(line, column)` for byte position `pos`: the number of LF bytes in
+   `[0, pos)` and the byte offset from the start of the current line. The
+   column counts bytes, not codepoints; callers that display columns convert
+   the final line's prefix with the existing codepoint machinery. */
+extern "C" obj_res lean_string_line_column(b_obj_arg s, b_obj_arg pos0) {
+    usize sz  = lean_string_size(s) - 1;
+    usize pos = !lean_is_scalar(pos0) ? sz : lean_unbox(pos0);
+    if (pos > sz) pos = sz;
+    char const * str = lean_string_cstr(s);
+    usize line       = 0;
+    usize line_start = 0;
+    usize i          = 0;
+#ifdef LEAN_SCAN_SSE2
+    while (i + 16 <= pos) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+        if (mask != 0) {
+            line      += __builtin_popcount(mask);
+            line_start = i + (31 - __builtin_clz(mask)) + 1;
+        }
+        i += 16;
+    }
+#endif
+    for (; i < pos; i++) {
+        if (str[i] == '\n') {
+            line++;
+            line_start = i + 1;
+        }
+    }
+    obj_res r = lean_alloc_ctor(0, 2, 0);
+    lean_ctor_set(r, 0, lean_box(line));
+    lean_ctor_set(r, 1, lean_box(pos - line_start));
+    return r;
+}
+
 static unsigned get_utf8_char_size_at(std::string const & s, usize i) {
     if (auto sz = get_utf8_first_byte_opt(s[i])) {
         return *sz;
@@ -2018,6 +3183,59 @@ extern "C" obj_res lean_float_array_push(obj_arg a, double d) {
     return r;
 }
 
+/* Bulk kernels for ByteArray/FloatArray.
+
+   The loops are written so the compiler's vectorizer can turn them into SIMD
+   code on every target (the bounds are hoisted and the bodies are free of
+   aliasing and RC traffic); memset/memchr already use the platform's
+   vectorized implementations. Exposed as extern "C" primitives for the
+   stdlib to bind. */
+
+extern "C" obj_res lean_byte_array_fill(obj_arg a, uint8 b) {
+    object * r = lean_sarray_ensure_exclusive(a);
+    memset(lean_sarray_cptr(r), b, lean_sarray_size(r));
+    return r;
+}
+
+/* Index of the first occurrence of `b` at or after `start`; the array size
+   when not found. */
+extern "C" size_t lean_byte_array_index_of(b_obj_arg a, uint8 b, size_t start) {
+    size_t sz = lean_sarray_size(a);
+    if (start >= sz) return sz;
+    uint8 * begin = lean_sarray_cptr(a);
+    void * p = memchr(begin + start, b, sz - start);
+    return p == nullptr ? sz : static_cast<uint8*>(p) - begin;
+}
+
+extern "C" double lean_float_array_sum(b_obj_arg a) {
+    size_t sz   = lean_sarray_size(a);
+    double * it = reinterpret_cast<double*>(lean_sarray_cptr(a));
+    double r    = 0.0;
+    for (size_t i = 0; i < sz; i++)
+        r += it[i];
+    return r;
+}
+
+/* Dot product over the common prefix of the two arrays. */
+extern "C" double lean_float_array_dot(b_obj_arg a, b_obj_arg b) {
+    size_t sz    = std::min(lean_sarray_size(a), lean_sarray_size(b));
+    double * it1 = reinterpret_cast<double*>(lean_sarray_cptr(a));
+    double * it2 = reinterpret_cast<double*>(lean_sarray_cptr(b));
+    double r     = 0.0;
+    for (size_t i = 0; i < sz; i++)
+        r += it1[i] * it2[i];
+    return r;
+}
+
+extern "C" obj_res lean_float_array_scale(obj_arg a, double s) {
+    object * r  = lean_sarray_ensure_exclusive(a);
+    size_t sz   = lean_sarray_size(r);
+    double * it = reinterpret_cast<double*>(lean_sarray_cptr(r));
+    for (size_t i = 0; i < sz; i++)
+        it[i] *= s;
+    return r;
+}
+
 // =======================================
 // Array functions for generated code
 
@@ -2063,11 +3281,58 @@ extern "C" obj_res lean_copy_expand_array(obj_arg a, bool expand) {
     return r;
 }
 
+/* Try to grow an exclusive array's capacity without copying, by claiming the
+   unused tail of the allocator block it already occupies. The deallocation
+   path derives the block from the byte size, so the grown size must (and
+   does) map back to the same slot/bucket. */
+static bool array_grow_in_place(object * a) {
+#ifdef LEAN_SMALL_ALLOCATOR
+    size_t usable  = alloc_usable_size(a, lean_array_byte_size(a));
+    size_t new_cap = (usable - sizeof(lean_array_object)) / sizeof(void*); // NOLINT
+    if (new_cap > lean_array_capacity(a)) {
+        lean_to_array(a)->m_capacity = new_cap;
+        return true;
+    }
+#else
+    (void) a;
+#endif
+    return false;
+}
+
+extern "C" obj_res lean_array_reserve(obj_arg a, size_t cap) {
+    if (lean_is_exclusive(a)) {
+        if (lean_array_capacity(a) >= cap)
+            return a;
+        if (array_grow_in_place(a) && lean_array_capacity(a) >= cap)
+            return a;
+    }
+    size_t sz      = lean_array_size(a);
+    if (cap < sz) cap = sz;
+    object * r     = lean_alloc_array(sz, cap);
+    object ** it   = lean_array_cptr(a);
+    object ** end  = it + sz;
+    object ** dest = lean_array_cptr(r);
+    if (lean_is_exclusive(a)) {
+        memcpy(dest, it, sz * sizeof(object*)); // NOLINT
+        lean_to_array(a)->m_size = 0;
+        lean_dec(a);
+    } else {
+        for (; it != end; ++it, ++dest) {
+            *dest = *it;
+            lean_inc(*it);
+        }
+        lean_dec(a);
+    }
+    return r;
+}
+
 extern "C" object * lean_array_push(obj_arg a, obj_arg v) {
     object * r;
     if (lean_is_exclusive(a)) {
         if (lean_array_capacity(a) > lean_array_size(a))
             r = a;
+        else if (array_grow_in_place(a))
+            r = a;
         else
             r = lean_copy_expand_array(a, true);
     } else {
@@ -2081,6 +3346,116 @@ extern "C" object * lean_array_push(obj_arg a, obj_arg v) {
     return r;
 }
 
+/* Array.map: apply `f` to every element. When the array is exclusive the cells
+   are rewritten in place, so mapping a large array neither allocates nor copies;
+   a shared array is copied once up front and then updated in place. */
+extern "C" obj_res lean_array_map(obj_arg f, obj_arg a) {
+    size_t sz = lean_array_size(a);
+    obj_res r;
+    if (lean_is_exclusive(a)) {
+        r = a;
+    } else {
+        r = lean_alloc_array(sz, sz);
+        object ** src  = lean_array_cptr(a);
+        object ** dest = lean_array_cptr(r);
+        for (size_t i = 0; i < sz; i++) {
+            lean_inc(src[i]);
+            dest[i] = src[i];
+        }
+        lean_dec(a);
+    }
+    object ** it = lean_array_cptr(r);
+    for (size_t i = 0; i < sz; i++) {
+        lean_inc(f);
+        /* the cell's reference moves into the application and the result moves back */
+        it[i] = lean_apply_1(f, it[i]);
+    }
+    lean_dec(f);
+    return r;
+}
+
+/* Array.foldl: fold `f` over the elements in `[start, stop)`. Matches the range
+   semantics of the compiled `Array.foldlM` reference: no element is visited
+   unless `start < stop && stop <= as.size`. */
+extern "C" obj_res lean_array_foldl(obj_arg f, obj_arg init, obj_arg a, obj_arg start, obj_arg stop) {
+    if (!lean_is_scalar(start) || !lean_is_scalar(stop)) {
+        /* a bound that does not fit in a scalar `Nat` cannot select a valid range */
+        if (!lean_is_scalar(start)) lean_dec(start);
+        if (!lean_is_scalar(stop))  lean_dec(stop);
+        lean_dec(f); lean_dec(a);
+        return init;
+    }
+    size_t sz = lean_array_size(a);
+    size_t i  = lean_unbox(start);
+    size_t e  = lean_unbox(stop);
+    object * b = init;
+    if (i < e && e <= sz) {
+        object ** it = lean_array_cptr(a);
+        for (; i < e; i++) {
+            lean_inc(f);
+            lean_inc(it[i]);
+            b = lean_apply_2(f, b, it[i]);
+        }
+    }
+    lean_dec(f);
+    lean_dec(a);
+    return b;
+}
+
+/* Array.filter: keep the elements in `[start, stop)` satisfying `p`. A full-range
+   filter of an exclusive array compacts in place in a single pass; otherwise the
+   result is built in one allocation sized for the range. As with `foldl`, an
+   invalid range selects no elements, i.e., the result is empty. */
+extern "C" obj_res lean_array_filter(obj_arg p, obj_arg a, obj_arg start, obj_arg stop) {
+    size_t sz = lean_array_size(a);
+    size_t i = 0, e = 0;
+    bool valid = lean_is_scalar(start) && lean_is_scalar(stop);
+    if (valid) {
+        i = lean_unbox(start);
+        e = lean_unbox(stop);
+        valid = i < e && e <= sz;
+    } else {
+        if (!lean_is_scalar(start)) lean_dec(start);
+        if (!lean_is_scalar(stop))  lean_dec(stop);
+    }
+    if (!valid) {
+        lean_dec(p); lean_dec(a);
+        return lean_alloc_array(0, 0);
+    }
+    if (lean_is_exclusive(a) && i == 0 && e == sz) {
+        object ** it = lean_array_cptr(a);
+        size_t j = 0;
+        for (size_t k = 0; k < sz; k++) {
+            object * v = it[k];
+            lean_inc(p); lean_inc(v);
+            if (lean_unbox(lean_apply_1(p, v))) {
+                it[j++] = v;
+            } else {
+                lean_dec(v);
+            }
+        }
+        lean_to_array(a)->m_size = j;
+        lean_dec(p);
+        return a;
+    }
+    object * r     = lean_alloc_array(0, e - i);
+    object ** it   = lean_array_cptr(a);
+    object ** dest = lean_array_cptr(r);
+    size_t j = 0;
+    for (; i < e; i++) {
+        object * v = it[i];
+        lean_inc(p); lean_inc(v);
+        if (lean_unbox(lean_apply_1(p, v))) {
+            lean_inc(v);
+            dest[j++] = v;
+        }
+    }
+    lean_to_array(r)->m_size = j;
+    lean_dec(p);
+    lean_dec(a);
+    return r;
+}
+
 // =======================================
 // Runtime info
 
@@ -2136,11 +3511,24 @@ extern "C" lean_external_class * lean_register_external_class(lean_external_fina
 void initialize_object() {
     g_ext_classes       = new std::vector<external_object_class*>();
     g_ext_classes_mutex = new mutex();
+    g_cancel_token_class = lean_register_external_class(cancel_token_finalizer, cancel_token_foreach);
     g_array_empty       = lean_alloc_array(0, 0);
     mark_persistent(g_array_empty);
 }
 
 void finalize_object() {
+#if defined(LEAN_MULTI_THREAD)
+    if (g_del_thread) {
+        {
+            lock_guard<mutex> lock(*g_del_mutex);
+            g_del_shutdown = true;
+            g_del_cv.notify_one();
+        }
+        g_del_thread->join();
+        delete g_del_thread;
+        g_del_thread = nullptr;
+    }
+#endif
     for (external_object_class * cls : *g_ext_classes) delete cls;
     delete g_ext_classes;
     delete g_ext_classes_mutex;
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Jared Roesch
 */
 #include <string>
+#include <vector>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -21,7 +22,10 @@ Author: Jared Roesch
 #else
 #include <unistd.h>
 #include <fcntl.h>
+#include <spawn.h>
+#include <cstring>
 #include <sys/wait.h>
+extern char ** environ;
 #endif
 
 #include <lean/object.h>
@@ -63,6 +67,17 @@ extern "C" obj_res lean_io_process_child_wait(b_obj_arg, b_obj_arg child, obj_ar
     return lean_io_result_mk_ok(box_uint32(exit_code));
 }
 
+/* Child.tryWait : (@& Child cfg) → IO (Option UInt32) */
+extern "C" obj_res lean_io_process_child_try_wait(b_obj_arg, b_obj_arg child, obj_arg) {
+    HANDLE h = static_cast<HANDLE>(lean_get_external_data(cnstr_get(child, 3)));
+    if (WaitForSingleObject(h, 0) == WAIT_TIMEOUT) {
+        return lean_io_result_mk_ok(mk_option_none());
+    }
+    DWORD exit_code;
+    GetExitCodeProcess(h, &exit_code);
+    return lean_io_result_mk_ok(mk_option_some(box_uint32(exit_code)));
+}
+
 static FILE * from_win_handle(HANDLE handle, char const * mode) {
     int fd = _open_osfhandle(reinterpret_cast<intptr_t>(handle), _O_APPEND);
     return fdopen(fd, mode);
@@ -230,6 +245,28 @@ extern "C" obj_res lean_io_process_child_wait(b_obj_arg, b_obj_arg child, obj_ar
     }
 }
 
+/* Child.tryWait : (@& Child cfg) → IO (Option UInt32) */
+extern "C" obj_res lean_io_process_child_try_wait(b_obj_arg, b_obj_arg child, obj_arg) {
+    pid_t pid = cnstr_get_uint32(child, 3 * sizeof(object *));
+    int status;
+    pid_t r = waitpid(pid, &status, WNOHANG);
+    if (r == 0) {
+        return lean_io_result_mk_ok(mk_option_none());
+    }
+    if (r < 0) {
+        return lean_io_result_mk_error(decode_io_error(errno, nullptr));
+    }
+    unsigned exit_code;
+    if (WIFEXITED(status)) {
+        exit_code = static_cast<unsigned>(WEXITSTATUS(status));
+    } else {
+        lean_assert(WIFSIGNALED(status));
+        // use bash's convention
+        exit_code = 128 + static_cast<unsigned>(WTERMSIG(status));
+    }
+    return lean_io_result_mk_ok(mk_option_some(box_uint32(exit_code)));
+}
+
 struct pipe { int m_read_fd; int m_write_fd; };
 
 static optional<pipe> setup_stdio(stdio cfg) {
@@ -252,6 +289,23 @@ static optional<pipe> setup_stdio(stdio cfg) {
     lean_unreachable();
 }
 
+/* Redirect `fd` of the child to `pipe`'s `in ? read : write` end and close both pipe fds
+   in the child; the dup'ed copy on `fd` survives. */
+static void add_pipe_actions(posix_spawn_file_actions_t * fa, optional<pipe> const & p, int fd, bool in) {
+    posix_spawn_file_actions_adddup2(fa, in ? p->m_read_fd : p->m_write_fd, fd);
+    posix_spawn_file_actions_addclose(fa, p->m_read_fd);
+    posix_spawn_file_actions_addclose(fa, p->m_write_fd);
+}
+
+/* We create children via `posix_spawn` instead of fork/exec: forking duplicates the parent's
+   page tables, which for a process with a large heap costs hundreds of milliseconds per spawn,
+   whereas `posix_spawn` uses vfork/`CLONE_VM` semantics on glibc and macOS and never copies
+   the address space. Build drivers spawning thousands of compiler/git children rely on this,
+   so redirections, the working directory, and environment overrides must all be expressed as
+   spawn attributes rather than code run between fork and exec.
+
+   `posix_spawn_file_actions_addchdir_np` requires glibc >= 2.29, macOS >= 10.15, or
+   musl >= 1.1.24; it was standardized (without the suffix) in POSIX.1-2024. */
 static obj_res spawn(string_ref const & proc_name, array_ref<string_ref> const & args, stdio stdin_mode, stdio stdout_mode,
   stdio stderr_mode, option_ref<string_ref> const & cwd, array_ref<pair_ref<string_ref, option_ref<string_ref>>> const & env) {
     /* Setup stdio based on process configuration. */
@@ -259,60 +313,74 @@ static obj_res spawn(string_ref const & proc_name, array_ref<string_ref> const &
     auto stdout_pipe = setup_stdio(stdout_mode);
     auto stderr_pipe = setup_stdio(stderr_mode);
 
-    int pid = fork();
-
-    if (pid == 0) {
-        for (auto & entry : env) {
-            if (entry.snd()) {
-                setenv(entry.fst().data(), entry.snd().get()->data(), true);
-            } else {
-                unsetenv(entry.fst().data());
-            }
-        }
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
 
-        if (stdin_pipe) {
-            dup2(stdin_pipe->m_read_fd, STDIN_FILENO);
-            close(stdin_pipe->m_write_fd);
-        } else if (stdin_mode == stdio::NUL) {
-            int fd = open("/dev/null", O_RDONLY);
-            dup2(fd, STDIN_FILENO);
-        }
+    if (stdin_pipe) {
+        add_pipe_actions(&fa, stdin_pipe, STDIN_FILENO, true);
+    } else if (stdin_mode == stdio::NUL) {
+        posix_spawn_file_actions_addopen(&fa, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    }
 
-        if (stdout_pipe) {
-            dup2(stdout_pipe->m_write_fd, STDOUT_FILENO);
-            close(stdout_pipe->m_read_fd);
-        } else if (stdout_mode == stdio::NUL) {
-            int fd = open("/dev/null", O_WRONLY);
-            dup2(fd, STDOUT_FILENO);
-        }
+    if (stdout_pipe) {
+        add_pipe_actions(&fa, stdout_pipe, STDOUT_FILENO, false);
+    } else if (stdout_mode == stdio::NUL) {
+        posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    }
 
-        if (stderr_pipe) {
-            dup2(stderr_pipe->m_write_fd, STDERR_FILENO);
-            close(stderr_pipe->m_read_fd);
-        } else if (stderr_mode == stdio::NUL) {
-            int fd = open("/dev/null", O_WRONLY);
-            dup2(fd, STDERR_FILENO);
-        }
+    if (stderr_pipe) {
+        add_pipe_actions(&fa, stderr_pipe, STDERR_FILENO, false);
+    } else if (stderr_mode == stdio::NUL) {
+        posix_spawn_file_actions_addopen(&fa, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    }
 
-        if (cwd) {
-            if (chdir(cwd.get()->data()) < 0) {
-                std::cerr << "could not change directory to " << cwd.get()->data() << std::endl;
-                exit(-1);
+    if (cwd)
+        posix_spawn_file_actions_addchdir_np(&fa, cwd.get()->data());
+
+    /* The parent's memory stays valid across `posix_spawn`, so argv can point directly into
+       the Lean string objects. */
+    buffer<char *> pargs;
+    pargs.push_back(const_cast<char *>(proc_name.data()));
+    for (auto & arg : args)
+        pargs.push_back(const_cast<char *>(arg.data()));
+    pargs.push_back(nullptr);
+
+    /* Environment overrides are applied to a copy of `environ` handed to the child; the
+       parent's environment is never mutated (unlike the Windows path). */
+    char ** child_env = environ;
+    buffer<char *> penv;
+    std::vector<std::string> env_overrides;
+    if (env.size() > 0) {
+        for (char ** p = environ; *p; p++) {
+            char const * eq  = strchr(*p, '=');
+            size_t name_len  = eq ? static_cast<size_t>(eq - *p) : strlen(*p);
+            bool overridden  = false;
+            for (auto & entry : env) {
+                if (entry.fst().num_bytes() == name_len && memcmp(entry.fst().data(), *p, name_len) == 0) {
+                    overridden = true;
+                    break;
+                }
             }
+            if (!overridden)
+                penv.push_back(*p);
         }
-
-        buffer<char *> pargs;
-        pargs.push_back(strdup(proc_name.data()));
-        for (auto & arg : args)
-            pargs.push_back(strdup(arg.data()));
-        pargs.push_back(NULL);
-
-        if (execvp(pargs[0], pargs.data()) < 0) {
-            std::cerr << "could not execute external process '" << pargs[0] << "'" << std::endl;
-            exit(-1);
+        for (auto & entry : env) {
+            if (entry.snd())
+                env_overrides.push_back(std::string(entry.fst().data()) + "=" + entry.snd().get()->data());
         }
-    } else if (pid == -1) {
-        throw errno;
+        for (auto & s : env_overrides)
+            penv.push_back(const_cast<char *>(s.c_str()));
+        penv.push_back(nullptr);
+        child_env = penv.data();
+    }
+
+    pid_t pid;
+    int err = posix_spawnp(&pid, proc_name.data(), &fa, nullptr, pargs.data(), child_env);
+    posix_spawn_file_actions_destroy(&fa);
+    if (err != 0) {
+        /* Unlike with fork/exec, a missing executable is reported here instead of via a child
+           that exits after printing to stderr. */
+        throw err;
     }
 
     object * parent_stdin  = box(0);
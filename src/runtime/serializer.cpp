@@ -23,34 +23,43 @@ void finalize_serializer() {
 }
 
 serializer::~serializer() {
+    reset_sharing();
+}
+
+void serializer::reset_sharing() {
     for (std::pair<object * const, unsigned> const & it : m_obj_table) {
         dec_ref(it.first);
     }
+    m_obj_table.clear();
+    m_str_table.clear();
+    m_cnstr_table.clear();
+    m_num_objs = 0;
 }
 
-void serializer::write_unsigned_short(unsigned short i) {
-    static_assert(sizeof(i) == 2, "unexpected unsigned short size");
-    m_out.put((i >> 8) & 0xff);
-    m_out.put(i & 0xff);
+void serializer::write_stream_elem(object * o) {
+    write_object(o);
+    reset_sharing();
 }
 
 void serializer::write_unsigned(unsigned i) {
+    /* LEB128: 7 bits per byte, high bit set on all but the last byte. Values below 128
+       (most tags, field counts and sizes) take a single byte, and back-reference indices
+       grow with the number of serialized objects instead of jumping to a fixed 5 bytes. */
     static_assert(sizeof(i) == 4, "unexpected unsigned size");
-    if (i < 255) {
-        m_out.put(i & 0xff);
-    } else {
-        m_out.put(-1);
-        m_out.put((i >> 24) & 0xff);
-        m_out.put((i >> 16) & 0xff);
-        m_out.put((i >> 8) & 0xff);
-        m_out.put(i & 0xff);
+    while (i >= 0x80) {
+        m_out.put(static_cast<char>((i & 0x7f) | 0x80));
+        i >>= 7;
     }
+    m_out.put(static_cast<char>(i));
 }
 
 void serializer::write_uint64(uint64 i) {
     static_assert(sizeof(i) == 8, "unexpected uint64 size");
-    write_unsigned((i >> 32) & 0xffffffff);
-    write_unsigned(i & 0xffffffff);
+    while (i >= 0x80) {
+        m_out.put(static_cast<char>((i & 0x7f) | 0x80));
+        i >>= 7;
+    }
+    m_out.put(static_cast<char>(i));
 }
 
 void serializer::write_size_t(size_t i) {
@@ -79,9 +88,9 @@ void serializer::write_constructor(object * o) {
     unsigned main_size = sizeof(lean_ctor_object) + sizeof(lean_object*)*num_objs;
     lean_assert(obj_size >= main_size);
     unsigned scalar_sz = obj_size - main_size;
-    write_unsigned_short(cnstr_tag(o));
-    write_unsigned_short(num_objs);
-    write_unsigned_short(scalar_sz);
+    write_unsigned(cnstr_tag(o));
+    write_unsigned(num_objs);
+    write_unsigned(scalar_sz);
     object ** it  = cnstr_obj_cptr(o);
     object ** end = it + num_objs;
     for (; it != end; ++it)
@@ -160,6 +169,70 @@ void serializer::write_external(object *) { // NOLINT
     lean_internal_panic("serializer for external objects has not been implemented yet");
 }
 
+/* Builds a content key for constructor `o`: tag, field counts, the identity of every child
+   (scalar value, or id of an already serialized object), and the scalar payload. Fails when
+   some child has not been serialized yet (not even as shared content); in that case `o` cannot
+   be structurally equal to an already emitted object either. */
+bool serializer::mk_cnstr_key(object * o, std::string & key) {
+    unsigned num_objs  = cnstr_num_objs(o);
+    unsigned obj_size  = lean_object_byte_size(o);
+    unsigned main_size = sizeof(lean_ctor_object) + sizeof(lean_object*)*num_objs;
+    unsigned scalar_sz = obj_size - main_size;
+    unsigned header[3] = { cnstr_tag(o), num_objs, scalar_sz };
+    key.append(reinterpret_cast<char const *>(header), sizeof(header));
+    for (unsigned i = 0; i < num_objs; i++) {
+        object * c = cnstr_get(o, i);
+        if (is_scalar(c)) {
+            size_t v = reinterpret_cast<size_t>(c);
+            key.push_back('s');
+            key.append(reinterpret_cast<char const *>(&v), sizeof(v));
+        } else {
+            unsigned id;
+            auto it = m_obj_table.find(c);
+            if (it != m_obj_table.end()) {
+                id = it->second;
+            } else if (optional<unsigned> shared = find_shared_content(c)) {
+                id = *shared;
+            } else {
+                return false;
+            }
+            key.push_back('r');
+            key.append(reinterpret_cast<char const *>(&id), sizeof(id));
+        }
+    }
+    key.append(reinterpret_cast<char const *>(cnstr_scalar_cptr(o)), scalar_sz);
+    return true;
+}
+
+optional<unsigned> serializer::find_shared_content(object * o) {
+    if (lean_ptr_tag(o) == LeanString) {
+        auto it = m_str_table.find(std::string(string_cstr(o), string_size(o)));
+        if (it != m_str_table.end())
+            return optional<unsigned>(it->second);
+    } else if (is_cnstr(o)) {
+        std::string key;
+        if (mk_cnstr_key(o, key)) {
+            auto it = m_cnstr_table.find(key);
+            if (it != m_cnstr_table.end())
+                return optional<unsigned>(it->second);
+        }
+    }
+    return optional<unsigned>();
+}
+
+/* Registers the content of the freshly serialized object `o`. All children of a constructor
+   have entered `m_obj_table` by now, so `mk_cnstr_key` succeeds. We use `insert` so the first
+   id emitted for some content wins. */
+void serializer::save_content(object * o, unsigned id) {
+    if (lean_ptr_tag(o) == LeanString) {
+        m_str_table.insert(std::make_pair(std::string(string_cstr(o), string_size(o)), id));
+    } else if (is_cnstr(o)) {
+        std::string key;
+        if (mk_cnstr_key(o, key))
+            m_cnstr_table.insert(std::make_pair(std::move(key), id));
+    }
+}
+
 void serializer::write_object(object * o) {
     if (is_scalar(o)) {
         m_out.put(0);
@@ -169,6 +242,13 @@ void serializer::write_object(object * o) {
         if (it != m_obj_table.end()) {
             m_out.put(1);
             write_unsigned(it->second);
+        } else if (optional<unsigned> id = find_shared_content(o)) {
+            /* distinct heap object, but structurally equal to an already emitted one
+               (e.g., a duplicated string or `name` chain) */
+            m_out.put(1);
+            write_unsigned(*id);
+            inc_ref(o);
+            m_obj_table.insert(std::make_pair(o, *id));
         } else {
             uint8 k = lean_ptr_tag(o);
             m_out.put(static_cast<unsigned>(k) + 2);
@@ -184,8 +264,10 @@ void serializer::write_object(object * o) {
             case LeanReserved:     lean_unreachable(); break;
             default:               write_constructor(o); break;
             }
+            unsigned obj_id = m_num_objs++;
             inc_ref(o);
-            m_obj_table.insert(std::make_pair(o, m_obj_table.size()));
+            m_obj_table.insert(std::make_pair(o, obj_id));
+            save_content(o, obj_id);
         }
     }
 }
@@ -205,8 +287,20 @@ void serializer::write_double(double d) {
 }
 
 deserializer::~deserializer() {
+    reset_sharing();
+}
+
+void deserializer::reset_sharing() {
     for (object * o : m_objs)
         dec_ref(o);
+    m_objs.clear();
+}
+
+object * deserializer::read_stream_elem() {
+    object * r = read_object();
+    inc(r);
+    reset_sharing();
+    return r;
 }
 
 std::string deserializer::read_string() {
@@ -222,29 +316,14 @@ std::string deserializer::read_string() {
     return r;
 }
 
-unsigned deserializer::read_unsigned_ext() {
-    unsigned r;
-    static_assert(sizeof(r) == 4, "unexpected unsigned size");
-    r  = static_cast<unsigned>(m_in.get()) << 24;
-    r |= static_cast<unsigned>(m_in.get()) << 16;
-    r |= static_cast<unsigned>(m_in.get()) << 8;
-    r |= static_cast<unsigned>(m_in.get());
-    return r;
-}
-
-unsigned short deserializer::read_unsigned_short() {
-    unsigned short r;
-    static_assert(sizeof(r) == 2, "unexpected unsigned short size");
-    r  = static_cast<unsigned short>(m_in.get()) << 8;
-    r |= static_cast<unsigned short>(m_in.get());
-    return r;
-}
-
 uint64 deserializer::read_uint64() {
-    uint64 r;
-    static_assert(sizeof(r) == 8, "unexpected uint64 size");
-    r  = static_cast<uint64>(read_unsigned()) << 32;
-    r |= static_cast<uint64>(read_unsigned());
+    static_assert(sizeof(uint64) == 8, "unexpected uint64 size");
+    uint64 r = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        unsigned char b = static_cast<unsigned char>(m_in.get());
+        r |= static_cast<uint64>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) break;
+    }
     return r;
 }
 
@@ -277,9 +356,9 @@ std::string deserializer::read_blob() {
 }
 
 object * deserializer::read_constructor() {
-    unsigned tag       = read_unsigned_short();
-    unsigned num_objs  = read_unsigned_short();
-    unsigned scalar_sz = read_unsigned_short();
+    unsigned tag       = read_unsigned();
+    unsigned num_objs  = read_unsigned();
+    unsigned scalar_sz = read_unsigned();
     object * r = alloc_cnstr(tag, num_objs, scalar_sz);
     for (unsigned i = 0; i < num_objs; i++) {
         object * o = read_object();
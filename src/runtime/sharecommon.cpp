@@ -31,8 +31,9 @@ extern "C" uint64_t lean_sharecommon_hash(b_obj_arg o) {
     size_t header_sz = sizeof(lean_object);
     // hash relevant parts of the header
     unsigned init = hash(lean_ptr_tag(o), lean_ptr_other(o));
-    // hash body
-    return hash_str(sz - header_sz, reinterpret_cast<char const *>(o) + header_sz, init);
+    // hash body; the result is only consumed by in-memory sharing tables, so the
+    // version-unstable `hash_bytes` is fine here
+    return hash_bytes(sz - header_sz, reinterpret_cast<char const *>(o) + header_sz, init);
 }
 
 // unsafe def mkObjectMap : Unit → ObjectMap
@@ -235,7 +236,26 @@ class sharecommon_fn {
         save(a, (lean_object*)new_a);
     }
 
+    /* `a` has no child references, so it is content-equal to the copy `visit_sarray`/`visit_string`
+       would allocate; probe the set with `a` itself and, on a hit, skip the copy entirely. */
+    bool save_existing(b_obj_arg a) {
+        obj_res o = m_state.set_find(a);
+        if (o == lean_box(0))
+            return false;
+        lean_assert(m_todo.size() > 0);
+        lean_assert(m_todo.back() == a);
+        m_todo.pop_back();
+        obj_res r = lean_ctor_get(o, 0);
+        lean_inc(r);
+        lean_dec(o);
+        lean_inc(a);
+        m_state.map_insert(a, r);
+        return true;
+    }
+
     void visit_sarray(b_obj_arg a) {
+        if (save_existing(a))
+            return;
         size_t sz        = lean_sarray_size(a);
         unsigned elem_sz = lean_sarray_elem_size(a);
         lean_sarray_object * new_a = (lean_sarray_object*)lean_alloc_sarray(elem_sz, sz, sz);
@@ -244,6 +264,8 @@ class sharecommon_fn {
     }
 
     void visit_string(b_obj_arg a) {
+        if (save_existing(a))
+            return;
         size_t sz     = lean_string_size(a);
         size_t len    = lean_string_len(a);
         lean_string_object * new_a = (lean_string_object*)lean_alloc_string(sz, sz, len);
@@ -6,8 +6,11 @@ Author: Leonardo de Moura
 */
 #include <memory.h>
 #include <iostream>
+#include <cstdint>
 #include <lean/thread.h>
 #include <lean/exception.h>
+#include <lean/stackinfo.h>
+#include <lean/compiler_hints.h>
 
 #if !defined(LEAN_USE_SPLIT_STACK)
 #if defined(LEAN_WINDOWS)
@@ -63,7 +66,10 @@ size_t get_stack_size(int main) {
 LEAN_THREAD_VALUE(bool, g_stack_info_init, false);
 LEAN_THREAD_VALUE(size_t, g_stack_size, 0);
 LEAN_THREAD_VALUE(size_t, g_stack_base, 0);
-LEAN_THREAD_VALUE(size_t, g_stack_threshold, 0);
+/* Initialized to SIZE_MAX so the first `check_stack` on a thread that skipped
+   `save_stack_info` takes the slow path and initializes; afterwards the hot path
+   is a single thread-local read and compare. */
+LEAN_THREAD_VALUE(size_t, g_stack_threshold, SIZE_MAX);
 
 void save_stack_info(bool main) {
     g_stack_info_init = true;
@@ -78,6 +84,34 @@ void save_stack_info(bool main) {
     }
 }
 
+stack_info_snapshot get_stack_info() {
+    stack_info_snapshot info;
+    info.m_init      = g_stack_info_init;
+    info.m_size      = g_stack_size;
+    info.m_base      = g_stack_base;
+    info.m_threshold = g_stack_threshold;
+    return info;
+}
+
+void set_stack_info(stack_info_snapshot const & info) {
+    g_stack_info_init = info.m_init;
+    g_stack_size      = info.m_size;
+    g_stack_base      = info.m_base;
+    g_stack_threshold = info.m_threshold;
+}
+
+void set_custom_stack_info(size_t stack_size) {
+    g_stack_info_init = true;
+    g_stack_size = stack_size;
+    char x;
+    g_stack_base = reinterpret_cast<size_t>(&x);
+    g_stack_threshold = g_stack_base + LEAN_STACK_BUFFER_SPACE - g_stack_size;
+    if (g_stack_threshold > g_stack_base + LEAN_STACK_BUFFER_SPACE) {
+        // negative overflow
+        g_stack_threshold = 0;
+    }
+}
+
 size_t get_used_stack_size() {
     char y;
     size_t curr_stack = reinterpret_cast<size_t>(&y);
@@ -93,12 +127,22 @@ size_t get_available_stack_size() {
 }
 
 void check_stack(char const * component_name) {
-    if (!g_stack_info_init)
-        save_stack_info(false);
     char y;
     size_t curr_stack = reinterpret_cast<size_t>(&y);
-    if (curr_stack < g_stack_threshold)
-        throw stack_space_exception(component_name);
+    /* This shows up in flat profiles of deep `expr` traversals, so the common
+       case must stay a single thread-local read and a compare. The threshold
+       already is the precise bound (stack base - stack size + buffer space),
+       i.e. it doubles as the watermark; the guard page installed by
+       `stack_overflow.cpp` remains the last line of defense for frames that
+       skip the check. */
+    if (LEAN_LIKELY(curr_stack >= g_stack_threshold))
+        return;
+    if (!g_stack_info_init) {
+        save_stack_info(false);
+        if (curr_stack >= g_stack_threshold)
+            return;
+    }
+    throw stack_space_exception(component_name);
 }
 }
 #endif
@@ -46,20 +46,6 @@ void reset_thread_local() {
 
 using runnable = std::function<void()>;
 
-static void thread_main(void * p) {
-#ifdef LEAN_SMALL_ALLOCATOR
-    init_thread_heap();
-#endif
-    std::unique_ptr<runnable> f;
-    f.reset(reinterpret_cast<runnable *>(p));
-
-    (*f)();
-    f.reset();
-
-    run_thread_finalizers();
-    run_post_thread_finalizers();
-}
-
 #if defined(LEAN_MULTI_THREAD)
 size_t lthread::m_thread_stack_size = LEAN_DEFAULT_THREAD_STACK_SIZE;
 
@@ -72,25 +58,147 @@ size_t lthread::get_thread_stack_size() {
 }
 
 static runnable mk_thread_proc(runnable const & p, size_t max) {
-    return [=]() { set_max_heartbeat(max); p(); }; // NOLINT
+    /* `reset_heartbeat` matters for pooled threads, which inherit the counter
+       of the previous job. */
+    return [=]() { reset_heartbeat(); set_max_heartbeat(max); p(); }; // NOLINT
+}
+
+/* ---- Pooled worker threads ----
+
+   A thread whose `lthread` procedure returns parks itself instead of exiting;
+   the next `lthread` hands its procedure to a parked thread when one is
+   available, so repeated worker spawns (the task manager reacts to blocked
+   workers by spawning more) stop paying OS thread creation, stack commit, and
+   thread-local heap setup each time. A pooled thread keeps its heap across
+   jobs and runs its thread finalizers only when it retires, so procedures must
+   not rely on fresh thread-local state beyond what `mk_thread_proc` re-arms.
+   Only the number of *parked* threads is capped: capping running threads would
+   deadlock the task manager, whose blocked workers occupy their threads for
+   the whole session. */
+
+#ifndef LEAN_MAX_PARKED_THREADS
+#define LEAN_MAX_PARKED_THREADS 32
+#endif
+
+struct pool_job {
+    runnable           m_fn;
+    mutex              m_mutex;
+    condition_variable m_cv;
+    bool               m_done{false};
+    explicit pool_job(runnable const & fn):m_fn(fn) {}
+    void run() {
+        m_fn();
+        m_fn = nullptr; /* release captured state before signalling joiners */
+        unique_lock<mutex> lock(m_mutex);
+        m_done = true;
+        m_cv.notify_all();
+    }
+    void wait() {
+        unique_lock<mutex> lock(m_mutex);
+        m_cv.wait(lock, [&]() { return m_done; });
+    }
+};
+
+struct pool_worker {
+    mutex                     m_mutex;
+    condition_variable        m_cv;
+    std::shared_ptr<pool_job> m_job;
+    bool                      m_retire{false};
+
+    void assign(std::shared_ptr<pool_job> const & j) {
+        unique_lock<mutex> lock(m_mutex);
+        m_job = j;
+        m_cv.notify_one();
+    }
+
+    void retire() {
+        unique_lock<mutex> lock(m_mutex);
+        m_retire = true;
+        m_cv.notify_one();
+    }
+};
+
+class thread_pool {
+    mutex                      m_mutex;
+    std::vector<pool_worker *> m_parked;
+    bool                       m_finalizing{false};
+public:
+    /* Hand `j` to a parked thread; false when none is available. */
+    bool try_submit(std::shared_ptr<pool_job> const & j) {
+        pool_worker * w;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            if (m_parked.empty())
+                return false;
+            w = m_parked.back();
+            m_parked.pop_back();
+        }
+        w->assign(j);
+        return true;
+    }
+
+    /* Park `w`; false when the thread should retire instead. */
+    bool park(pool_worker * w) {
+        unique_lock<mutex> lock(m_mutex);
+        if (m_finalizing || m_parked.size() >= LEAN_MAX_PARKED_THREADS)
+            return false;
+        m_parked.push_back(w);
+        return true;
+    }
+
+    void retire_all() {
+        std::vector<pool_worker *> ws;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_finalizing = true;
+            ws.swap(m_parked);
+        }
+        for (pool_worker * w : ws)
+            w->retire();
+    }
+};
+
+/* Never deleted: threads still winding down at finalization call `park`. */
+static thread_pool * g_thread_pool = nullptr;
+
+static void pooled_worker_main(std::shared_ptr<pool_job> job) {
+#ifdef LEAN_SMALL_ALLOCATOR
+    init_thread_heap();
+#endif
+    pool_worker w;
+    while (true) {
+        job->run();
+        job.reset();
+        if (g_thread_pool == nullptr || !g_thread_pool->park(&w))
+            break;
+        unique_lock<mutex> lock(w.m_mutex);
+        w.m_cv.wait(lock, [&]() { return w.m_job != nullptr || w.m_retire; });
+        if (w.m_job == nullptr)
+            break;
+        job = w.m_job;
+        w.m_job = nullptr;
+    }
+    run_thread_finalizers();
+    run_post_thread_finalizers();
 }
 
 #if defined(LEAN_WINDOWS)
 /* Windows version */
 struct lthread::imp {
-    std::function<void(void)> m_proc;
-    HANDLE                    m_thread;
+    HANDLE m_thread;
 
     static DWORD WINAPI _main(void * p) {
-        thread_main(p);
+        std::unique_ptr<std::shared_ptr<pool_job>> j(reinterpret_cast<std::shared_ptr<pool_job>*>(p));
+        pooled_worker_main(*j);
         return 0;
     }
 
-    imp(runnable const & p) {
-        runnable * f = new std::function<void()>(mk_thread_proc(p, get_max_heartbeat()));
+    imp(std::shared_ptr<pool_job> const & j) {
+        auto * p = new std::shared_ptr<pool_job>(j);
         m_thread = CreateThread(nullptr, m_thread_stack_size,
-                                _main, f, 0, nullptr);
+                                _main, p, 0, nullptr);
         if (m_thread == NULL) {
+            delete p;
             throw exception("failed to create thread");
         }
     }
@@ -98,55 +206,66 @@ struct lthread::imp {
     ~imp() {
         CloseHandle(m_thread);
     }
-
-    void join() {
-        if (WaitForSingleObject(m_thread, INFINITE) == WAIT_FAILED) {
-            throw exception("failed to join thread");
-        }
-    }
 };
 #else
 /* OSX/Linux version based on pthreads */
 struct lthread::imp {
-    pthread_attr_t            m_attr;
-    pthread_t                 m_thread;
-    bool                      m_joined = false;
+    pthread_attr_t m_attr;
+    pthread_t      m_thread;
 
     static void * _main(void * p) {
         stack_guard guard;
-        thread_main(p);
+        std::unique_ptr<std::shared_ptr<pool_job>> j(reinterpret_cast<std::shared_ptr<pool_job>*>(p));
+        pooled_worker_main(*j);
         return nullptr;
     }
 
-    imp(runnable const & p) {
+    imp(std::shared_ptr<pool_job> const & j) {
         pthread_attr_init(&m_attr);
         if (pthread_attr_setstacksize(&m_attr, m_thread_stack_size)) {
             throw exception("failed to set thread stack size");
         }
-        runnable * f = new std::function<void()>(mk_thread_proc(p, get_max_heartbeat()));
-        if (pthread_create(&m_thread, &m_attr, _main, f)) {
+        auto * p = new std::shared_ptr<pool_job>(j);
+        if (pthread_create(&m_thread, &m_attr, _main, p)) {
+            delete p;
             throw exception("failed to create thread");
         }
     }
 
     ~imp() {
         pthread_attr_destroy(&m_attr);
-        if (!m_joined) pthread_detach(m_thread);
-    }
-
-    void join() {
-        m_joined = true;
-        if (pthread_join(m_thread, nullptr)) {
-            throw exception("failed to join thread");
-        }
+        pthread_detach(m_thread);
     }
 };
 #endif
-lthread::lthread(std::function<void(void)> const & p):m_imp(new imp(p)) {}
+lthread::lthread(std::function<void(void)> const & p):
+    m_job(std::make_shared<pool_job>(mk_thread_proc(p, get_max_heartbeat()))) {
+    if (g_thread_pool != nullptr && g_thread_pool->try_submit(m_job))
+        return;
+    m_imp.reset(new imp(m_job));
+}
 
 lthread::~lthread() {}
 
-void lthread::join() { m_imp->join(); }
+void lthread::join() { m_job->wait(); }
+
+static void initialize_thread_pool() {
+    g_thread_pool = new thread_pool();
+}
+
+static void finalize_thread_pool() {
+    g_thread_pool->retire_all();
+}
+#else
+static void initialize_thread_pool() {}
+static void finalize_thread_pool() {}
+#endif
+
+/* Zero-initialized TLS block; see the declaration in lean/thread.h. */
+#ifdef _MSC_VER
+__declspec(thread) thread_ctx g_thread_ctx;
+#else
+__thread thread_ctx g_thread_ctx LEAN_TLS_INITIAL_EXEC;
 #endif
 
 LEAN_THREAD_VALUE(bool, g_finalizing, false);
@@ -263,8 +382,10 @@ void run_post_thread_finalizers() {
 void initialize_thread() {
     g_thread_finalizers_mgr = new thread_finalizers_manager;
     initialize_thread_local_reset_fns();
+    initialize_thread_pool();
 }
 void finalize_thread() {
+    finalize_thread_pool();
     finalize_thread_local_reset_fns();
 }
 #else
@@ -305,8 +426,10 @@ void run_post_thread_finalizers() {
 
 void initialize_thread() {
     initialize_thread_local_reset_fns();
+    initialize_thread_pool();
 }
 void finalize_thread() {
+    finalize_thread_pool();
     finalize_thread_local_reset_fns();
 }
 #endif
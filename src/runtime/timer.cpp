@@ -0,0 +1,182 @@
+/*
+Copyright (c) 2019 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: Leonardo de Moura
+*/
+#include <memory>
+#include <lean/timer.h>
+#include <lean/stackinfo.h>
+
+#if defined(LEAN_MULTI_THREAD)
+namespace lean {
+
+#define LEAN_TIMER_TICK_MS       10
+#define LEAN_TIMER_WHEEL_BUCKETS 256
+
+struct timer_event {
+    /* Intrusive doubly-linked wheel bucket; `m_prev` is non-null iff the
+       event is still armed. Both fields are guarded by the wheel mutex. */
+    timer_event *  m_next{nullptr};
+    timer_event ** m_prev{nullptr};
+    uint64_t       m_deadline; /* absolute tick */
+    cancel_token * m_token;
+    /* One reference for the wheel, one for the caller of `set_timer`. */
+    atomic_uint    m_rc;
+    timer_event(cancel_token * tk, uint64_t deadline):
+        m_deadline(deadline), m_token(tk), m_rc(2) {
+        tk->inc_ref();
+    }
+};
+
+static void event_dec_ref(timer_event * e) {
+    if (e->m_rc.fetch_sub(1, memory_order_acq_rel) == 1)
+        delete e;
+}
+
+class timer_wheel {
+    mutex                            m_mutex;
+    condition_variable               m_cv;
+    timer_event *                    m_buckets[LEAN_TIMER_WHEEL_BUCKETS];
+    uint64_t                         m_curr_tick{0};
+    unsigned                         m_num_events{0};
+    bool                             m_shutting_down{false};
+    std::unique_ptr<lthread>         m_watcher;
+    chrono::steady_clock::time_point m_start;
+
+    uint64_t tick_of(chrono::steady_clock::time_point const & t) const {
+        return chrono::duration_cast<chrono::milliseconds>(t - m_start).count() / LEAN_TIMER_TICK_MS;
+    }
+
+    /* Caller must hold `m_mutex`. */
+    void unlink(timer_event * e) {
+        *e->m_prev = e->m_next;
+        if (e->m_next)
+            e->m_next->m_prev = e->m_prev;
+        e->m_prev = nullptr;
+        e->m_next = nullptr;
+        m_num_events--;
+    }
+
+    /* Caller must hold `m_mutex`. Fire every event in `tick`'s bucket whose
+       deadline has been reached; later rounds hashing to the same bucket stay. */
+    void expire_bucket(uint64_t tick) {
+        timer_event ** it = &m_buckets[tick % LEAN_TIMER_WHEEL_BUCKETS];
+        while (timer_event * e = *it) {
+            if (e->m_deadline <= tick) {
+                unlink(e);
+                /* Firing is just an atomic store on the token, so it is safe
+                   (and cheap) to do under the lock. */
+                e->m_token->cancel();
+                e->m_token->dec_ref();
+                event_dec_ref(e);
+            } else {
+                it = &e->m_next;
+            }
+        }
+    }
+
+    void worker() {
+        save_stack_info(false);
+        unique_lock<mutex> lock(m_mutex);
+        while (!m_shutting_down) {
+            if (m_num_events == 0) {
+                m_cv.wait(lock);
+                continue;
+            }
+            m_cv.wait_until(lock, m_start + chrono::milliseconds((m_curr_tick + 1) * LEAN_TIMER_TICK_MS));
+            if (m_shutting_down)
+                break;
+            uint64_t now_tick = tick_of(chrono::steady_clock::now());
+            while (m_curr_tick < now_tick) {
+                m_curr_tick++;
+                expire_bucket(m_curr_tick);
+            }
+        }
+    }
+
+public:
+    timer_wheel():m_start(chrono::steady_clock::now()) {
+        for (unsigned i = 0; i < LEAN_TIMER_WHEEL_BUCKETS; i++)
+            m_buckets[i] = nullptr;
+    }
+
+    timer_event * set(cancel_token * tk, unsigned ms) {
+        unique_lock<mutex> lock(m_mutex);
+        uint64_t deadline = tick_of(chrono::steady_clock::now())
+            + (ms + LEAN_TIMER_TICK_MS - 1) / LEAN_TIMER_TICK_MS + 1;
+        timer_event * e = new timer_event(tk, deadline);
+        timer_event ** b = &m_buckets[deadline % LEAN_TIMER_WHEEL_BUCKETS];
+        e->m_next = *b;
+        if (*b)
+            (*b)->m_prev = &e->m_next;
+        e->m_prev = b;
+        *b = e;
+        m_num_events++;
+        if (!m_watcher)
+            m_watcher.reset(new lthread([this]() { worker(); }));
+        m_cv.notify_one();
+        return e;
+    }
+
+    void cancel(timer_event * e) {
+        unique_lock<mutex> lock(m_mutex);
+        if (e->m_prev == nullptr)
+            return; /* already fired (or disarmed) */
+        unlink(e);
+        lock.unlock();
+        e->m_token->dec_ref();
+        event_dec_ref(e);
+    }
+
+    ~timer_wheel() {
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_shutting_down = true;
+            m_cv.notify_one();
+        }
+        if (m_watcher)
+            m_watcher->join();
+        /* Release pending events without firing them. */
+        for (unsigned i = 0; i < LEAN_TIMER_WHEEL_BUCKETS; i++) {
+            while (timer_event * e = m_buckets[i]) {
+                unlink(e);
+                e->m_token->dec_ref();
+                event_dec_ref(e);
+            }
+        }
+    }
+};
+
+static timer_wheel * g_timer_wheel = nullptr;
+
+timer_event * set_timer(cancel_token * tk, unsigned ms) {
+    return g_timer_wheel->set(tk, ms);
+}
+
+void cancel_timer(timer_event * e) {
+    g_timer_wheel->cancel(e);
+}
+
+void release_timer(timer_event * e) {
+    event_dec_ref(e);
+}
+
+void initialize_timer() {
+    g_timer_wheel = new timer_wheel();
+}
+
+void finalize_timer() {
+    delete g_timer_wheel;
+    g_timer_wheel = nullptr;
+}
+}
+#else
+namespace lean {
+timer_event * set_timer(cancel_token *, unsigned) { return nullptr; }
+void cancel_timer(timer_event *) {}
+void release_timer(timer_event *) {}
+void initialize_timer() {}
+void finalize_timer() {}
+}
+#endif
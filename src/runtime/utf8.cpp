@@ -5,6 +5,8 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <cstdlib>
+#include <cstring>
+#include <cstdint>
 #include <string>
 #include <lean/debug.h>
 #include <lean/optional.h>
@@ -33,22 +35,36 @@ unsigned get_utf8_size(unsigned char c) {
 }
 
 size_t utf8_strlen(char const * str) {
-    size_t r = 0;
-    while (*str != 0) {
-        unsigned sz = get_utf8_size(*str);
-        r++;
-        str += sz;
-    }
-    return r;
+    /* `strlen` is vectorized by libc, and the bounded scan below stops at the terminator even
+       when a (malformed) multi-byte sequence claims to extend past it. */
+    return utf8_strlen(str, strlen(str));
 }
 
 size_t utf8_strlen(char const * str, size_t sz) {
     size_t r = 0;
     size_t i = 0;
+    uint64_t const high_bits = 0x8080808080808080ull;
     while (i < sz) {
-        unsigned d = get_utf8_size(str[i]);
-        r++;
-        i += d;
+        if (static_cast<unsigned char>(str[i]) < 0x80) {
+            /* ASCII fast path: count whole words while no byte has the high bit set.
+               This is where string construction spends its time in practice (source code,
+               identifiers); non-ASCII and malformed bytes take the per-character path below
+               with the same semantics as before. */
+            if (i + 8 <= sz) {
+                uint64_t w;
+                memcpy(&w, str + i, 8);
+                if ((w & high_bits) == 0) {
+                    r += 8;
+                    i += 8;
+                    continue;
+                }
+            }
+            r++;
+            i++;
+        } else {
+            r++;
+            i += get_utf8_size(str[i]);
+        }
     }
     return r;
 }
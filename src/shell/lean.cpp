@@ -201,6 +201,10 @@ static void display_help(std::ostream & out) {
     std::cout << "  --server           start lean in server mode\n";
     std::cout << "  --worker           start lean in server-worker mode\n";
 #endif
+    std::cout << "  --batch            read compilation requests from stdin, one per line:\n"
+              << "                     '<input.lean> [<output.olean> [<output.c>]]'; after each request\n"
+              << "                     'ok <file>' or 'error <file>' is written to stdout. Lets a build\n"
+              << "                     tool reuse one initialized process for many files\n";
     std::cout << "  --plugin=file      load and initialize shared library for registering linters etc.\n";
     std::cout << "  --deps             just print dependencies of a Lean input\n";
     std::cout << "  --print-prefix     print the installation prefix for Lean and exit\n";
@@ -233,6 +237,7 @@ static struct option g_long_options[] = {
     {"timeout",      optional_argument, 0, 'T'},
     {"c",            optional_argument, 0, 'c'},
     {"exitOnPanic",  no_argument,       0, 'e'},
+    {"batch",        no_argument,       0, 'b'},
 #if defined(LEAN_MULTI_THREAD)
     {"threads",      required_argument, 0, 'j'},
     {"tstack",       required_argument, 0, 's'},
@@ -249,7 +254,7 @@ static struct option g_long_options[] = {
 };
 
 static char const * g_opt_str =
-    "PdD:o:c:C:qgvht:012j:012rR:M:012T:012ap:e"
+    "PdD:o:c:C:qgvht:012j:012rR:M:012T:012ap:eb"
 #if defined(LEAN_MULTI_THREAD)
     "s:012"
 #endif
@@ -367,6 +372,31 @@ extern "C" object* lean_environment_free_regions(object * env, object * w);
 void environment_free_regions(environment && env) {
     consume_io_result(lean_environment_free_regions(env.steal(), io_mk_world()));
 }
+
+/* Compiles a single file in the current process: runs the frontend and writes the requested
+   artifacts. Returns true if the file elaborated without errors. Used by `--batch` mode. */
+static bool compile_input(std::string const & mod_fn, std::string const & contents, options const & opts,
+                          optional<std::string> const & root_dir,
+                          std::string const & olean_out, std::string const & c_out) {
+    optional<name> mod_name = module_name_of_file(mod_fn, root_dir, /* optional */ olean_out.empty() && c_out.empty());
+    if (!mod_name)
+        mod_name = name("_stdin");
+    pair_ref<environment, object_ref> r = run_new_frontend(contents, opts, mod_fn, *mod_name);
+    environment env = r.fst();
+    bool ok = unbox(r.snd().raw());
+    if (ok && !olean_out.empty()) {
+        time_task t(".olean serialization", opts);
+        write_module(env, olean_out);
+    }
+    if (ok && !c_out.empty()) {
+        std::ofstream out(c_out);
+        if (out.fail())
+            throw exception(sstream() << "failed to create '" << c_out << "'");
+        time_task t("C code generation", opts);
+        ir::emit_c(out, env, *mod_name);
+    }
+    return ok;
+}
 }
 
 extern "C" object * lean_get_prefix(object * w);
@@ -411,6 +441,7 @@ int main(int argc, char ** argv) {
     unsigned trust_lvl = LEAN_BELIEVER_TRUST_LEVEL + 1;
     bool only_deps = false;
     bool stats = false;
+    bool batch_mode = false;
     // 0 = don't run server, 1 = watchdog, 2 = worker
     int run_server = 0; 
     unsigned num_threads    = 0;
@@ -474,6 +505,9 @@ int main(int argc, char ** argv) {
             case 'r':
                 run = true;
                 break;
+            case 'b':
+                batch_mode = true;
+                break;
             case 'o':
                 olean_fn = optarg;
                 break;
@@ -578,7 +612,34 @@ int main(int argc, char ** argv) {
             return run_server_watchdog(forwarded_args);
         else if (run_server == 2)
             return run_server_worker();
-            
+
+        if (batch_mode) {
+            /* One request per line: '<input.lean> [<output.olean> [<output.c>]]'. Environments
+               are dropped between requests, so files are isolated; what the long-lived process
+               amortizes is runtime/search-path initialization and the page-cache and package-root
+               caches warmed by earlier requests. */
+            std::string line;
+            bool all_ok = true;
+            while (std::getline(std::cin, line)) {
+                std::istringstream iss(line);
+                std::string src, olean_out, c_out;
+                iss >> src >> olean_out >> c_out;
+                if (src.empty())
+                    continue;
+                try {
+                    bool ok = compile_input(src, read_file(src), opts, root_dir, olean_out, c_out);
+                    std::cout << (ok ? "ok " : "error ") << src << std::endl;
+                    all_ok = all_ok && ok;
+                } catch (lean::throwable & ex) {
+                    std::cerr << ex.what() << "\n";
+                    std::cout << "error " << src << std::endl;
+                    all_ok = false;
+                }
+            }
+            return all_ok ? 0 : 1;
+        }
+
+
         if (use_stdin) {
             if (argc - optind != 0) {
                 mod_fn = argv[optind++];
@@ -589,11 +650,35 @@ int main(int argc, char ** argv) {
             buf << std::cin.rdbuf();
             contents = buf.str();
         } else {
-            if ((!run && argc - optind != 1) || (run && argc - optind == 0)) {
-                std::cerr << "Expected exactly one file name\n";
+            if ((!run && argc - optind < 1) || (run && argc - optind == 0)) {
+                std::cerr << "Expected at least one file name\n";
                 display_help(std::cerr);
                 return 1;
             }
+            if (!run && argc - optind > 1) {
+                /* Multiple inputs: compile them in order in this one process, so a later file
+                   importing an earlier one's dependencies benefits from the warmed package-root
+                   cache and page-cache-backed regions instead of re-paying startup per process.
+                   Per-file artifact names cannot be expressed with a single -o/-c, so those
+                   combinations go through `--batch`. */
+                if (olean_fn || c_output) {
+                    std::cerr << "-o/-c accept a single input file; use --batch for per-file outputs\n";
+                    return 1;
+                }
+                bool all_ok = true;
+                while (optind < argc) {
+                    std::string fn = argv[optind++];
+                    try {
+                        if (!compile_input(fn, read_file(fn), opts, root_dir, "", ""))
+                            all_ok = false;
+                    } catch (lean::throwable & ex) {
+                        std::cerr << fn << ": " << ex.what() << "\n";
+                        all_ok = false;
+                    }
+                }
+                display_cumulative_profiling_times(std::cerr);
+                return all_ok ? 0 : 1;
+            }
             mod_fn = argv[optind++];
             contents = read_file(mod_fn);
             main_module_name = module_name_of_file(mod_fn, root_dir, /* optional */ !olean_fn && !c_output);
@@ -647,7 +732,7 @@ int main(int argc, char ** argv) {
                 return 1;
             }
             time_task _("C code generation", opts);
-            out << lean::ir::emit_c(env, *main_module_name).data();
+            lean::ir::emit_c(out, env, *main_module_name);
             out.close();
         }
 
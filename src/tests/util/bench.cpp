@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Microbenchmarks for runtime primitives. Each benchmark prints one JSON line
+(name, iteration count, nanoseconds per iteration) so successive runs can be
+diffed mechanically. Not registered as a test: the numbers are for comparing
+two builds, not for pass/fail.
+*/
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include "util/timeit.h"
+#include "util/name.h"
+#include "util/init_module.h"
+#include <lean/object.h>
+#include <lean/hash.h>
+#include <lean/thread.h>
+#include <lean/stackinfo.h>
+using namespace lean;
+
+/* Runs `fn(n)` with growing `n` until the measurement is long enough to be stable,
+   then reports the cost per iteration. */
+static void bench(char const * name, std::function<void(size_t)> const & fn) {
+    size_t n = 1024;
+    double elapsed;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        fn(n);
+        elapsed = second_duration(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= 0.2 || n >= (static_cast<size_t>(1) << 28))
+            break;
+        n *= 4;
+    }
+    std::cout << "{\"name\": \"" << name << "\", \"iters\": " << n
+              << ", \"ns_per_iter\": " << elapsed * 1e9 / static_cast<double>(n) << "}\n";
+}
+
+static void bench_alloc() {
+    bench("alloc_cnstr_2", [](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            object * o = alloc_cnstr(0, 2, 0);
+            cnstr_set(o, 0, box(i));
+            cnstr_set(o, 1, box(i));
+            dec(o);
+        }
+    });
+}
+
+static object * add_fn(object * a, object * b) {
+    return box(unbox(a) + unbox(b));
+}
+
+static void bench_apply() {
+    bench("closure_apply_1", [](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            object * c = alloc_closure(reinterpret_cast<void*>(add_fn), 2, 1);
+            closure_set(c, 0, box(1));
+            object * r = apply_1(c, box(i));
+            dec(r);
+        }
+    });
+}
+
+static void bench_array_push() {
+    bench("array_push", [](size_t n) {
+        object * a = array_mk_empty();
+        for (size_t i = 0; i < n; i++) {
+            a = lean_array_push(a, box(i));
+        }
+        dec(a);
+    });
+}
+
+static void bench_string_push() {
+    bench("string_push", [](size_t n) {
+        object * s = mk_string("");
+        for (size_t i = 0; i < n; i++) {
+            s = lean_string_push(s, 'a');
+        }
+        dec(s);
+    });
+}
+
+/* keeps results observable so the hash loops are not optimized away */
+static volatile uint64 g_sink;
+
+static void bench_hashing() {
+    char buf[64];
+    for (unsigned i = 0; i < sizeof(buf); i++)
+        buf[i] = static_cast<char>('a' + i % 26);
+    bench("hash_str_64", [&](size_t n) {
+        unsigned h = 11;
+        for (size_t i = 0; i < n; i++)
+            h = hash_str(sizeof(buf), buf, h);
+        g_sink = h;
+    });
+    bench("hash_bytes_64", [&](size_t n) {
+        uint64 h = 11;
+        for (size_t i = 0; i < n; i++)
+            h = hash_bytes(sizeof(buf), buf, h);
+        g_sink = h;
+    });
+    name deep = name({"foo", "bar", "baz", "qux"});
+    bench("name_hash", [&](size_t n) {
+        uint64 h = 0;
+        for (size_t i = 0; i < n; i++)
+            h += name::hash(deep.raw());
+        g_sink = h;
+    });
+}
+
+static object * id_fn(object * u) {
+    return u;
+}
+
+static void bench_task_spawn() {
+#if defined(LEAN_MULTI_THREAD)
+    scoped_task_manager tm(hardware_concurrency());
+    bench("task_spawn_get", [](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            object * c = alloc_closure(reinterpret_cast<void*>(id_fn), 1, 0);
+            object * t = lean_task_spawn_core(c, 0, false);
+            object * v = lean_task_get_own(t);
+            dec(v);
+        }
+    });
+#endif
+}
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    bench_alloc();
+    bench_apply();
+    bench_array_push();
+    bench_string_push();
+    bench_hashing();
+    bench_task_spawn();
+    finalize_util_module();
+    return 0;
+}
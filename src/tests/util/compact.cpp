@@ -37,10 +37,52 @@ void tst1() {
     std::cout << mpz_value(r.read()) << "\n";
 }
 
+static size_t compacted_size(object * o) {
+    object_compactor c;
+    c(o);
+    return c.size();
+}
+
+void tst2() {
+    /* Incremental compaction: seeding a compactor with an existing region shares
+       unchanged subgraphs instead of copying them again. */
+    name n1{"hello", "bla", "world", "foo", "boo"};
+    object_compactor c1;
+    c1(n1.raw());
+    name n2(n1, "extra");
+    object_compactor c2(c1.data(), c1.size());
+    c2(n2.raw());
+    /* Only the new name cell and its string should have been appended. */
+    lean_assert(c2.size() < c1.size() + compacted_size(n2.raw()));
+    compacted_region r(c2);
+    name n3(r.read());
+    lean_assert(n3 == n2);
+    lean_assert(n3.get_prefix() == n1);
+}
+
+void tst3() {
+    /* mpz literals are max-shared by content like strings. */
+    object_ref a(mk_nat_obj(mpz("123456789123456789123456789")));
+    object_ref b(mk_nat_obj(mpz("123456789123456789123456789")));
+    lean_assert(a.raw() != b.raw());
+    object_compactor c;
+    c(a.raw());
+    size_t sz1 = c.size();
+    c(b.raw());
+    /* only a terminator should have been appended for the duplicate value */
+    lean_assert(c.size() - sz1 < 4 * sizeof(void*));
+    compacted_region r(c);
+    object * x = r.read();
+    object * y = r.read();
+    lean_assert(x == y);
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
     tst1();
+    tst2();
+    tst3();
     finalize_util_module();
     return has_violations() ? 1 : 0;
 }
@@ -229,6 +229,35 @@ static void tst18() {
     lean_assert(is_eqp(tail(tail(l)), tail(l2)));
 }
 
+static void tst19() {
+    list<int> l({1, 2, 3, 4});
+    typename list<int>::cell * c = l.raw();
+    list<int> r = map(std::move(l), [](int const & v) { return v * 10; });
+    lean_assert_eq(r, list<int>({10, 20, 30, 40}));
+    lean_assert(is_eqp(r, c)); // the exclusively referenced spine was reused
+    list<int> shared({7, 8});
+    list<int> l2 = cons(1, cons(2, shared));
+    list<int> r2 = map(std::move(l2), [](int const & v) { return v + 1; });
+    lean_assert_eq(r2, list<int>({2, 3, 8, 9}));
+    lean_assert_eq(shared, list<int>({7, 8})); // the shared suffix was copied
+    list<int> l3({5, 6});
+    list<int> l4 = l3;
+    lean_assert_eq(map(std::move(l4), [](int const & v) { return v - 1; }), list<int>({4, 5}));
+    lean_assert_eq(l3, list<int>({5, 6}));
+    lean_assert(empty(map(list<int>(), [](int const & v) { return v; })));
+}
+
+static void tst20() {
+    list<int> l({1, 2, 3, 4, 5, 6});
+    lean_assert_eq(filter(std::move(l), [](int v) { return v % 2 == 1; }), list<int>({1, 3, 5}));
+    lean_assert(empty(filter(list<int>({2, 4}), [](int v) { return v % 2 == 1; })));
+    lean_assert_eq(filter(list<int>({1, 3}), [](int v) { return v % 2 == 1; }), list<int>({1, 3}));
+    list<int> shared({2, 3});
+    list<int> l2 = cons(9, cons(2, shared));
+    lean_assert_eq(filter(std::move(l2), [](int v) { return v % 2 == 1; }), list<int>({9, 3}));
+    lean_assert_eq(shared, list<int>({2, 3}));
+}
+
 int main() {
     initialize_util_module();
     tst1();
@@ -249,6 +278,8 @@ int main() {
     tst16();
     tst17();
     tst18();
+    tst19();
+    tst20();
     finalize_util_module();
     return has_violations() ? 1 : 0;
 }
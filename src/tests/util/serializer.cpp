@@ -87,6 +87,28 @@ static void tst4() {
     lean_assert_eq(d5, o5);
 }
 
+static void tst5() {
+    /* streaming mode: back references do not cross element boundaries and the
+       reader drops its window after each element */
+    std::ostringstream out;
+    serializer s(out);
+    name n1{"foo", "bla"};
+    name n2(n1, "tst");
+    s.write_size_t(3);
+    s.write_stream_elem(n1.raw());
+    s.write_stream_elem(n2.raw());
+    s.write_stream_elem(n1.raw());
+    std::istringstream in(out.str());
+    deserializer d(in);
+    lean_assert(d.read_size_t() == 3);
+    name m1(d.read_stream_elem());
+    name m2(d.read_stream_elem());
+    name m3(d.read_stream_elem());
+    lean_assert(m1 == n1);
+    lean_assert(m2 == n2);
+    lean_assert(m3 == n1);
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -94,6 +116,7 @@ int main() {
     tst2();
     tst3();
     tst4();
+    tst5();
     finalize_util_module();
     return has_violations() ? 1 : 0;
 }
@@ -7,8 +7,12 @@ Author: Leonardo de Moura
 #pragma once
 #include <algorithm>
 #include <cstring>
+#include <memory>
+#include <iterator>
+#include <type_traits>
 #include <lean/debug.h>
 #include <lean/optional.h>
+#include <lean/alloc.h>
 
 namespace lean {
 /**
@@ -23,19 +27,28 @@ protected:
     T *      m_buffer;
     unsigned m_pos;
     unsigned m_capacity;
-    char     m_initial_buffer[INITIAL_SIZE * sizeof(T)];
+    alignas(T) char m_initial_buffer[INITIAL_SIZE * sizeof(T)];
 
     void free_memory() {
         if (m_buffer != reinterpret_cast<T*>(m_initial_buffer))
-            delete[] reinterpret_cast<char*>(m_buffer);
+            dealloc(m_buffer, sizeof(T) * m_capacity);
     }
 
     void expand() {
-        unsigned new_capacity  = m_capacity << 1;
-        char * new_buffer_char = new char[sizeof(T) * new_capacity];
-        T * new_buffer         = reinterpret_cast<T*>(new_buffer_char);
-        std::uninitialized_copy(m_buffer, m_buffer + m_pos, new_buffer);
-        destroy();
+        unsigned new_capacity = m_capacity << 1;
+        /* Heap storage comes from the Lean small-object allocator: growth in
+           the common (small) capacity range is a thread-local free-list pop
+           instead of a libc malloc. */
+        T * new_buffer        = static_cast<T*>(alloc(sizeof(T) * new_capacity));
+        if (std::is_trivially_copyable<T>::value) {
+            /* Trivial elements are relocated with one memcpy and the old ones
+               need no destructor calls. */
+            std::memcpy(static_cast<void *>(new_buffer), static_cast<void const *>(m_buffer), sizeof(T) * m_pos);
+            free_memory();
+        } else {
+            std::uninitialized_copy(std::make_move_iterator(m_buffer), std::make_move_iterator(m_buffer + m_pos), new_buffer);
+            destroy();
+        }
         m_buffer              = new_buffer;
         m_capacity            = new_capacity;
     }
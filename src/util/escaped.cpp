@@ -5,6 +5,10 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include "util/escaped.h"
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define LEAN_ESCAPED_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace lean {
 
@@ -23,11 +27,48 @@ char const * escaped::end() const {
     return e;
 }
 
+/* Return a pointer to the first character in <tt>[it, e)</tt> that needs
+   special handling (a quote to escape, or a newline when indentation is
+   emitted), or \c e if the span is clean. The caller bulk-copies clean spans;
+   streaming one character at a time dominated the cost of emitting large
+   string literals. */
+static char const * find_special(char const * it, char const * e, bool nl_special) {
+#ifdef LEAN_ESCAPED_SSE2
+    __m128i const quote = _mm_set1_epi8('"');
+    __m128i const nl    = _mm_set1_epi8('\n');
+    while (e - it >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(it));
+        __m128i hit   = _mm_cmpeq_epi8(chunk, quote);
+        if (nl_special)
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, nl));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask != 0)
+            return it + __builtin_ctz(mask);
+        it += 16;
+    }
+#endif
+    for (; it != e; ++it) {
+        if (*it == '"' || (nl_special && *it == '\n'))
+            break;
+    }
+    return it;
+}
+
 std::ostream & operator<<(std::ostream & out, escaped const & s) {
     char const * it = s.m_str;
     char const * e  = s.end();
-    for (; it != e; ++it) {
+    /* A newline is only special when it triggers indentation output. */
+    bool nl_special = s.m_indent > 0;
+    while (it != e) {
+        char const * sp = find_special(it, e, nl_special);
+        if (sp != it) {
+            out.write(it, sp - it);
+            it = sp;
+            if (it == e)
+                break;
+        }
         char c = *it;
+        ++it;
         if (c == '"') {
             out << '\\';
         }
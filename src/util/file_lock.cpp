@@ -10,6 +10,7 @@ Author: Leonardo de Moura
 #include <fcntl.h>
 #include <lean/exception.h>
 #include <lean/sstream.h>
+#include <lean/interrupt.h>
 #include "util/file_lock.h"
 
 #if defined(LEAN_WINDOWS)
@@ -34,7 +35,10 @@ static BOOL lock(HANDLE h, int non_blocking, int exclusive) {
     if (exclusive)
         flags |= LOCKFILE_EXCLUSIVE_LOCK;
 
-    return LockFileEx(h, flags, 0, lower, upper, &ovlp);
+    BOOL res = LockFileEx(h, flags, 0, lower, upper, &ovlp);
+    if (!res && non_blocking && GetLastError() == ERROR_LOCK_VIOLATION)
+        errno = EWOULDBLOCK; /* match the POSIX flock contention report */
+    return res;
 }
 
 static BOOL unlock(HANDLE h) {
@@ -89,7 +93,22 @@ file_lock::file_lock(char const * fname, bool exclusive):
             throw exception(sstream() << "failed to open lock file for '" << fname << "': " << strerror(errno));
         }
     } else {
-        int status = flock(m_fd, exclusive ? LOCK_EX : LOCK_SH);
+        /* Readers take the lock shared, so concurrent imports of the same
+           module never serialize on each other; only a writer excludes them.
+           The uncontended case is a single non-blocking attempt. On contention
+           we wait in bounded interruptible sleeps instead of parking inside
+           `flock`: a blocked `flock` cannot be interrupted, so a canceled job
+           would keep its task worker pinned for as long as the writer holds
+           the lock. */
+        int op = (exclusive ? LOCK_EX : LOCK_SH) | LOCK_NB;
+        int status = flock(m_fd, op);
+        unsigned delay_ms = 1;
+        while (status == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
+            sleep_for(delay_ms);
+            if (delay_ms < 64)
+                delay_ms *= 2;
+            status = flock(m_fd, op);
+        }
         if (status == -1)
             throw exception(sstream() << "failed to lock file '" << fname << "': " << strerror(errno));
     }
@@ -10,10 +10,12 @@ Author: Leonardo de Moura
 #include "util/name_generator.h"
 #include "util/options.h"
 #include "util/format.h"
+#include "util/timeit.h"
 
 namespace lean {
 void initialize_util_module() {
     initialize_runtime_module();
+    initialize_timeit();
     initialize_ascii();
     initialize_name();
     initialize_name_generator();
@@ -26,6 +28,7 @@ void finalize_util_module() {
     finalize_name_generator();
     finalize_name();
     finalize_ascii();
+    finalize_timeit();
     finalize_runtime_module();
 }
 }
@@ -41,6 +41,20 @@ bool operator<(data_value const & a, data_value const & b) {
     lean_unreachable();
 }
 
+/* Returns the `data_value` object bound to `k` as a borrowed pointer into `m`, or nullptr.
+   Walking the raw cells avoids the per-cell reference counting `find` pays; the typed
+   accessors below only touch the counters of the value they actually return. */
+static object * find_core(kvmap const & m, name const & k) {
+    object * it = m.raw();
+    while (!is_scalar(it)) {
+        object * entry = cnstr_get(it, 0);
+        if (name::eq(cnstr_get(entry, 0), k.raw()))
+            return cnstr_get(entry, 1);
+        it = cnstr_get(it, 1);
+    }
+    return nullptr;
+}
+
 optional<data_value> find(kvmap m, name const & k) {
     while (!is_nil(m)) {
         if (head(m).fst() == k)
@@ -51,33 +65,33 @@ optional<data_value> find(kvmap m, name const & k) {
 }
 
 optional<string_ref> get_string(kvmap const & m, name const & k) {
-    optional<data_value> r = find(m, k);
-    if (r && r->kind() == data_value_kind::String)
-        return optional<string_ref>(r->get_string());
+    object * v = find_core(m, k);
+    if (v && cnstr_tag(v) == static_cast<unsigned>(data_value_kind::String))
+        return optional<string_ref>(string_ref(cnstr_get(v, 0), true));
     else
         return optional<string_ref>();
 }
 
 optional<nat> get_nat(kvmap const & m, name const & k) {
-    optional<data_value> r = find(m, k);
-    if (r && r->kind() == data_value_kind::Nat)
-        return optional<nat>(r->get_nat());
+    object * v = find_core(m, k);
+    if (v && cnstr_tag(v) == static_cast<unsigned>(data_value_kind::Nat))
+        return optional<nat>(nat(cnstr_get(v, 0), true));
     else
         return optional<nat>();
 }
 
 optional<bool> get_bool(kvmap const & m, name const & k) {
-    optional<data_value> r = find(m, k);
-    if (r && r->kind() == data_value_kind::Bool)
-        return optional<bool>(r->get_bool());
+    object * v = find_core(m, k);
+    if (v && cnstr_tag(v) == static_cast<unsigned>(data_value_kind::Bool))
+        return optional<bool>(lean_ctor_get_uint8(v, 0) != 0);
     else
         return optional<bool>();
 }
 
 optional<name> get_name(kvmap const & m, name const & k) {
-    optional<data_value> r = find(m, k);
-    if (r && r->kind() == data_value_kind::Name)
-        return optional<name>(r->get_name());
+    object * v = find_core(m, k);
+    if (v && cnstr_tag(v) == static_cast<unsigned>(data_value_kind::Name))
+        return optional<name>(name(cnstr_get(v, 0), true));
     else
         return optional<name>();
 }
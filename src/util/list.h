@@ -31,6 +31,11 @@ public:
         ~cell() {}
         T const & head() const { return m_head; }
         list const & tail() const { return m_tail; }
+        /* Mutable accessors for the destructive transforms in list_fn.h.
+           They may only be used when this cell is exclusively referenced
+           (i.e., get_rc() == 1). */
+        T & head() { return m_head; }
+        list & tail() { return m_tail; }
         void dealloc();
     };
 private:
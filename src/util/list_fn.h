@@ -143,6 +143,31 @@ list<T> map(list<T> const & l, F && f) {
     return map2<T, T, F>(l, std::move(f));
 }
 
+/**
+   \brief Version of \c map that consumes \c l and updates exclusively
+   referenced cells in place instead of allocating new ones. Copying
+   resumes at the first shared cell.
+*/
+template<typename T, typename F>
+list<T> map(list<T> && l, F && f) {
+    typedef typename list<T>::cell cell;
+    cell * it   = l.raw();
+    cell * last = nullptr; /* last exclusively referenced cell visited */
+    while (it && it->get_rc() == 1) {
+        it->head() = f(it->head());
+        last       = it;
+        it         = it->tail().raw();
+    }
+    if (it) {
+        /* \c it is reachable from another list; the remaining cells must be copied. */
+        list<T> new_tail = map2<T, T>(list<T>(it), f);
+        if (last == nullptr)
+            return new_tail;
+        last->tail() = new_tail;
+    }
+    return std::move(l);
+}
+
 /**
    \brief Filter/Remove elements from the list
    that do not satisfy the given predicate.
@@ -171,6 +196,35 @@ list<T> filter(list<T> const & l, P && p) {
     }
 }
 
+/**
+   \brief Version of \c filter that consumes \c l and unlinks the dropped
+   cells from the spine in place while the cells are exclusively referenced.
+   Copying resumes at the first shared cell.
+*/
+template<typename T, typename P>
+list<T> filter(list<T> && l, P && p) {
+    typedef typename list<T>::cell cell;
+    list<T> * slot = &l; /* location holding the reference to \c it */
+    cell * it      = l.raw();
+    while (it && it->get_rc() == 1) {
+        cell * next = it->tail().raw();
+        if (p(it->head())) {
+            slot = &it->tail();
+        } else {
+            /* Unlink the cell; the assignment drops the last reference to it. */
+            list<T> rest = it->tail();
+            *slot = rest;
+        }
+        it = next;
+    }
+    if (it) {
+        /* \c it is reachable from another list; filter the remaining cells by copying. */
+        list<T> suffix(it);
+        *slot = filter(suffix, p);
+    }
+    return std::move(l);
+}
+
 /** \brief Remove all occurrences of \c a from \c l */
 template<typename T>
 list<T> remove(list<T> const & l, T const & a) {
@@ -155,6 +155,42 @@ list_ref<T> map(list_ref<T> const & l, F && f) {
     return map2<T, T, F>(l, std::move(f));
 }
 
+/** \brief Version of `map` that consumes `l` and stores the new heads into the
+    exclusively referenced cons cells in place instead of rebuilding the spine.
+    This is the same reuse the compiler performs for Lean code: a list that is
+    uniquely referenced at the call site is updated destructively, and copying
+    resumes at the first cell that is shared (or marked multi-threaded or
+    persistent, for which `is_exclusive` is also false). */
+template<typename T, typename F>
+list_ref<T> map(list_ref<T> && l, F && f) {
+    object * r    = l.steal();
+    object * last = nullptr; /* last exclusively referenced cell visited */
+    object * it   = r;
+    while (!is_scalar(it) && is_exclusive(it)) {
+        T const & h = head<T>(it);
+        T new_h     = f(h);
+        if (new_h.raw() != h.raw()) {
+            object * old_h = cnstr_get(it, 0);
+            cnstr_set(it, 0, new_h.steal());
+            dec(old_h);
+        }
+        last = it;
+        it   = cnstr_get(it, 1);
+    }
+    if (!is_scalar(it)) {
+        /* `it` is visible to other owners; the remaining cells must be copied. */
+        list_ref<T> new_tail = map2<T, T>(list_ref<T>(it, true), f);
+        if (last == nullptr) {
+            dec(r);
+            return new_tail;
+        }
+        object * old_tail = cnstr_get(last, 1);
+        cnstr_set(last, 1, new_tail.steal());
+        dec(old_tail);
+    }
+    return list_ref<T>(r);
+}
+
 template<typename T, typename F>
 list_ref<T> map_reuse(list_ref<T> const & l, F && f) {
     if (is_nil(l))
@@ -236,6 +272,36 @@ list_ref<T> filter(list_ref<T> const & l, P && p) {
     return l; // no element was removed
 }
 
+/** \brief Version of `filter` that consumes `l` and unlinks the dropped cells
+    from the spine in place while the cells are exclusively referenced, instead
+    of rebuilding the kept prefix. Copying resumes at the first shared cell. */
+template<typename T, typename P>
+list_ref<T> filter(list_ref<T> && l, P && p) {
+    object *  r    = l.steal();
+    object ** slot = &r; /* location holding the reference to `it` */
+    object *  it   = r;
+    while (!is_scalar(it) && is_exclusive(it)) {
+        object * next = cnstr_get(it, 1);
+        if (p(head<T>(it))) {
+            slot = cnstr_obj_cptr(it) + 1;
+        } else {
+            /* Unlink the cell: the reference it held to `next` is transferred to `*slot`. */
+            cnstr_set(it, 1, box(0));
+            *slot = next;
+            dec(it);
+        }
+        it = next;
+    }
+    if (!is_scalar(it)) {
+        /* `it` is visible to other owners; filter the remaining cells by copying. */
+        list_ref<T> suffix(it, true);
+        list_ref<T> new_tail = filter(suffix, p);
+        *slot = new_tail.steal();
+        dec(it);
+    }
+    return list_ref<T>(r);
+}
+
 /** \brief Append two lists */
 template<typename T> list_ref<T> append(list_ref<T> const & l1, list_ref<T> const & l2) {
     if (!l1) {
@@ -27,9 +27,6 @@ static inline obj_res name_mk_string_of_cstr(obj_arg p, char const * s) {
     return lean_name_mk_string(p, mk_string(s));
 }
 
-extern "C" uint64_t lean_name_hash(obj_arg n);
-uint64_t name::hash(b_obj_arg n) { inc(n); return lean_name_hash(n); }
-
 bool name::eq_core(b_obj_arg n1, b_obj_arg n2) {
     while (true) {
         lean_assert(!is_scalar(n1));
@@ -42,7 +39,7 @@ bool name::eq_core(b_obj_arg n1, b_obj_arg n2) {
             if (!string_eq(cnstr_get(n1, 1), cnstr_get(n2, 1)))
                 return false;
         } else {
-            if (!nat_eq(cnstr_get(n1, 1), cnstr_get(n1, 1)))
+            if (!nat_eq(cnstr_get(n1, 1), cnstr_get(n2, 1)))
                 return false;
         }
         n1 = cnstr_get(n1, 0);
@@ -222,11 +219,20 @@ bool operator==(name const & a, char const * b) {
 }
 
 int name::cmp_core(object * i1, object * i2) {
+    if (i1 == i2)
+        return 0;
     buffer<object*> limbs1, limbs2;
     copy_limbs(i1, limbs1);
     copy_limbs(i2, limbs2);
     auto it1 = limbs1.begin();
     auto it2 = limbs2.begin();
+    /* Hierarchical names are built by extending an existing prefix, so the
+       common prefix of two related names is usually the same object limb for
+       limb. Skip it by pointer identity instead of comparing components. */
+    while (it1 != limbs1.end() && it2 != limbs2.end() && *it1 == *it2) {
+        ++it1;
+        ++it2;
+    }
     for (; it1 != limbs1.end() && it2 != limbs2.end(); ++it1, ++it2) {
         i1 = *it1;
         i2 = *it2;
@@ -236,10 +242,8 @@ int name::cmp_core(object * i1, object * i2) {
             return k1 == name_kind::STRING ? 1 : -1;
 
         if (k1 == name_kind::STRING) {
-            if (get_string(i1) < get_string(i2))
-                return -1;
-            if (get_string(i2) < get_string(i1))
-                return 1;
+            if (int r = cmp(get_string(i1), get_string(i2)))
+                return r < 0 ? -1 : 1;
         } else {
             if (get_numeral(i1) < get_numeral(i2))
                 return -1;
@@ -99,7 +99,13 @@ public:
     static name mk_internal_unique_name();
     name & operator=(name const & other) { object_ref::operator=(other); return *this; }
     name & operator=(name && other) { object_ref::operator=(other); return *this; }
-    static uint64_t hash(b_obj_arg n);
+    /* `Name.str`/`Name.num` store their hash code in a scalar field, see `Name.hash` in
+       `Init.Prelude`; read it directly instead of calling into compiled Lean code. */
+    static uint64_t hash(b_obj_arg n) {
+        if (is_scalar(n))
+            return 1723; /* hash of `Name.anonymous` */
+        return lean_ctor_get_uint64(n, sizeof(object*)*2);
+    }
     unsigned hash() const { return hash(raw()); }
     /** \brief Return true iff \c n1 is a prefix of \c n2. */
     friend bool is_prefix_of(name const & n1, name const & n2);
@@ -202,7 +208,7 @@ public:
 
 name string_to_name(std::string const & str);
 
-struct name_hash_fn { unsigned operator()(name const & n) const { return n.hash(); } };
+struct name_hash_fn { size_t operator()(name const & n) const { return static_cast<size_t>(name::hash(n.raw())); } };
 struct name_eq_fn { bool operator()(name const & n1, name const & n2) const { return n1 == n2; } };
 struct name_cmp {
     typedef name type;
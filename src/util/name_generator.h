@@ -46,7 +46,14 @@ public:
 
     /**
         \brief Create a child name_generator, each child name_generator is guaranteed to produce
-        names different from this name_generator and any other name_generator created with this generator. */
+        names different from this name_generator and any other name_generator created with this generator.
+
+        This is also the intended way to hand out name generation to concurrent tasks: fork one
+        child per task and move it into the task. Each generator is an ordinary two-word value
+        owned by exactly one task, so generating a name is a prefix extension with no locks,
+        atomics, or shared counters; uniqueness across tasks comes from the disjoint child
+        prefixes, not from coordination. Forking costs one name cell, and only deepens the
+        prefix of the forked-off branch. */
     name_generator mk_child() { return name_generator(next()); }
 
     /**
@@ -4,9 +4,25 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <iostream>
+#include <lean/thread.h>
 #include "util/object_ref.h"
 
 namespace lean {
+#ifdef LEAN_OBJECT_REF_STATS
+static atomic<uint64_t> g_object_ref_copies(0);
+static atomic<uint64_t> g_object_ref_moves(0);
+void object_ref_count_copy() { g_object_ref_copies.fetch_add(1, memory_order_relaxed); }
+void object_ref_count_move() { g_object_ref_moves.fetch_add(1, memory_order_relaxed); }
+struct object_ref_stats {
+    ~object_ref_stats() {
+        std::cerr << "num. object_ref copies: " << g_object_ref_copies << "\n";
+        std::cerr << "num. object_ref moves:  " << g_object_ref_moves << "\n";
+    }
+};
+static object_ref_stats g_object_ref_stats;
+#endif
+
 object_ref mk_cnstr(unsigned tag, unsigned num_objs, object ** objs, unsigned scalar_sz) {
     object * r = alloc_cnstr(tag, num_objs, scalar_sz);
     for (unsigned i = 0; i < num_objs; i++) {
@@ -12,6 +12,21 @@ Author: Leonardo de Moura
 #include <lean/serializer.h>
 
 namespace lean {
+#ifdef LEAN_OBJECT_REF_STATS
+/* Count object_ref copies (which pay an inc/dec pair) vs moves (which are
+   free). Compiled out by default; see object_ref.cpp for the report printed
+   at exit. Attributing the traffic to call sites is done by running a build
+   with this flag under a sampling profiler and breaking on the counter
+   functions. */
+void object_ref_count_copy();
+void object_ref_count_move();
+#define LEAN_OBJECT_REF_COPY_STAT() object_ref_count_copy();
+#define LEAN_OBJECT_REF_MOVE_STAT() object_ref_count_move();
+#else
+#define LEAN_OBJECT_REF_COPY_STAT()
+#define LEAN_OBJECT_REF_MOVE_STAT()
+#endif
+
 /* Smart point for Lean objects. It is useful for writing C++ code that manipulates Lean objects.  */
 class object_ref {
 protected:
@@ -20,10 +35,11 @@ public:
     object_ref():m_obj(box(0)) {}
     explicit object_ref(obj_arg o):m_obj(o) { lean_assert(is_scalar(o) || !is_heap_obj(o) || lean_nonzero_rc(o)); }
     object_ref(b_obj_arg o, bool):m_obj(o) { inc(o); }
-    object_ref(object_ref const & s):m_obj(s.m_obj) { inc(m_obj); }
-    object_ref(object_ref && s):m_obj(s.m_obj) { s.m_obj = box(0); }
+    object_ref(object_ref const & s):m_obj(s.m_obj) { LEAN_OBJECT_REF_COPY_STAT(); inc(m_obj); }
+    object_ref(object_ref && s):m_obj(s.m_obj) { LEAN_OBJECT_REF_MOVE_STAT(); s.m_obj = box(0); }
     ~object_ref() { dec(m_obj); }
     object_ref & operator=(object_ref const & s) {
+        LEAN_OBJECT_REF_COPY_STAT();
         inc(s.m_obj);
         object * new_obj = s.m_obj;
         dec(m_obj);
@@ -31,6 +47,7 @@ public:
         return *this;
     }
     object_ref & operator=(object_ref && s) {
+        LEAN_OBJECT_REF_MOVE_STAT();
         dec(m_obj);
         m_obj   = s.m_obj;
         s.m_obj = box(0);
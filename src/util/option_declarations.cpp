@@ -4,6 +4,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <lean/thread.h>
 #include "util/option_declarations.h"
 #include "util/array_ref.h"
 #include "util/pair_ref.h"
@@ -16,7 +17,7 @@ extern "C" object * lean_data_value_to_string (obj_arg d);
 
 extern "C" object * lean_get_option_decls_array(obj_arg w);
 
-option_declarations get_option_declarations() {
+static option_declarations build_option_declarations() {
     auto decl_array = get_io_result<array_ref<pair_ref<name, option_decl> > > (lean_get_option_decls_array(io_mk_world()));
     option_declarations r;
     for (pair_ref<name, option_decl> const & p : decl_array) {
@@ -31,6 +32,29 @@ option_declarations get_option_declarations() {
     return r;
 }
 
+/* Snapshot of the registry, rebuilt lazily after a registration. The registry is
+   read-mostly: registrations happen during initialization, while queries come from
+   every request in server mode. Readers perform one acquire load and copy the
+   persistent map (a reference count increment); `register_option` publishes by
+   clearing the pointer, and the next reader rebuilds from the Lean-side registry.
+   Superseded snapshots are intentionally leaked: the number of generations is
+   bounded by the number of registrations, and reclaiming them would require
+   tracking concurrent readers. */
+static atomic<option_declarations *> g_option_decls_snapshot(nullptr);
+
+option_declarations get_option_declarations() {
+    option_declarations * s = g_option_decls_snapshot.load(memory_order_acquire);
+    if (s != nullptr)
+        return *s;
+    option_declarations * fresh = new option_declarations(build_option_declarations());
+    option_declarations * expected = nullptr;
+    if (g_option_decls_snapshot.compare_exchange_strong(expected, fresh, memory_order_acq_rel))
+        return *fresh;
+    /* another reader installed a snapshot first */
+    delete fresh;
+    return *expected;
+}
+
 data_value mk_data_value(data_value_kind k, char const * val) {
     switch (k) {
     case data_value_kind::String:
@@ -51,5 +75,8 @@ extern "C" object * lean_register_option(obj_arg name, obj_arg decl, obj_arg w);
 void register_option(name const & n, data_value_kind k, char const * default_value, char const * description) {
     object_ref decl = mk_cnstr(0, mk_data_value(k, default_value), string_ref(""), string_ref(description));
     consume_io_result(lean_register_option(n.to_obj_arg(), decl.to_obj_arg(), io_mk_world()));
+    /* Invalidate the snapshot (see above). Registrations that go through the Lean
+       side directly also happen during initialization, before the first query. */
+    g_option_decls_snapshot.store(nullptr, memory_order_release);
 }
 }
@@ -9,10 +9,18 @@ Author: Leonardo de Moura
 #include <string>
 #include <iostream>
 #include <chrono>
+#include <cstdint>
 
 namespace lean {
 using second_duration = std::chrono::duration<double>;
 
+/** \brief Timestamp as seconds since an arbitrary per-process epoch, for measuring
+    profiling scopes. Backed by the TSC (calibrated in \c initialize_timeit) when the
+    CPU advertises an invariant TSC, which is several times cheaper than querying
+    \c steady_clock; falls back to \c steady_clock otherwise. Timestamps taken before
+    \c initialize_timeit use the fallback epoch and must not be mixed with later ones. */
+second_duration fast_now();
+
 struct display_profiling_time {
     second_duration m_time;
 };
@@ -22,20 +30,19 @@ std::ostream & operator<<(std::ostream & out, display_profiling_time const & tim
 /** \brief Low tech timer. */
 class timeit {
     second_duration m_threshold;
-    std::chrono::steady_clock::time_point m_start;
+    second_duration m_start;
     std::ostream & m_out;
     std::string    m_msg;
 public:
     timeit(std::ostream & out, char const * msg, second_duration threshold):
         m_threshold(threshold), m_out(out), m_msg(msg) {
-        m_start = std::chrono::steady_clock::now();
+        m_start = fast_now();
     }
     timeit(std::ostream & out, char const * msg, double threshold):
         timeit(out, msg, second_duration(threshold)) {}
     timeit(std::ostream & out, char const * msg) : timeit(out, msg, second_duration(0)) {}
     ~timeit() {
-        auto end = std::chrono::steady_clock::now();
-        auto diff = second_duration(end - m_start);
+        auto diff = fast_now() - m_start;
         if (diff >= m_threshold) {
             m_out << m_msg << " " << display_profiling_time{diff} << "\n";
         }
@@ -46,12 +53,12 @@ public:
 class xtimeit {
     second_duration m_threshold;
     second_duration m_excluded {0};
-    std::chrono::steady_clock::time_point m_start;
+    second_duration m_start;
     std::function<void(second_duration)> m_fn; // NOLINT
 public:
     xtimeit(second_duration threshold, std::function<void(second_duration)> const & fn): // NOLINT
         m_threshold(threshold), m_fn(fn) {
-        m_start = std::chrono::steady_clock::now();
+        m_start = fast_now();
     }
     xtimeit(std::function<void(second_duration)> const & fn) : xtimeit(second_duration(0), fn) {} // NOLINT
     xtimeit(xtimeit const &) = delete;
@@ -64,8 +71,7 @@ public:
     }
 
     second_duration get_elapsed_inclusive() const {
-        auto end = std::chrono::steady_clock::now();
-        return second_duration(end - m_start);
+        return fast_now() - m_start;
     }
 
     second_duration get_elapsed() const {
@@ -77,4 +83,35 @@ public:
     }
 };
 
+/** \brief Hardware counter deltas for a measured scope. Fields are zero when the
+    corresponding counter is unavailable on the current platform. */
+struct perf_counters {
+    uint64_t m_cycles        = 0;
+    uint64_t m_instructions  = 0;
+    uint64_t m_cache_misses  = 0;
+    uint64_t m_branch_misses = 0;
+    perf_counters & operator+=(perf_counters const & c) {
+        m_cycles        += c.m_cycles;
+        m_instructions  += c.m_instructions;
+        m_cache_misses  += c.m_cache_misses;
+        m_branch_misses += c.m_branch_misses;
+        return *this;
+    }
+};
+
+/** \brief RAII companion to \c timeit that samples the thread's hardware counters at
+    construction and adds the delta to \c out at destruction. Uses perf_event_open on
+    Linux; when that is unavailable (other platforms, restrictive perf_event_paranoid,
+    containers) only cycles are approximated via rdtsc and the other fields stay zero. */
+class perf_scope {
+    perf_counters   m_begin;
+    perf_counters & m_out;
+public:
+    explicit perf_scope(perf_counters & out);
+    ~perf_scope();
+    perf_scope(perf_scope const &) = delete;
+};
+
+void initialize_timeit();
+void finalize_timeit();
 }
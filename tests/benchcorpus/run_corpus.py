@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""Whole-pipeline macro-benchmark over a pinned corpus of Lean modules.
+
+Runs `lean -D profiler=true` over every module listed in `corpus.txt`,
+repeats each run, and splits wall time into the `time_task` categories the
+profiler reports (parsing, import, elaboration, type checking, compilation,
+.olean serialization, ...). Results are written as CSV with mean, standard
+deviation, min and max per (module, category), plus a `wall` row for the
+total wall time of the process, so changes can be attributed to a phase and
+judged against run-to-run variance.
+
+Usage: run_corpus.py [--reps N] [--corpus FILE] [--out FILE] [--lean LEAN]
+
+`lean` must be on PATH (the `bench_corpus` CMake target arranges this).
+"""
+
+import argparse
+import csv
+import os
+import re
+import statistics
+import subprocess
+import sys
+import time
+
+# `\t<category> <float>(m?)s` lines below "cumulative profiling times:"
+CATEGORY_RE = re.compile(r"^\t(.+?)\s+([\d.]+)(m?)s$", re.MULTILINE)
+
+
+def parse_profile(stderr):
+    times = {}
+    for m in CATEGORY_RE.finditer(stderr):
+        times[m.group(1)] = times.get(m.group(1), 0.0) + \
+            float(m.group(2)) * (1e-3 if m.group(3) else 1.0)
+    return times
+
+
+def bench_module(lean, path, reps):
+    """Return {category: [seconds per rep]} for one module."""
+    samples = {}
+    for _ in range(reps):
+        start = time.monotonic()
+        proc = subprocess.run([lean, "-D", "profiler=true", path],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                              encoding="utf-8")
+        wall = time.monotonic() - start
+        if proc.returncode != 0:
+            sys.stderr.write(proc.stderr)
+            raise RuntimeError(f"lean failed on {path} (exit {proc.returncode})")
+        times = parse_profile(proc.stderr)
+        times["wall"] = wall
+        for cat, t in times.items():
+            samples.setdefault(cat, []).append(t)
+    return samples
+
+
+def load_corpus(corpus_file):
+    base = os.path.dirname(os.path.abspath(corpus_file))
+    modules = []
+    with open(corpus_file) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            path = os.path.normpath(os.path.join(base, line))
+            if not os.path.exists(path):
+                raise RuntimeError(f"corpus module not found: {path}")
+            modules.append(path)
+    return modules
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--reps", type=int, default=5)
+    ap.add_argument("--corpus", default=os.path.join(os.path.dirname(__file__), "corpus.txt"))
+    ap.add_argument("--out", default="-", help="output CSV file, '-' for stdout")
+    ap.add_argument("--lean", default="lean")
+    args = ap.parse_args()
+
+    modules = load_corpus(args.corpus)
+    out = sys.stdout if args.out == "-" else open(args.out, "w", newline="")
+    w = csv.writer(out)
+    w.writerow(["module", "category", "reps", "mean_s", "stddev_s", "min_s", "max_s"])
+    for path in modules:
+        name = os.path.basename(path)
+        sys.stderr.write(f"benchmarking {name} ({args.reps} reps)\n")
+        samples = bench_module(args.lean, path, args.reps)
+        for cat in sorted(samples.keys()):
+            s = samples[cat]
+            # a category missing in some rep contributed ~0 time there
+            s = s + [0.0] * (args.reps - len(s))
+            w.writerow([name, cat, args.reps,
+                        f"{statistics.mean(s):.6f}",
+                        f"{statistics.stdev(s):.6f}" if len(s) > 1 else "0",
+                        f"{min(s):.6f}", f"{max(s):.6f}"])
+    if out is not sys.stdout:
+        out.close()
+        sys.stderr.write(f"results written to {args.out}\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,9 @@
+/- Naive Fibonacci forced through kernel reduction: `rfl` makes `check` unfold
+   the `brecOn` translation step by step, stressing recursor reduction and the
+   whnf cache. -/
+def fib : Nat → Nat
+  | 0     => 0
+  | 1     => 1
+  | n + 2 => fib (n + 1) + fib n
+
+theorem fib16 : fib 16 = 987 := rfl
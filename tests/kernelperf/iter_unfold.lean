@@ -0,0 +1,10 @@
+/- Deeply nested closure applications: each `iter` step leaves a beta redex
+   for the kernel to reduce, measuring plain delta/beta throughput without
+   recursor-heavy structure. -/
+def iter (f : Nat → Nat) : Nat → Nat → Nat
+  | 0,     x => x
+  | n + 1, x => f (iter f n x)
+
+theorem iter_add : iter (· + 2) 100 0 = 200 := rfl
+
+theorem iter_comp : iter (fun x => iter (· + 1) 10 x) 20 0 = 200 := rfl
@@ -0,0 +1,9 @@
+/- Builds a long literal list and consumes it; the kernel walks one
+   constructor application per element on each side of the defeq check. -/
+def mkList : Nat → List Nat
+  | 0     => []
+  | n + 1 => n :: mkList n
+
+theorem mkList_len : (mkList 64).length = 64 := rfl
+
+theorem mkList_sum : (mkList 32).foldl (· + ·) 0 = 496 := rfl
@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+source ../common.sh
+
+# Heuristic changes legitimately move the counters; the tolerance leaves them
+# headroom so only real blowups fail.
+TOL=1.5
+[ -f "$f.tolerance" ] && TOL=$(< "$f.tolerance")
+
+LEAN_KERNEL_DECL_STATS=1 lean "$f" 2> "$f.stats" || { cat "$f.stats"; fail "Failed to check $f"; }
+
+# Sum whnf/unfolded/recursor over all "kernel stats:" lines. max depth is a
+# high-water mark and cache hit rates depend on declaration order, so neither
+# is a stable aggregate.
+awk -F'[=, ]+' '/^kernel stats:/ {
+        for (i = 1; i < NF; i++) {
+            if ($i == "whnf")     whnf += $(i+1);
+            if ($i == "unfolded") unf  += $(i+1);
+            if ($i == "recursor") rec  += $(i+1);
+        }
+    }
+    END { printf "whnf=%d\nunfolded=%d\nrecursor=%d\n", whnf, unf, rec }' "$f.stats" > "$f.baseline.produced"
+rm -f "$f.stats"
+
+# Baselines are only (re-)recorded on request; a silently recorded baseline on a
+# clean checkout would make the suite pass without ever comparing anything.
+if [ -n "${KERNELPERF_RECORD+x}" ]; then
+    cp -- "$f.baseline.produced" "$f.baseline"
+    echo "-- recorded new baseline $f.baseline; commit it"
+    exit 0
+fi
+[ -f "$f.baseline" ] || fail "Missing $f.baseline; record one with KERNELPERF_RECORD=1 and commit it"
+
+paste -d= "$f.baseline" "$f.baseline.produced" | awk -F= -v tol="$TOL" '
+    $1 != $3 { printf "ERROR: baseline/produced counter mismatch: %s vs %s\n", $1, $3; bad = 1 }
+    $1 == $3 && $2 > 0 {
+        if ($4 > $2 * tol) { printf "ERROR: %s blew up: %d -> %d (tolerance %.2fx)\n", $1, $2, $4, tol; bad = 1 }
+        else if ($4 * tol < $2) printf "note: %s dropped: %d -> %d; consider re-recording the baseline\n", $1, $2, $4
+    }
+    END { exit bad }' || fail "kernel perf regression in $f"
+echo "-- $f within tolerance"